@@ -33,9 +33,9 @@
 #include "dart/collision/dart/DARTCollide.hpp"
 
 #include <memory>
-#include <thread>
 
 #include "dart/collision/CollisionObject.hpp"
+#include "dart/collision/dart/DARTCollisionObject.hpp"
 #include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/BoxShape.hpp"
 #include "dart/dynamics/CapsuleShape.hpp"
@@ -3525,14 +3525,6 @@ inline void setCcdDefaultSettings(ccd_t& ccd)
   ccd.max_iterations = 10000;
 }
 
-/// This allows us to prevent weird effects where we don't want to carry over
-/// cacheing
-void clearCcdCache()
-{
-  _ccdDirCache.clear();
-  _ccdPosCache.clear();
-}
-
 /*
 /// This checks whether a 2D shape contains a point. This assumes that shape was
 /// sorted using sortConvex2DShape().
@@ -3692,22 +3684,22 @@ bool get2DLineIntersection(
   return false; // No collision
 }
 
-// Get the `pos` vec for CCD for this pair of objects
-ccd_vec3_t& getCachedCcdPos(CollisionObject* o1, CollisionObject* o2)
+// Get the `dir` and `pos` warm start vecs for CCD for this pair of objects
+CcdWarmStart& getCachedCcdWarmStart(CollisionObject* o1, CollisionObject* o2)
 {
-  long key = (long)o1 ^ (long)o2;
-  const std::thread::id tid = std::this_thread::get_id();
-  ccd_vec3_t& pos = _ccdPosCache[tid][key];
-  return pos;
-}
+  if (o1 != nullptr && o2 != nullptr
+      && o1->getCollisionDetector() == o2->getCollisionDetector()
+      && o1->getCollisionDetector()->getType()
+             == DARTCollisionDetector::getStaticType())
+  {
+    return static_cast<DARTCollisionDetector*>(o1->getCollisionDetector())
+        ->getCcdWarmStart(
+            static_cast<DARTCollisionObject*>(o1),
+            static_cast<DARTCollisionObject*>(o2));
+  }
 
-// Get the `dir` vec for CCD for this pair of objects
-ccd_vec3_t& getCachedCcdDir(CollisionObject* o1, CollisionObject* o2)
-{
-  long key = (long)o1 ^ (long)o2;
-  const std::thread::id tid = std::this_thread::get_id();
-  ccd_vec3_t& dir = _ccdDirCache[tid][key];
-  return dir;
+  thread_local CcdWarmStart scratch = CcdWarmStart();
+  return scratch;
 }
 
 int collideBoxBoxAsMesh(
@@ -3738,8 +3730,9 @@ int collideBoxBoxAsMesh(
   box2.transform = &T1;
 
   ccd_real_t depth;
-  ccd_vec3_t& dir = getCachedCcdDir(o1, o2);
-  ccd_vec3_t& pos = getCachedCcdPos(o1, o2);
+  CcdWarmStart& warmStart = getCachedCcdWarmStart(o1, o2);
+  ccd_vec3_t& dir = warmStart.dir;
+  ccd_vec3_t& pos = warmStart.pos;
   int intersect = ccdMPRPenetration(&box1, &box2, &ccd, &depth, &dir, &pos);
   if (intersect == 0)
   {
@@ -3783,8 +3776,9 @@ int collideMeshBox(
   box2.transform = &c1;
 
   ccd_real_t depth;
-  ccd_vec3_t& dir = getCachedCcdDir(o1, o2);
-  ccd_vec3_t& pos = getCachedCcdPos(o1, o2);
+  CcdWarmStart& warmStart = getCachedCcdWarmStart(o1, o2);
+  ccd_vec3_t& dir = warmStart.dir;
+  ccd_vec3_t& pos = warmStart.pos;
   int intersect = ccdMPRPenetration(&mesh1, &box2, &ccd, &depth, &dir, &pos);
   if (intersect == 0)
   {
@@ -3828,8 +3822,9 @@ int collideBoxMesh(
   mesh2.scale = &size1;
 
   ccd_real_t depth;
-  ccd_vec3_t& dir = getCachedCcdDir(o1, o2);
-  ccd_vec3_t& pos = getCachedCcdPos(o1, o2);
+  CcdWarmStart& warmStart = getCachedCcdWarmStart(o1, o2);
+  ccd_vec3_t& dir = warmStart.dir;
+  ccd_vec3_t& pos = warmStart.pos;
   int intersect = ccdMPRPenetration(&box1, &mesh2, &ccd, &depth, &dir, &pos);
   if (intersect == 0)
   {
@@ -3879,8 +3874,9 @@ int collideMeshSphere(
   setCcdDefaultSettings(ccd);      // maximal tolerance
 
   ccd_real_t depth;
-  ccd_vec3_t& dir = getCachedCcdDir(o1, o2);
-  ccd_vec3_t& pos = getCachedCcdPos(o1, o2);
+  CcdWarmStart& warmStart = getCachedCcdWarmStart(o1, o2);
+  ccd_vec3_t& dir = warmStart.dir;
+  ccd_vec3_t& pos = warmStart.pos;
   int intersect = ccdMPRPenetration(&mesh, &sphere, &ccd, &depth, &dir, &pos);
   if (intersect == 0)
   {
@@ -3923,8 +3919,9 @@ int collideSphereMesh(
   setCcdDefaultSettings(ccd);      // maximal tolerance
 
   ccd_real_t depth;
-  ccd_vec3_t& dir = getCachedCcdDir(o1, o2);
-  ccd_vec3_t& pos = getCachedCcdPos(o1, o2);
+  CcdWarmStart& warmStart = getCachedCcdWarmStart(o1, o2);
+  ccd_vec3_t& dir = warmStart.dir;
+  ccd_vec3_t& pos = warmStart.pos;
   int intersect = ccdMPRPenetration(&sphere, &mesh, &ccd, &depth, &dir, &pos);
   if (intersect == 0)
   {
@@ -3969,8 +3966,9 @@ int collideMeshMesh(
   mesh2.scale = &size1;
 
   ccd_real_t depth;
-  ccd_vec3_t& dir = getCachedCcdDir(o1, o2);
-  ccd_vec3_t& pos = getCachedCcdPos(o1, o2);
+  CcdWarmStart& warmStart = getCachedCcdWarmStart(o1, o2);
+  ccd_vec3_t& dir = warmStart.dir;
+  ccd_vec3_t& pos = warmStart.pos;
   int intersect = ccdMPRPenetration(&mesh1, &mesh2, &ccd, &depth, &dir, &pos);
   if (intersect == 0)
   {
@@ -4244,8 +4242,9 @@ int collideBoxCapsule(
   capsule2.transform = &T1;
 
   ccd_real_t depth;
-  ccd_vec3_t& dir = getCachedCcdDir(o1, o2);
-  ccd_vec3_t& pos = getCachedCcdPos(o1, o2);
+  CcdWarmStart& warmStart = getCachedCcdWarmStart(o1, o2);
+  ccd_vec3_t& dir = warmStart.dir;
+  ccd_vec3_t& pos = warmStart.pos;
   int intersect = ccdMPRPenetration(&box1, &capsule2, &ccd, &depth, &dir, &pos);
   if (intersect == 0)
   {
@@ -4316,8 +4315,9 @@ int collideCapsuleBox(
   box2.transform = &T1;
 
   ccd_real_t depth;
-  ccd_vec3_t& dir = getCachedCcdDir(o1, o2);
-  ccd_vec3_t& pos = getCachedCcdPos(o1, o2);
+  CcdWarmStart& warmStart = getCachedCcdWarmStart(o1, o2);
+  ccd_vec3_t& dir = warmStart.dir;
+  ccd_vec3_t& pos = warmStart.pos;
   int intersect = ccdMPRPenetration(&capsule1, &box2, &ccd, &depth, &dir, &pos);
   if (intersect == 0)
   {
@@ -4390,8 +4390,9 @@ int collideMeshCapsule(
   capsule2.transform = &T1;
 
   ccd_real_t depth;
-  ccd_vec3_t& dir = getCachedCcdDir(o1, o2);
-  ccd_vec3_t& pos = getCachedCcdPos(o1, o2);
+  CcdWarmStart& warmStart = getCachedCcdWarmStart(o1, o2);
+  ccd_vec3_t& dir = warmStart.dir;
+  ccd_vec3_t& pos = warmStart.pos;
   int intersect
       = ccdMPRPenetration(&mesh1, &capsule2, &ccd, &depth, &dir, &pos);
   if (intersect == 0)
@@ -4465,8 +4466,9 @@ int collideCapsuleMesh(
   mesh2.transform = &T1;
 
   ccd_real_t depth;
-  ccd_vec3_t& dir = getCachedCcdDir(o1, o2);
-  ccd_vec3_t& pos = getCachedCcdPos(o1, o2);
+  CcdWarmStart& warmStart = getCachedCcdWarmStart(o1, o2);
+  ccd_vec3_t& dir = warmStart.dir;
+  ccd_vec3_t& pos = warmStart.pos;
   int intersect
       = ccdMPRPenetration(&capsule1, &mesh2, &ccd, &depth, &dir, &pos);
   if (intersect == 0)
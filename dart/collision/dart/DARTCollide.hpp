@@ -33,8 +33,6 @@
 #ifndef DART_COLLISION_DART_DARTCOLLIDE_HPP_
 #define DART_COLLISION_DART_DARTCOLLIDE_HPP_
 
-#include <thread>
-#include <unordered_map>
 #include <vector>
 
 #include <Eigen/Dense>
@@ -43,6 +41,7 @@
 #include <ccd/vec3.h>
 
 #include "dart/collision/CollisionDetector.hpp"
+#include "dart/collision/dart/DARTCollisionDetector.hpp"
 
 namespace dart {
 namespace collision {
@@ -242,11 +241,11 @@ int collideCylinderPlane(
 // Interface with libccd:
 /////////////////////////////////////////////////////////////////////
 
-// Get the `pos` vec for CCD for this pair of objects
-ccd_vec3_t& getCachedCcdPos(CollisionObject* o1, CollisionObject* o2);
-
-// Get the `dir` vec for CCD for this pair of objects
-ccd_vec3_t& getCachedCcdDir(CollisionObject* o1, CollisionObject* o2);
+// Get the `dir` and `pos` warm start vecs for CCD for this pair of objects.
+// These live in the DARTCollisionDetector that owns the objects. If the objects
+// don't belong to a DARTCollisionDetector (like in unit tests that call the
+// narrowphase directly), this falls back to scratch space local to the thread.
+CcdWarmStart& getCachedCcdWarmStart(CollisionObject* o1, CollisionObject* o2);
 
 // We need to define structs for each object type that we pass to libccd, with
 // all relevant info about the object.
@@ -417,15 +416,6 @@ bool get2DLineIntersection(
 /// code, so it's easy to tweak settings across all collision pairs.
 inline void setCcdDefaultSettings(ccd_t& ccd);
 
-/// This allows us to prevent weird effects where we don't want to carry over
-/// cacheing
-void clearCcdCache();
-
-/// This is the static cache for all the CCD collision search data
-static std::unordered_map<std::thread::id, std::unordered_map<long, ccd_vec3_t>>
-    _ccdDirCache;
-static std::unordered_map<std::thread::id, std::unordered_map<long, ccd_vec3_t>>
-    _ccdPosCache;
 
 } // namespace collision
 } // namespace dart
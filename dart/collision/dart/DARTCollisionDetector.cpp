@@ -78,7 +78,6 @@ DARTCollisionDetector::Registrar<DARTCollisionDetector>
 //==============================================================================
 std::shared_ptr<DARTCollisionDetector> DARTCollisionDetector::create()
 {
-  clearCcdCache();
   return std::shared_ptr<DARTCollisionDetector>(new DARTCollisionDetector());
 }
 
@@ -147,30 +146,32 @@ bool DARTCollisionDetector::collide(
   auto collisionFound = false;
   const auto& filter = option.collisionFilter;
 
-  for (auto i = 0u; i < objects.size() - 1; ++i)
-  {
-    auto* collObj1 = objects[i];
+  // Broadphase: only pairs with overlapping bounding boxes can collide
+  std::vector<std::pair<std::size_t, std::size_t>> pairs;
+  casted->updateBroadphase();
+  casted->computeOverlappingPairs(pairs);
 
-    for (auto j = i + 1u; j < objects.size(); ++j)
-    {
-      auto* collObj2 = objects[j];
+  for (const auto& pair : pairs)
+  {
+    auto* collObj1 = objects[pair.first];
+    auto* collObj2 = objects[pair.second];
 
-      if (filter && filter->ignoresCollision(collObj1, collObj2))
-        continue;
+    if (filter && filter->ignoresCollision(collObj1, collObj2))
+      continue;
 
-      collisionFound = checkPair(collObj1, collObj2, option, result);
+    if (checkPair(collObj1, collObj2, option, result))
+      collisionFound = true;
 
-      if (result)
-      {
-        if (result->getNumContacts() >= option.maxNumContacts)
-          return true;
-      }
-      else
-      {
-        // If no result is passed, stop checking when the first contact is found
-        if (collisionFound)
-          return true;
-      }
+    if (result)
+    {
+      if (result->getNumContacts() >= option.maxNumContacts)
+        return true;
+    }
+    else
+    {
+      // If no result is passed, stop checking when the first contact is found
+      if (collisionFound)
+        return true;
     }
   }
 
@@ -209,30 +210,34 @@ bool DARTCollisionDetector::collide(
   auto collisionFound = false;
   const auto& filter = option.collisionFilter;
 
-  for (auto i = 0u; i < objects1.size(); ++i)
-  {
-    auto* collObj1 = objects1[i];
+  // Broadphase: only pairs with overlapping bounding boxes can collide
+  std::vector<std::pair<std::size_t, std::size_t>> pairs;
+  casted1->updateBroadphase();
+  if (casted2 != casted1)
+    casted2->updateBroadphase();
+  DARTCollisionGroup::computeOverlappingPairs(casted1, casted2, pairs);
 
-    for (auto j = 0u; j < objects2.size(); ++j)
-    {
-      auto* collObj2 = objects2[j];
+  for (const auto& pair : pairs)
+  {
+    auto* collObj1 = objects1[pair.first];
+    auto* collObj2 = objects2[pair.second];
 
-      if (filter && filter->ignoresCollision(collObj1, collObj2))
-        continue;
+    if (filter && filter->ignoresCollision(collObj1, collObj2))
+      continue;
 
-      collisionFound = checkPair(collObj1, collObj2, option, result);
+    if (checkPair(collObj1, collObj2, option, result))
+      collisionFound = true;
 
-      if (result)
-      {
-        if (result->getNumContacts() >= option.maxNumContacts)
-          return true;
-      }
-      else
-      {
-        // If no result is passed, stop checking when the first contact is found
-        if (collisionFound)
-          return true;
-      }
+    if (result)
+    {
+      if (result->getNumContacts() >= option.maxNumContacts)
+        return true;
+    }
+    else
+    {
+      // If no result is passed, stop checking when the first contact is found
+      if (collisionFound)
+        return true;
     }
   }
 
@@ -266,7 +271,8 @@ double DARTCollisionDetector::distance(
 }
 
 //==============================================================================
-DARTCollisionDetector::DARTCollisionDetector() : CollisionDetector()
+DARTCollisionDetector::DARTCollisionDetector()
+  : CollisionDetector(), mNextCollisionObjectId(0u)
 {
   mCollisionObjectManager.reset(new ManagerForSharableCollisionObjects(this));
 }
@@ -317,7 +323,7 @@ std::unique_ptr<CollisionObject> DARTCollisionDetector::createCollisionObject(
   warnUnsupportedShapeType(shapeFrame);
 
   return std::unique_ptr<DARTCollisionObject>(
-      new DARTCollisionObject(this, shapeFrame));
+      new DARTCollisionObject(this, shapeFrame, mNextCollisionObjectId++));
 }
 
 //==============================================================================
@@ -326,6 +332,51 @@ void DARTCollisionDetector::refreshCollisionObject(CollisionObject* /*object*/)
   // Do nothing
 }
 
+//==============================================================================
+void DARTCollisionDetector::notifyCollisionObjectDestroying(
+    CollisionObject* object)
+{
+  const std::uint32_t id = static_cast<DARTCollisionObject*>(object)->mId;
+  for (auto it = mCcdCache.begin(); it != mCcdCache.end();)
+  {
+    if (static_cast<std::uint32_t>(it->first >> 32) == id
+        || static_cast<std::uint32_t>(it->first) == id)
+      it = mCcdCache.erase(it);
+    else
+      ++it;
+  }
+}
+
+//==============================================================================
+CcdWarmStart& DARTCollisionDetector::getCcdWarmStart(
+    const DARTCollisionObject* o1, const DARTCollisionObject* o2)
+{
+  const std::uint64_t key
+      = (static_cast<std::uint64_t>(o1->mId) << 32) | o2->mId;
+
+  auto it = mCcdCache.find(key);
+  if (it == mCcdCache.end())
+  {
+    CcdWarmStart warmStart;
+    ccdVec3Set(&warmStart.dir, 0, 0, 0);
+    ccdVec3Set(&warmStart.pos, 0, 0, 0);
+    it = mCcdCache.emplace(key, warmStart).first;
+  }
+  return it->second;
+}
+
+//==============================================================================
+void DARTCollisionDetector::clearCcdCache()
+{
+  mCcdCache.clear();
+}
+
+//==============================================================================
+std::size_t DARTCollisionDetector::getCcdCacheSize() const
+{
+  return mCcdCache.size();
+}
+
 namespace {
 
 //==============================================================================
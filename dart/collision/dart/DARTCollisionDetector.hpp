@@ -33,7 +33,12 @@
 #ifndef DART_COLLISION_DART_DARTCOLLISIONDETECTOR_HPP_
 #define DART_COLLISION_DART_DARTCOLLISIONDETECTOR_HPP_
 
+#include <cstdint>
+#include <unordered_map>
 #include <vector>
+
+#include <ccd/vec3.h>
+
 #include "dart/collision/CollisionDetector.hpp"
 
 namespace dart {
@@ -41,6 +46,15 @@ namespace collision {
 
 class DARTCollisionObject;
 
+/// This is the search state that libccd's MPR carries over from one call to
+/// the next for a single pair of objects, so that it can warm start from where
+/// the pair was last timestep.
+struct CcdWarmStart
+{
+  ccd_vec3_t dir;
+  ccd_vec3_t pos;
+};
+
 class DARTCollisionDetector : public CollisionDetector
 {
 public:
@@ -87,6 +101,26 @@ public:
       const DistanceOption& option = DistanceOption(false, 0.0, nullptr),
       DistanceResult* result = nullptr) override;
 
+  /// Returns the libccd warm start for the ordered pair (o1, o2), creating a
+  /// zeroed one the first time we see the pair. The returned reference stays
+  /// valid until one of the two objects is destroyed, or clearCcdCache() is
+  /// called.
+  ///
+  /// The cache belongs to this detector, and each World (and each clone of a
+  /// World) owns its own detector, so worlds stepping on different threads
+  /// never touch the same cache. Like collide(), this is not safe to call on
+  /// the same detector from several threads at once.
+  CcdWarmStart& getCcdWarmStart(
+      const DARTCollisionObject* o1, const DARTCollisionObject* o2);
+
+  /// This drops every cached libccd warm start, so that the next collision
+  /// check of every pair starts its search from scratch.
+  void clearCcdCache();
+
+  /// Returns the number of pairs we're currently caching libccd warm starts
+  /// for
+  std::size_t getCcdCacheSize() const;
+
 protected:
 
   /// Constructor
@@ -99,6 +133,19 @@ protected:
   // Documentation inherited
   void refreshCollisionObject(CollisionObject* object) override;
 
+  // Documentation inherited
+  void notifyCollisionObjectDestroying(CollisionObject* object) override;
+
+protected:
+  /// The libccd warm starts for every pair of objects that has gone through a
+  /// libccd narrowphase, keyed on the pair of object IDs
+  std::unordered_map<std::uint64_t, CcdWarmStart> mCcdCache;
+
+  /// The ID we'll give to the next DARTCollisionObject we create. Unlike
+  /// pointers, these never get reused, so a stale cache entry can never be
+  /// picked up by a new pair of objects.
+  std::uint32_t mNextCollisionObjectId;
+
 private:
   static Registrar<DARTCollisionDetector> mRegistrar;
 };
@@ -32,19 +32,53 @@
 
 #include "dart/collision/dart/DARTCollisionGroup.hpp"
 
+#include <algorithm>
+#include <numeric>
+
 #include "dart/collision/CollisionObject.hpp"
+#include "dart/collision/dart/DARTCollisionObject.hpp"
 
 namespace dart {
 namespace collision {
 
+namespace {
+
+/// We only switch sweep axes once another axis is this many times more spread
+/// out than the current one. Switching costs a full re-sort, so scenes that
+/// sit near a tie shouldn't flip back and forth every timestep.
+constexpr double SWEEP_AXIS_SWITCH_RATIO = 1.5;
+
+} // namespace
+
 //==============================================================================
 DARTCollisionGroup::DARTCollisionGroup(
     const CollisionDetectorPtr& collisionDetector)
-  : CollisionGroup(collisionDetector)
+  : CollisionGroup(collisionDetector),
+    mSweepAxis(0),
+    mBroadphaseDirty(true),
+    mBroadphaseMargin(1e-2)
 {
   // Do nothing
 }
 
+//==============================================================================
+void DARTCollisionGroup::setBroadphaseMargin(double margin)
+{
+  mBroadphaseMargin = margin;
+}
+
+//==============================================================================
+double DARTCollisionGroup::getBroadphaseMargin() const
+{
+  return mBroadphaseMargin;
+}
+
+//==============================================================================
+int DARTCollisionGroup::getSweepAxis() const
+{
+  return mSweepAxis;
+}
+
 //==============================================================================
 void DARTCollisionGroup::initializeEngineData()
 {
@@ -58,6 +92,7 @@ void DARTCollisionGroup::addCollisionObjectToEngine(CollisionObject* object)
       == mCollisionObjects.end())
   {
     mCollisionObjects.push_back(object);
+    mBroadphaseDirty = true;
   }
 }
 
@@ -74,13 +109,17 @@ void DARTCollisionGroup::removeCollisionObjectFromEngine(
     CollisionObject* object)
 {
   mCollisionObjects.erase(
-      std::remove(mCollisionObjects.begin(), mCollisionObjects.end(), object));
+      std::remove(mCollisionObjects.begin(), mCollisionObjects.end(), object),
+      mCollisionObjects.end());
+  mBroadphaseDirty = true;
 }
 
 //==============================================================================
 void DARTCollisionGroup::removeAllCollisionObjectsFromEngine()
 {
   mCollisionObjects.clear();
+  mSortedObjects.clear();
+  mBroadphaseDirty = true;
 }
 
 //==============================================================================
@@ -89,5 +128,198 @@ void DARTCollisionGroup::updateCollisionGroupEngineData()
   // Do nothing
 }
 
+//==============================================================================
+void DARTCollisionGroup::updateBroadphase()
+{
+  const std::size_t numObjects = mCollisionObjects.size();
+
+  // Refresh the boxes, and find the axis along which the box centers are most
+  // spread out
+  Eigen::Vector3d sum = Eigen::Vector3d::Zero();
+  Eigen::Vector3d sumSq = Eigen::Vector3d::Zero();
+  std::size_t numFinite = 0u;
+  for (auto* object : mCollisionObjects)
+  {
+    auto* casted = static_cast<DARTCollisionObject*>(object);
+    casted->updateAabb(mBroadphaseMargin);
+
+    const Eigen::Vector3d center
+        = 0.5 * (casted->getAabbMin() + casted->getAabbMax());
+    if (center.allFinite())
+    {
+      sum += center;
+      sumSq += center.cwiseProduct(center);
+      numFinite++;
+    }
+  }
+
+  const bool rebuild = mBroadphaseDirty || mSortedObjects.size() != numObjects;
+
+  int axis = mSweepAxis;
+  if (numFinite > 0u)
+  {
+    const Eigen::Vector3d mean = sum / numFinite;
+    const Eigen::Vector3d variance
+        = sumSq / numFinite - mean.cwiseProduct(mean);
+    const double bestVariance = variance.maxCoeff(&axis);
+
+    // If we're sorting from scratch anyway, we may as well take the best axis.
+    // Otherwise, stay put unless the best axis is clearly better.
+    if (!rebuild
+        && bestVariance <= SWEEP_AXIS_SWITCH_RATIO * variance[mSweepAxis])
+    {
+      axis = mSweepAxis;
+    }
+  }
+
+  const auto minOf = [this](std::size_t index) {
+    return static_cast<const DARTCollisionObject*>(mCollisionObjects[index])
+        ->getAabbMin()[mSweepAxis];
+  };
+
+  if (rebuild || axis != mSweepAxis)
+  {
+    mSweepAxis = axis;
+    mSortedObjects.resize(numObjects);
+    std::iota(mSortedObjects.begin(), mSortedObjects.end(), 0u);
+    std::sort(
+        mSortedObjects.begin(),
+        mSortedObjects.end(),
+        [&minOf](std::size_t a, std::size_t b) { return minOf(a) < minOf(b); });
+    mBroadphaseDirty = false;
+    return;
+  }
+
+  // The previous ordering is almost always nearly sorted, so insertion sort
+  // runs in close to linear time here, where std::sort wouldn't.
+  for (std::size_t i = 1u; i < numObjects; ++i)
+  {
+    const std::size_t current = mSortedObjects[i];
+    const double currentMin = minOf(current);
+    std::size_t j = i;
+    while (j > 0u && minOf(mSortedObjects[j - 1u]) > currentMin)
+    {
+      mSortedObjects[j] = mSortedObjects[j - 1u];
+      --j;
+    }
+    mSortedObjects[j] = current;
+  }
+}
+
+//==============================================================================
+void DARTCollisionGroup::computeOverlappingPairs(
+    std::vector<std::pair<std::size_t, std::size_t>>& pairs) const
+{
+  pairs.clear();
+
+  for (std::size_t i = 0u; i < mSortedObjects.size(); ++i)
+  {
+    const std::size_t index1 = mSortedObjects[i];
+    const auto* object1
+        = static_cast<const DARTCollisionObject*>(mCollisionObjects[index1]);
+    const double max1 = object1->getAabbMax()[mSweepAxis];
+
+    for (std::size_t j = i + 1u; j < mSortedObjects.size(); ++j)
+    {
+      const std::size_t index2 = mSortedObjects[j];
+      const auto* object2
+          = static_cast<const DARTCollisionObject*>(mCollisionObjects[index2]);
+
+      // Everything after this starts past the end of object1 along the sweep
+      // axis, so it can't overlap
+      if (object2->getAabbMin()[mSweepAxis] > max1)
+        break;
+
+      if (object1->aabbOverlaps(object2))
+        pairs.emplace_back(std::min(index1, index2), std::max(index1, index2));
+    }
+  }
+
+  // Contacts get reported in the order that pairs are checked, and callers
+  // (and the LCP warm starts) depend on that order staying the same as it was
+  // before we had a broadphase.
+  std::sort(pairs.begin(), pairs.end());
+}
+
+//==============================================================================
+void DARTCollisionGroup::computeOverlappingPairs(
+    const DARTCollisionGroup* group1,
+    const DARTCollisionGroup* group2,
+    std::vector<std::pair<std::size_t, std::size_t>>& pairs)
+{
+  pairs.clear();
+
+  // We sweep both groups together along group1's axis. group2 may be sorted
+  // along a different axis, in which case we pay for one extra sort here.
+  const int axis = group1->mSweepAxis;
+  std::vector<std::size_t> sorted2 = group2->mSortedObjects;
+  const auto& objects1 = group1->mCollisionObjects;
+  const auto& objects2 = group2->mCollisionObjects;
+  if (group2->mSweepAxis != axis)
+  {
+    std::sort(
+        sorted2.begin(),
+        sorted2.end(),
+        [&objects2, axis](std::size_t a, std::size_t b) {
+          return static_cast<const DARTCollisionObject*>(objects2[a])
+                     ->getAabbMin()[axis]
+                 < static_cast<const DARTCollisionObject*>(objects2[b])
+                       ->getAabbMin()[axis];
+        });
+  }
+  const auto& sorted1 = group1->mSortedObjects;
+
+  const auto minOf = [axis](const CollisionObject* object) {
+    return static_cast<const DARTCollisionObject*>(object)
+        ->getAabbMin()[axis];
+  };
+  const auto maxOf = [axis](const CollisionObject* object) {
+    return static_cast<const DARTCollisionObject*>(object)
+        ->getAabbMax()[axis];
+  };
+
+  // Merge the two sorted lists, and for each object, scan forward through the
+  // other group's list until we pass the end of its box
+  std::size_t i = 0u;
+  std::size_t j = 0u;
+  while (i < sorted1.size() && j < sorted2.size())
+  {
+    const auto* object1 = objects1[sorted1[i]];
+    const auto* object2 = objects2[sorted2[j]];
+
+    if (minOf(object1) <= minOf(object2))
+    {
+      const double max1 = maxOf(object1);
+      for (std::size_t k = j; k < sorted2.size(); ++k)
+      {
+        const auto* other = objects2[sorted2[k]];
+        if (minOf(other) > max1)
+          break;
+        if (static_cast<const DARTCollisionObject*>(object1)->aabbOverlaps(
+                static_cast<const DARTCollisionObject*>(other)))
+          pairs.emplace_back(sorted1[i], sorted2[k]);
+      }
+      ++i;
+    }
+    else
+    {
+      const double max2 = maxOf(object2);
+      for (std::size_t k = i; k < sorted1.size(); ++k)
+      {
+        const auto* other = objects1[sorted1[k]];
+        if (minOf(other) > max2)
+          break;
+        if (static_cast<const DARTCollisionObject*>(object2)->aabbOverlaps(
+                static_cast<const DARTCollisionObject*>(other)))
+          pairs.emplace_back(sorted1[k], sorted2[j]);
+      }
+      ++j;
+    }
+  }
+
+  // Match the order a brute force double loop over (group1, group2) would use
+  std::sort(pairs.begin(), pairs.end());
+}
+
 }  // namespace collision
 }  // namespace dart
@@ -33,6 +33,10 @@
 #ifndef DART_COLLISION_DART_DARTCOLLISIONGROUP_HPP_
 #define DART_COLLISION_DART_DARTCOLLISIONGROUP_HPP_
 
+#include <cstddef>
+#include <utility>
+#include <vector>
+
 #include "dart/collision/CollisionGroup.hpp"
 
 namespace dart {
@@ -52,6 +56,18 @@ public:
   /// Destructor
   virtual ~DARTCollisionGroup() = default;
 
+  /// Set the padding added to every side of each object's bounding box before
+  /// the broadphase compares them. Pairs whose padded boxes don't overlap are
+  /// never sent to the narrowphase.
+  void setBroadphaseMargin(double margin);
+
+  /// Return the padding added to every side of each object's bounding box in
+  /// the broadphase
+  double getBroadphaseMargin() const;
+
+  /// Return the axis (0, 1 or 2) the broadphase currently sweeps along
+  int getSweepAxis() const;
+
 protected:
 
   // Documentation inherited
@@ -73,11 +89,49 @@ protected:
   // Documentation inherited
   void updateCollisionGroupEngineData() override;
 
+  /// This refreshes the world-frame bounding box of every object in the group,
+  /// and brings the sweep-and-prune ordering up to date. Objects don't move
+  /// much between timesteps, so this is usually a near-linear insertion sort
+  /// over the previous ordering.
+  void updateBroadphase();
+
+  /// This fills `pairs` with the indices (into mCollisionObjects) of every
+  /// pair of objects in this group whose bounding boxes overlap, with i < j,
+  /// sorted in the same order that a brute force double loop would visit them.
+  /// updateBroadphase() must have been called first.
+  void computeOverlappingPairs(
+      std::vector<std::pair<std::size_t, std::size_t>>& pairs) const;
+
+  /// This fills `pairs` with the indices of every object in `group1` (first)
+  /// and `group2` (second) whose bounding boxes overlap, sorted in the same
+  /// order that a brute force double loop would visit them. updateBroadphase()
+  /// must have been called on both groups first.
+  static void computeOverlappingPairs(
+      const DARTCollisionGroup* group1,
+      const DARTCollisionGroup* group2,
+      std::vector<std::pair<std::size_t, std::size_t>>& pairs);
+
 protected:
 
   /// CollisionObjects added to this DARTCollisionGroup
   std::vector<CollisionObject*> mCollisionObjects;
 
+  /// Indices into mCollisionObjects, sorted by the minimum of each object's
+  /// bounding box along mSweepAxis
+  std::vector<std::size_t> mSortedObjects;
+
+  /// The axis we sweep along. We pick whichever axis the objects are most
+  /// spread out along, since that's the one that prunes the most pairs, but
+  /// only switch once another axis is clearly better.
+  int mSweepAxis;
+
+  /// True if objects were added or removed since the last sort, so
+  /// mSortedObjects has to be rebuilt from scratch
+  bool mBroadphaseDirty;
+
+  /// Padding added to every side of each object's bounding box
+  double mBroadphaseMargin;
+
 };
 
 }  // namespace collision
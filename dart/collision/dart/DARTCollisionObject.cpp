@@ -32,18 +32,71 @@
 
 #include "dart/collision/dart/DARTCollisionObject.hpp"
 
+#include <limits>
+
+#include "dart/dynamics/Shape.hpp"
+
 namespace dart {
 namespace collision {
 
 //==============================================================================
 DARTCollisionObject::DARTCollisionObject(
     CollisionDetector* collisionDetector,
-    const dynamics::ShapeFrame* shapeFrame)
-  : CollisionObject(collisionDetector, shapeFrame)
+    const dynamics::ShapeFrame* shapeFrame,
+    std::uint32_t id)
+  : CollisionObject(collisionDetector, shapeFrame),
+    mId(id),
+    mAabbMin(Eigen::Vector3d::Constant(-std::numeric_limits<double>::infinity())),
+    mAabbMax(Eigen::Vector3d::Constant(std::numeric_limits<double>::infinity()))
 {
   // Do nothing
 }
 
+//==============================================================================
+const Eigen::Vector3d& DARTCollisionObject::getAabbMin() const
+{
+  return mAabbMin;
+}
+
+//==============================================================================
+const Eigen::Vector3d& DARTCollisionObject::getAabbMax() const
+{
+  return mAabbMax;
+}
+
+//==============================================================================
+bool DARTCollisionObject::aabbOverlaps(const DARTCollisionObject* other) const
+{
+  return (mAabbMin.array() <= other->mAabbMax.array()).all()
+         && (other->mAabbMin.array() <= mAabbMax.array()).all();
+}
+
+//==============================================================================
+void DARTCollisionObject::updateAabb(double margin)
+{
+  const auto& localBox = getShape()->getBoundingBox();
+  const Eigen::Vector3d localCenter = localBox.computeCenter();
+  const Eigen::Vector3d localHalfExtents = localBox.computeHalfExtents();
+
+  if (!localCenter.allFinite() || !localHalfExtents.allFinite())
+  {
+    // Shapes without a finite bounding box (planes, for example) have to be
+    // checked against everything
+    mAabbMin.setConstant(-std::numeric_limits<double>::infinity());
+    mAabbMax.setConstant(std::numeric_limits<double>::infinity());
+    return;
+  }
+
+  const Eigen::Isometry3d& T = getTransform();
+  const Eigen::Vector3d center = T * localCenter;
+  const Eigen::Vector3d halfExtents
+      = T.linear().cwiseAbs() * localHalfExtents
+        + Eigen::Vector3d::Constant(margin);
+
+  mAabbMin = center - halfExtents;
+  mAabbMax = center + halfExtents;
+}
+
 //==============================================================================
 void DARTCollisionObject::updateEngineData()
 {
@@ -33,6 +33,8 @@
 #ifndef DART_COLLISION_DART_DARTCOLLISIONOBJECT_HPP_
 #define DART_COLLISION_DART_DARTCOLLISIONOBJECT_HPP_
 
+#include <cstdint>
+
 #include <Eigen/Dense>
 #include "dart/collision/CollisionObject.hpp"
 
@@ -46,16 +48,47 @@ class DARTCollisionObject : public CollisionObject
 public:
 
   friend class DARTCollisionDetector;
+  friend class DARTCollisionGroup;
+
+  /// Return the minimum corner of the world-frame axis-aligned bounding box,
+  /// as of the last call to updateAabb()
+  const Eigen::Vector3d& getAabbMin() const;
+
+  /// Return the maximum corner of the world-frame axis-aligned bounding box,
+  /// as of the last call to updateAabb()
+  const Eigen::Vector3d& getAabbMax() const;
+
+  /// Return true if the world-frame bounding boxes of this object and `other`
+  /// overlap, as of the last call to updateAabb() on both
+  bool aabbOverlaps(const DARTCollisionObject* other) const;
 
 protected:
 
   /// Constructor
   DARTCollisionObject(CollisionDetector* collisionDetector,
-                      const dynamics::ShapeFrame* shapeFrame);
+                      const dynamics::ShapeFrame* shapeFrame,
+                      std::uint32_t id);
 
   // Documentation inherited
   void updateEngineData() override;
 
+  /// Recompute the world-frame axis-aligned bounding box from the Shape's
+  /// local bounding box and the current world transform. The box is padded by
+  /// `margin` on every side.
+  void updateAabb(double margin);
+
+protected:
+
+  /// An ID for this object that's unique within its DARTCollisionDetector,
+  /// used to key per-pair caches
+  std::uint32_t mId;
+
+  /// Minimum corner of the world-frame axis-aligned bounding box
+  Eigen::Vector3d mAabbMin;
+
+  /// Maximum corner of the world-frame axis-aligned bounding box
+  Eigen::Vector3d mAabbMax;
+
 };
 
 }  // namespace collision
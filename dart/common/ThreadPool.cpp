@@ -0,0 +1,222 @@
+#include "dart/common/ThreadPool.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <exception>
+
+namespace dart {
+namespace common {
+
+//==============================================================================
+ThreadPool::ThreadPool(int numThreads) : mNumPending(0), mShuttingDown(false)
+{
+  if (numThreads <= 0)
+  {
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  // std::deque's move constructor isn't noexcept, so resize() would try to
+  // copy our (move-only) queues. Constructing the vector in one go avoids that.
+  mWorkerTasks
+      = std::vector<std::deque<std::packaged_task<void(int)>>>(numThreads);
+  mWorkers.reserve(numThreads);
+  for (int i = 0; i < numThreads; i++)
+  {
+    mWorkers.emplace_back(&ThreadPool::workerLoop, this, i);
+  }
+}
+
+//==============================================================================
+ThreadPool::~ThreadPool()
+{
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mShuttingDown = true;
+  }
+  mHasWork.notify_all();
+  for (std::thread& worker : mWorkers)
+  {
+    worker.join();
+  }
+}
+
+//==============================================================================
+/// Returns the number of worker threads in this pool
+int ThreadPool::getNumThreads() const
+{
+  return static_cast<int>(mWorkers.size());
+}
+
+//==============================================================================
+/// This queues up a task to run on any free worker. The task receives the
+/// index of the worker it ends up running on.
+std::future<void> ThreadPool::submit(std::function<void(int worker)> task)
+{
+  std::packaged_task<void(int)> packaged(std::move(task));
+  std::future<void> future = packaged.get_future();
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mTasks.push_back(std::move(packaged));
+    mNumPending++;
+  }
+  mHasWork.notify_one();
+  return future;
+}
+
+//==============================================================================
+/// This queues up a task on `preferredWorker`'s own queue. That worker will
+/// run it unless some other worker runs out of work first and steals it.
+std::future<void> ThreadPool::submitTo(
+    int preferredWorker, std::function<void(int worker)> task)
+{
+  assert(preferredWorker >= 0 && preferredWorker < getNumThreads());
+  std::packaged_task<void(int)> packaged(std::move(task));
+  std::future<void> future = packaged.get_future();
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mWorkerTasks[preferredWorker].push_back(std::move(packaged));
+    mNumPending++;
+  }
+  // We can't wake a specific thread on a shared condition variable, and if we
+  // only woke one it may not be the preferred worker, which would then go
+  // back to sleep with work in its queue.
+  mHasWork.notify_all();
+  return future;
+}
+
+//==============================================================================
+/// This runs `fn(index, worker)` for every index in [0, n), spread across the
+/// workers in the pool, and blocks until all of them have finished.
+void ThreadPool::parallelFor(
+    int n, const std::function<void(int index, int worker)>& fn)
+{
+  if (n <= 0)
+    return;
+
+  // We hand out contiguous chunks rather than single indices, so that the
+  // queue doesn't become the bottleneck when `fn` is cheap.
+  int numChunks = std::min(n, getNumThreads());
+  std::vector<std::future<void>> futures;
+  futures.reserve(numChunks);
+  for (int chunk = 0; chunk < numChunks; chunk++)
+  {
+    int start = (int)(((long)n * chunk) / numChunks);
+    int end = (int)(((long)n * (chunk + 1)) / numChunks);
+    futures.push_back(submit([&fn, start, end](int worker) {
+      for (int i = start; i < end; i++)
+      {
+        fn(i, worker);
+      }
+    }));
+  }
+
+  waitForAll(futures);
+}
+
+//==============================================================================
+/// This is the same as parallelFor(), except that every index is its own
+/// task, and index `i` is always queued on worker `i % getNumThreads()`.
+void ThreadPool::parallelForWithAffinity(
+    int n, const std::function<void(int index, int worker)>& fn)
+{
+  if (n <= 0)
+    return;
+
+  std::vector<std::future<void>> futures;
+  futures.reserve(n);
+  for (int i = 0; i < n; i++)
+  {
+    futures.push_back(submitTo(
+        i % getNumThreads(), [&fn, i](int worker) { fn(i, worker); }));
+  }
+
+  waitForAll(futures);
+}
+
+//==============================================================================
+/// This is the loop that each worker thread runs until the pool shuts down
+void ThreadPool::workerLoop(int worker)
+{
+  while (true)
+  {
+    std::packaged_task<void(int)> task;
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mHasWork.wait(lock, [this] { return mShuttingDown || mNumPending > 0; });
+      if (!popTask(worker, task))
+        return;
+    }
+    task(worker);
+  }
+}
+
+//==============================================================================
+/// This pops the next task for `worker`, first from its own queue, then from
+/// the shared queue, and finally by stealing from another worker's queue.
+bool ThreadPool::popTask(int worker, std::packaged_task<void(int)>& task)
+{
+  std::deque<std::packaged_task<void(int)>>* queue = nullptr;
+  bool fromFront = true;
+  if (!mWorkerTasks[worker].empty())
+  {
+    queue = &mWorkerTasks[worker];
+  }
+  else if (!mTasks.empty())
+  {
+    queue = &mTasks;
+  }
+  else
+  {
+    // Steal from the back, which is the work the owner would get to last
+    int numThreads = getNumThreads();
+    for (int offset = 1; offset < numThreads; offset++)
+    {
+      int victim = (worker + offset) % numThreads;
+      if (!mWorkerTasks[victim].empty())
+      {
+        queue = &mWorkerTasks[victim];
+        fromFront = false;
+        break;
+      }
+    }
+  }
+  if (queue == nullptr)
+    return false;
+
+  if (fromFront)
+  {
+    task = std::move(queue->front());
+    queue->pop_front();
+  }
+  else
+  {
+    task = std::move(queue->back());
+    queue->pop_back();
+  }
+  mNumPending--;
+  return true;
+}
+
+//==============================================================================
+/// This blocks on every future, and rethrows the first exception (if any)
+/// once they've all finished
+void ThreadPool::waitForAll(std::vector<std::future<void>>& futures)
+{
+  std::exception_ptr firstError = nullptr;
+  for (std::future<void>& future : futures)
+  {
+    try
+    {
+      future.get();
+    }
+    catch (...)
+    {
+      if (!firstError)
+        firstError = std::current_exception();
+    }
+  }
+  if (firstError)
+    std::rethrow_exception(firstError);
+}
+
+} // namespace common
+} // namespace dart
@@ -0,0 +1,105 @@
+#ifndef DART_COMMON_THREAD_POOL_HPP_
+#define DART_COMMON_THREAD_POOL_HPP_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dart {
+namespace common {
+
+/// This is a fixed-size pool of worker threads that live for as long as the
+/// pool does. Unlike launching a fresh std::async per task, this lets callers
+/// that hit the same parallel loop thousands of times (batched rollouts,
+/// multiple shooting, etc) pay the thread creation cost exactly once.
+///
+/// Every task is handed the index of the worker that runs it, in [0,
+/// getNumThreads()), so that callers can keep per-worker scratch state (like a
+/// cloned World) without any locking.
+///
+/// Each worker also has its own queue. Tasks submitted with submitTo() go to a
+/// specific worker's queue, so repeated work on the same data keeps landing on
+/// the same core, but an idle worker will steal from the back of a busy
+/// worker's queue rather than sit around waiting.
+class ThreadPool
+{
+public:
+  /// This creates a pool with `numThreads` workers. If `numThreads` is <= 0,
+  /// we use std::thread::hardware_concurrency().
+  explicit ThreadPool(int numThreads = 0);
+
+  /// This blocks until all queued tasks have finished, and then joins all the
+  /// workers.
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /// Returns the number of worker threads in this pool
+  int getNumThreads() const;
+
+  /// This queues up a task to run on any free worker. The task receives the
+  /// index of the worker it ends up running on.
+  std::future<void> submit(std::function<void(int worker)> task);
+
+  /// This queues up a task on `preferredWorker`'s own queue. That worker will
+  /// run it unless some other worker runs out of work first and steals it, so
+  /// the task must not assume which worker it ends up on.
+  std::future<void> submitTo(
+      int preferredWorker, std::function<void(int worker)> task);
+
+  /// This runs `fn(index, worker)` for every index in [0, n), spread across the
+  /// workers in the pool, and blocks until all of them have finished. If any
+  /// call throws, the first exception is rethrown here after every index has
+  /// been processed.
+  void parallelFor(int n, const std::function<void(int index, int worker)>& fn);
+
+  /// This is the same as parallelFor(), except that every index is its own
+  /// task, and index `i` is always queued on worker `i % getNumThreads()`. Use
+  /// this when each index is expensive and touches its own persistent state
+  /// (like one World per shot), so that across calls each index tends to run
+  /// on the same thread and find its state still warm in that core's cache.
+  void parallelForWithAffinity(
+      int n, const std::function<void(int index, int worker)>& fn);
+
+protected:
+  /// This is the loop that each worker thread runs until the pool shuts down
+  void workerLoop(int worker);
+
+  /// This pops the next task for `worker`, first from its own queue, then from
+  /// the shared queue, and finally by stealing from the back of another
+  /// worker's queue. Returns false if there's no work anywhere. Must be called
+  /// with mMutex held.
+  bool popTask(int worker, std::packaged_task<void(int)>& task);
+
+  /// This blocks on every future, and rethrows the first exception (if any)
+  /// once they've all finished
+  static void waitForAll(std::vector<std::future<void>>& futures);
+
+  std::vector<std::thread> mWorkers;
+
+  /// Tasks that any worker may pick up
+  std::deque<std::packaged_task<void(int)>> mTasks;
+
+  /// Tasks queued for a specific worker, indexed by worker
+  std::vector<std::deque<std::packaged_task<void(int)>>> mWorkerTasks;
+
+  /// The total number of tasks waiting in mTasks and mWorkerTasks
+  int mNumPending;
+
+  std::mutex mMutex;
+
+  std::condition_variable mHasWork;
+
+  bool mShuttingDown;
+};
+
+} // namespace common
+} // namespace dart
+
+#endif
@@ -0,0 +1,197 @@
+#include "dart/constraint/BlockSparseDelassus.hpp"
+
+#include "dart/constraint/ConstrainedGroup.hpp"
+#include "dart/constraint/ContactConstraint.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+
+namespace dart {
+namespace constraint {
+
+//==============================================================================
+BlockSparseDelassus::BlockSparseDelassus() : mDimension(0)
+{
+  // Do nothing
+}
+
+//==============================================================================
+/// This recomputes A for `group`. `offsets` gives the first row of A for
+/// each constraint in the group.
+void BlockSparseDelassus::build(
+    ConstrainedGroup& group, const Eigen::VectorXi& offsets)
+{
+  const std::size_t numConstraints = group.getNumConstraints();
+  mDimension = group.getTotalDimension();
+  mOffsets = offsets;
+  mBlocks.clear();
+  mBlockIndex.clear();
+  mConstraintDims.resize(numConstraints);
+
+  // Collect the constraints that touch each skeleton, in order
+  for (std::size_t i = 0; i < numConstraints; ++i)
+  {
+    const ConstraintBasePtr& constraint = group.getConstraint(i);
+    assert(dynamic_cast<ContactConstraint*>(constraint.get()) != nullptr);
+    mConstraintDims[i] = constraint->getDimension();
+
+    for (const dynamics::SkeletonPtr& skel : constraint->getSkeletons())
+    {
+      auto found = mBlockIndex.find(skel.get());
+      if (found == mBlockIndex.end())
+      {
+        found = mBlockIndex.emplace(skel.get(), mBlocks.size()).first;
+        mBlocks.emplace_back();
+        mBlocks.back().skeleton = skel.get();
+      }
+      SkeletonBlock& block = mBlocks[found->second];
+      // Self-collisions list the same skeleton twice
+      if (!block.constraints.empty() && block.constraints.back() == i)
+        continue;
+      block.rows.push_back(
+          block.constraints.empty()
+              ? 0
+              : block.rows.back() + mConstraintDims[block.constraints.back()]);
+      block.constraints.push_back(i);
+    }
+  }
+
+  for (SkeletonBlock& block : mBlocks)
+  {
+    const std::size_t numRows
+        = block.rows.back() + mConstraintDims[block.constraints.back()];
+
+    // Stack the J^T blocks for every constraint touching this skeleton
+    Eigen::MatrixXd jacT(block.skeleton->getNumDofs(), numRows);
+    for (std::size_t k = 0; k < block.constraints.size(); ++k)
+    {
+      const ContactConstraint* contact = static_cast<const ContactConstraint*>(
+          group.getConstraint(block.constraints[k]).get());
+      jacT.middleCols(block.rows[k], mConstraintDims[block.constraints[k]])
+          = contact->getImpulseJacobian(block.skeleton).transpose();
+    }
+
+    // One M^{-1} (which the Skeleton caches) stands in for an articulated body
+    // impulse propagation per constraint dimension
+    block.impulseResponse = block.skeleton->getInvMassMatrix() * jacT;
+    block.block = jacT.transpose() * block.impulseResponse;
+  }
+}
+
+//==============================================================================
+/// Returns the number of rows (and columns) of A
+std::size_t BlockSparseDelassus::getDimension() const
+{
+  return mDimension;
+}
+
+//==============================================================================
+/// Returns the number of entries we're storing, summed over all the blocks
+std::size_t BlockSparseDelassus::getNumStoredEntries() const
+{
+  std::size_t entries = 0;
+  for (const SkeletonBlock& block : mBlocks)
+  {
+    entries += block.block.size();
+  }
+  return entries;
+}
+
+//==============================================================================
+/// This multiplies the diagonal of A by (1 + cfm)
+void BlockSparseDelassus::applyConstraintForceMixing(double cfm)
+{
+  // Every block that touches a row holds part of that row's diagonal entry, so
+  // scaling each part scales the sum
+  for (SkeletonBlock& block : mBlocks)
+  {
+    block.block.diagonal() *= (1.0 + cfm);
+  }
+}
+
+//==============================================================================
+/// This adds A into the top left (n x n) block of a dense matrix
+void BlockSparseDelassus::addTo(RowMajorMatrix& dense) const
+{
+  for (const SkeletonBlock& block : mBlocks)
+  {
+    for (std::size_t a = 0; a < block.constraints.size(); ++a)
+    {
+      const std::size_t dimA = mConstraintDims[block.constraints[a]];
+      for (std::size_t b = 0; b < block.constraints.size(); ++b)
+      {
+        const std::size_t dimB = mConstraintDims[block.constraints[b]];
+        dense.block(
+            mOffsets[block.constraints[a]],
+            mOffsets[block.constraints[b]],
+            dimA,
+            dimB)
+            += block.block.block(block.rows[a], block.rows[b], dimA, dimB);
+      }
+    }
+  }
+}
+
+//==============================================================================
+/// This returns A as an Eigen sparse matrix, with one row per constraint
+/// dimension
+BlockSparseDelassus::SparseMatrix BlockSparseDelassus::toSparse() const
+{
+  std::vector<Eigen::Triplet<double>> triplets;
+  triplets.reserve(getNumStoredEntries());
+  for (const SkeletonBlock& block : mBlocks)
+  {
+    for (std::size_t a = 0; a < block.constraints.size(); ++a)
+    {
+      const std::size_t dimA = mConstraintDims[block.constraints[a]];
+      for (std::size_t b = 0; b < block.constraints.size(); ++b)
+      {
+        const std::size_t dimB = mConstraintDims[block.constraints[b]];
+        for (std::size_t r = 0; r < dimA; ++r)
+        {
+          for (std::size_t c = 0; c < dimB; ++c)
+          {
+            triplets.emplace_back(
+                mOffsets[block.constraints[a]] + r,
+                mOffsets[block.constraints[b]] + c,
+                block.block(block.rows[a] + r, block.rows[b] + c));
+          }
+        }
+      }
+    }
+  }
+
+  // setFromTriplets() sums duplicates, which is exactly what we want for
+  // constraints that share more than one skeleton
+  SparseMatrix sparse(mDimension, mDimension);
+  sparse.setFromTriplets(triplets.begin(), triplets.end());
+  return sparse;
+}
+
+//==============================================================================
+/// Returns the per-skeleton blocks
+const std::vector<BlockSparseDelassus::SkeletonBlock>&
+BlockSparseDelassus::getBlocks() const
+{
+  return mBlocks;
+}
+
+//==============================================================================
+/// This returns `skel`'s velocity change in response to a unit impulse
+/// along each dimension of constraint `constraintIndex`.
+Eigen::MatrixXd BlockSparseDelassus::getImpulseResponse(
+    std::size_t constraintIndex, const dynamics::Skeleton* skel) const
+{
+  const SkeletonBlock& block = mBlocks[mBlockIndex.at(skel)];
+  for (std::size_t k = 0; k < block.constraints.size(); ++k)
+  {
+    if (block.constraints[k] == constraintIndex)
+    {
+      return block.impulseResponse.middleCols(
+          block.rows[k], mConstraintDims[constraintIndex]);
+    }
+  }
+  assert(false && "Constraint doesn't touch this skeleton");
+  return Eigen::MatrixXd::Zero(skel->getNumDofs(), 0);
+}
+
+} // namespace constraint
+} // namespace dart
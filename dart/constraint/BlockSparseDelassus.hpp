@@ -0,0 +1,108 @@
+#ifndef DART_CONSTRAINT_BLOCKSPARSEDELASSUS_HPP_
+#define DART_CONSTRAINT_BLOCKSPARSEDELASSUS_HPP_
+
+#include <unordered_map>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <Eigen/SparseCore>
+
+namespace dart {
+
+namespace dynamics {
+class Skeleton;
+}
+
+namespace constraint {
+
+class ConstrainedGroup;
+
+/// This is the Delassus matrix A = J * M^{-1} * J^T of a group of contacts,
+/// stored block-sparse.
+///
+/// Two contacts only interact through a skeleton they both touch, so rather
+/// than one dense (n x n) matrix we keep one dense block per skeleton, over
+/// just the constraint dimensions that touch that skeleton. A is the sum of
+/// those blocks. Each contact touches at most two skeletons, so in a pile of
+/// objects the storage (and the cost of a product with A) grows with the
+/// number of contacts per object, rather than with the square of the total
+/// number of contacts.
+///
+/// Every constraint in the group must be a ContactConstraint.
+class BlockSparseDelassus
+{
+public:
+  typedef Eigen::SparseMatrix<double, Eigen::RowMajor> SparseMatrix;
+  typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+      RowMajorMatrix;
+
+  /// This is the block of A contributed by a single skeleton
+  struct SkeletonBlock
+  {
+    const dynamics::Skeleton* skeleton;
+
+    /// The indices (into the group) of the constraints touching this skeleton
+    std::vector<std::size_t> constraints;
+
+    /// The first row of `block` for each entry in `constraints`
+    std::vector<std::size_t> rows;
+
+    /// J_s * M_s^{-1} * J_s^T, over just `constraints`
+    Eigen::MatrixXd block;
+
+    /// M_s^{-1} * J_s^T, which is this skeleton's velocity change in response
+    /// to a unit impulse along each dimension of `constraints`
+    Eigen::MatrixXd impulseResponse;
+  };
+
+  /// Creates an empty (0 x 0) matrix
+  BlockSparseDelassus();
+
+  /// This recomputes A for `group`. `offsets` gives the first row of A for
+  /// each constraint in the group.
+  void build(ConstrainedGroup& group, const Eigen::VectorXi& offsets);
+
+  /// Returns the number of rows (and columns) of A
+  std::size_t getDimension() const;
+
+  /// Returns the number of entries we're storing, summed over all the blocks
+  std::size_t getNumStoredEntries() const;
+
+  /// This multiplies the diagonal of A by (1 + cfm), matching the constraint
+  /// force mixing ContactConstraint applies during impulse tests
+  void applyConstraintForceMixing(double cfm);
+
+  /// This adds A into the top left (n x n) block of a dense matrix
+  void addTo(RowMajorMatrix& dense) const;
+
+  /// This returns A as an Eigen sparse matrix, with one row per constraint
+  /// dimension
+  SparseMatrix toSparse() const;
+
+  /// Returns the per-skeleton blocks
+  const std::vector<SkeletonBlock>& getBlocks() const;
+
+  /// This returns `skel`'s velocity change in response to a unit impulse
+  /// along each dimension of constraint `constraintIndex`, as a (dofs x dim)
+  /// matrix. `skel` must be one of the skeletons that constraint touches.
+  Eigen::MatrixXd getImpulseResponse(
+      std::size_t constraintIndex, const dynamics::Skeleton* skel) const;
+
+protected:
+  std::size_t mDimension;
+
+  Eigen::VectorXi mOffsets;
+
+  std::vector<SkeletonBlock> mBlocks;
+
+  /// Maps a skeleton to its index in mBlocks
+  std::unordered_map<const dynamics::Skeleton*, std::size_t> mBlockIndex;
+
+  /// For every constraint, the dimension of that constraint
+  std::vector<std::size_t> mConstraintDims;
+};
+
+} // namespace constraint
+} // namespace dart
+
+#endif
@@ -45,6 +45,8 @@
 #include "dart/constraint/DantzigBoxedLcpSolver.hpp"
 #include "dart/constraint/LCPUtils.hpp"
 #include "dart/constraint/PgsBoxedLcpSolver.hpp"
+#include "dart/dynamics/Joint.hpp"
+#include "dart/dynamics/Skeleton.hpp"
 #include "dart/external/odelcpsolver/lcp.h"
 #include "dart/lcpsolver/Lemke.hpp"
 #include "dart/neural/ConstrainedGroupGradientMatrices.hpp"
@@ -86,7 +88,9 @@ BoxedLcpConstraintSolver::BoxedLcpConstraintSolver(
 //==============================================================================
 BoxedLcpConstraintSolver::BoxedLcpConstraintSolver(
     BoxedLcpSolverPtr boxedLcpSolver, BoxedLcpSolverPtr secondaryBoxedLcpSolver)
-  : ConstraintSolver()
+  : ConstraintSolver(),
+    mBatchedImpulseTestsEnabled(true),
+    mSparseLcpThreshold(100)
 {
   if (boxedLcpSolver)
   {
@@ -184,6 +188,30 @@ void BoxedLcpConstraintSolver::setCachedLCPSolution(Eigen::VectorXd X)
   mX = X;
 }
 
+//==============================================================================
+void BoxedLcpConstraintSolver::setBatchedImpulseTestsEnabled(bool enabled)
+{
+  mBatchedImpulseTestsEnabled = enabled;
+}
+
+//==============================================================================
+bool BoxedLcpConstraintSolver::getBatchedImpulseTestsEnabled() const
+{
+  return mBatchedImpulseTestsEnabled;
+}
+
+//==============================================================================
+void BoxedLcpConstraintSolver::setSparseLcpThreshold(std::size_t threshold)
+{
+  mSparseLcpThreshold = threshold;
+}
+
+//==============================================================================
+std::size_t BoxedLcpConstraintSolver::getSparseLcpThreshold() const
+{
+  return mSparseLcpThreshold;
+}
+
 //==============================================================================
 void BoxedLcpConstraintSolver::solveConstrainedGroup(
     ConstrainedGroup& group, simulation::World* world)
@@ -197,11 +225,6 @@ void BoxedLcpConstraintSolver::solveConstrainedGroup(
     return;
 
   const int nSkip = dPAD(n); // nSkip = n + (n % 4);
-#ifdef NDEBUG                // release
-  mA.resize(n, nSkip);
-#else // debug
-  mA.setZero(n, nSkip); // rows = n, cols = n + (n % 4)
-#endif
   bool mXResized = mX.size() != n;
   if (mXResized)
   {
@@ -224,6 +247,13 @@ void BoxedLcpConstraintSolver::solveConstrainedGroup(
     mOffset[i] = mOffset[i - 1] + constraint->getDimension();
   }
 
+  const bool batched = canBatchImpulseTests(group);
+
+  // The impulse tests write straight into mA, but batched groups may never
+  // need it, so those only allocate it once the sparse path has been ruled out
+  if (!batched)
+    allocateLcpMatrix(n);
+
   // For each constraint
   ConstraintInfo constInfo;
   constInfo.invTimeStep = 1.0 / mTimeStep;
@@ -249,10 +279,20 @@ void BoxedLcpConstraintSolver::solveConstrainedGroup(
       group.getGradientConstraintMatrices()->registerConstraint(constraint);
     }
 
+    if (batched)
+    {
+      // Adjust findex for global index. mA gets filled in all at once below.
+      for (std::size_t j = 0; j < constraint->getDimension(); ++j)
+      {
+        if (mFIndex[mOffset[i] + j] >= 0)
+          mFIndex[mOffset[i] + j] += mOffset[i];
+      }
+      continue;
+    }
+
     // Fill a matrix by impulse tests: A
     constraint->excite();
 
-    double* impulses = new double[constraint->getDimension()];
     for (std::size_t j = 0; j < constraint->getDimension(); ++j)
     {
       // Adjust findex for global index
@@ -319,7 +359,6 @@ void BoxedLcpConstraintSolver::solveConstrainedGroup(
             constraint, j);
       }
     }
-    delete[] impulses;
 
     assert(isSymmetric(
         n, mA.data(), mOffset[i], mOffset[i] + constraint->getDimension() - 1));
@@ -327,6 +366,26 @@ void BoxedLcpConstraintSolver::solveConstrainedGroup(
     constraint->unexcite();
   }
 
+  if (batched)
+  {
+    buildDelassus(group);
+    if (group.getGradientConstraintMatrices())
+      measureConstraintImpulsesBatched(group);
+
+    // Large groups skip the dense matrix entirely, unless the sparse solve
+    // fails. That's only worth trying if the primary solver can actually work
+    // on a sparse matrix, otherwise it'd just densify it again.
+    if (n >= mSparseLcpThreshold && mBoxedLcpSolver->hasSparseSolve()
+        && solveSparse(group, world, mXResized))
+    {
+      applyConstraintImpulses(group);
+      return;
+    }
+
+    allocateLcpMatrix(n);
+    fillLcpMatrixBatched(group);
+  }
+
   assert(isSymmetric(n, mA.data()));
 
   // Print LCP formulation
@@ -664,7 +723,171 @@ void BoxedLcpConstraintSolver::solveConstrainedGroup(
   }
 
   // Apply constraint impulses
-  for (std::size_t i = 0; i < numConstraints; ++i)
+  applyConstraintImpulses(group);
+}
+
+//==============================================================================
+bool BoxedLcpConstraintSolver::canBatchImpulseTests(ConstrainedGroup& group)
+{
+  if (!mBatchedImpulseTestsEnabled)
+    return false;
+
+  std::size_t numDofs = 0;
+  std::unordered_map<const dynamics::Skeleton*, bool> seen;
+  for (std::size_t i = 0; i < group.getNumConstraints(); ++i)
+  {
+    const ConstraintBasePtr& constraint = group.getConstraint(i);
+    if (dynamic_cast<ContactConstraint*>(constraint.get()) == nullptr)
+      return false;
+
+    for (const dynamics::SkeletonPtr& skel : constraint->getSkeletons())
+    {
+      if (seen.count(skel.get()))
+        continue;
+      seen[skel.get()] = true;
+      numDofs += skel->getNumDofs();
+
+      for (std::size_t j = 0; j < skel->getNumJoints(); ++j)
+      {
+        const dynamics::Joint* joint = skel->getJoint(j);
+        if (joint->getNumDofs() > 0 && !joint->isDynamic())
+          return false;
+      }
+    }
+  }
+
+  // Computing M^{-1} costs about one impulse propagation per DOF, so this only
+  // pays for itself when there are at least as many constraint dimensions as
+  // DOFs. When we're recording gradients, ConstrainedGroupGradientMatrices has
+  // already asked every skeleton for M^{-1}, so it's always cheaper.
+  return group.getGradientConstraintMatrices() != nullptr
+         || group.getTotalDimension() >= numDofs;
+}
+
+//==============================================================================
+void BoxedLcpConstraintSolver::allocateLcpMatrix(std::size_t n)
+{
+  const int nSkip = dPAD(n); // nSkip = n + (n % 4);
+#ifdef NDEBUG                // release
+  mA.resize(n, nSkip);
+#else // debug
+  mA.setZero(n, nSkip); // rows = n, cols = n + (n % 4)
+#endif
+}
+
+//==============================================================================
+void BoxedLcpConstraintSolver::buildDelassus(ConstrainedGroup& group)
+{
+  mDelassus.build(group, mOffset);
+
+  // This matches the CFM that ContactConstraint::getVelocityChange() adds to
+  // the diagonal during impulse tests
+  if (mConstraintForceMixingEnabled)
+  {
+    mDelassus.applyConstraintForceMixing(
+        ContactConstraint::getConstraintForceMixing());
+  }
+}
+
+//==============================================================================
+void BoxedLcpConstraintSolver::fillLcpMatrixBatched(ConstrainedGroup& group)
+{
+  const std::size_t n = group.getTotalDimension();
+
+  mA.block(0, 0, n, n).setZero();
+  mDelassus.addTo(mA);
+}
+
+//==============================================================================
+void BoxedLcpConstraintSolver::measureConstraintImpulsesBatched(
+    ConstrainedGroup& group)
+{
+  std::shared_ptr<neural::ConstrainedGroupGradientMatrices> grads
+      = group.getGradientConstraintMatrices();
+  for (std::size_t i = 0; i < group.getNumConstraints(); ++i)
+  {
+    const ConstraintBasePtr& constraint = group.getConstraint(i);
+    std::vector<Eigen::MatrixXd> responses;
+    for (const dynamics::SkeletonPtr& skel : constraint->getSkeletons())
+    {
+      responses.push_back(mDelassus.getImpulseResponse(i, skel.get()));
+    }
+    for (std::size_t j = 0; j < constraint->getDimension(); ++j)
+    {
+      std::vector<Eigen::VectorXd> skelVelocityChanges;
+      for (const Eigen::MatrixXd& response : responses)
+      {
+        skelVelocityChanges.push_back(response.col(j));
+      }
+      grads->measureConstraintImpulse(constraint, skelVelocityChanges);
+    }
+  }
+}
+
+//==============================================================================
+bool BoxedLcpConstraintSolver::solveSparse(
+    ConstrainedGroup& group, simulation::World* world, bool xResized)
+{
+  std::shared_ptr<neural::ConstrainedGroupGradientMatrices> grads
+      = group.getGradientConstraintMatrices();
+
+  // This is the same pre-solve as the dense path: if nothing has changed
+  // categories since the last step, the gradient matrices can produce an exact
+  // solution in a single solve.
+  if (grads)
+  {
+    grads->registerLCPResults(mX, mHi, mLo, mFIndex, mB, mDelassus, false);
+    grads->constructMatrices(world);
+    if (grads->areResultsStandardized())
+    {
+      mX = grads->getContactConstraintImpluses();
+      return true;
+    }
+  }
+
+  const BlockSparseDelassus::SparseMatrix A = mDelassus.toSparse();
+
+  // We don't have the dense A that LCPUtils::guessSolution() needs, so a
+  // fresh problem just starts from zero
+  if (xResized)
+    mX.setZero();
+
+  std::vector<BoxedLcpSolver*> solvers;
+  solvers.push_back(mBoxedLcpSolver.get());
+  if (mSecondaryBoxedLcpSolver && mSecondaryBoxedLcpSolver->hasSparseSolve())
+    solvers.push_back(mSecondaryBoxedLcpSolver.get());
+
+  for (std::size_t i = 0; i < solvers.size(); ++i)
+  {
+    Eigen::VectorXd x = mX;
+    Eigen::VectorXd b = mB;
+    Eigen::VectorXd lo = mLo;
+    Eigen::VectorXd hi = mHi;
+    Eigen::VectorXi fIndex = mFIndex;
+    const bool earlyTermination = (i + 1 < solvers.size());
+    bool success = solvers[i]->solveSparse(
+        A, x, b, 0, lo, hi, fIndex, earlyTermination);
+    if (success && !x.hasNaN()
+        && LCPUtils::isLCPSolutionValid(A, x, mB, mHi, mLo, mFIndex, false))
+    {
+      mX = x;
+      if (grads)
+      {
+        grads->registerLCPResults(mX, mHi, mLo, mFIndex, mB, mDelassus, false);
+        grads->constructMatrices(world);
+        if (grads->areResultsStandardized())
+          mX = grads->getContactConstraintImpluses();
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+//==============================================================================
+void BoxedLcpConstraintSolver::applyConstraintImpulses(ConstrainedGroup& group)
+{
+  for (std::size_t i = 0; i < group.getNumConstraints(); ++i)
   {
     const ConstraintBasePtr& constraint = group.getConstraint(i);
     if (constraint->isContactConstraint())
@@ -33,6 +33,7 @@
 #ifndef DART_CONSTRAINT_BOXEDLCPCONSTRAINTSOLVER_HPP_
 #define DART_CONSTRAINT_BOXEDLCPCONSTRAINTSOLVER_HPP_
 
+#include "dart/constraint/BlockSparseDelassus.hpp"
 #include "dart/constraint/ConstraintSolver.hpp"
 #include "dart/constraint/SmartPointer.hpp"
 
@@ -112,11 +113,74 @@ public:
   /// our optimistic LCP-stabilization-to-acceptance approach.
   virtual void setCachedLCPSolution(Eigen::VectorXd X) override;
 
+  /// If this is true (the default), then when a constrained group is made up
+  /// entirely of contacts we build the LCP matrix as J * M^{-1} * J^T, with one
+  /// inverse mass matrix per skeleton, rather than running an articulated body
+  /// impulse propagation for every single constraint dimension. Turning this
+  /// off always uses per-dimension impulse tests, which is mostly useful for
+  /// testing.
+  void setBatchedImpulseTestsEnabled(bool enabled);
+
+  /// Returns true if we build the LCP matrix for contact-only groups from the
+  /// skeletons' inverse mass matrices.
+  bool getBatchedImpulseTestsEnabled() const;
+
+  /// Contact-only groups with at least this many constraint dimensions skip
+  /// the dense LCP matrix. They keep the BlockSparseDelassus, and are solved
+  /// with BoxedLcpSolver::solveSparse(). Groups recording gradients hand the
+  /// same BlockSparseDelassus to their ConstrainedGroupGradientMatrices. If
+  /// the sparse solve fails, we fall back to the usual dense path. Defaults to
+  /// 100.
+  ///
+  /// This only applies when the primary solver hasSparseSolve(), which both
+  /// PGS and Dantzig do.
+  void setSparseLcpThreshold(std::size_t threshold);
+
+  /// Returns the number of constraint dimensions at which contact-only groups
+  /// switch to the sparse LCP path
+  std::size_t getSparseLcpThreshold() const;
+
 protected:
   // Documentation inherited.
   void solveConstrainedGroup(
       ConstrainedGroup& group, simulation::World* world) override;
 
+  /// Returns true if we can (and should) fill in mA for this group with
+  /// fillLcpMatrixBatched() instead of one impulse test per dimension. That
+  /// requires every constraint to be a ContactConstraint, and every DOF they
+  /// touch to be dynamic, since the impulse tests leave kinematic joints'
+  /// velocities untouched but M^{-1} doesn't.
+  bool canBatchImpulseTests(ConstrainedGroup& group);
+
+  /// This sizes mA for a group with `n` constraint dimensions
+  void allocateLcpMatrix(std::size_t n);
+
+  /// This computes mDelassus for a group that canBatchImpulseTests(),
+  /// including constraint force mixing
+  void buildDelassus(ConstrainedGroup& group);
+
+  /// This fills the top left (n x n) block of mA from mDelassus. The result
+  /// matches what the impulse tests would have produced.
+  void fillLcpMatrixBatched(ConstrainedGroup& group);
+
+  /// This reports the velocity change for every constraint dimension to the
+  /// group's gradient matrices, reading it off mDelassus instead of running
+  /// impulse tests
+  void measureConstraintImpulsesBatched(ConstrainedGroup& group);
+
+  /// This solves the LCP straight from mDelassus, without ever forming a dense
+  /// matrix, trying the primary and then the secondary solver. A secondary
+  /// solver without a sparse path is skipped, since the dense path will try it
+  /// anyway. The primary solver must hasSparseSolve(). If the group records
+  /// gradients, this runs the same pre-solve and registers the same results
+  /// as the dense path, but hands over mDelassus instead of a dense A. Returns
+  /// true, with the solution in mX, only if we produced a valid solution.
+  bool solveSparse(
+      ConstrainedGroup& group, simulation::World* world, bool xResized);
+
+  /// This applies the impulses in mX to the constraints in the group
+  void applyConstraintImpulses(ConstrainedGroup& group);
+
   /// Boxed LCP solver
   BoxedLcpSolverPtr mBoxedLcpSolver;
   // TODO(JS): Hold as unique_ptr because there is no reason to share. Make this
@@ -170,6 +234,17 @@ protected:
   /// Cache data for boxed LCP formulation
   Eigen::VectorXi mOffset;
 
+  /// If true, contact-only groups build mA from inverse mass matrices instead
+  /// of per-dimension impulse tests
+  bool mBatchedImpulseTestsEnabled;
+
+  /// Contact-only groups at least this big are solved from mDelassus
+  std::size_t mSparseLcpThreshold;
+
+  /// Block-sparse J * M^{-1} * J^T for the current group, when every
+  /// constraint in it is a contact
+  BlockSparseDelassus mDelassus;
+
 #ifndef NDEBUG
 private:
   /// Return true if the matrix is symmetric
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "dart/constraint/BoxedLcpSolver.hpp"
+
+#include "dart/external/odelcpsolver/matrix.h"
+
+namespace dart {
+namespace constraint {
+
+//==============================================================================
+bool BoxedLcpSolver::solveSparse(
+    const Eigen::SparseMatrix<double, Eigen::RowMajor>& A,
+    Eigen::VectorXd& x,
+    Eigen::VectorXd& b,
+    int nub,
+    Eigen::VectorXd& lo,
+    Eigen::VectorXd& hi,
+    Eigen::VectorXi& findex,
+    bool earlyTermination)
+{
+  const int n = A.rows();
+
+  typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+      RowMajorMatrix;
+
+  // solve() expects a row-major matrix with every row padded to dPAD(n)
+  RowMajorMatrix dense = RowMajorMatrix::Zero(n, dPAD(n));
+  dense.block(0, 0, n, n) = A;
+
+  return solve(
+      n,
+      dense.data(),
+      x.data(),
+      b.data(),
+      nub,
+      lo.data(),
+      hi.data(),
+      findex.data(),
+      earlyTermination);
+}
+
+//==============================================================================
+bool BoxedLcpSolver::hasSparseSolve() const
+{
+  return false;
+}
+
+} // namespace constraint
+} // namespace dart
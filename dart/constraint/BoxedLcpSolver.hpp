@@ -35,6 +35,7 @@
 
 #include <string>
 #include <Eigen/Core>
+#include <Eigen/SparseCore>
 
 namespace dart {
 namespace constraint {
@@ -101,6 +102,31 @@ public:
       bool earlyTermination = false)
       = 0;
 
+  /// This solves the same LCP as solve(), but with a sparse A (which doesn't
+  /// need any padding). `x` is read as the initial guess and overwritten with
+  /// the solution. `b`, `lo` and `hi` may be modified.
+  ///
+  /// The default implementation just copies A into a dense matrix and calls
+  /// solve(), since pivoting fills in A as it goes anyway. Solvers that can
+  /// avoid the dense matrix (for at least some problems) should override
+  /// this, and hasSparseSolve().
+  ///
+  /// \return Success.
+  virtual bool solveSparse(
+      const Eigen::SparseMatrix<double, Eigen::RowMajor>& A,
+      Eigen::VectorXd& x,
+      Eigen::VectorXd& b,
+      int nub,
+      Eigen::VectorXd& lo,
+      Eigen::VectorXd& hi,
+      Eigen::VectorXi& findex,
+      bool earlyTermination = false);
+
+  /// Returns true if solveSparse() works on the sparse matrix directly, rather
+  /// than copying it into a dense one. Callers that would rather build the
+  /// dense matrix themselves can use this to skip the sparse path.
+  virtual bool hasSparseSolve() const;
+
 #ifndef NDEBUG
   virtual bool canSolve(int n, const double* A) = 0;
 #endif
@@ -571,6 +571,24 @@ void ContactConstraint::applyUnitImpulse(std::size_t index)
   mAppliedImpulseIndex = index;
 }
 
+//==============================================================================
+Eigen::MatrixXd ContactConstraint::getImpulseJacobian(
+    const dynamics::Skeleton* skel) const
+{
+  Eigen::MatrixXd jac = Eigen::MatrixXd::Zero(mDim, skel->getNumDofs());
+
+  // This mirrors applyUnitImpulse() and getVelocityChange(): the impulse is
+  // applied as a body-frame spatial impulse along mSpatialNormal, and the
+  // velocity change is read back along the same directions.
+  if (mBodyNodeA->isReactive() && mBodyNodeA->getSkeleton().get() == skel)
+    jac += mSpatialNormalA.transpose() * skel->getJacobian(mBodyNodeA.get());
+
+  if (mBodyNodeB->isReactive() && mBodyNodeB->getSkeleton().get() == skel)
+    jac += mSpatialNormalB.transpose() * skel->getJacobian(mBodyNodeB.get());
+
+  return jac;
+}
+
 //==============================================================================
 void ContactConstraint::getVelocityChange(double* vel, bool withCfm)
 {
@@ -162,6 +162,15 @@ public:
 
   using TangentBasisMatrix = Eigen::Matrix<double, 3, 2>;
 
+  /// This returns the (getDimension() x skel->getNumDofs()) Jacobian of this
+  /// contact's relative velocities with respect to `skel`'s generalized
+  /// velocities. Its transpose maps a unit impulse along each contact
+  /// dimension to the generalized impulse it applies to `skel`, so
+  /// J * M^{-1} * J^T gives the same block of the LCP matrix that an impulse
+  /// test would. Only reactive bodies contribute, and if neither body belongs
+  /// to `skel` this is all zeros.
+  Eigen::MatrixXd getImpulseJacobian(const dynamics::Skeleton* skel) const;
+
   /// Get change in relative velocity at contact point due to external impulse
   /// \param[out] relVel Change in relative velocity at contact point of the
   /// two colliding bodies.
@@ -32,6 +32,13 @@
 
 #include "dart/constraint/DantzigBoxedLcpSolver.hpp"
 
+#include <cmath>
+#include <vector>
+
+#include <Eigen/SparseCholesky>
+
+#include "dart/constraint/LCPUtils.hpp"
+
 #include "dart/external/odelcpsolver/lcp.h"
 
 namespace dart {
@@ -74,6 +81,112 @@ bool DantzigBoxedLcpSolver::solve(
   }
 }
 
+//==============================================================================
+bool DantzigBoxedLcpSolver::solveSparse(
+    const Eigen::SparseMatrix<double, Eigen::RowMajor>& A,
+    Eigen::VectorXd& x,
+    Eigen::VectorXd& b,
+    int nub,
+    Eigen::VectorXd& lo,
+    Eigen::VectorXd& hi,
+    Eigen::VectorXi& findex,
+    bool earlyTermination)
+{
+  // How close x has to be to a bound for us to guess it's sitting on it
+  const double BOUND_EPS = 1e-9;
+
+  const int n = A.rows();
+
+  // Guess the active set from the initial x. Variables strictly between their
+  // bounds are free (w = 0), and everything else stays fixed where it is.
+  std::vector<int> freeIndex(n, -1);
+  std::vector<int> freeVars;
+  Eigen::VectorXd guess = Eigen::VectorXd::Zero(n);
+  bool canGuess = nub == 0;
+  for (int i = 0; canGuess && i < n; i++)
+  {
+    double hi_tmp = hi(i);
+    double lo_tmp = lo(i);
+    if (findex(i) >= 0)
+    {
+      hi_tmp = std::abs(hi(i) * x(findex(i)));
+      lo_tmp = -hi_tmp;
+    }
+
+    if (x(i) > lo_tmp + BOUND_EPS && x(i) < hi_tmp - BOUND_EPS)
+    {
+      freeIndex[i] = freeVars.size();
+      freeVars.push_back(i);
+    }
+    else
+    {
+      guess(i) = (x(i) - lo_tmp < hi_tmp - x(i)) ? lo_tmp : hi_tmp;
+    }
+  }
+  // Friction pinned at a bound scales with its normal force, so a free normal
+  // would couple the two. That isn't a plain linear solve anymore, so leave it
+  // to the pivoting.
+  for (int i = 0; canGuess && i < n; i++)
+  {
+    if (findex(i) >= 0 && freeIndex[i] == -1 && guess(i) != 0
+        && freeIndex[findex(i)] != -1)
+    {
+      canGuess = false;
+    }
+  }
+
+  if (canGuess && !freeVars.empty())
+  {
+    // A_FF * x_F = b_F - A_FB * x_B
+    const int numFree = freeVars.size();
+    std::vector<Eigen::Triplet<double>> triplets;
+    Eigen::VectorXd rhs(numFree);
+    for (int f = 0; f < numFree; f++)
+    {
+      const int i = freeVars[f];
+      rhs(f) = b(i);
+      for (Eigen::SparseMatrix<double, Eigen::RowMajor>::InnerIterator it(A, i);
+           it;
+           ++it)
+      {
+        if (freeIndex[it.col()] != -1)
+          triplets.emplace_back(f, freeIndex[it.col()], it.value());
+        else
+          rhs(f) -= it.value() * guess(it.col());
+      }
+    }
+    Eigen::SparseMatrix<double> A_FF(numFree, numFree);
+    A_FF.setFromTriplets(triplets.begin(), triplets.end());
+
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> ldlt(A_FF);
+    if (ldlt.info() == Eigen::Success)
+    {
+      const Eigen::VectorXd x_F = ldlt.solve(rhs);
+      for (int f = 0; f < numFree; f++)
+      {
+        guess(freeVars[f]) = x_F(f);
+      }
+    }
+  }
+
+  if (canGuess && !guess.hasNaN()
+      && LCPUtils::isLCPSolutionValid(A, guess, b, hi, lo, findex, false))
+  {
+    x = guess;
+    return true;
+  }
+
+  // The active set changed, so we need the pivoting after all
+  return BoxedLcpSolver::solveSparse(
+      A, x, b, nub, lo, hi, findex, earlyTermination);
+}
+
+//==============================================================================
+bool DantzigBoxedLcpSolver::hasSparseSolve() const
+{
+  return true;
+}
+
 #ifndef NDEBUG
 //==============================================================================
 bool DantzigBoxedLcpSolver::canSolve(int /*n*/, const double* /*A*/)
@@ -59,6 +59,24 @@ public:
       int* findex,
       bool earlyTermination) override;
 
+  /// This first guesses that the active set hasn't changed since the initial
+  /// `x` (which is usually last step's solution). Under that guess the LCP is
+  /// just a linear system over the free variables, which we solve with a
+  /// sparse LDLT. If that doesn't give a valid solution, we hand off to the
+  /// dense pivoting in solve().
+  bool solveSparse(
+      const Eigen::SparseMatrix<double, Eigen::RowMajor>& A,
+      Eigen::VectorXd& x,
+      Eigen::VectorXd& b,
+      int nub,
+      Eigen::VectorXd& lo,
+      Eigen::VectorXd& hi,
+      Eigen::VectorXi& findex,
+      bool earlyTermination = false) override;
+
+  // Documentation inherited.
+  bool hasSparseSolve() const override;
+
 #ifndef NDEBUG
   // Documentation inherited.
   bool canSolve(int n, const double* A) override;
@@ -18,7 +18,35 @@ bool LCPUtils::isLCPSolutionValid(
     const Eigen::VectorXi& mFIndex,
     bool ignoreFrictionIndices)
 {
-  Eigen::VectorXd v = mA * mX - mB;
+  return isLCPResidualValid(
+      mA * mX - mB, mX, mHi, mLo, mFIndex, ignoreFrictionIndices);
+}
+
+//==============================================================================
+bool LCPUtils::isLCPSolutionValid(
+    const Eigen::SparseMatrix<double, Eigen::RowMajor>& mA,
+    const Eigen::VectorXd& mX,
+    const Eigen::VectorXd& mB,
+    const Eigen::VectorXd& mHi,
+    const Eigen::VectorXd& mLo,
+    const Eigen::VectorXi& mFIndex,
+    bool ignoreFrictionIndices)
+{
+  return isLCPResidualValid(
+      mA * mX - mB, mX, mHi, mLo, mFIndex, ignoreFrictionIndices);
+}
+
+//==============================================================================
+/// This checks an LCP solution given just the residual v = A*x - b, which is
+/// all isLCPSolutionValid() actually needs from A
+bool LCPUtils::isLCPResidualValid(
+    const Eigen::VectorXd& v,
+    const Eigen::VectorXd& mX,
+    const Eigen::VectorXd& mHi,
+    const Eigen::VectorXd& mLo,
+    const Eigen::VectorXi& mFIndex,
+    bool ignoreFrictionIndices)
+{
   for (int i = 0; i < mX.size(); i++)
   {
     double upperLimit = mHi(i);
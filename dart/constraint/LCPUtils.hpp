@@ -4,6 +4,7 @@
 #include <memory>
 
 #include <Eigen/Dense>
+#include <Eigen/SparseCore>
 
 #include "dart/constraint/BoxedLcpSolver.hpp"
 
@@ -22,6 +23,26 @@ public:
       const Eigen::VectorXi& mFIndex,
       bool ignoreFrictionIndices);
 
+  /// This is the same check as above, for a sparse A
+  static bool isLCPSolutionValid(
+      const Eigen::SparseMatrix<double, Eigen::RowMajor>& mA,
+      const Eigen::VectorXd& mX,
+      const Eigen::VectorXd& mB,
+      const Eigen::VectorXd& mHi,
+      const Eigen::VectorXd& mLo,
+      const Eigen::VectorXi& mFIndex,
+      bool ignoreFrictionIndices);
+
+  /// This checks an LCP solution given just the residual v = A*x - b, which is
+  /// all isLCPSolutionValid() actually needs from A
+  static bool isLCPResidualValid(
+      const Eigen::VectorXd& v,
+      const Eigen::VectorXd& mX,
+      const Eigen::VectorXd& mHi,
+      const Eigen::VectorXd& mLo,
+      const Eigen::VectorXi& mFIndex,
+      bool ignoreFrictionIndices);
+
   /// This applies a simple algorithm to guess the solution to the LCP problem.
   /// It's not guaranteed to be correct, but it often can be if there is no
   /// sliding friction on this timestep.
@@ -251,6 +251,126 @@ bool PgsBoxedLcpSolver::solve(
   return possibleToTerminate;
 }
 
+//==============================================================================
+bool PgsBoxedLcpSolver::hasSparseSolve() const
+{
+  return true;
+}
+
+//==============================================================================
+bool PgsBoxedLcpSolver::solveSparse(
+    const Eigen::SparseMatrix<double, Eigen::RowMajor>& A,
+    Eigen::VectorXd& x,
+    Eigen::VectorXd& b,
+    int nub,
+    Eigen::VectorXd& lo,
+    Eigen::VectorXd& hi,
+    Eigen::VectorXi& findex,
+    bool earlyTermination)
+{
+  typedef Eigen::SparseMatrix<double, Eigen::RowMajor> SparseMatrix;
+
+  const int n = A.rows();
+
+  if (nub >= n)
+  {
+    return BoxedLcpSolver::solveSparse(
+        A, x, b, nub, lo, hi, findex, earlyTermination);
+  }
+
+  const Eigen::VectorXd diagonal = A.diagonal();
+
+  // This is one projected Gauss-Seidel update of x[i], which returns the
+  // amount x[i] moved
+  auto update = [&](int i) {
+    const double old_x = x(i);
+
+    double new_x = b(i);
+    for (SparseMatrix::InnerIterator it(A, i); it; ++it)
+    {
+      if (it.col() != i)
+        new_x -= it.value() * x(it.col());
+    }
+    new_x /= diagonal(i);
+    assert(!isnan(new_x));
+
+    double hi_tmp = hi(i);
+    double lo_tmp = lo(i);
+    if (findex(i) >= 0)
+    {
+      hi_tmp = hi(i) * x(findex(i));
+      lo_tmp = -hi_tmp;
+    }
+
+    if (new_x > hi_tmp)
+      x(i) = hi_tmp;
+    else if (new_x < lo_tmp)
+      x(i) = lo_tmp;
+    else
+      x(i) = new_x;
+
+    return x(i) - old_x;
+  };
+
+  mCacheOrder.clear();
+  mCacheOrder.reserve(n);
+
+  bool possibleToTerminate = true;
+  for (int i = 0; i < n; ++i)
+  {
+    if (diagonal(i) < mOption.mEpsilonForDivision)
+    {
+      x(i) = 0.0;
+      continue;
+    }
+
+    mCacheOrder.push_back(i);
+
+    if (std::abs(update(i)) > mOption.mDeltaXThreshold)
+      possibleToTerminate = false;
+  }
+
+  if (possibleToTerminate)
+    return true;
+
+  for (int iter = 1; iter < mOption.mMaxIteration; ++iter)
+  {
+    if (mOption.mRandomizeConstraintOrder)
+    {
+      if ((iter & 7) == 0)
+      {
+        for (std::size_t i = 1; i < mCacheOrder.size(); ++i)
+        {
+          const int tmp = mCacheOrder[i];
+          const int swapi = dRandInt(i + 1);
+          mCacheOrder[i] = mCacheOrder[swapi];
+          mCacheOrder[swapi] = tmp;
+        }
+      }
+    }
+
+    possibleToTerminate = true;
+
+    for (const auto& index : mCacheOrder)
+    {
+      const double deltaX = update(index);
+
+      if (possibleToTerminate
+          && std::abs(x(index)) > mOption.mEpsilonForDivision)
+      {
+        const double relativeDeltaX = std::abs(deltaX / x(index));
+        if (relativeDeltaX > mOption.mRelativeDeltaXTolerance)
+          possibleToTerminate = false;
+      }
+    }
+
+    if (possibleToTerminate)
+      break;
+  }
+
+  return possibleToTerminate;
+}
+
 #ifndef NDEBUG
 //==============================================================================
 bool PgsBoxedLcpSolver::canSolve(int n, const double* A)
@@ -77,6 +77,23 @@ public:
       int* findex,
       bool earlyTermination) override;
 
+  /// This runs the same projected Gauss-Seidel sweeps as solve(), but only
+  /// ever touches the nonzeros of A, so each sweep costs O(nnz(A)) instead of
+  /// O(n^2). If all the variables are unbounded we fall back to the dense
+  /// factorization in solve().
+  bool solveSparse(
+      const Eigen::SparseMatrix<double, Eigen::RowMajor>& A,
+      Eigen::VectorXd& x,
+      Eigen::VectorXd& b,
+      int nub,
+      Eigen::VectorXd& lo,
+      Eigen::VectorXd& hi,
+      Eigen::VectorXi& findex,
+      bool earlyTermination = false) override;
+
+  // Documentation inherited.
+  bool hasSparseSolve() const override;
+
 #ifndef NDEBUG
   // Documentation inherited.
   bool canSolve(int n, const double* A) override;
@@ -389,6 +389,56 @@ bool Inertia::operator ==(const Inertia& other) const
   return (other.mSpatialTensor == mSpatialTensor);
 }
 
+//==============================================================================
+Eigen::Matrix6d Inertia::getSpatialTensorGradientWrtParameter(
+    Param _param) const
+{
+  // The spatial tensor is
+  //
+  //   [ I + m*C*C^T   m*C   ]
+  //   [ m*C^T         m*1   ]
+  //
+  // where C = [com], so it's linear in m and I, and quadratic in the COM.
+  Eigen::Matrix6d dG = Eigen::Matrix6d::Zero();
+  Eigen::Matrix3d C = math::makeSkewSymmetric(mCenterOfMass);
+
+  if(_param == MASS)
+  {
+    dG.block<3,3>(0,0) = C*C.transpose();
+    dG.block<3,3>(3,0) = C.transpose();
+    dG.block<3,3>(0,3) = C;
+    dG.block<3,3>(3,3) = Eigen::Matrix3d::Identity();
+  }
+  else if(_param <= COM_Z)
+  {
+    Eigen::Matrix3d dC = math::makeSkewSymmetric(
+        Eigen::Vector3d::Unit(_param - COM_X));
+    dG.block<3,3>(0,0) = mMass*(dC*C.transpose() + C*dC.transpose());
+    dG.block<3,3>(3,0) = mMass*dC.transpose();
+    dG.block<3,3>(0,3) = mMass*dC;
+  }
+  else if(_param <= I_ZZ)
+  {
+    const int i = _param - I_XX;
+    dG(i,i) = 1.0;
+  }
+  else if(_param <= I_YZ)
+  {
+    const int i = (_param == I_YZ) ? 1 : 0;
+    const int j = (_param == I_XY) ? 1 : 2;
+    dG(i,j) = 1.0;
+    dG(j,i) = 1.0;
+  }
+  else
+  {
+    dtwarn << "[Inertia::getSpatialTensorGradientWrtParameter] Requested "
+           << "Param #" << _param << ", but inertial parameters only go up to "
+           << I_YZ << ". Returning 0\n";
+  }
+
+  return dG;
+}
+
 //==============================================================================
 // Note: Taken from Springer Handbook, chapter 2.2.11
 void Inertia::computeSpatialTensor()
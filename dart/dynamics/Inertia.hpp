@@ -105,6 +105,10 @@ public:
   /// Get the spatial inertia tensor
   const Eigen::Matrix6d& getSpatialTensor() const;
 
+  /// Get the derivative of the spatial inertia tensor with respect to a single
+  /// inertial parameter, holding all the other parameters constant
+  Eigen::Matrix6d getSpatialTensorGradientWrtParameter(Param _param) const;
+
   /// Returns true iff _moment is a physically valid moment of inertia
   static bool verifyMoment(const Eigen::Matrix3d& _moment,
                            bool _printWarnings = true,
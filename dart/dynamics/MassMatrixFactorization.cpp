@@ -0,0 +1,123 @@
+#include "dart/dynamics/MassMatrixFactorization.hpp"
+
+#include <cassert>
+
+namespace dart {
+namespace dynamics {
+
+//==============================================================================
+MassMatrixFactorization::MassMatrixFactorization()
+{
+  // Do nothing
+}
+
+//==============================================================================
+/// This factors `M`. `parents` gives, for each DOF, the index of the closest
+/// DOF above it in the tree, or -1 if there isn't one.
+void MassMatrixFactorization::compute(
+    const Eigen::MatrixXd& M, const std::vector<int>& parents)
+{
+  const int n = static_cast<int>(parents.size());
+  assert(M.rows() == n && M.cols() == n);
+
+  mParents = parents;
+  mLD = M;
+
+  for (int k = n - 1; k >= 0; k--)
+  {
+    assert(mParents[k] < k);
+    assert(mLD(k, k) > 0);
+
+    // Eliminate DOF k from all of its ancestors. Those are the only nonzeros
+    // in row k, and the only rows k's elimination can touch.
+    for (int i = mParents[k]; i != -1; i = mParents[i])
+    {
+      const double a = mLD(k, i) / mLD(k, k);
+      for (int j = i; j != -1; j = mParents[j])
+      {
+        mLD(i, j) -= a * mLD(k, j);
+      }
+      mLD(k, i) = a;
+    }
+  }
+}
+
+//==============================================================================
+std::size_t MassMatrixFactorization::getNumDofs() const
+{
+  return mParents.size();
+}
+
+//==============================================================================
+/// This returns M^{-1} * B
+Eigen::MatrixXd MassMatrixFactorization::solve(const Eigen::MatrixXd& B) const
+{
+  const int n = static_cast<int>(mParents.size());
+  assert(B.rows() == n);
+
+  Eigen::MatrixXd X = B;
+  for (int col = 0; col < X.cols(); col++)
+  {
+    auto x = X.col(col);
+
+    // L^T * y = b
+    for (int i = n - 1; i >= 0; i--)
+    {
+      for (int j = mParents[i]; j != -1; j = mParents[j])
+      {
+        x(j) -= mLD(i, j) * x(i);
+      }
+    }
+
+    // D * z = y
+    for (int i = 0; i < n; i++)
+    {
+      x(i) /= mLD(i, i);
+    }
+
+    // L * x = z
+    for (int i = 0; i < n; i++)
+    {
+      for (int j = mParents[i]; j != -1; j = mParents[j])
+      {
+        x(i) -= mLD(i, j) * x(j);
+      }
+    }
+  }
+
+  return X;
+}
+
+//==============================================================================
+/// This returns M^{-1}
+Eigen::MatrixXd MassMatrixFactorization::getInverse() const
+{
+  const std::size_t n = mParents.size();
+  return solve(Eigen::MatrixXd::Identity(n, n));
+}
+
+//==============================================================================
+/// This returns the unit lower triangular L
+Eigen::MatrixXd MassMatrixFactorization::getL() const
+{
+  const int n = static_cast<int>(mParents.size());
+  Eigen::MatrixXd L = Eigen::MatrixXd::Identity(n, n);
+  for (int i = 0; i < n; i++)
+  {
+    for (int j = mParents[i]; j != -1; j = mParents[j])
+    {
+      L(i, j) = mLD(i, j);
+    }
+  }
+  return L;
+}
+
+//==============================================================================
+/// This returns the diagonal of D
+Eigen::VectorXd MassMatrixFactorization::getD() const
+{
+  return mLD.diagonal();
+}
+
+} // namespace dynamics
+} // namespace dart
@@ -0,0 +1,59 @@
+#ifndef DART_DYNAMICS_MASSMATRIXFACTORIZATION_HPP_
+#define DART_DYNAMICS_MASSMATRIXFACTORIZATION_HPP_
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+namespace dart {
+namespace dynamics {
+
+/// This is a sparse M = L^T * D * L factorization of the mass matrix of a
+/// kinematic tree, from Featherstone's "Rigid Body Dynamics Algorithms",
+/// section 6.3.
+///
+/// M(i, j) can only be nonzero if DOF i is an ancestor of DOF j in the tree,
+/// or the other way around. If we order the DOFs so that every DOF comes after
+/// its parent, factoring from the last DOF to the first never fills in
+/// anything outside of that pattern, so L keeps the same sparsity as M. On a
+/// branching tree both the factorization and each solve then only cost as
+/// much as the total depth of the DOFs, rather than O(n^3) and O(n^2).
+class MassMatrixFactorization
+{
+public:
+  /// Creates an empty (0 x 0) factorization
+  MassMatrixFactorization();
+
+  /// This factors `M`. `parents` gives, for each DOF, the index of the
+  /// closest DOF above it in the tree, or -1 if there isn't one. Every DOF
+  /// must come after its parent.
+  void compute(const Eigen::MatrixXd& M, const std::vector<int>& parents);
+
+  /// Returns the number of rows (and columns) of M
+  std::size_t getNumDofs() const;
+
+  /// This returns M^{-1} * B
+  Eigen::MatrixXd solve(const Eigen::MatrixXd& B) const;
+
+  /// This returns M^{-1}
+  Eigen::MatrixXd getInverse() const;
+
+  /// This returns the unit lower triangular L
+  Eigen::MatrixXd getL() const;
+
+  /// This returns the diagonal of D
+  Eigen::VectorXd getD() const;
+
+protected:
+  /// For each DOF, the index of its parent DOF, or -1
+  std::vector<int> mParents;
+
+  /// D on the diagonal, and the strictly lower part of L below it. The upper
+  /// triangle isn't used.
+  Eigen::MatrixXd mLD;
+};
+
+} // namespace dynamics
+} // namespace dart
+
+#endif
@@ -1,5 +1,7 @@
 #include "dart/dynamics/SimpleFeatherstone.hpp"
 
+#include <algorithm>
+
 #include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/DegreeOfFreedom.hpp"
 #include "dart/dynamics/Joint.hpp"
@@ -14,6 +16,7 @@ JointAndBody& SimpleFeatherstone::emplaceBack()
 {
   mJointsAndBodies.emplace_back();
   mScratchSpace.emplace_back();
+  mBatchScratchSpace.emplace_back();
   return mJointsAndBodies.at(mJointsAndBodies.size() - 1);
 }
 
@@ -137,6 +140,582 @@ void SimpleFeatherstone::forwardDynamics(
   }
 }
 
+namespace {
+
+constexpr int LANES = FeatherstoneBatchScratchSpace::LANES;
+typedef double Lanes[LANES];
+
+// All the helpers below work on every lane at once, and keep the loop over the
+// lanes innermost, so each one is a short, contiguous loop that vectorizes.
+
+// out = AdInvT(T, in), where T is given as (rotation, translation). `out` must
+// not alias `in`.
+void batchAdInvT(
+    const Lanes* rotation,
+    const Lanes* translation,
+    const Lanes* in,
+    Lanes* out)
+{
+  // lin = v + w x p
+  Lanes lin[3];
+  for (int k = 0; k < LANES; k++)
+  {
+    lin[0][k] = in[3][k] + in[1][k] * translation[2][k]
+                - in[2][k] * translation[1][k];
+    lin[1][k] = in[4][k] + in[2][k] * translation[0][k]
+                - in[0][k] * translation[2][k];
+    lin[2][k] = in[5][k] + in[0][k] * translation[1][k]
+                - in[1][k] * translation[0][k];
+  }
+  // Multiply both halves by R^T. Row r of R^T is column r of R.
+  for (int r = 0; r < 3; r++)
+  {
+    const Lanes* col = rotation + r * 3;
+    for (int k = 0; k < LANES; k++)
+    {
+      out[r][k] = col[0][k] * in[0][k] + col[1][k] * in[1][k]
+                  + col[2][k] * in[2][k];
+      out[r + 3][k] = col[0][k] * lin[0][k] + col[1][k] * lin[1][k]
+                      + col[2][k] * lin[2][k];
+    }
+  }
+}
+
+// out = dAdInvT(T, in), where T is given as (rotation, translation). `out`
+// must not alias `in`.
+void batchDAdInvT(
+    const Lanes* rotation,
+    const Lanes* translation,
+    const Lanes* in,
+    Lanes* out)
+{
+  // Multiply both halves by R
+  for (int r = 0; r < 3; r++)
+  {
+    for (int k = 0; k < LANES; k++)
+    {
+      out[r][k] = rotation[r][k] * in[0][k] + rotation[3 + r][k] * in[1][k]
+                  + rotation[6 + r][k] * in[2][k];
+      out[r + 3][k] = rotation[r][k] * in[3][k]
+                      + rotation[3 + r][k] * in[4][k]
+                      + rotation[6 + r][k] * in[5][k];
+    }
+  }
+  // ang += p x lin
+  for (int k = 0; k < LANES; k++)
+  {
+    out[0][k] += translation[1][k] * out[5][k] - translation[2][k] * out[4][k];
+    out[1][k] += translation[2][k] * out[3][k] - translation[0][k] * out[5][k];
+    out[2][k] += translation[0][k] * out[4][k] - translation[1][k] * out[3][k];
+  }
+}
+
+// out = M * in, where M is a column-major 6x6 with a value per lane
+void batchMatrixTimes(const Lanes* M, const Lanes* in, Lanes* out)
+{
+  for (int r = 0; r < 6; r++)
+  {
+    for (int k = 0; k < LANES; k++)
+    {
+      out[r][k] = M[r][k] * in[0][k];
+    }
+    for (int c = 1; c < 6; c++)
+    {
+      for (int k = 0; k < LANES; k++)
+      {
+        out[r][k] += M[c * 6 + r][k] * in[c][k];
+      }
+    }
+  }
+}
+
+// out = s^T * in, where s is the same for every lane
+void batchDot(const Eigen::Vector6d& s, const Lanes* in, Lanes& out)
+{
+  for (int k = 0; k < LANES; k++)
+  {
+    out[k] = s(0) * in[0][k];
+  }
+  for (int r = 1; r < 6; r++)
+  {
+    for (int k = 0; k < LANES; k++)
+    {
+      out[k] += s(r) * in[r][k];
+    }
+  }
+}
+
+// out += X^T * PI * X, where X = Ad(T^{-1}) and T is given as (rotation,
+// translation). This is math::transformInertia(T.inverse(), PI), done a 3x3
+// block at a time. With PI = [A, B; B^T, C], and primes denoting R * (.) * R^T,
+// the result is [A' + [p]B'^T - D[p], D; D^T, C'], where D = B' + [p]C'.
+void batchAddTransformedInertia(
+    const Lanes* rotation,
+    const Lanes* translation,
+    const Lanes* PI,
+    Lanes* out)
+{
+  const Lanes* p = translation;
+
+  // Rotate the A, B and C blocks of PI. These are column-major 3x3s.
+  Lanes rotated[3][9];
+  const int blockOffsets[3] = {0, 18, 21};
+  for (int b = 0; b < 3; b++)
+  {
+    const Lanes* block = PI + blockOffsets[b];
+    // tmp = R * block
+    Lanes tmp[9];
+    for (int c = 0; c < 3; c++)
+    {
+      for (int r = 0; r < 3; r++)
+      {
+        for (int k = 0; k < LANES; k++)
+        {
+          tmp[c * 3 + r][k] = rotation[r][k] * block[c * 6][k]
+                              + rotation[3 + r][k] * block[c * 6 + 1][k]
+                              + rotation[6 + r][k] * block[c * 6 + 2][k];
+        }
+      }
+    }
+    // rotated = tmp * R^T
+    for (int c = 0; c < 3; c++)
+    {
+      for (int r = 0; r < 3; r++)
+      {
+        for (int k = 0; k < LANES; k++)
+        {
+          rotated[b][c * 3 + r][k] = tmp[r][k] * rotation[c][k]
+                                     + tmp[3 + r][k] * rotation[3 + c][k]
+                                     + tmp[6 + r][k] * rotation[6 + c][k];
+        }
+      }
+    }
+  }
+  const Lanes* A = rotated[0];
+  const Lanes* B = rotated[1];
+  const Lanes* C = rotated[2];
+
+  // D = B' + [p]C', a column at a time
+  Lanes D[9];
+  for (int c = 0; c < 3; c++)
+  {
+    const Lanes* m = C + c * 3;
+    for (int k = 0; k < LANES; k++)
+    {
+      D[c * 3][k] = B[c * 3][k] + p[1][k] * m[2][k] - p[2][k] * m[1][k];
+      D[c * 3 + 1][k] = B[c * 3 + 1][k] + p[2][k] * m[0][k] - p[0][k] * m[2][k];
+      D[c * 3 + 2][k] = B[c * 3 + 2][k] + p[0][k] * m[1][k] - p[1][k] * m[0][k];
+    }
+  }
+
+  // TL = A' + [p]B'^T - D[p]. Column c of [p]B'^T is p x (row c of B'), and
+  // row r of -D[p] is p x (row r of D).
+  Lanes TL[9];
+  for (int c = 0; c < 3; c++)
+  {
+    for (int k = 0; k < LANES; k++)
+    {
+      const double b0 = B[c][k];
+      const double b1 = B[3 + c][k];
+      const double b2 = B[6 + c][k];
+      TL[c * 3][k] = A[c * 3][k] + p[1][k] * b2 - p[2][k] * b1;
+      TL[c * 3 + 1][k] = A[c * 3 + 1][k] + p[2][k] * b0 - p[0][k] * b2;
+      TL[c * 3 + 2][k] = A[c * 3 + 2][k] + p[0][k] * b1 - p[1][k] * b0;
+    }
+  }
+  for (int r = 0; r < 3; r++)
+  {
+    for (int k = 0; k < LANES; k++)
+    {
+      const double d0 = D[r][k];
+      const double d1 = D[3 + r][k];
+      const double d2 = D[6 + r][k];
+      TL[r][k] += p[1][k] * d2 - p[2][k] * d1;
+      TL[3 + r][k] += p[2][k] * d0 - p[0][k] * d2;
+      TL[6 + r][k] += p[0][k] * d1 - p[1][k] * d0;
+    }
+  }
+
+  for (int c = 0; c < 3; c++)
+  {
+    for (int r = 0; r < 3; r++)
+    {
+      for (int k = 0; k < LANES; k++)
+      {
+        out[c * 6 + r][k] += TL[c * 3 + r][k];
+        out[(c + 3) * 6 + r][k] += D[c * 3 + r][k];
+        out[c * 6 + r + 3][k] += D[r * 3 + c][k];
+        out[(c + 3) * 6 + r + 3][k] += C[c * 3 + r][k];
+      }
+    }
+  }
+}
+
+} // namespace
+
+// This computes accelerations for `numStates` states at once
+void SimpleFeatherstone::forwardDynamicsBatch(
+    int numStates,
+    const double* pos,
+    const double* vel,
+    const double* force,
+    /* OUT */ double* accelerations)
+{
+  for (int start = 0; start < numStates; start += LANES)
+  {
+    int lanes = std::min(LANES, numStates - start);
+
+    // Load this block of states into the lanes. If we're at the end and don't
+    // have enough states to fill every lane, we fill the rest with copies of
+    // the first state, so the extra lanes compute something harmless.
+    for (int i = 0; i < len(); i++)
+    {
+      FeatherstoneBatchScratchSpace& scratch = mBatchScratchSpace[i];
+      const int offset = i * numStates + start;
+      for (int k = 0; k < LANES; k++)
+      {
+        const int from = offset + (k < lanes ? k : 0);
+        scratch.pos[k] = pos[from];
+        scratch.vel[k] = vel[from];
+        scratch.force[k] = force[from];
+      }
+    }
+
+    // Forward pass
+    for (int i = 0; i < len(); i++)
+    {
+      const JointAndBody& joint = mJointsAndBodies[i];
+      const Eigen::Vector6d& s = joint.axis;
+      FeatherstoneBatchScratchSpace& scratch = mBatchScratchSpace[i];
+
+      // The exponential map doesn't vectorize, so we take it one lane at a
+      // time
+      Lanes expRotation[9];
+      Lanes expTranslation[3];
+      for (int k = 0; k < LANES; k++)
+      {
+        Eigen::Isometry3d E = math::expMap(s * scratch.pos[k]);
+        for (int j = 0; j < 9; j++)
+        {
+          expRotation[j][k] = E.linear()(j % 3, j / 3);
+        }
+        for (int j = 0; j < 3; j++)
+        {
+          expTranslation[j][k] = E.translation()(j);
+        }
+      }
+
+      // transformFromParent = parent * E * child. The fixed transforms are the
+      // same in every lane, so this part vectorizes. With M = R_parent * R_E,
+      // the rotation is M * R_child, and the translation is
+      // M * p_child + R_parent * p_E + p_parent.
+      const Eigen::Isometry3d& parentT = joint.transformFromParent;
+      const Eigen::Isometry3d& childT = joint.transformFromChildren;
+      Lanes M[9];
+      for (int c = 0; c < 3; c++)
+      {
+        for (int r = 0; r < 3; r++)
+        {
+          for (int k = 0; k < LANES; k++)
+          {
+            M[c * 3 + r][k] = parentT(r, 0) * expRotation[c * 3][k]
+                              + parentT(r, 1) * expRotation[c * 3 + 1][k]
+                              + parentT(r, 2) * expRotation[c * 3 + 2][k];
+          }
+        }
+      }
+      for (int c = 0; c < 3; c++)
+      {
+        for (int r = 0; r < 3; r++)
+        {
+          for (int k = 0; k < LANES; k++)
+          {
+            scratch.rotation[c * 3 + r][k] = M[r][k] * childT(0, c)
+                                             + M[3 + r][k] * childT(1, c)
+                                             + M[6 + r][k] * childT(2, c);
+          }
+        }
+      }
+      for (int r = 0; r < 3; r++)
+      {
+        for (int k = 0; k < LANES; k++)
+        {
+          scratch.translation[r][k]
+              = M[r][k] * childT(0, 3) + M[3 + r][k] * childT(1, 3)
+                + M[6 + r][k] * childT(2, 3)
+                + parentT(r, 0) * expTranslation[0][k]
+                + parentT(r, 1) * expTranslation[1][k]
+                + parentT(r, 2) * expTranslation[2][k] + parentT(r, 3);
+        }
+      }
+
+      if (joint.parentIndex != -1)
+      {
+        batchAdInvT(
+            scratch.rotation,
+            scratch.translation,
+            mBatchScratchSpace[joint.parentIndex].spatialVelocity,
+            scratch.spatialVelocity);
+      }
+      else
+      {
+        for (int r = 0; r < 6; r++)
+        {
+          std::fill_n(scratch.spatialVelocity[r], LANES, 0.0);
+        }
+      }
+      for (int r = 0; r < 6; r++)
+      {
+        for (int k = 0; k < LANES; k++)
+        {
+          scratch.spatialVelocity[r][k] += s(r) * scratch.vel[k];
+        }
+      }
+
+      // partialAcceleration = ad(V, s * vel)
+      const Lanes* V = scratch.spatialVelocity;
+      Lanes* eta = scratch.partialAcceleration;
+      for (int k = 0; k < LANES; k++)
+      {
+        const double dq = scratch.vel[k];
+        eta[0][k] = (V[1][k] * s(2) - V[2][k] * s(1)) * dq;
+        eta[1][k] = (V[2][k] * s(0) - V[0][k] * s(2)) * dq;
+        eta[2][k] = (V[0][k] * s(1) - V[1][k] * s(0)) * dq;
+        eta[3][k] = (V[1][k] * s(5) - V[2][k] * s(4) + V[4][k] * s(2)
+                     - V[5][k] * s(1))
+                    * dq;
+        eta[4][k] = (V[2][k] * s(3) - V[0][k] * s(5) + V[5][k] * s(0)
+                     - V[3][k] * s(2))
+                    * dq;
+        eta[5][k] = (V[0][k] * s(4) - V[1][k] * s(3) + V[3][k] * s(1)
+                     - V[4][k] * s(0))
+                    * dq;
+      }
+
+      // Zero out scratch space to prepare for sums in backwards pass
+      for (int j = 0; j < 36; j++)
+      {
+        std::fill_n(scratch.articulatedInertia[j], LANES, 0.0);
+      }
+      for (int r = 0; r < 6; r++)
+      {
+        std::fill_n(scratch.articulatedBiasForce[r], LANES, 0.0);
+      }
+    }
+
+    // Backward pass
+    for (int i = len() - 1; i >= 0; i--)
+    {
+      const JointAndBody& joint = mJointsAndBodies[i];
+      const Eigen::Vector6d& s = joint.axis;
+      FeatherstoneBatchScratchSpace& scratch = mBatchScratchSpace[i];
+      Lanes* AI = scratch.articulatedInertia;
+      Lanes* B = scratch.articulatedBiasForce;
+      const Lanes* V = scratch.spatialVelocity;
+
+      for (int j = 0; j < 36; j++)
+      {
+        const double inertia = joint.inertia.data()[j];
+        for (int k = 0; k < LANES; k++)
+        {
+          AI[j][k] += inertia;
+        }
+      }
+
+      // B -= dad(V, inertia * V)
+      Lanes F[6];
+      for (int r = 0; r < 6; r++)
+      {
+        for (int k = 0; k < LANES; k++)
+        {
+          F[r][k] = joint.inertia(r, 0) * V[0][k];
+        }
+        for (int c = 1; c < 6; c++)
+        {
+          for (int k = 0; k < LANES; k++)
+          {
+            F[r][k] += joint.inertia(r, c) * V[c][k];
+          }
+        }
+      }
+      for (int k = 0; k < LANES; k++)
+      {
+        B[0][k] -= F[1][k] * V[2][k] - F[2][k] * V[1][k] + F[4][k] * V[5][k]
+                   - F[5][k] * V[4][k];
+        B[1][k] -= F[2][k] * V[0][k] - F[0][k] * V[2][k] + F[5][k] * V[3][k]
+                   - F[3][k] * V[5][k];
+        B[2][k] -= F[0][k] * V[1][k] - F[1][k] * V[0][k] + F[3][k] * V[4][k]
+                   - F[4][k] * V[3][k];
+        B[3][k] -= F[4][k] * V[2][k] - F[5][k] * V[1][k];
+        B[4][k] -= F[5][k] * V[0][k] - F[3][k] * V[2][k];
+        B[5][k] -= F[3][k] * V[1][k] - F[4][k] * V[0][k];
+      }
+
+      // AIS = Articulated_Inertia_times_axiS. AI is symmetric, so s^T * AI is
+      // the transpose of this.
+      Lanes AIS[6];
+      for (int r = 0; r < 6; r++)
+      {
+        for (int k = 0; k < LANES; k++)
+        {
+          AIS[r][k] = AI[r][k] * s(0);
+        }
+        for (int c = 1; c < 6; c++)
+        {
+          for (int k = 0; k < LANES; k++)
+          {
+            AIS[r][k] += AI[c * 6 + r][k] * s(c);
+          }
+        }
+      }
+      Lanes sAIS;
+      batchDot(s, AIS, sAIS);
+      for (int k = 0; k < LANES; k++)
+      {
+        scratch.psi[k] = 1.0 / sAIS[k];
+      }
+
+      // Total force on the joint, see GenericJoint.hpp:2028 for DART
+      // equivalent, inside GenericJoint::addChildBiasForceToDynamic()
+      Lanes AIeta[6];
+      batchMatrixTimes(AI, scratch.partialAcceleration, AIeta);
+      for (int r = 0; r < 6; r++)
+      {
+        for (int k = 0; k < LANES; k++)
+        {
+          AIeta[r][k] += B[r][k];
+        }
+      }
+      Lanes sAIeta;
+      batchDot(s, AIeta, sAIeta);
+      for (int k = 0; k < LANES; k++)
+      {
+        scratch.totalForce[k] = scratch.force[k] - sAIeta[k];
+      }
+
+      if (joint.parentIndex == -1)
+        continue;
+      FeatherstoneBatchScratchSpace& parent
+          = mBatchScratchSpace[joint.parentIndex];
+
+      // Sum into our parents, see GenericJoint::addChildArtInertiaToDynamic().
+      // PI = AI - AIS * psi * AIS^T, and then the parent's articulated inertia
+      // gets X^T * PI * X, where X = Ad(T^{-1})
+      Lanes PI[36];
+      for (int c = 0; c < 6; c++)
+      {
+        for (int r = 0; r < 6; r++)
+        {
+          for (int k = 0; k < LANES; k++)
+          {
+            PI[c * 6 + r][k]
+                = AI[c * 6 + r][k] - AIS[r][k] * scratch.psi[k] * AIS[c][k];
+          }
+        }
+      }
+      batchAddTransformedInertia(
+          scratch.rotation,
+          scratch.translation,
+          PI,
+          parent.articulatedInertia);
+
+      // beta = B + AI * (eta + s * psi * totalForce)
+      Lanes inner[6];
+      for (int r = 0; r < 6; r++)
+      {
+        for (int k = 0; k < LANES; k++)
+        {
+          inner[r][k] = scratch.partialAcceleration[r][k]
+                        + s(r) * scratch.psi[k] * scratch.totalForce[k];
+        }
+      }
+      Lanes beta[6];
+      batchMatrixTimes(AI, inner, beta);
+      for (int r = 0; r < 6; r++)
+      {
+        for (int k = 0; k < LANES; k++)
+        {
+          beta[r][k] += B[r][k];
+        }
+      }
+      Lanes parentBeta[6];
+      batchDAdInvT(scratch.rotation, scratch.translation, beta, parentBeta);
+      for (int r = 0; r < 6; r++)
+      {
+        for (int k = 0; k < LANES; k++)
+        {
+          parent.articulatedBiasForce[r][k] += parentBeta[r][k];
+        }
+      }
+    }
+
+    // Last forward pass
+    for (int i = 0; i < len(); i++)
+    {
+      const JointAndBody& joint = mJointsAndBodies[i];
+      const Eigen::Vector6d& s = joint.axis;
+      FeatherstoneBatchScratchSpace& scratch = mBatchScratchSpace[i];
+
+      // The parent's acceleration, moved into our frame
+      Lanes parentAccel[6];
+      if (joint.parentIndex != -1)
+      {
+        batchAdInvT(
+            scratch.rotation,
+            scratch.translation,
+            mBatchScratchSpace[joint.parentIndex].spatialAcceleration,
+            parentAccel);
+      }
+      else
+      {
+        for (int r = 0; r < 6; r++)
+        {
+          std::fill_n(parentAccel[r], LANES, 0.0);
+        }
+      }
+
+      Lanes inner[6];
+      for (int r = 0; r < 6; r++)
+      {
+        for (int k = 0; k < LANES; k++)
+        {
+          inner[r][k] = parentAccel[r][k] + scratch.partialAcceleration[r][k];
+        }
+      }
+      Lanes AIinner[6];
+      batchMatrixTimes(scratch.articulatedInertia, inner, AIinner);
+      for (int r = 0; r < 6; r++)
+      {
+        for (int k = 0; k < LANES; k++)
+        {
+          AIinner[r][k] += scratch.articulatedBiasForce[r][k];
+        }
+      }
+      Lanes sAIinner;
+      batchDot(s, AIinner, sAIinner);
+
+      Lanes accel;
+      for (int k = 0; k < LANES; k++)
+      {
+        accel[k] = scratch.psi[k] * (scratch.force[k] - sAIinner[k]);
+      }
+      for (int r = 0; r < 6; r++)
+      {
+        for (int k = 0; k < LANES; k++)
+        {
+          scratch.spatialAcceleration[r][k] = accel[k] * s(r) + inner[r][k];
+        }
+      }
+
+      double* out = accelerations + i * numStates + start;
+      for (int k = 0; k < lanes; k++)
+      {
+        out[k] = accel[k];
+      }
+    }
+  }
+}
+
 // This gets the values from a DART skeleton to populate our Featherstone
 // implementation
 void SimpleFeatherstone::populateFromSkeleton(
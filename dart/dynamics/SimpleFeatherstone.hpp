@@ -6,6 +6,7 @@
 
 #include <Eigen/Dense>
 
+#include "dart/common/Memory.hpp"
 #include "dart/math/Geometry.hpp"
 
 namespace dart {
@@ -46,6 +47,45 @@ struct FeatherstoneScratchSpace
   Eigen::Matrix6d phi;
 };
 
+// This is the scratch space for a single joint in
+// SimpleFeatherstone::forwardDynamicsBatch(). It holds the same values as
+// FeatherstoneScratchSpace, but for LANES states at once, laid out as
+// structure-of-arrays: every scalar in every vector or matrix gets its own
+// array of LANES values. That way each step of the spatial algebra is a
+// contiguous loop over the lanes, which the compiler can turn into AVX2 or
+// AVX-512 instructions (see DART_ENABLE_SIMD). 6x6 matrices are stored
+// column-major, so entry (row, col) is at [col * 6 + row].
+//
+// Each lane array is aligned to EIGEN_MAX_ALIGN_BYTES, which is the widest
+// vector the build targets. That's all Eigen's aligned allocator guarantees,
+// so these must live in a common::aligned_vector (a plain std::vector doesn't
+// honor over-alignment before C++17).
+struct FeatherstoneBatchScratchSpace
+{
+  static constexpr int LANES = 8;
+  static constexpr std::size_t ALIGNMENT
+      = EIGEN_MAX_ALIGN_BYTES > 0 ? EIGEN_MAX_ALIGN_BYTES : alignof(double);
+
+  alignas(ALIGNMENT) double pos[LANES];
+  alignas(ALIGNMENT) double vel[LANES];
+  alignas(ALIGNMENT) double force[LANES];
+
+  // transformFromParent, split into its rotation (column-major) and
+  // translation
+  alignas(ALIGNMENT) double rotation[9][LANES];
+  alignas(ALIGNMENT) double translation[3][LANES];
+
+  alignas(ALIGNMENT) double spatialVelocity[6][LANES];
+  alignas(ALIGNMENT) double spatialAcceleration[6][LANES];
+  alignas(ALIGNMENT) double partialAcceleration[6][LANES];
+
+  alignas(ALIGNMENT) double articulatedInertia[36][LANES];
+  alignas(ALIGNMENT) double articulatedBiasForce[6][LANES];
+
+  alignas(ALIGNMENT) double psi[LANES];
+  alignas(ALIGNMENT) double totalForce[LANES];
+};
+
 class SimpleFeatherstone
 {
 public:
@@ -64,14 +104,29 @@ public:
       double* force,
       /* OUT */ double* accelerations);
 
+  // This computes accelerations for `numStates` states at once. The states
+  // are stored DOF-major: DOF i of state k is at [i * numStates + k], so all
+  // the pointer arguments are assumed to point to arrays of length
+  // len() * numStates. If you're holding the states in Eigen, that's a
+  // column-major (numStates x len()) matrix. The states are processed in
+  // blocks of FeatherstoneBatchScratchSpace::LANES, with the spatial algebra
+  // for a whole block vectorized across the states.
+  void forwardDynamicsBatch(
+      int numStates,
+      const double* pos,
+      const double* vel,
+      const double* force,
+      /* OUT */ double* accelerations);
+
   // This gets the values from a DART skeleton to populate our Featherstone
   // implementation
   void populateFromSkeleton(
       const std::shared_ptr<dynamics::Skeleton>& skeleton);
 
   // protected:
-  std::vector<JointAndBody> mJointsAndBodies;
-  std::vector<FeatherstoneScratchSpace> mScratchSpace;
+  common::aligned_vector<JointAndBody> mJointsAndBodies;
+  common::aligned_vector<FeatherstoneScratchSpace> mScratchSpace;
+  common::aligned_vector<FeatherstoneBatchScratchSpace> mBatchScratchSpace;
 };
 
 } // namespace dynamics
@@ -50,11 +50,18 @@
 #include "dart/dynamics/BallJoint.hpp"
 #include "dart/dynamics/Marker.hpp"
 #include "dart/dynamics/PointMass.hpp"
+#include "dart/dynamics/PrismaticJoint.hpp"
+#include "dart/dynamics/RevoluteJoint.hpp"
+#include "dart/dynamics/ScrewJoint.hpp"
 #include "dart/dynamics/ShapeNode.hpp"
 #include "dart/dynamics/SoftBodyNode.hpp"
+#include "dart/dynamics/TranslationalJoint.hpp"
+#include "dart/dynamics/TranslationalJoint2D.hpp"
+#include "dart/dynamics/WeldJoint.hpp"
 #include "dart/math/Geometry.hpp"
 #include "dart/math/Helpers.hpp"
 #include "dart/neural/ConstrainedGroupGradientMatrices.hpp"
+#include "dart/neural/WithRespectToMass.hpp"
 
 #define SET_ALL_FLAGS(X)                                                       \
   for (auto& cache : mTreeCache)                                               \
@@ -1620,7 +1627,18 @@ void Skeleton::setGradientConstraintMatrices(
 //==============================================================================
 Eigen::MatrixXd Skeleton::getJacobianOfC(neural::WithRespectTo* wrt)
 {
-  // TOOD(keenon): replace with the GEAR approach
+  if (neural::WithRespectToMass* wrtMass
+      = dynamic_cast<neural::WithRespectToMass*>(wrt))
+  {
+    return getJacobianOfCWrtMass(wrtMass);
+  }
+  if (canDifferentiateCAnalytically())
+  {
+    if (wrt == neural::WithRespectTo::POSITION)
+      return getJacobianOfCWrtPosition();
+    if (wrt == neural::WithRespectTo::VELOCITY)
+      return getJacobianOfCWrtVelocity();
+  }
   return finiteDifferenceJacobianOfC(wrt);
 }
 
@@ -1629,10 +1647,86 @@ Eigen::MatrixXd Skeleton::getJacobianOfC(neural::WithRespectTo* wrt)
 Eigen::MatrixXd Skeleton::getJacobianOfMinv(
     Eigen::VectorXd f, neural::WithRespectTo* wrt)
 {
-  // TOOD(keenon): replace with the GEAR approach
+  if (neural::WithRespectToMass* wrtMass
+      = dynamic_cast<neural::WithRespectToMass*>(wrt))
+  {
+    return getJacobianOfMinvWrtMass(f, wrtMass);
+  }
+  if (wrt == neural::WithRespectTo::POSITION && canDifferentiateCAnalytically())
+  {
+    return getJacobianOfMinvWrtPosition(f);
+  }
   return finiteDifferenceJacobianOfMinv(f, wrt);
 }
 
+//==============================================================================
+Eigen::MatrixXd Skeleton::getJacobianOfCWrtMass(neural::WithRespectToMass* wrt)
+{
+  std::size_t n = getNumDofs();
+  std::size_t m = wrt->dim(this);
+  Eigen::MatrixXd J = Eigen::MatrixXd::Zero(n, m);
+  if (m == 0)
+    return J;
+
+  const Eigen::VectorXd dq = getVelocities();
+  const Eigen::Vector3d& gravity = getGravity();
+
+  std::size_t cursor = 0;
+  for (neural::WrtMassBodyNodyEntry& entry : wrt->getNodes(this))
+  {
+    const BodyNode* node = getBodyNode(entry.linkName);
+
+    // The body's spatial Jacobian, velocity, and acceleration (with ddq = 0)
+    // in its own frame, same as BodyNode::aggregateCombinedVector() uses
+    const math::Jacobian bodyJac = getJacobian(node);
+    const Eigen::Vector6d& V = node->getSpatialVelocity();
+    Eigen::Vector6d dV = getJacobianSpatialDeriv(node) * dq;
+    if (node->getGravityMode())
+      dV -= math::AdInvRLinear(node->getWorldTransform(), gravity);
+
+    for (const Eigen::Matrix6d& dG : entry.getSpatialTensorGradients(this))
+    {
+      const Eigen::Vector6d dF = dG * dV - math::dad(V, dG * V);
+      J.col(cursor) = bodyJac.transpose() * dF;
+      cursor++;
+    }
+  }
+  assert(cursor == m);
+
+  return J;
+}
+
+//==============================================================================
+Eigen::MatrixXd Skeleton::getJacobianOfMinvWrtMass(
+    Eigen::VectorXd f, neural::WithRespectToMass* wrt)
+{
+  std::size_t n = getNumDofs();
+  std::size_t m = wrt->dim(this);
+  Eigen::MatrixXd J = Eigen::MatrixXd::Zero(n, m);
+  if (m == 0)
+    return J;
+
+  const Eigen::MatrixXd Minv = getInvMassMatrix();
+  const Eigen::VectorXd Minv_f = Minv * f;
+
+  std::size_t cursor = 0;
+  for (neural::WrtMassBodyNodyEntry& entry : wrt->getNodes(this))
+  {
+    const BodyNode* node = getBodyNode(entry.linkName);
+    const math::Jacobian bodyJac = getJacobian(node);
+    const Eigen::Vector6d V_f = bodyJac * Minv_f;
+
+    for (const Eigen::Matrix6d& dG : entry.getSpatialTensorGradients(this))
+    {
+      J.col(cursor) = -Minv * (bodyJac.transpose() * (dG * V_f));
+      cursor++;
+    }
+  }
+  assert(cursor == m);
+
+  return J;
+}
+
 //==============================================================================
 Eigen::MatrixXd Skeleton::getUnconstrainedVelJacobianWrt(
     double dt, neural::WithRespectTo* wrt)
@@ -1643,7 +1737,8 @@ Eigen::MatrixXd Skeleton::getUnconstrainedVelJacobianWrt(
   Eigen::MatrixXd Minv = getInvMassMatrix();
   Eigen::MatrixXd dC = getJacobianOfC(wrt);
 
-  if (wrt == neural::WithRespectTo::POSITION) {
+  if (wrt == neural::WithRespectTo::POSITION
+      || dynamic_cast<neural::WithRespectToMass*>(wrt) != nullptr) {
     Eigen::MatrixXd dM = getJacobianOfMinv(dt * (tau - C), wrt);
     return dM - Minv * dt * dC;
   }
@@ -1655,10 +1750,701 @@ Eigen::MatrixXd Skeleton::getUnconstrainedVelJacobianWrt(
 //==============================================================================
 Eigen::MatrixXd Skeleton::getVelCJacobian()
 {
-  // TOOD(keenon): replace with the GEAR approach
+  if (canDifferentiateCAnalytically())
+    return getJacobianOfCWrtVelocity();
   return finiteDifferenceVelCJacobian();
 }
 
+namespace {
+
+/// These are the terms of the recursive Newton-Euler equations in world
+/// coordinates, where for each body i
+///
+///   V_i = V_parent + sum_j v_j * dq_j
+///   a_i = a_parent + sum_j (ad(V_i, v_j) * dq_j + v_j * ddq_j)
+///   F_i = G_i * (a_i - g) - dad(V_i, G_i * V_i) - Fext_i
+///
+/// with j running over the DOFs of the parent joint of i, and v_j the world
+/// screw of DOF j. tau_j = v_j^T times the sum of F over the subtree below
+/// DOF j. With ddq = 0 that's C(pos, vel), and with dq = 0, g = 0 and
+/// Fext = 0 that's M(pos) * ddq.
+struct WorldFrameDynamics
+{
+  /// For each body, the index of its parent body, or -1
+  std::vector<int> parents;
+
+  /// For each DOF, the index of the child body of its joint
+  std::vector<int> dofBodies;
+
+  /// For each body, the DOFs of its parent joint
+  std::vector<std::vector<std::size_t>> bodyDofs;
+
+  Eigen::VectorXd dq;
+  Eigen::VectorXd ddq;
+
+  /// For each DOF, the world screw that a unit change in velocity moves along
+  std::vector<Eigen::Vector6d> velScrews;
+
+  /// For each DOF, the world screw that a unit change in position moves every
+  /// body below it along
+  std::vector<Eigen::Vector6d> posScrews;
+
+  /// For each body, its spatial inertia in world coordinates
+  std::vector<Eigen::Matrix6d> inertia;
+
+  /// For each body, world coordinate terms from the equations above
+  std::vector<Eigen::Vector6d> V;
+  std::vector<Eigen::Vector6d> a;
+  std::vector<Eigen::Vector6d> gravity;
+  std::vector<Eigen::Vector6d> Fext;
+
+  /// For each body, the sum of F over its subtree
+  std::vector<Eigen::Vector6d> subtreeF;
+};
+
+//==============================================================================
+/// This runs the recursion above at the skeleton's current position. If
+/// `includeForces` is false, then gravity and external forces are left out.
+WorldFrameDynamics computeWorldFrameDynamics(
+    Skeleton* skel,
+    const Eigen::VectorXd& dq,
+    const Eigen::VectorXd& ddq,
+    bool includeForces)
+{
+  WorldFrameDynamics w;
+  const std::size_t numBodies = skel->getNumBodyNodes();
+  const std::size_t numDofs = skel->getNumDofs();
+
+  w.parents.resize(numBodies);
+  w.dofBodies.resize(numDofs);
+  w.bodyDofs.resize(numBodies);
+  w.dq = dq;
+  w.ddq = ddq;
+  w.velScrews.resize(numDofs);
+  w.posScrews.resize(numDofs);
+  w.inertia.resize(numBodies);
+  w.V.resize(numBodies);
+  w.a.resize(numBodies);
+  w.gravity.resize(numBodies);
+  w.Fext.resize(numBodies);
+  w.subtreeF.resize(numBodies);
+
+  Eigen::Vector6d worldGravity = Eigen::Vector6d::Zero();
+  worldGravity.tail<3>() = skel->getGravity();
+
+  // BodyNodes are always ordered parents before children
+  for (std::size_t i = 0; i < numBodies; i++)
+  {
+    const BodyNode* node = skel->getBodyNode(i);
+    const Joint* joint = node->getParentJoint();
+    const BodyNode* parentNode = node->getParentBodyNode();
+    w.parents[i]
+        = parentNode == nullptr ? -1 : parentNode->getIndexInSkeleton();
+    assert(w.parents[i] < static_cast<int>(i));
+
+    for (std::size_t d = 0; d < joint->getNumDofs(); d++)
+    {
+      std::size_t dof = joint->getIndexInSkeleton(d);
+      w.bodyDofs[i].push_back(dof);
+      w.dofBodies[dof] = i;
+      w.velScrews[dof] = joint->getWorldAxisScrewForVelocity(d);
+      w.posScrews[dof] = joint->getWorldAxisScrewForPosition(d);
+    }
+
+    const Eigen::Isometry3d& T = node->getWorldTransform();
+    const Eigen::Matrix6d AdInv = math::getAdTMatrix(T.inverse());
+    w.inertia[i] = AdInv.transpose()
+                   * node->getInertia().getSpatialTensor() * AdInv;
+    w.gravity[i] = includeForces && node->getGravityMode()
+                       ? worldGravity
+                       : Eigen::Vector6d::Zero();
+    w.Fext[i] = includeForces
+                    ? math::dAdInvT(T, node->getExternalForceLocal())
+                    : Eigen::Vector6d::Zero();
+
+    const int parent = w.parents[i];
+    w.V[i] = parent == -1 ? Eigen::Vector6d::Zero() : w.V[parent];
+    for (std::size_t dof : w.bodyDofs[i])
+    {
+      w.V[i] += w.velScrews[dof] * w.dq(dof);
+    }
+    w.a[i] = parent == -1 ? Eigen::Vector6d::Zero() : w.a[parent];
+    for (std::size_t dof : w.bodyDofs[i])
+    {
+      w.a[i] += math::ad(w.V[i], w.velScrews[dof]) * w.dq(dof)
+                + w.velScrews[dof] * w.ddq(dof);
+    }
+  }
+
+  for (std::size_t i = 0; i < numBodies; i++)
+  {
+    const Eigen::Matrix6d& G = w.inertia[i];
+    w.subtreeF[i] = G * (w.a[i] - w.gravity[i])
+                    - math::dad(w.V[i], G * w.V[i]) - w.Fext[i];
+  }
+  for (int i = numBodies - 1; i >= 0; i--)
+  {
+    if (w.parents[i] != -1)
+      w.subtreeF[w.parents[i]] += w.subtreeF[i];
+  }
+
+  return w;
+}
+
+//==============================================================================
+/// This differentiates the tau computed by computeWorldFrameDynamics() with
+/// respect to position, holding dq and ddq fixed.
+Eigen::MatrixXd jacobianOfWorldFrameDynamicsWrtPosition(
+    const WorldFrameDynamics& w)
+{
+  const std::size_t numBodies = w.parents.size();
+  const std::size_t numDofs = w.dofBodies.size();
+
+  Eigen::MatrixXd J = Eigen::MatrixXd::Zero(numDofs, numDofs);
+  std::vector<bool> moved(numBodies);
+  std::vector<Eigen::Vector6d> dV(numBodies);
+  std::vector<Eigen::Vector6d> da(numBodies);
+  std::vector<Eigen::Vector6d> dF(numBodies);
+
+  for (std::size_t k = 0; k < numDofs; k++)
+  {
+    const Eigen::Vector6d& screw = w.posScrews[k];
+
+    // Perturbing DOF k moves every body below it by exp(screw * eps), which
+    // changes every world quantity attached to those bodies by an ad(screw)
+    for (std::size_t i = 0; i < numBodies; i++)
+    {
+      const int parent = w.parents[i];
+      moved[i] = (static_cast<int>(i) == w.dofBodies[k])
+                 || (parent != -1 && moved[parent]);
+      if (!moved[i])
+      {
+        dV[i].setZero();
+        da[i].setZero();
+        dF[i].setZero();
+        continue;
+      }
+
+      dV[i] = parent == -1 ? Eigen::Vector6d::Zero() : dV[parent];
+      da[i] = parent == -1 ? Eigen::Vector6d::Zero() : da[parent];
+      for (std::size_t dof : w.bodyDofs[i])
+      {
+        dV[i] += math::ad(screw, w.velScrews[dof]) * w.dq(dof);
+      }
+      for (std::size_t dof : w.bodyDofs[i])
+      {
+        const Eigen::Vector6d dScrew = math::ad(screw, w.velScrews[dof]);
+        da[i] += (math::ad(dV[i], w.velScrews[dof])
+                  + math::ad(w.V[i], dScrew))
+                     * w.dq(dof)
+                 + dScrew * w.ddq(dof);
+      }
+
+      // d(G * x) = -dad(screw, G * x) - G * ad(screw, x)
+      const Eigen::Matrix6d& G = w.inertia[i];
+      auto dG = [&](const Eigen::Vector6d& x) -> Eigen::Vector6d {
+        return -math::dad(screw, G * x) - G * math::ad(screw, x);
+      };
+      dF[i] = dG(w.a[i] - w.gravity[i]) + G * da[i]
+              - math::dad(dV[i], G * w.V[i])
+              - math::dad(w.V[i], dG(w.V[i]) + G * dV[i])
+              + math::dad(screw, w.Fext[i]);
+    }
+
+    for (int i = numBodies - 1; i >= 0; i--)
+    {
+      if (w.parents[i] != -1)
+        dF[w.parents[i]] += dF[i];
+    }
+
+    for (std::size_t j = 0; j < numDofs; j++)
+    {
+      const int body = w.dofBodies[j];
+      J(j, k) = w.velScrews[j].dot(dF[body]);
+      if (moved[body])
+        J(j, k) += math::ad(screw, w.velScrews[j]).dot(w.subtreeF[body]);
+    }
+  }
+
+  return J;
+}
+
+//==============================================================================
+/// This gives jacobianOfWorldFrameDynamicsWrtPosition(w) * d, without forming
+/// the Jacobian.
+///
+/// Moving every DOF along d at once moves each body along the sum of d_k * s_k
+/// over the DOFs k above it (including its own), and everything in the
+/// derivative is linear in that screw. So this is the same sweep as one column
+/// of jacobianOfWorldFrameDynamicsWrtPosition(), with a per-body screw.
+Eigen::VectorXd jacobianProductOfWorldFrameDynamicsWrtPosition(
+    const WorldFrameDynamics& w, const Eigen::VectorXd& d)
+{
+  const std::size_t numBodies = w.parents.size();
+  const std::size_t numDofs = w.dofBodies.size();
+
+  std::vector<Eigen::Vector6d> screw(numBodies);
+  std::vector<Eigen::Vector6d> dV(numBodies);
+  std::vector<Eigen::Vector6d> da(numBodies);
+  std::vector<Eigen::Vector6d> dF(numBodies);
+
+  for (std::size_t i = 0; i < numBodies; i++)
+  {
+    const int parent = w.parents[i];
+    screw[i] = parent == -1 ? Eigen::Vector6d::Zero() : screw[parent];
+    for (std::size_t dof : w.bodyDofs[i])
+    {
+      screw[i] += w.posScrews[dof] * d(dof);
+    }
+
+    dV[i] = parent == -1 ? Eigen::Vector6d::Zero() : dV[parent];
+    da[i] = parent == -1 ? Eigen::Vector6d::Zero() : da[parent];
+    for (std::size_t dof : w.bodyDofs[i])
+    {
+      dV[i] += math::ad(screw[i], w.velScrews[dof]) * w.dq(dof);
+    }
+    for (std::size_t dof : w.bodyDofs[i])
+    {
+      const Eigen::Vector6d dScrew = math::ad(screw[i], w.velScrews[dof]);
+      da[i] += (math::ad(dV[i], w.velScrews[dof]) + math::ad(w.V[i], dScrew))
+                   * w.dq(dof)
+               + dScrew * w.ddq(dof);
+    }
+
+    const Eigen::Matrix6d& G = w.inertia[i];
+    auto dG = [&](const Eigen::Vector6d& x) -> Eigen::Vector6d {
+      return -math::dad(screw[i], G * x) - G * math::ad(screw[i], x);
+    };
+    dF[i] = dG(w.a[i] - w.gravity[i]) + G * da[i]
+            - math::dad(dV[i], G * w.V[i])
+            - math::dad(w.V[i], dG(w.V[i]) + G * dV[i])
+            + math::dad(screw[i], w.Fext[i]);
+  }
+
+  for (int i = numBodies - 1; i >= 0; i--)
+  {
+    if (w.parents[i] != -1)
+      dF[w.parents[i]] += dF[i];
+  }
+
+  Eigen::VectorXd result = Eigen::VectorXd::Zero(numDofs);
+  for (std::size_t j = 0; j < numDofs; j++)
+  {
+    const int body = w.dofBodies[j];
+    result(j) = w.velScrews[j].dot(dF[body])
+                + math::ad(screw[body], w.velScrews[j]).dot(w.subtreeF[body]);
+  }
+  return result;
+}
+
+//==============================================================================
+/// This gives the velocity Jacobian of the tau computed by
+/// computeWorldFrameDynamics() times d, without forming the Jacobian. This is
+/// one column of getJacobianOfCWrtVelocity(), with every DOF moving at once.
+Eigen::VectorXd jacobianProductOfWorldFrameDynamicsWrtVelocity(
+    const WorldFrameDynamics& w, const Eigen::VectorXd& d)
+{
+  const std::size_t numBodies = w.parents.size();
+  const std::size_t numDofs = w.dofBodies.size();
+
+  std::vector<Eigen::Vector6d> dV(numBodies);
+  std::vector<Eigen::Vector6d> da(numBodies);
+  std::vector<Eigen::Vector6d> dF(numBodies);
+
+  for (std::size_t i = 0; i < numBodies; i++)
+  {
+    const int parent = w.parents[i];
+    dV[i] = parent == -1 ? Eigen::Vector6d::Zero() : dV[parent];
+    da[i] = parent == -1 ? Eigen::Vector6d::Zero() : da[parent];
+    for (std::size_t dof : w.bodyDofs[i])
+    {
+      dV[i] += w.velScrews[dof] * d(dof);
+      da[i] += math::ad(w.V[i], w.velScrews[dof]) * d(dof);
+    }
+    for (std::size_t dof : w.bodyDofs[i])
+    {
+      da[i] += math::ad(dV[i], w.velScrews[dof]) * w.dq(dof);
+    }
+
+    const Eigen::Matrix6d& G = w.inertia[i];
+    dF[i] = G * da[i] - math::dad(dV[i], G * w.V[i])
+            - math::dad(w.V[i], G * dV[i]);
+  }
+
+  for (int i = numBodies - 1; i >= 0; i--)
+  {
+    if (w.parents[i] != -1)
+      dF[w.parents[i]] += dF[i];
+  }
+
+  Eigen::VectorXd result = Eigen::VectorXd::Zero(numDofs);
+  for (std::size_t j = 0; j < numDofs; j++)
+  {
+    result(j) = w.velScrews[j].dot(dF[w.dofBodies[j]]);
+  }
+  return result;
+}
+
+//==============================================================================
+/// For each body, this gives the world velocity it would have if the DOFs
+/// moved at velocity `u`. The tau computed by computeWorldFrameDynamics()
+/// then satisfies u^T * tau = sum_i W_i^T * F_i.
+std::vector<Eigen::Vector6d> virtualWorldVelocities(
+    const WorldFrameDynamics& w, const Eigen::VectorXd& u)
+{
+  const std::size_t numBodies = w.parents.size();
+  std::vector<Eigen::Vector6d> W(numBodies);
+  for (std::size_t i = 0; i < numBodies; i++)
+  {
+    const int parent = w.parents[i];
+    W[i] = parent == -1 ? Eigen::Vector6d::Zero() : W[parent];
+    for (std::size_t dof : w.bodyDofs[i])
+    {
+      W[i] += w.velScrews[dof] * u(dof);
+    }
+  }
+  return W;
+}
+
+//==============================================================================
+/// This replaces each entry with the sum of the entries over its subtree
+void accumulateSubtrees(
+    const WorldFrameDynamics& w, std::vector<Eigen::Vector6d>& x)
+{
+  for (int i = w.parents.size() - 1; i >= 0; i--)
+  {
+    if (w.parents[i] != -1)
+      x[w.parents[i]] += x[i];
+  }
+}
+
+//==============================================================================
+/// This gives u^T times jacobianOfWorldFrameDynamicsWrtPosition(w), without
+/// forming the Jacobian.
+///
+/// Perturbing DOF k moves the subtree below it by ad(s_k), so the change in
+/// every dV, da and dF in that subtree is a closed form in s_k, the body's
+/// own terms, and the V and a of the parent of DOF k's body. Dotting those
+/// with W_i leaves s_k^T times subtree sums we can accumulate in one
+/// backward pass.
+Eigen::VectorXd vectorJacobianProductOfWorldFrameDynamicsWrtPosition(
+    const WorldFrameDynamics& w, const Eigen::VectorXd& u)
+{
+  const std::size_t numBodies = w.parents.size();
+  const std::size_t numDofs = w.dofBodies.size();
+  const std::vector<Eigen::Vector6d> W = virtualWorldVelocities(w, u);
+
+  std::vector<Eigen::Vector6d> R(numBodies);
+  std::vector<Eigen::Vector6d> GW(numBodies);
+  std::vector<Eigen::Vector6d> dadVGW(numBodies);
+  std::vector<Eigen::Vector6d> dadWGV(numBodies);
+  std::vector<Eigen::Vector6d> GZ(numBodies);
+  for (std::size_t i = 0; i < numBodies; i++)
+  {
+    const Eigen::Matrix6d& G = w.inertia[i];
+    const Eigen::Vector6d GV = G * w.V[i];
+    const Eigen::Vector6d Z = math::ad(w.V[i], W[i]);
+    GW[i] = G * W[i];
+    dadVGW[i] = math::dad(w.V[i], GW[i]);
+    dadWGV[i] = math::dad(W[i], GV);
+    GZ[i] = G * Z;
+    R[i] = math::dad(W[i], G * (w.a[i] - w.gravity[i]))
+           - math::dad(w.gravity[i], GW[i]) - math::dad(w.V[i], dadWGV[i])
+           - math::dad(Z, GV) - math::dad(W[i], w.Fext[i]);
+
+    // This is from the rotation of the screws of the DOFs on this body
+    for (std::size_t dof : w.bodyDofs[i])
+    {
+      R[i] -= math::dad(w.velScrews[dof], w.subtreeF[i]) * u(dof);
+    }
+  }
+  accumulateSubtrees(w, R);
+  accumulateSubtrees(w, GW);
+  accumulateSubtrees(w, dadVGW);
+  accumulateSubtrees(w, dadWGV);
+  accumulateSubtrees(w, GZ);
+
+  Eigen::VectorXd result = Eigen::VectorXd::Zero(numDofs);
+  for (std::size_t k = 0; k < numDofs; k++)
+  {
+    const int body = w.dofBodies[k];
+    const int parent = w.parents[body];
+    Eigen::Vector6d r = R[body];
+    if (parent != -1)
+    {
+      const Eigen::Vector6d& Vp = w.V[parent];
+      r += math::dad(w.a[parent], GW[body]) - math::dad(Vp, dadVGW[body])
+           + math::dad(Vp, math::dad(Vp, GW[body]))
+           + math::dad(Vp, dadWGV[body]) - math::dad(Vp, GZ[body]);
+    }
+    result(k) = w.posScrews[k].dot(r);
+  }
+  return result;
+}
+
+} // namespace
+
+//==============================================================================
+/// Returns true if getJacobianOfCWrtPosition() and
+/// getJacobianOfCWrtVelocity() can be used on this skeleton
+bool Skeleton::canDifferentiateCAnalytically() const
+{
+  if (getNumSoftBodyNodes() > 0)
+    return false;
+
+  for (std::size_t i = 0; i < getNumJoints(); i++)
+  {
+    const std::string& type = getJoint(i)->getType();
+    if (type != WeldJoint::getStaticType()
+        && type != RevoluteJoint::getStaticType()
+        && type != PrismaticJoint::getStaticType()
+        && type != ScrewJoint::getStaticType()
+        && type != TranslationalJoint::getStaticType()
+        && type != TranslationalJoint2D::getStaticType()
+        && type != BallJoint::getStaticType()
+        && type != FreeJoint::getStaticType())
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+//==============================================================================
+/// This gives the Jacobian of C(pos, vel) with respect to position, computed
+/// analytically.
+Eigen::MatrixXd Skeleton::getJacobianOfCWrtPosition()
+{
+  assert(canDifferentiateCAnalytically());
+
+  const WorldFrameDynamics w = computeWorldFrameDynamics(
+      this, getVelocities(), Eigen::VectorXd::Zero(getNumDofs()), true);
+  return jacobianOfWorldFrameDynamicsWrtPosition(w);
+}
+
+//==============================================================================
+/// This gives the Jacobian of M^{-1}f with respect to position, computed
+/// analytically.
+Eigen::MatrixXd Skeleton::getJacobianOfMinvWrtPosition(const Eigen::VectorXd& f)
+{
+  assert(canDifferentiateCAnalytically());
+
+  // d(M^{-1}) = -M^{-1} * dM * M^{-1}, and dM * (M^{-1}f) is the derivative of
+  // inverse dynamics with ddq = M^{-1}f and nothing else acting on the
+  // skeleton. Joint armature is part of M, but doesn't depend on position.
+  const Eigen::MatrixXd& Minv = getInvMassMatrix();
+  const Eigen::VectorXd Minv_f = Minv * f;
+  const WorldFrameDynamics w = computeWorldFrameDynamics(
+      this, Eigen::VectorXd::Zero(getNumDofs()), Minv_f, false);
+  return -Minv * jacobianOfWorldFrameDynamicsWrtPosition(w);
+}
+
+//==============================================================================
+/// This gives the Jacobian of C(pos, vel) with respect to velocity, computed
+/// analytically.
+Eigen::MatrixXd Skeleton::getJacobianOfCWrtVelocity()
+{
+  assert(canDifferentiateCAnalytically());
+
+  const std::size_t numBodies = getNumBodyNodes();
+  const std::size_t numDofs = getNumDofs();
+  const WorldFrameDynamics w = computeWorldFrameDynamics(
+      this, getVelocities(), Eigen::VectorXd::Zero(numDofs), true);
+
+  Eigen::MatrixXd J = Eigen::MatrixXd::Zero(numDofs, numDofs);
+  std::vector<Eigen::Vector6d> dV(numBodies);
+  std::vector<Eigen::Vector6d> da(numBodies);
+  std::vector<Eigen::Vector6d> dF(numBodies);
+
+  for (std::size_t k = 0; k < numDofs; k++)
+  {
+    // Velocity doesn't move any screws, it only changes V below DOF k
+    for (std::size_t i = 0; i < numBodies; i++)
+    {
+      const int parent = w.parents[i];
+      dV[i] = parent == -1 ? Eigen::Vector6d::Zero() : dV[parent];
+      da[i] = parent == -1 ? Eigen::Vector6d::Zero() : da[parent];
+      if (static_cast<int>(i) == w.dofBodies[k])
+      {
+        dV[i] += w.velScrews[k];
+        da[i] += math::ad(w.V[i], w.velScrews[k]);
+      }
+      for (std::size_t dof : w.bodyDofs[i])
+      {
+        da[i] += math::ad(dV[i], w.velScrews[dof]) * w.dq(dof);
+      }
+
+      const Eigen::Matrix6d& G = w.inertia[i];
+      dF[i] = G * da[i] - math::dad(dV[i], G * w.V[i])
+              - math::dad(w.V[i], G * dV[i]);
+    }
+
+    for (int i = numBodies - 1; i >= 0; i--)
+    {
+      if (w.parents[i] != -1)
+        dF[w.parents[i]] += dF[i];
+    }
+
+    for (std::size_t j = 0; j < numDofs; j++)
+    {
+      J(j, k) = w.velScrews[j].dot(dF[w.dofBodies[j]]);
+    }
+  }
+
+  return J;
+}
+
+//==============================================================================
+/// This gives getJacobianOfC(WithRespectTo::POSITION)^T * u, without forming
+/// the Jacobian if we can differentiate C analytically.
+Eigen::VectorXd Skeleton::getJacobianOfCWrtPositionTransposeTimes(
+    const Eigen::VectorXd& u)
+{
+  if (!canDifferentiateCAnalytically())
+  {
+    return getJacobianOfC(neural::WithRespectTo::POSITION).transpose() * u;
+  }
+
+  const WorldFrameDynamics w = computeWorldFrameDynamics(
+      this, getVelocities(), Eigen::VectorXd::Zero(getNumDofs()), true);
+  return vectorJacobianProductOfWorldFrameDynamicsWrtPosition(w, u);
+}
+
+//==============================================================================
+/// This gives getJacobianOfC(WithRespectTo::VELOCITY)^T * u, without forming
+/// the Jacobian if we can differentiate C analytically.
+Eigen::VectorXd Skeleton::getJacobianOfCWrtVelocityTransposeTimes(
+    const Eigen::VectorXd& u)
+{
+  if (!canDifferentiateCAnalytically())
+  {
+    return getJacobianOfC(neural::WithRespectTo::VELOCITY).transpose() * u;
+  }
+
+  const std::size_t numBodies = getNumBodyNodes();
+  const std::size_t numDofs = getNumDofs();
+  const WorldFrameDynamics w = computeWorldFrameDynamics(
+      this, getVelocities(), Eigen::VectorXd::Zero(numDofs), true);
+  const std::vector<Eigen::Vector6d> W = virtualWorldVelocities(w, u);
+
+  // Changing the velocity of DOF k by one adds v_k to V everywhere below it,
+  // and [v_k, V_i - V_parent - V_body] to a, where body is DOF k's body and
+  // parent is that body's parent. Dotting the resulting dF with W leaves v_k^T
+  // times subtree sums.
+  std::vector<Eigen::Vector6d> R(numBodies);
+  std::vector<Eigen::Vector6d> GW(numBodies);
+  for (std::size_t i = 0; i < numBodies; i++)
+  {
+    const Eigen::Matrix6d& G = w.inertia[i];
+    GW[i] = G * W[i];
+    R[i] = math::dad(W[i], G * w.V[i]) - math::dad(w.V[i], GW[i])
+           - G * math::ad(w.V[i], W[i]);
+  }
+  accumulateSubtrees(w, R);
+  accumulateSubtrees(w, GW);
+
+  Eigen::VectorXd result = Eigen::VectorXd::Zero(numDofs);
+  for (std::size_t k = 0; k < numDofs; k++)
+  {
+    const int body = w.dofBodies[k];
+    const int parent = w.parents[body];
+    Eigen::Vector6d D = w.V[body];
+    if (parent != -1)
+      D += w.V[parent];
+    result(k) = w.velScrews[k].dot(R[body] + math::dad(D, GW[body]));
+  }
+  return result;
+}
+
+//==============================================================================
+/// This gives getJacobianOfMinv(f, WithRespectTo::POSITION)^T * u, without
+/// forming the Jacobian if we can differentiate analytically.
+Eigen::VectorXd Skeleton::getJacobianOfMinvWrtPositionTransposeTimes(
+    const Eigen::VectorXd& f, const Eigen::VectorXd& u)
+{
+  if (!canDifferentiateCAnalytically())
+  {
+    return getJacobianOfMinv(f, neural::WithRespectTo::POSITION).transpose()
+           * u;
+  }
+
+  // This is the transpose of getJacobianOfMinvWrtPosition(), so it's
+  // -dM^T * M^{-1}u, and M is symmetric.
+  const Eigen::VectorXd Minv_f = multiplyByImplicitInvMassMatrix(f);
+  const Eigen::VectorXd Minv_u = multiplyByImplicitInvMassMatrix(u);
+  const WorldFrameDynamics w = computeWorldFrameDynamics(
+      this, Eigen::VectorXd::Zero(getNumDofs()), Minv_f, false);
+  return -vectorJacobianProductOfWorldFrameDynamicsWrtPosition(w, Minv_u);
+}
+
+//==============================================================================
+/// This gives getJacobianOfC(WithRespectTo::POSITION) * D, without forming the
+/// Jacobian if we can differentiate C analytically.
+Eigen::MatrixXd Skeleton::getJacobianOfCWrtPositionTimes(
+    const Eigen::MatrixXd& D)
+{
+  if (!canDifferentiateCAnalytically())
+  {
+    return getJacobianOfC(neural::WithRespectTo::POSITION) * D;
+  }
+
+  const WorldFrameDynamics w = computeWorldFrameDynamics(
+      this, getVelocities(), Eigen::VectorXd::Zero(getNumDofs()), true);
+  Eigen::MatrixXd result(getNumDofs(), D.cols());
+  for (int col = 0; col < D.cols(); col++)
+  {
+    result.col(col)
+        = jacobianProductOfWorldFrameDynamicsWrtPosition(w, D.col(col));
+  }
+  return result;
+}
+
+//==============================================================================
+/// This gives getJacobianOfC(WithRespectTo::VELOCITY) * D, without forming the
+/// Jacobian if we can differentiate C analytically.
+Eigen::MatrixXd Skeleton::getJacobianOfCWrtVelocityTimes(
+    const Eigen::MatrixXd& D)
+{
+  if (!canDifferentiateCAnalytically())
+  {
+    return getJacobianOfC(neural::WithRespectTo::VELOCITY) * D;
+  }
+
+  const WorldFrameDynamics w = computeWorldFrameDynamics(
+      this, getVelocities(), Eigen::VectorXd::Zero(getNumDofs()), true);
+  Eigen::MatrixXd result(getNumDofs(), D.cols());
+  for (int col = 0; col < D.cols(); col++)
+  {
+    result.col(col)
+        = jacobianProductOfWorldFrameDynamicsWrtVelocity(w, D.col(col));
+  }
+  return result;
+}
+
+//==============================================================================
+/// This gives getJacobianOfMinv(f, WithRespectTo::POSITION) * D, without
+/// forming the Jacobian if we can differentiate analytically.
+Eigen::MatrixXd Skeleton::getJacobianOfMinvWrtPositionTimes(
+    const Eigen::VectorXd& f, const Eigen::MatrixXd& D)
+{
+  if (!canDifferentiateCAnalytically())
+  {
+    return getJacobianOfMinv(f, neural::WithRespectTo::POSITION) * D;
+  }
+
+  // This is -M^{-1} * dM * M^{-1}f, same as getJacobianOfMinvWrtPosition()
+  const Eigen::VectorXd Minv_f = multiplyByImplicitInvMassMatrix(f);
+  const WorldFrameDynamics w = computeWorldFrameDynamics(
+      this, Eigen::VectorXd::Zero(getNumDofs()), Minv_f, false);
+  Eigen::MatrixXd result(getNumDofs(), D.cols());
+  for (int col = 0; col < D.cols(); col++)
+  {
+    result.col(col) = -multiplyByImplicitInvMassMatrix(
+        jacobianProductOfWorldFrameDynamicsWrtPosition(w, D.col(col)));
+  }
+  return result;
+}
+
 //==============================================================================
 Eigen::MatrixXd Skeleton::finiteDifferenceJacobianOfC(
     neural::WithRespectTo* wrt, bool useRidders)
@@ -2904,6 +3690,16 @@ const Eigen::MatrixXd& Skeleton::getInvMassMatrix() const
   return mSkelCache.mInvM;
 }
 
+//==============================================================================
+const MassMatrixFactorization& Skeleton::getMassMatrixFactorization(
+    std::size_t _treeIdx) const
+{
+  if (mTreeCache[_treeIdx].mDirty.mMassMatrixFactorization)
+    updateMassMatrixFactorization(_treeIdx);
+
+  return mTreeCache[_treeIdx].mMassMatrixFactorization;
+}
+
 //==============================================================================
 const Eigen::MatrixXd& Skeleton::getInvAugMassMatrix(std::size_t _treeIdx) const
 {
@@ -3000,6 +3796,39 @@ Eigen::VectorXd Skeleton::multiplyByImplicitInvMassMatrix(Eigen::VectorXd x)
     return x;
   }
 
+  // If we've already factored the mass matrix of every tree, solving against
+  // those factorizations is cheaper than another articulated body pass
+  bool reuseFactorizations = true;
+  for (std::size_t tree = 0; tree < mTreeCache.size(); ++tree)
+  {
+    if (mTreeCache[tree].mDirty.mMassMatrixFactorization
+        || !canInvertMassMatrixByFactorization(tree))
+    {
+      reuseFactorizations = false;
+      break;
+    }
+  }
+  if (reuseFactorizations)
+  {
+    Eigen::VectorXd result = Eigen::VectorXd(dof);
+    for (std::size_t tree = 0; tree < mTreeCache.size(); ++tree)
+    {
+      const std::vector<DegreeOfFreedom*>& treeDofs = mTreeCache[tree].mDofs;
+      std::size_t nTreeDofs = treeDofs.size();
+      if (nTreeDofs == 0)
+        continue;
+
+      Eigen::VectorXd treeX = Eigen::VectorXd(nTreeDofs);
+      for (std::size_t i = 0; i < nTreeDofs; ++i)
+        treeX(i) = x(treeDofs[i]->getIndexInSkeleton());
+      const Eigen::VectorXd treeResult
+          = mTreeCache[tree].mMassMatrixFactorization.solve(treeX);
+      for (std::size_t i = 0; i < nTreeDofs; ++i)
+        result(treeDofs[i]->getIndexInSkeleton()) = treeResult(i);
+    }
+    return result;
+  }
+
   // Backup the origianl internal force
   Eigen::VectorXd originalInternalForce = getForces();
 
@@ -3844,53 +4673,63 @@ void Skeleton::updateMassMatrix(std::size_t _treeIdx) const
     return;
   }
 
-  cache.mM.setZero();
-
-  // Backup the original internal force
-  Eigen::VectorXd originalGenAcceleration = getAccelerations();
-
-  // Clear out the accelerations of the dofs in this tree so that we can set
-  // them to 1.0 one at a time to build up the mass matrix
-  for (std::size_t i = 0; i < dof; ++i)
-    cache.mDofs[i]->setAcceleration(0.0);
-
-  for (std::size_t j = 0; j < dof; ++j)
+  // This is the Composite Rigid Body Algorithm. First we accumulate the
+  // spatial inertia of each subtree in the frame of its root body, going
+  // leaves-first.
+  const std::size_t numBodies = cache.mBodyNodes.size();
+  common::aligned_vector<Eigen::Matrix6d> composite(numBodies);
+  for (std::size_t i = 0; i < numBodies; ++i)
   {
-    // Set the acceleration of this DOF to 1.0 while all the rest are 0.0
-    cache.mDofs[j]->setAcceleration(1.0);
-
-    // Prepare cache data
-    for (std::vector<BodyNode*>::const_iterator it = cache.mBodyNodes.begin();
-         it != cache.mBodyNodes.end();
-         ++it)
+    composite[i] = cache.mBodyNodes[i]->getSpatialInertia();
+  }
+  for (std::size_t i = numBodies; i-- > 0;)
+  {
+    const BodyNode* body = cache.mBodyNodes[i];
+    if (body->mParentBodyNode)
     {
-      (*it)->updateMassMatrix();
+      composite[body->mParentBodyNode->getIndexInTree()]
+          += math::transformInertia(
+              body->mParentJoint->getRelativeTransform().inverse(),
+              composite[i]);
     }
+  }
 
-    // Mass matrix
-    for (std::vector<BodyNode*>::const_reverse_iterator it
-         = cache.mBodyNodes.rbegin();
-         it != cache.mBodyNodes.rend();
-         ++it)
-    {
-      (*it)->aggregateMassMatrix(cache.mM, j);
-      std::size_t localDof = (*it)->mParentJoint->getNumDofs();
-      if (localDof > 0)
-      {
-        std::size_t iStart = (*it)->mParentJoint->getIndexInTree(0);
+  // Then the columns of M for each joint's DOFs are the forces it takes to
+  // accelerate that joint's whole subtree, projected onto each joint between
+  // that joint and the root.
+  cache.mM.setZero();
+  for (std::size_t i = 0; i < numBodies; ++i)
+  {
+    const BodyNode* body = cache.mBodyNodes[i];
+    const std::size_t localDof = body->mParentJoint->getNumDofs();
+    if (localDof == 0)
+      continue;
 
-        if (iStart + localDof < j)
-          break;
-      }
-    }
+    const std::size_t iStart = body->mParentJoint->getIndexInTree(0);
+    const math::Jacobian& S = body->mParentJoint->getRelativeJacobian();
+    math::Jacobian F = composite[i] * S;
+    cache.mM.block(iStart, iStart, localDof, localDof).noalias()
+        = S.transpose() * F;
 
-    // Set the acceleration of this DOF back to 0.0
-    cache.mDofs[j]->setAcceleration(0.0);
+    for (const BodyNode* child = body; child->mParentBodyNode != nullptr;
+         child = child->mParentBodyNode)
+    {
+      const Eigen::Isometry3d& T = child->mParentJoint->getRelativeTransform();
+      for (std::size_t k = 0; k < localDof; ++k)
+        F.col(k) = math::dAdInvT(T, F.col(k));
+
+      const Joint* joint = child->mParentBodyNode->mParentJoint;
+      const std::size_t jointDof = joint->getNumDofs();
+      if (jointDof == 0)
+        continue;
+
+      const std::size_t jStart = joint->getIndexInTree(0);
+      cache.mM.block(jStart, iStart, jointDof, localDof).noalias()
+          = joint->getRelativeJacobian().transpose() * F;
+      cache.mM.block(iStart, jStart, localDof, jointDof)
+          = cache.mM.block(jStart, iStart, jointDof, localDof).transpose();
+    }
   }
-  cache.mM.triangularView<Eigen::StrictlyUpper>() = cache.mM.transpose();
-
-  // Restore the original generalized accelerations
-  const_cast<Skeleton*>(this)->setAccelerations(originalGenAcceleration);
 
   cache.mDirty.mMassMatrix = false;
 }
@@ -3944,6 +4783,23 @@ void Skeleton::updateAugMassMatrix(std::size_t _treeIdx) const
     return;
   }
 
+  // Without soft bodies, the augmented mass matrix is just M plus the
+  // implicit damping and spring terms on the diagonal, so we can reuse M
+  if (getNumSoftBodyNodes() == 0)
+  {
+    const double timeStep = mAspectProperties.mTimeStep;
+    cache.mAugM = getMassMatrix(_treeIdx);
+    for (std::size_t i = 0; i < dof; ++i)
+    {
+      const DegreeOfFreedom* treeDof = cache.mDofs[i];
+      cache.mAugM(i, i) += timeStep * treeDof->getDampingCoefficient()
+                           + timeStep * timeStep
+                                 * treeDof->getSpringStiffness();
+    }
+    cache.mDirty.mAugMassMatrix = false;
+    return;
+  }
+
   cache.mAugM.setZero();
 
   // Backup the origianl internal force
@@ -4045,6 +4901,13 @@ void Skeleton::updateInvMassMatrix(std::size_t _treeIdx) const
     return;
   }
 
+  if (canInvertMassMatrixByFactorization(_treeIdx))
+  {
+    cache.mInvM = getMassMatrixFactorization(_treeIdx).getInverse();
+    cache.mDirty.mInvMassMatrix = false;
+    return;
+  }
+
   // We don't need to set mInvM as zero matrix as long as the below is correct
   // cache.mInvM.setZero();
 
@@ -4132,6 +4995,56 @@ void Skeleton::updateInvMassMatrix() const
   mSkelCache.mDirty.mInvMassMatrix = false;
 }
 
+//==============================================================================
+void Skeleton::updateMassMatrixFactorization(std::size_t _treeIdx) const
+{
+  DataCache& cache = mTreeCache[_treeIdx];
+
+  // Each DOF's parent is the DOF before it in the same joint, or else the last
+  // DOF of the closest joint above it that has any
+  std::vector<int> parents(cache.mDofs.size());
+  std::vector<int> lastDof(cache.mBodyNodes.size());
+  for (std::size_t i = 0; i < cache.mBodyNodes.size(); ++i)
+  {
+    const BodyNode* body = cache.mBodyNodes[i];
+    const BodyNode* parentBody = body->mParentBodyNode;
+    int parent
+        = parentBody == nullptr ? -1 : lastDof[parentBody->getIndexInTree()];
+    for (std::size_t k = 0; k < body->mParentJoint->getNumDofs(); ++k)
+    {
+      const std::size_t index = body->mParentJoint->getIndexInTree(k);
+      parents[index] = parent;
+      parent = static_cast<int>(index);
+    }
+    lastDof[i] = parent;
+  }
+
+  cache.mMassMatrixFactorization.compute(getMassMatrix(_treeIdx), parents);
+  cache.mDirty.mMassMatrixFactorization = false;
+}
+
+//==============================================================================
+bool Skeleton::canInvertMassMatrixByFactorization(std::size_t _treeIdx) const
+{
+  for (const BodyNode* body : mTreeCache[_treeIdx].mBodyNodes)
+  {
+    if (body->asSoftBodyNode() != nullptr)
+      return false;
+
+    switch (body->mParentJoint->getActuatorType())
+    {
+      case Joint::FORCE:
+      case Joint::PASSIVE:
+      case Joint::SERVO:
+      case Joint::MIMIC:
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
 //==============================================================================
 void Skeleton::updateInvAugMassMatrix(std::size_t _treeIdx) const
 {
@@ -4799,6 +5712,7 @@ void Skeleton::dirtyArticulatedInertia(std::size_t _treeIdx)
   SET_FLAG(_treeIdx, mAugMassMatrix);
   SET_FLAG(_treeIdx, mInvMassMatrix);
   SET_FLAG(_treeIdx, mInvAugMassMatrix);
+  SET_FLAG(_treeIdx, mMassMatrixFactorization);
   SET_FLAG(_treeIdx, mCoriolisForces);
   SET_FLAG(_treeIdx, mGravityForces);
   SET_FLAG(_treeIdx, mCoriolisAndGravityForces);
@@ -5253,6 +6167,7 @@ Skeleton::DirtyFlags::DirtyFlags()
     mAugMassMatrix(true),
     mInvMassMatrix(true),
     mInvAugMassMatrix(true),
+    mMassMatrixFactorization(true),
     mGravityForces(true),
     mCoriolisForces(true),
     mCoriolisAndGravityForces(true),
@@ -42,6 +42,7 @@
 #include "dart/dynamics/HierarchicalIK.hpp"
 #include "dart/dynamics/Joint.hpp"
 #include "dart/dynamics/Marker.hpp"
+#include "dart/dynamics/MassMatrixFactorization.hpp"
 #include "dart/dynamics/MetaSkeleton.hpp"
 #include "dart/dynamics/ShapeNode.hpp"
 #include "dart/dynamics/SmartPointer.hpp"
@@ -54,6 +55,7 @@ namespace dart {
 
 namespace neural {
 class ConstrainedGroupGradientMatrices;
+class WithRespectToMass;
 }
 
 namespace dynamics {
@@ -599,6 +601,79 @@ public:
   Eigen::MatrixXd getJacobianOfMinv(
       Eigen::VectorXd f, neural::WithRespectTo* wrt);
 
+  /// This gives the Jacobian of C(pos, vel) with respect to the link masses,
+  /// COMs and moments of inertia tracked by `wrt`, computed analytically.
+  /// Every BodyNode's contribution to C is linear in its spatial inertia, so
+  /// each column is just one body's term of the recursive Newton-Euler sum
+  /// with the spatial inertia swapped for its derivative.
+  Eigen::MatrixXd getJacobianOfCWrtMass(neural::WithRespectToMass* wrt);
+
+  /// This gives the Jacobian of M^{-1}f with respect to the link masses, COMs
+  /// and moments of inertia tracked by `wrt`, computed analytically, using
+  /// d(M^{-1}f) = -M^{-1} * dM * M^{-1}f with dM = J^T * dG * J.
+  Eigen::MatrixXd getJacobianOfMinvWrtMass(
+      Eigen::VectorXd f, neural::WithRespectToMass* wrt);
+
+  /// Returns true if getJacobianOfCWrtPosition(), getJacobianOfCWrtVelocity()
+  /// and getJacobianOfMinvWrtPosition() can be used on this skeleton. That
+  /// requires every joint's relative Jacobian to be constant in that joint's
+  /// position, which is true for weld, revolute, prismatic, screw,
+  /// translational, ball, and free joints, and no soft bodies. Otherwise we
+  /// fall back to finite differences.
+  bool canDifferentiateCAnalytically() const;
+
+  /// This gives the Jacobian of C(pos, vel) with respect to position,
+  /// computed analytically. We run the recursive Newton-Euler equations in
+  /// world coordinates, where moving a DOF just rigidly moves every body below
+  /// it along that DOF's screw axis, and differentiate one forward and one
+  /// backward sweep per DOF. That's O(N^2) without ever changing the
+  /// skeleton's state.
+  Eigen::MatrixXd getJacobianOfCWrtPosition();
+
+  /// This gives the Jacobian of C(pos, vel) with respect to velocity,
+  /// computed analytically, the same way as getJacobianOfCWrtPosition().
+  Eigen::MatrixXd getJacobianOfCWrtVelocity();
+
+  /// This gives the Jacobian of M^{-1}f with respect to position, computed
+  /// analytically, using d(M^{-1}f) = -M^{-1} * dM * M^{-1}f. dM * M^{-1}f is
+  /// the position derivative of inverse dynamics with M^{-1}f as the
+  /// acceleration, which we get the same way as getJacobianOfCWrtPosition().
+  /// This reuses the cached M^{-1}, rather than refactoring M 2N times.
+  Eigen::MatrixXd getJacobianOfMinvWrtPosition(const Eigen::VectorXd& f);
+
+  /// This gives getJacobianOfC(WithRespectTo::POSITION)^T * u in O(n), by
+  /// running the derivative in getJacobianOfCWrtPosition() backwards over the
+  /// tree, rather than forming the Jacobian. If we can't differentiate C
+  /// analytically, this forms the Jacobian with getJacobianOfC().
+  Eigen::VectorXd getJacobianOfCWrtPositionTransposeTimes(
+      const Eigen::VectorXd& u);
+
+  /// This gives getJacobianOfC(WithRespectTo::VELOCITY)^T * u in O(n), the
+  /// same way as getJacobianOfCWrtPositionTransposeTimes().
+  Eigen::VectorXd getJacobianOfCWrtVelocityTransposeTimes(
+      const Eigen::VectorXd& u);
+
+  /// This gives getJacobianOfMinv(f, WithRespectTo::POSITION)^T * u, the same
+  /// way as getJacobianOfCWrtPositionTransposeTimes().
+  Eigen::VectorXd getJacobianOfMinvWrtPositionTransposeTimes(
+      const Eigen::VectorXd& f, const Eigen::VectorXd& u);
+
+  /// This gives getJacobianOfC(WithRespectTo::POSITION) * D, one column per
+  /// column of D. Moving along a direction moves each body along the sum of
+  /// the screws above it, so each column is a single O(n) forward sweep of the
+  /// derivative in getJacobianOfCWrtPosition(). If we can't differentiate C
+  /// analytically, this forms the Jacobian with getJacobianOfC().
+  Eigen::MatrixXd getJacobianOfCWrtPositionTimes(const Eigen::MatrixXd& D);
+
+  /// This gives getJacobianOfC(WithRespectTo::VELOCITY) * D, the same way as
+  /// getJacobianOfCWrtPositionTimes().
+  Eigen::MatrixXd getJacobianOfCWrtVelocityTimes(const Eigen::MatrixXd& D);
+
+  /// This gives getJacobianOfMinv(f, WithRespectTo::POSITION) * D, the same
+  /// way as getJacobianOfCWrtPositionTimes().
+  Eigen::MatrixXd getJacobianOfMinvWrtPositionTimes(
+      const Eigen::VectorXd& f, const Eigen::MatrixXd& D);
+
   /// VERY SLOW: Only for testing. This computes the unconstrained Jacobian
   /// giving the difference in C(pos, vel) for finite changes
   Eigen::MatrixXd finiteDifferenceJacobianOfC(
@@ -1026,6 +1101,12 @@ public:
   // Documentation inherited
   const Eigen::MatrixXd& getInvAugMassMatrix() const override;
 
+  /// Get the sparse L^T * D * L factorization of the mass matrix of a tree.
+  /// This is cached alongside the mass matrix, so solving against it is
+  /// cheap until the tree moves.
+  const MassMatrixFactorization& getMassMatrixFactorization(
+      std::size_t _treeIdx) const;
+
   // Returns the value of M*x, left multiplying x by the mass matrix. This is
   // O(n) compared with O(n^2) to form the complete mass matrix and then
   // multiply.
@@ -1033,7 +1114,8 @@ public:
 
   // Returns the value of M_inv*x, left multiplying x by the inverse mass
   // matrix. This is O(n) compared with O(n^2) to form the complete inverse mass
-  // matrix and then multiply.
+  // matrix and then multiply. If the mass matrix factorization of every tree
+  // is already up to date, this solves against those instead.
   Eigen::VectorXd multiplyByImplicitInvMassMatrix(Eigen::VectorXd x);
 
   /// Get the Coriolis force vector of a tree in this Skeleton
@@ -1304,6 +1386,16 @@ protected:
   /// Update inverse of mass matrix of the skeleton.
   void updateInvMassMatrix() const;
 
+  /// Update the mass matrix factorization of a tree
+  void updateMassMatrixFactorization(std::size_t _treeIdx) const;
+
+  /// Returns true if the inverse of the mass matrix of a tree, as computed by
+  /// the articulated body algorithm, is exactly the inverse of
+  /// getMassMatrix(). That's not the case for kinematically actuated joints,
+  /// or for soft bodies, which the articulated body algorithm handles
+  /// differently.
+  bool canInvertMassMatrixByFactorization(std::size_t _treeIdx) const;
+
   /// Update the inverse augmented mass matrix of a tree
   void updateInvAugMassMatrix(std::size_t _treeIdx) const;
 
@@ -1393,6 +1485,9 @@ protected:
     /// Dirty flag for the inverse of augmented mass matrix.
     bool mInvAugMassMatrix;
 
+    /// Dirty flag for the mass matrix factorization.
+    bool mMassMatrixFactorization;
+
     /// Dirty flag for the gravity force vector.
     bool mGravityForces;
 
@@ -1447,6 +1542,9 @@ protected:
     /// Inverse of augmented mass matrix for the skeleton.
     Eigen::MatrixXd mInvAugM;
 
+    /// Factorization of mM. Only kept for each tree, not for the skeleton.
+    MassMatrixFactorization mMassMatrixFactorization;
+
     /// Coriolis vector for the skeleton which is C(q,dq)*dq.
     Eigen::VectorXd mCvec;
 
@@ -5,7 +5,9 @@
 #include <array>
 
 #include "dart/constraint/ConstraintSolver.hpp"
+#include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/DegreeOfFreedom.hpp"
+#include "dart/dynamics/Joint.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/neural/ConstrainedGroupGradientMatrices.hpp"
 #include "dart/neural/DifferentiableContactConstraint.hpp"
@@ -149,7 +151,31 @@ void BackpropSnapshot::backprop(
   // using ConstrainedGroups directly. Currently it's redundant to construct
   // Jacobians _both_ in the ConstrainedGroups and in the BackpropSnapshot, so
   // it's better overall to just use one.
-  if (exploreAlternateStrategies == false)
+  // The vector-Jacobian path is fully matrix-free, through clamping and
+  // contact geometry too. Only the mass term still needs a Jacobian, so with
+  // mass dimensions we stick with the cached Jacobians below.
+  if (exploreAlternateStrategies == false && !mUseFDOverride
+      && !mSlowDebugResultsAgainstFD && world->getMassDims() == 0)
+  {
+    backpropWithoutJacobians(
+        world, thisTimestepLoss, nextTimestepLoss, thisLog);
+
+    clipLossGradientsToBounds(
+        world,
+        thisTimestepLoss.lossWrtPosition,
+        thisTimestepLoss.lossWrtVelocity,
+        thisTimestepLoss.lossWrtTorque);
+
+#ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
+    if (thisLog != nullptr)
+    {
+      thisLog->end();
+    }
+#endif
+    snapshot.restore();
+    return;
+  }
+  else if (exploreAlternateStrategies == false)
   {
     const Eigen::MatrixXd& posPos = getPosPosJacobian(world, thisLog);
     const Eigen::MatrixXd& posVel = getPosVelJacobian(world, thisLog);
@@ -368,6 +394,513 @@ void BackpropSnapshot::backprop(
 #endif
 }
 
+//==============================================================================
+/// This gives the transpose of the integrator's block diagonal pos-pos
+/// Jacobian (or vel-pos Jacobian, if `wrtVel`) times `x`, one joint block at a
+/// time, in the same order as Skeleton::getPosPosJac()
+Eigen::VectorXd BackpropSnapshot::integratorJacobianTransposeTimes(
+    simulation::WorldPtr world, const Eigen::VectorXd& x, bool wrtVel)
+{
+  Eigen::VectorXd result = Eigen::VectorXd::Zero(x.size());
+  double dt = world->getTimeStep();
+  int cursor = 0;
+  for (std::size_t i = 0; i < world->getNumSkeletons(); i++)
+  {
+    SkeletonPtr skel = world->getSkeleton(i);
+    for (std::size_t j = 0; j < skel->getNumBodyNodes(); j++)
+    {
+      Joint* joint = skel->getBodyNode(j)->getParentJoint();
+      int dofs = joint->getNumDofs();
+      if (dofs == 0)
+      {
+        continue;
+      }
+      Eigen::VectorXd pos = joint->getPositions();
+      Eigen::VectorXd vel = joint->getVelocities();
+      Eigen::MatrixXd jac = wrtVel ? joint->getVelPosJacobian(pos, vel, dt)
+                                   : joint->getPosPosJacobian(pos, vel, dt);
+      result.segment(cursor, dofs) = jac.transpose() * x.segment(cursor, dofs);
+      cursor += dofs;
+    }
+  }
+  return result;
+}
+
+//==============================================================================
+/// This gives the integrator's block diagonal pos-pos Jacobian (or vel-pos
+/// Jacobian, if `wrtVel`) times each column of `x`, the same way as
+/// integratorJacobianTransposeTimes()
+Eigen::MatrixXd BackpropSnapshot::integratorJacobianTimes(
+    simulation::WorldPtr world, const Eigen::MatrixXd& x, bool wrtVel)
+{
+  Eigen::MatrixXd result = Eigen::MatrixXd::Zero(x.rows(), x.cols());
+  double dt = world->getTimeStep();
+  int cursor = 0;
+  for (std::size_t i = 0; i < world->getNumSkeletons(); i++)
+  {
+    SkeletonPtr skel = world->getSkeleton(i);
+    for (std::size_t j = 0; j < skel->getNumBodyNodes(); j++)
+    {
+      Joint* joint = skel->getBodyNode(j)->getParentJoint();
+      int dofs = joint->getNumDofs();
+      if (dofs == 0)
+      {
+        continue;
+      }
+      Eigen::VectorXd pos = joint->getPositions();
+      Eigen::VectorXd vel = joint->getVelocities();
+      Eigen::MatrixXd jac = wrtVel ? joint->getVelPosJacobian(pos, vel, dt)
+                                   : joint->getPosPosJacobian(pos, vel, dt);
+      result.middleRows(cursor, dofs) = jac * x.middleRows(cursor, dofs);
+      cursor += dofs;
+    }
+  }
+  return result;
+}
+
+//==============================================================================
+void BackpropSnapshot::backpropWithoutJacobians(
+    simulation::WorldPtr world,
+    LossGradient& thisTimestepLoss,
+    const LossGradient& nextTimestepLoss,
+    PerformanceLog* perfLog)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
+  if (perfLog != nullptr)
+  {
+    thisLog = perfLog->startRun("BackpropSnapshot.backpropWithoutJacobians");
+  }
+#endif
+
+  RestorableSnapshot snapshot(world);
+  world->setPositions(mPreStepPosition);
+  world->setVelocities(mPreStepVelocity);
+  world->setExternalForces(mPreStepTorques);
+  world->setCachedLCPSolution(mPreStepLCPCache);
+
+  const Eigen::VectorXd& g_p = nextTimestepLoss.lossWrtPosition;
+  const Eigen::VectorXd& g_v = nextTimestepLoss.lossWrtVelocity;
+  double dt = world->getTimeStep();
+
+  // The integrator: pos-pos = P * X and vel-pos = V * X, where P and V are
+  // block diagonal by joint, and X is the bounce approximation (identity if
+  // nothing bounced)
+
+  Eigen::VectorXd posFromPos
+      = integratorJacobianTransposeTimes(world, g_p, false);
+  Eigen::VectorXd velFromPos
+      = integratorJacobianTransposeTimes(world, g_p, true);
+  if (hasBounces())
+  {
+    const Eigen::MatrixXd& X = getBounceApproximationJacobian(world, thisLog);
+    posFromPos = X.transpose() * posFromPos;
+    velFromPos = X.transpose() * velFromPos;
+  }
+
+  // The velocity update is v' = v_f + Minv * A * f_c, with A = A_c + A_ub * E,
+  // the velocity we'd have without any constraints v_f = v + dt * Minv * (tau
+  // - C), f_c = Q^+ * b, Q = A_c^T * Minv * A, and b = -Bd * A_c^T * v_f. This
+  // is the transpose of what jvp() does, pushing g_v back through the LCP
+  // with the pseudoinverse the constraint groups cache:
+  //
+  //   u = Minv * g_v
+  //   mu = (Q^+)^T * A^T * u
+  //   w = -A_c * Bd * mu
+  //
+  // and then g_v + w back through v_f.
+
+  Eigen::VectorXd u = implicitMultiplyByInvMassMatrix(world, g_v);
+  Eigen::VectorXd w = Eigen::VectorXd::Zero(mNumDOFs);
+  Eigen::VectorXd posFromVel = Eigen::VectorXd::Zero(mNumDOFs);
+
+  Eigen::MatrixXd A_c = getClampingConstraintMatrix(world);
+  if (A_c.cols() > 0)
+  {
+    Eigen::MatrixXd A_ub = getUpperBoundConstraintMatrix(world);
+    Eigen::MatrixXd E = getUpperBoundMappingMatrix();
+    Eigen::MatrixXd A_c_ub_E = A_c + A_ub * E;
+    Eigen::VectorXd f_c = getClampingConstraintImpulses();
+    Eigen::VectorXd b = getClampingConstraintRelativeVels();
+    Eigen::VectorXd v_f = getPreConstraintVelocity();
+    Eigen::MatrixXd Q = getClampingQ();
+    Eigen::MatrixXd Qinv = getClampingQPseudoInverse();
+
+    Eigen::VectorXd lambda = A_c_ub_E.transpose() * u;
+    Eigen::VectorXd mu = Qinv.transpose() * lambda;
+    Eigen::VectorXd nu = -getBounceDiagonals().cwiseProduct(mu);
+    w = A_c * nu;
+
+    // Position moves the contact geometry. Every term that touches it is some
+    // K_i^T * z, where K_i is the force Jacobian of constraint i (the
+    // derivative of its column of A), so we collect the z's for each
+    // constraint as a column here, and apply each K_i^T once at the end.
+    Eigen::MatrixXd clampingAdj = u * f_c.transpose() + v_f * nu.transpose();
+    Eigen::MatrixXd upperBoundAdj = u * (E * f_c).transpose();
+    posFromVel += getJacobianOfMinvWrtPositionTransposeTimes(
+        world, A_c_ub_E * f_c, g_v);
+
+    // These are the transposes of the dQ and dQT terms in jvp(), applied to
+    // alpha and beta
+    auto addDQTranspose = [&](const Eigen::VectorXd& y,
+                              const Eigen::VectorXd& alpha) {
+      Eigen::VectorXd A_y = A_c_ub_E * y;
+      Eigen::VectorXd A_c_alpha = A_c * alpha;
+      Eigen::VectorXd Minv_A_c_alpha
+          = implicitMultiplyByInvMassMatrix(world, A_c_alpha);
+      clampingAdj += implicitMultiplyByInvMassMatrix(world, A_y)
+                         * alpha.transpose()
+                     + Minv_A_c_alpha * y.transpose();
+      upperBoundAdj += Minv_A_c_alpha * (E * y).transpose();
+      posFromVel
+          += getJacobianOfMinvWrtPositionTransposeTimes(world, A_y, A_c_alpha);
+    };
+    auto addDQTTranspose = [&](const Eigen::VectorXd& r,
+                               const Eigen::VectorXd& beta) {
+      Eigen::VectorXd A_c_r = A_c * r;
+      Eigen::VectorXd A_beta = A_c_ub_E * beta;
+      Eigen::VectorXd Minv_A_c_r
+          = implicitMultiplyByInvMassMatrix(world, A_c_r);
+      clampingAdj += Minv_A_c_r * beta.transpose()
+                     + implicitMultiplyByInvMassMatrix(world, A_beta)
+                           * r.transpose();
+      upperBoundAdj += Minv_A_c_r * (E * beta).transpose();
+      posFromVel
+          += getJacobianOfMinvWrtPositionTransposeTimes(world, A_c_r, A_beta);
+    };
+
+    // This is the transpose of the gradient of the pseudoinverse, see
+    // https://mathoverflow.net/a/29511/163259. The last two terms vanish when
+    // we were able to precisely invert Q.
+    addDQTranspose(Qinv * b, -mu);
+    Eigen::MatrixXd I = Eigen::MatrixXd::Identity(Q.rows(), Q.cols());
+    Eigen::MatrixXd imprecisionMap = I - Q * Qinv;
+    if (imprecisionMap.squaredNorm() >= 1e-18)
+    {
+      addDQTTranspose(imprecisionMap * b, Qinv * mu);
+      addDQTTranspose(Qinv.transpose() * Qinv * b, lambda - Q.transpose() * mu);
+    }
+
+    std::vector<std::shared_ptr<DifferentiableContactConstraint>> clamping
+        = getClampingConstraints();
+    std::vector<std::shared_ptr<DifferentiableContactConstraint>> upperBound
+        = getUpperBoundConstraints();
+    for (std::size_t i = 0; i < clamping.size(); i++)
+    {
+      posFromVel += clamping[i]
+                        ->getConstraintForcesJacobianTransposeTimes(
+                            world, clampingAdj.col(i))
+                        .col(0);
+    }
+    for (std::size_t i = 0; i < upperBound.size(); i++)
+    {
+      posFromVel += upperBound[i]
+                        ->getConstraintForcesJacobianTransposeTimes(
+                            world, upperBoundAdj.col(i))
+                        .col(0);
+    }
+  }
+
+  // C and Minv only depend on each skeleton's own state, so each skeleton can
+  // run its own reverse sweeps
+
+  Eigen::VectorXd velFromVel = g_v + w;
+  Eigen::VectorXd u_m = implicitMultiplyByInvMassMatrix(world, velFromVel);
+  Eigen::VectorXd x = dt
+                      * (world->getExternalForces()
+                         - world->getCoriolisAndGravityAndExternalForces());
+  posFromVel
+      += getJacobianOfMinvWrtPositionTransposeTimes(world, x, velFromVel);
+
+  int cursor = 0;
+  for (std::size_t i = 0; i < world->getNumSkeletons(); i++)
+  {
+    SkeletonPtr skel = world->getSkeleton(i);
+    int dofs = skel->getNumDofs();
+    velFromVel.segment(cursor, dofs)
+        -= dt
+           * skel->getJacobianOfCWrtVelocityTransposeTimes(
+               u_m.segment(cursor, dofs));
+    posFromVel.segment(cursor, dofs)
+        -= dt
+           * skel->getJacobianOfCWrtPositionTransposeTimes(
+               u_m.segment(cursor, dofs));
+    cursor += dofs;
+  }
+
+  thisTimestepLoss.lossWrtPosition = posFromPos + posFromVel;
+  thisTimestepLoss.lossWrtVelocity = velFromPos + velFromVel;
+  thisTimestepLoss.lossWrtTorque = dt * u_m;
+  // The mass term comes from the mass-vel Jacobian, which is skipped entirely
+  // when there are no mass dimensions.
+  if (world->getMassDims() > 0)
+  {
+    thisTimestepLoss.lossWrtMass
+        = getMassVelJacobian(world, thisLog).transpose() * g_v;
+  }
+  else
+  {
+    thisTimestepLoss.lossWrtMass = Eigen::VectorXd::Zero(0);
+  }
+
+  snapshot.restore();
+
+#ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+}
+
+//==============================================================================
+StateTangentBatch BackpropSnapshot::jvp(
+    simulation::WorldPtr world,
+    const Eigen::MatrixXd& dPos,
+    const Eigen::MatrixXd& dVel,
+    const Eigen::MatrixXd& dForce,
+    const Eigen::MatrixXd& dMass,
+    PerformanceLog* perfLog)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
+  if (perfLog != nullptr)
+  {
+    thisLog = perfLog->startRun("BackpropSnapshot.jvp");
+  }
+#endif
+
+  const int k = dPos.cols();
+  assert(dPos.rows() == mNumDOFs && dVel.rows() == mNumDOFs
+         && dForce.rows() == mNumDOFs);
+  assert(dVel.cols() == k && dForce.cols() == k);
+  assert(dMass.size() == 0 || dMass.cols() == k);
+
+  StateTangentBatch result;
+
+  // If we're overriding with finite differences, the dense Jacobians are the
+  // only source of truth
+  if (mUseFDOverride || mSlowDebugResultsAgainstFD)
+  {
+    result.dPosition = getPosPosJacobian(world, thisLog) * dPos
+                       + getVelPosJacobian(world, thisLog) * dVel;
+    result.dVelocity = getPosVelJacobian(world, thisLog) * dPos
+                       + getVelVelJacobian(world, thisLog) * dVel
+                       + getForceVelJacobian(world, thisLog) * dForce;
+    if (dMass.size() > 0)
+    {
+      result.dVelocity += getMassVelJacobian(world, thisLog) * dMass;
+    }
+#ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
+    if (thisLog != nullptr)
+    {
+      thisLog->end();
+    }
+#endif
+    return result;
+  }
+
+  RestorableSnapshot snapshot(world);
+  world->setPositions(mPreStepPosition);
+  world->setVelocities(mPreStepVelocity);
+  world->setExternalForces(mPreStepTorques);
+  world->setCachedLCPSolution(mPreStepLCPCache);
+
+  double dt = world->getTimeStep();
+  const bool hasDPos = !dPos.isZero();
+
+  // The integrator: pos-pos = P * X and vel-pos = V * X, where P and V are
+  // block diagonal by joint, and X is the bounce approximation (identity if
+  // nothing bounced)
+
+  if (hasBounces())
+  {
+    const Eigen::MatrixXd& X = getBounceApproximationJacobian(world, thisLog);
+    result.dPosition = integratorJacobianTimes(world, X * dPos, false)
+                       + integratorJacobianTimes(world, X * dVel, true);
+  }
+  else
+  {
+    result.dPosition = integratorJacobianTimes(world, dPos, false)
+                       + integratorJacobianTimes(world, dVel, true);
+  }
+
+  // The velocity update is v' = v_f + Minv * A * f_c, with A = A_c + A_ub * E,
+  // the velocity we'd have without any constraints v_f = v + dt * Minv * (tau
+  // - C), and f_c = Q^+ * b. So we push the tangent through v_f first, and
+  // then through the clamping LCP.
+
+  auto minvTimes = [&](const Eigen::MatrixXd& x) {
+    Eigen::MatrixXd out(mNumDOFs, x.cols());
+    for (int col = 0; col < x.cols(); col++)
+    {
+      out.col(col) = implicitMultiplyByInvMassMatrix(world, x.col(col));
+    }
+    return out;
+  };
+
+  Eigen::MatrixXd A_c = getClampingConstraintMatrix(world);
+  const bool hasClamping = A_c.cols() > 0;
+  const Eigen::VectorXd tauMinusC
+      = world->getExternalForces()
+        - world->getCoriolisAndGravityAndExternalForces();
+
+  // C(pos, vel) and Minv(pos) are block diagonal by skeleton, so each skeleton
+  // pushes all k directions through its own forward sweeps
+
+  Eigen::MatrixXd freeForces = dt * dForce;
+  int cursor = 0;
+  for (std::size_t i = 0; i < world->getNumSkeletons(); i++)
+  {
+    SkeletonPtr skel = world->getSkeleton(i);
+    int dofs = skel->getNumDofs();
+    freeForces.middleRows(cursor, dofs)
+        -= dt
+           * skel->getJacobianOfCWrtVelocityTimes(
+               dVel.middleRows(cursor, dofs));
+    if (hasDPos)
+    {
+      freeForces.middleRows(cursor, dofs)
+          -= dt
+             * skel->getJacobianOfCWrtPositionTimes(
+                 dPos.middleRows(cursor, dofs));
+    }
+    cursor += dofs;
+  }
+  Eigen::MatrixXd freeVel = dVel + minvTimes(freeForces);
+  if (hasDPos)
+  {
+    freeVel += getJacobianOfMinvWrtPositionTimes(world, dt * tauMinusC, dPos);
+  }
+
+  result.dVelocity = freeVel;
+
+  if (hasClamping)
+  {
+    Eigen::MatrixXd A_ub = getUpperBoundConstraintMatrix(world);
+    Eigen::MatrixXd E = getUpperBoundMappingMatrix();
+    Eigen::MatrixXd A_c_ub_E = A_c + A_ub * E;
+    Eigen::VectorXd f_c = getClampingConstraintImpulses();
+    Eigen::VectorXd bounce = getBounceDiagonals();
+
+    // Each constraint group has already factored its Q, for all k directions
+    Eigen::MatrixXd Qinv = getClampingQPseudoInverse();
+
+    Eigen::MatrixXd dB = bounce.asDiagonal() * -(A_c.transpose() * freeVel);
+    Eigen::MatrixXd constraintForces;
+
+    if (hasDPos)
+    {
+      // Position moves the contact geometry. Each constraint's force Jacobian
+      // K_i (the derivative of its column of A) gets applied to dPos once, and
+      // every term below is a weighted sum of those products.
+
+      std::vector<std::shared_ptr<DifferentiableContactConstraint>> clamping
+          = getClampingConstraints();
+      std::vector<std::shared_ptr<DifferentiableContactConstraint>>
+          upperBound = getUpperBoundConstraints();
+      std::vector<Eigen::MatrixXd> clampingK_dPos;
+      std::vector<Eigen::MatrixXd> upperBoundK_dPos;
+      for (auto& constraint : clamping)
+      {
+        clampingK_dPos.push_back(
+            constraint->getConstraintForcesJacobianTimes(world, dPos));
+      }
+      for (auto& constraint : upperBound)
+      {
+        upperBoundK_dPos.push_back(
+            constraint->getConstraintForcesJacobianTimes(world, dPos));
+      }
+
+      // d(A^T) * v, one row per constraint
+      auto dAT = [&](const std::vector<Eigen::MatrixXd>& K_dPos,
+                     const Eigen::VectorXd& v) {
+        Eigen::MatrixXd out(K_dPos.size(), k);
+        for (std::size_t i = 0; i < K_dPos.size(); i++)
+        {
+          out.row(i) = v.transpose() * K_dPos[i];
+        }
+        return out;
+      };
+      // d(A) * y
+      auto dA = [&](const std::vector<Eigen::MatrixXd>& K_dPos,
+                    const Eigen::VectorXd& y) {
+        Eigen::MatrixXd out = Eigen::MatrixXd::Zero(mNumDOFs, k);
+        for (std::size_t i = 0; i < K_dPos.size(); i++)
+        {
+          out += y(i) * K_dPos[i];
+        }
+        return out;
+      };
+
+      // These are the same dQ and dQT as in
+      // getJacobianOfLCPConstraintMatrixClampingSubset(), applied to dPos
+      auto dQ = [&](const Eigen::VectorXd& y) {
+        Eigen::VectorXd A_y = A_c_ub_E * y;
+        return Eigen::MatrixXd(
+            dAT(clampingK_dPos, implicitMultiplyByInvMassMatrix(world, A_y))
+            + A_c.transpose()
+                  * (getJacobianOfMinvWrtPositionTimes(world, A_y, dPos)
+                     + minvTimes(
+                         dA(clampingK_dPos, y)
+                         + dA(upperBoundK_dPos, E * y))));
+      };
+      auto dQT = [&](const Eigen::VectorXd& r) {
+        Eigen::VectorXd A_r = A_c * r;
+        Eigen::VectorXd w = implicitMultiplyByInvMassMatrix(world, A_r);
+        return Eigen::MatrixXd(
+            dAT(clampingK_dPos, w) + E.transpose() * dAT(upperBoundK_dPos, w)
+            + A_c_ub_E.transpose()
+                  * (getJacobianOfMinvWrtPositionTimes(world, A_r, dPos)
+                     + minvTimes(dA(clampingK_dPos, r))));
+      };
+
+      Eigen::VectorXd v_f = getPreConstraintVelocity();
+      dB += bounce.asDiagonal() * -dAT(clampingK_dPos, v_f);
+
+      // This is the gradient of the pseudoinverse, see
+      // https://mathoverflow.net/a/29511/163259. The last two terms vanish when
+      // we were able to precisely invert Q.
+      Eigen::VectorXd b = getClampingConstraintRelativeVels();
+      Eigen::MatrixXd dF_c = Qinv * dB - Qinv * dQ(Qinv * b);
+      Eigen::MatrixXd Q = getClampingQ();
+      Eigen::MatrixXd I = Eigen::MatrixXd::Identity(Q.rows(), Q.cols());
+      Eigen::MatrixXd imprecisionMap = I - Q * Qinv;
+      if (imprecisionMap.squaredNorm() >= 1e-18)
+      {
+        dF_c += Qinv * Qinv.transpose() * dQT(imprecisionMap * b)
+                + (I - Qinv * Q) * dQT(Qinv.transpose() * Qinv * b);
+      }
+
+      constraintForces = A_c_ub_E * dF_c + dA(clampingK_dPos, f_c)
+                         + dA(upperBoundK_dPos, E * f_c);
+      result.dVelocity
+          += getJacobianOfMinvWrtPositionTimes(world, A_c_ub_E * f_c, dPos);
+    }
+    else
+    {
+      constraintForces = A_c_ub_E * (Qinv * dB);
+    }
+
+    result.dVelocity += minvTimes(constraintForces);
+  }
+
+  if (dMass.size() > 0 && !dMass.isZero())
+  {
+    result.dVelocity += getMassVelJacobian(world, thisLog) * dMass;
+  }
+
+  snapshot.restore();
+
+#ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+  return result;
+}
+
 //==============================================================================
 /// This zeros out any components of the gradient that would want to push us
 /// out of the box-bounds encoded in the world for pos, vel, or force.
@@ -431,6 +964,8 @@ void BackpropSnapshot::clipLossGradientsToBounds(
 const Eigen::MatrixXd& BackpropSnapshot::getForceVelJacobian(
     WorldPtr world, PerformanceLog* perfLog)
 {
+  std::lock_guard<std::recursive_mutex> lock(mCacheMutex);
+
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
   if (perfLog != nullptr)
@@ -523,6 +1058,8 @@ const Eigen::MatrixXd& BackpropSnapshot::getForceVelJacobian(
 const Eigen::MatrixXd& BackpropSnapshot::getMassVelJacobian(
     simulation::WorldPtr world, PerformanceLog* perfLog)
 {
+  std::lock_guard<std::recursive_mutex> lock(mCacheMutex);
+
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
   if (perfLog != nullptr)
@@ -580,6 +1117,8 @@ const Eigen::MatrixXd& BackpropSnapshot::getMassVelJacobian(
 const Eigen::MatrixXd& BackpropSnapshot::getVelVelJacobian(
     WorldPtr world, PerformanceLog* perfLog)
 {
+  std::lock_guard<std::recursive_mutex> lock(mCacheMutex);
+
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
   if (perfLog != nullptr)
@@ -683,6 +1222,8 @@ const Eigen::MatrixXd& BackpropSnapshot::getVelVelJacobian(
 const Eigen::MatrixXd& BackpropSnapshot::getPosVelJacobian(
     WorldPtr world, PerformanceLog* perfLog)
 {
+  std::lock_guard<std::recursive_mutex> lock(mCacheMutex);
+
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
   if (perfLog != nullptr)
@@ -1141,6 +1682,8 @@ Eigen::MatrixXd BackpropSnapshot::getPosJacobianWrt(
 const Eigen::MatrixXd& BackpropSnapshot::getBounceApproximationJacobian(
     simulation::WorldPtr world, PerformanceLog* perfLog)
 {
+  std::lock_guard<std::recursive_mutex> lock(mCacheMutex);
+
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
   if (perfLog != nullptr)
@@ -1237,6 +1780,8 @@ const Eigen::MatrixXd& BackpropSnapshot::getBounceApproximationJacobian(
 const Eigen::MatrixXd& BackpropSnapshot::getPosPosJacobian(
     WorldPtr world, PerformanceLog* perfLog)
 {
+  std::lock_guard<std::recursive_mutex> lock(mCacheMutex);
+
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
   if (perfLog != nullptr)
@@ -1304,6 +1849,8 @@ const Eigen::MatrixXd& BackpropSnapshot::getPosPosJacobian(
 const Eigen::MatrixXd& BackpropSnapshot::getVelPosJacobian(
     WorldPtr world, PerformanceLog* perfLog)
 {
+  std::lock_guard<std::recursive_mutex> lock(mCacheMutex);
+
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
   if (perfLog != nullptr)
@@ -1379,6 +1926,12 @@ Eigen::VectorXd BackpropSnapshot::getPreStepTorques()
   return mPreStepTorques;
 }
 
+//==============================================================================
+Eigen::VectorXd BackpropSnapshot::getPreStepLCPCache()
+{
+  return mPreStepLCPCache;
+}
+
 //==============================================================================
 Eigen::VectorXd BackpropSnapshot::getPreConstraintVelocity()
 {
@@ -1505,6 +2058,40 @@ Eigen::MatrixXd BackpropSnapshot::getClampingAMatrix()
   return result;
 }
 
+//==============================================================================
+Eigen::MatrixXd BackpropSnapshot::getClampingQ()
+{
+  std::lock_guard<std::recursive_mutex> lock(mCacheMutex);
+
+  Eigen::MatrixXd result = Eigen::MatrixXd::Zero(mNumClamping, mNumClamping);
+  int cursor = 0;
+  for (int i = 0; i < mGradientMatrices.size(); i++)
+  {
+    const Eigen::MatrixXd& groupQ = mGradientMatrices[i]->getClampingQ();
+    result.block(cursor, cursor, groupQ.rows(), groupQ.cols()) = groupQ;
+    cursor += groupQ.rows();
+  }
+  return result;
+}
+
+//==============================================================================
+Eigen::MatrixXd BackpropSnapshot::getClampingQPseudoInverse()
+{
+  std::lock_guard<std::recursive_mutex> lock(mCacheMutex);
+
+  Eigen::MatrixXd result = Eigen::MatrixXd::Zero(mNumClamping, mNumClamping);
+  int cursor = 0;
+  for (int i = 0; i < mGradientMatrices.size(); i++)
+  {
+    const Eigen::MatrixXd& groupQinv
+        = mGradientMatrices[i]->getClampingQPseudoInverse();
+    result.block(cursor, cursor, groupQinv.rows(), groupQinv.cols())
+        = groupQinv;
+    cursor += groupQinv.rows();
+  }
+  return result;
+}
+
 //==============================================================================
 Eigen::MatrixXd BackpropSnapshot::getPosCJacobian(simulation::WorldPtr world)
 {
@@ -1803,6 +2390,32 @@ void BackpropSnapshot::setSlowDebugResultsAgainstFD(bool slowDebug)
 void BackpropSnapshot::benchmarkJacobians(
     std::shared_ptr<simulation::World> world, int numSamples)
 {
+  std::lock_guard<std::recursive_mutex> lock(mCacheMutex);
+
+  // We time the analytical Jacobians by recomputing them over and over. Do
+  // that in scratch buffers, so the published caches never change once they've
+  // been computed, and views handed out of them (e.g. to Python) stay valid.
+  Eigen::MatrixXd* caches[]
+      = {&mCachedPosPos,
+         &mCachedPosVel,
+         &mCachedVelPos,
+         &mCachedVelVel,
+         &mCachedForceVel};
+  bool* cachesDirty[]
+      = {&mCachedPosPosDirty,
+         &mCachedPosVelDirty,
+         &mCachedVelPosDirty,
+         &mCachedVelVelDirty,
+         &mCachedForceVelDirty};
+  Eigen::MatrixXd publishedCaches[5];
+  bool publishedCachesDirty[5];
+  for (int i = 0; i < 5; i++)
+  {
+    publishedCaches[i].swap(*caches[i]);
+    publishedCachesDirty[i] = *cachesDirty[i];
+    *cachesDirty[i] = true;
+  }
+
   long posPosFd = 0L;
   long posPosA = 0L;
 
@@ -1946,6 +2559,12 @@ void BackpropSnapshot::benchmarkJacobians(
   Eigen::MatrixXd velVelJacR    = finiteDifferenceVelVelJacobian(world, true);
   Eigen::MatrixXd forceVelJacR  = finiteDifferenceForceVelJacobian(world, true);
 
+  for (int i = 0; i < 5; i++)
+  {
+    caches[i]->swap(publishedCaches[i]);
+    *cachesDirty[i] = publishedCachesDirty[i];
+  }
+
   // Now we need to form and print out a report
   std::cout << "Benchmark results:" << std::endl;
 
@@ -2036,1395 +2655,328 @@ void BackpropSnapshot::benchmarkJacobians(
 }
 
 //==============================================================================
-Eigen::MatrixXd BackpropSnapshot::finiteDifferenceVelVelJacobian(
-  WorldPtr world, bool useRidders)
+/// This finite differences the post-step velocities (or positions, if
+/// `outputPositions` is true) with respect to `inputDim` inputs, on the
+/// world's FiniteDifferenceEngine.
+Eigen::MatrixXd BackpropSnapshot::finiteDifferenceStepJacobian(
+    simulation::WorldPtr world,
+    int inputDim,
+    const std::function<void(
+        const simulation::WorldPtr& world, int column, double eps)>& perturb,
+    bool outputPositions,
+    bool requireSameClamping,
+    FiniteDifferenceScheme scheme,
+    double eps,
+    std::size_t subdivisions)
 {
-  if (useRidders) return finiteDifferenceRiddersVelVelJacobian(world);
-
-  RestorableSnapshot snapshot(world);
-
-  Eigen::MatrixXd J(mNumDOFs, mNumDOFs);
-
-  bool oldGradientEnabled = world->getConstraintSolver()->getGradientEnabled();
-  world->getConstraintSolver()->setGradientEnabled(true);
+  const double timeStep = world->getTimeStep();
 
-  world->setPositions(mPreStepPosition);
-  world->setVelocities(mPreStepVelocity);
-  world->setExternalForces(mPreStepTorques);
-  world->setCachedLCPSolution(mPreStepLCPCache);
-  world->step(false);
-
-  Eigen::VectorXd originalVel = world->getVelocities();
-
-  double EPSILON = 1e-7;
-  for (std::size_t i = 0; i < world->getNumDofs(); i++)
-  {
-    snapshot.restore();
-
-    Eigen::VectorXd velPos = world->getVelocities();
-    Eigen::VectorXd velNeg = world->getVelocities();
-
-    double epsPos = EPSILON;
-    while (true)
-    {
-      world->setPositions(mPreStepPosition);
-      world->setExternalForces(mPreStepTorques);
-      world->setCachedLCPSolution(mPreStepLCPCache);
-      Eigen::VectorXd tweakedVel = Eigen::VectorXd(mPreStepVelocity);
-      tweakedVel(i) += epsPos;
-      world->setVelocities(tweakedVel);
-      std::shared_ptr<neural::BackpropSnapshot> snapshot
-          = neural::forwardPass(world, true);
-
-      if ((!areResultsStandardized() || snapshot->areResultsStandardized())
-          && snapshot->getNumClamping() == getNumClamping()
-          && snapshot->getNumUpperBound() == getNumUpperBound())
-      {
-        velPos = snapshot->getPostStepVelocity();
-        break;
-      }
-      epsPos *= 0.5;
-
-      assert(std::abs(epsPos) > 1e-20);
-    }
-
-    double epsNeg = EPSILON;
-    while (true)
-    {
-      world->setPositions(mPreStepPosition);
-      world->setExternalForces(mPreStepTorques);
-      world->setCachedLCPSolution(mPreStepLCPCache);
-      Eigen::VectorXd tweakedVel = Eigen::VectorXd(mPreStepVelocity);
-      tweakedVel(i) -= epsNeg;
-      world->setVelocities(tweakedVel);
-      std::shared_ptr<neural::BackpropSnapshot> snapshot
-          = neural::forwardPass(world, true);
-
-      if ((!areResultsStandardized() || snapshot->areResultsStandardized())
-          && snapshot->getNumClamping() == getNumClamping()
-          && snapshot->getNumUpperBound() == getNumUpperBound())
-      {
-        velNeg = snapshot->getPostStepVelocity();
-        break;
-      }
-      epsNeg *= 0.5;
-
-      assert(std::abs(epsNeg) > 1e-20);
-    }
-
-    Eigen::VectorXd velChange = (velPos - velNeg) / (epsPos + epsNeg);
-
-    // TODO: remove me
-    /*
-#ifndef NDEBUG
-    Eigen::VectorXd identityCol = Eigen::VectorXd::Zero(velChange.size());
-    identityCol(i) = 1.0;
-    // Sanity check
-    if ((velChange - identityCol).squaredNorm() > 1e-10)
-    {
-      // Something is screwy here, let's investigate
-      dynamics::DegreeOfFreedom* dof = world->getDofs()[i];
-      std::cout << "Error on perturbing joint vel: " << dof->getName()
-                << std::endl;
-
-      snapshot.restore();
-      world->setPositions(mPreStepPosition);
-      world->setExternalForces(mPreStepTorques);
-      world->setCachedLCPSolution(mPreStepLCPCache);
-      tweakedVel = Eigen::VectorXd::Zero(mPreStepVelocity);
-      tweakedVel(i) -= EPSILON;
-      world->setVelocities(tweakedVel);
-      // Opportunity to put a breakpoint here
-      world->step(false);
-    }
-#endif
-    */
-    // TODO: </remove>
-
-    J.col(i).noalias() = velChange;
-  }
-
-  snapshot.restore();
-  world->getConstraintSolver()->setGradientEnabled(oldGradientEnabled);
-
-  return J;
-}
-
-//==============================================================================
-Eigen::MatrixXd
-BackpropSnapshot::finiteDifferenceRiddersVelVelJacobian(WorldPtr world)
-{
-  RestorableSnapshot snapshot(world);
-
-  Eigen::MatrixXd J(mNumDOFs, mNumDOFs);
-
-  bool oldGradientEnabled = world->getConstraintSolver()->getGradientEnabled();
-  world->getConstraintSolver()->setGradientEnabled(true);
-
-  world->setPositions(mPreStepPosition);
-  world->setVelocities(mPreStepVelocity);
-  world->setExternalForces(mPreStepTorques);
-  world->setCachedLCPSolution(mPreStepLCPCache);
-  world->step(false);
-
-  double originalStepSize = 1e-4; 
-  const double con = 1.4, con2 = (con * con); 
-  const double safeThreshold = 2.0; 
-  const int tabSize = 10;
-
-  for (std::size_t i = 0; i < world->getNumDofs(); i++)
-  {
-    // Neville tableau of finite difference results
-    std::array<std::array<Eigen::VectorXd, tabSize>, tabSize> tab;
-
-    snapshot.restore();
-
-    Eigen::VectorXd velPlus;
-    Eigen::VectorXd velMinus;
-
-    // Find largest original step size which doesn't change numClamping
-    while (true)
-    {
-      world->setPositions(mPreStepPosition);
-      world->setExternalForces(mPreStepTorques);
-      world->setCachedLCPSolution(mPreStepLCPCache);
-      Eigen::VectorXd perturbedPlus = Eigen::VectorXd(mPreStepVelocity);
-      perturbedPlus(i) += originalStepSize;
-      world->setVelocities(perturbedPlus);
-      std::shared_ptr<neural::BackpropSnapshot> snapshotPlus
-          = neural::forwardPass(world, true);
-      world->setPositions(mPreStepPosition);
-      world->setExternalForces(mPreStepTorques);
-      world->setCachedLCPSolution(mPreStepLCPCache);
-      Eigen::VectorXd perturbedMinus = Eigen::VectorXd(mPreStepVelocity);
-      perturbedMinus(i) -= originalStepSize;
-      world->setVelocities(perturbedMinus);
-      std::shared_ptr<neural::BackpropSnapshot> snapshotMinus
-          = neural::forwardPass(world, true);
-
-      if ((!areResultsStandardized() || snapshotPlus->areResultsStandardized())
-          && snapshotPlus->getNumClamping() == getNumClamping()
-          && snapshotPlus->getNumUpperBound() == getNumUpperBound()
-          && (!areResultsStandardized() || snapshotMinus->areResultsStandardized())
-          && snapshotMinus->getNumClamping() == getNumClamping()
-          && snapshotMinus->getNumUpperBound() == getNumUpperBound())
-      {
-        velPlus = snapshotPlus->getPostStepVelocity();
-        velMinus = snapshotMinus->getPostStepVelocity();
-        break;
-      }
-      originalStepSize *= 0.5;
-
-      assert(std::abs(originalStepSize) > 1e-20);
-    }
-    tab[0][0] = (velPlus - velMinus) / (2 * originalStepSize);
-
-    double stepSize = originalStepSize;
-    double bestError = std::numeric_limits<double>::max();
-
-    // Iterate over smaller and smaller step sizes
-    for (int iTab = 1; iTab < tabSize; iTab++)
-    {
-      stepSize /= con;
-
-      world->setPositions(mPreStepPosition);
-      world->setExternalForces(mPreStepTorques);
-      world->setCachedLCPSolution(mPreStepLCPCache);
-      Eigen::VectorXd perturbedPlus = Eigen::VectorXd(mPreStepVelocity);
-      perturbedPlus(i) += stepSize;
-      world->setVelocities(perturbedPlus);
-      std::shared_ptr<neural::BackpropSnapshot> snapshotPlus
-          = neural::forwardPass(world, true);
-      velPlus = snapshotPlus->getPostStepVelocity();
-      if (!((!areResultsStandardized() || snapshotPlus->areResultsStandardized())
-            && snapshotPlus->getNumClamping() == getNumClamping()
-            && snapshotPlus->getNumUpperBound() == getNumUpperBound()))
-      {
-        assert(false && "Lowering EPS in finiteDifferenceRiddersVelVelJacobian() "
-                      "caused numClamping() or numUpperBound() to change.");
-      }
-      world->setPositions(mPreStepPosition);
-      world->setExternalForces(mPreStepTorques);
-      world->setCachedLCPSolution(mPreStepLCPCache);
-      Eigen::VectorXd perturbedMinus = Eigen::VectorXd(mPreStepVelocity);
-      perturbedMinus(i) -= stepSize;
-      world->setVelocities(perturbedMinus);
-      std::shared_ptr<neural::BackpropSnapshot> snapshotMinus
-          = neural::forwardPass(world, true);
-      velMinus = snapshotMinus->getPostStepVelocity();
-      if (!((!areResultsStandardized() || snapshotMinus->areResultsStandardized())
-            && snapshotMinus->getNumClamping() == getNumClamping()
-            && snapshotMinus->getNumUpperBound() == getNumUpperBound()))
-      {
-        assert(false && "Lowering EPS in finiteDifferenceRiddersVelVelJacobian() "
-                      "caused numClamping() or numUpperBound() to change.");
-      }
-      
-      tab[0][iTab] = (velPlus - velMinus) / (2 * stepSize);
-
-      double fac = con2;
-      // Compute extrapolations of increasing orders, requiring no new evaluations
-      for (int jTab = 1; jTab <= iTab; jTab++)
-      {
-        tab[jTab][iTab] = (tab[jTab-1][iTab] * fac - tab[jTab-1][iTab-1]) /
-                              (fac - 1.0);
-        fac = con2 * fac;
-        double currError = 
-          std::max((tab[jTab][iTab] - tab[jTab-1][iTab]).array().abs().maxCoeff(),
-                   (tab[jTab][iTab] - tab[jTab-1][iTab-1]).array().abs().maxCoeff());
-        if (currError < bestError)
-        {
-          bestError = currError;
-          J.col(i).noalias() = tab[jTab][iTab];
-        }
-      }
-
-      // If higher order is worse by a significant factor, quit early.
-      if ((tab[iTab][iTab] - tab[iTab-1][iTab-1]).array().abs().maxCoeff() >= 
-          safeThreshold * bestError)
-      {
-        break;
-      }
-    }
-  }
-
-  snapshot.restore();
-  world->getConstraintSolver()->setGradientEnabled(oldGradientEnabled);
-
-  return J;
-}
-
-//==============================================================================
-Eigen::MatrixXd BackpropSnapshot::finiteDifferencePosVelJacobian(
-    simulation::WorldPtr world, bool useRidders)
-{
-  if (useRidders) return finiteDifferenceRiddersPosVelJacobian(world);
-
-  RestorableSnapshot snapshot(world);
-
-  Eigen::MatrixXd J(mNumDOFs, mNumDOFs);
-
-  bool oldGradientEnabled = world->getConstraintSolver()->getGradientEnabled();
-  world->getConstraintSolver()->setGradientEnabled(true);
-  bool oldPenetrationCorrectionEnabled
-      = world->getPenetrationCorrectionEnabled();
-  world->setPenetrationCorrectionEnabled(false);
-  bool oldCFM = world->getConstraintForceMixingEnabled();
-  world->setConstraintForceMixingEnabled(false);
-
-  world->setPositions(mPreStepPosition);
-  world->setVelocities(mPreStepVelocity);
-  world->setExternalForces(mPreStepTorques);
-  world->setCachedLCPSolution(mPreStepLCPCache);
-
-  world->step(false);
-
-  Eigen::VectorXd originalVel = world->getVelocities();
-
-  double EPSILON = 1e-7;
-  for (std::size_t i = 0; i < world->getNumDofs(); i++)
-  {
-    snapshot.restore();
-
-    Eigen::VectorXd perturbedVelPos = world->getVelocities();
-    Eigen::VectorXd perturbedVelNeg = world->getVelocities();
-
-    double epsPos = EPSILON;
-    while (true)
-    {
-      // Get predicted next vel
-      world->setExternalForces(mPreStepTorques);
-      world->setCachedLCPSolution(mPreStepLCPCache);
-      world->setVelocities(mPreStepVelocity);
-      Eigen::VectorXd tweakedPos = Eigen::VectorXd(mPreStepPosition);
-      tweakedPos(i) += epsPos;
-      world->setPositions(tweakedPos);
-
-      BackpropSnapshotPtr ptr = neural::forwardPass(world, true);
-      if ((!areResultsStandardized() || ptr->areResultsStandardized())
-          && ptr->getNumClamping() == getNumClamping()
-          && ptr->getNumUpperBound() == getNumUpperBound())
-      {
-        perturbedVelPos = ptr->getPostStepVelocity();
-        break;
-      }
-      epsPos *= 0.5;
-
-      if (std::abs(epsPos) <= 1e-20)
-      {
-        std::cout << "Found a non-differentiabe point in getting pos-vel Jac:"
-                  << std::endl;
-        printReplicationInstructions(world);
-      }
-      assert(std::abs(epsPos) > 1e-20);
-    }
-
-    double epsNeg = EPSILON;
-    while (true)
-    {
-      // Get predicted next vel
-      world->setExternalForces(mPreStepTorques);
-      world->setCachedLCPSolution(mPreStepLCPCache);
-      world->setVelocities(mPreStepVelocity);
-      Eigen::VectorXd tweakedPos = Eigen::VectorXd(mPreStepPosition);
-      tweakedPos(i) -= epsNeg;
-      world->setPositions(tweakedPos);
-
-      BackpropSnapshotPtr ptr = neural::forwardPass(world, true);
-      if ((!areResultsStandardized() || ptr->areResultsStandardized())
-          && ptr->getNumClamping() == getNumClamping()
-          && ptr->getNumUpperBound() == getNumUpperBound())
-      {
-        perturbedVelNeg = ptr->getPostStepVelocity();
-        break;
-      }
-      epsNeg *= 0.5;
-
-      if (std::abs(epsNeg) <= 1e-20)
-      {
-        std::cout << "Found a non-differentiabe point in getting pos-vel Jac:"
-                  << std::endl;
-        printReplicationInstructions(world);
-      }
-      assert(std::abs(epsNeg) > 1e-20);
-    }
-
-    J.col(i).noalias()
-        = (perturbedVelPos - perturbedVelNeg) / (epsPos + epsNeg);
-  }
-
-  snapshot.restore();
-  world->getConstraintSolver()->setGradientEnabled(oldGradientEnabled);
-  world->setPenetrationCorrectionEnabled(oldPenetrationCorrectionEnabled);
-  world->setConstraintForceMixingEnabled(oldCFM);
-
-  return J;
-}
-
-//==============================================================================
-Eigen::MatrixXd BackpropSnapshot::finiteDifferenceRiddersPosVelJacobian(
-    simulation::WorldPtr world)
-{
-  RestorableSnapshot snapshot(world);
-
-  Eigen::MatrixXd J(mNumDOFs, mNumDOFs);
-
-  bool oldGradientEnabled = world->getConstraintSolver()->getGradientEnabled();
-  world->getConstraintSolver()->setGradientEnabled(true);
-  bool oldPenetrationCorrectionEnabled
-      = world->getPenetrationCorrectionEnabled();
-  world->setPenetrationCorrectionEnabled(false);
-  bool oldCFM = world->getConstraintForceMixingEnabled();
-  world->setConstraintForceMixingEnabled(false);
-
-  world->setPositions(mPreStepPosition);
-  world->setVelocities(mPreStepVelocity);
-  world->setExternalForces(mPreStepTorques);
-  world->setCachedLCPSolution(mPreStepLCPCache);
-  world->step(false);
-
-  double originalStepSize = 1e-4; 
-  const double con = 1.4, con2 = (con * con); 
-  const double safeThreshold = 2.0; 
-  const int tabSize = 10;
-
-  for (std::size_t i = 0; i < world->getNumDofs(); i++)
-  {
-    // Neville tableau of finite difference results
-    std::array<std::array<Eigen::VectorXd, tabSize>, tabSize> tab;
-
-    snapshot.restore();
-
-    Eigen::VectorXd velPlus;
-    Eigen::VectorXd velMinus;
-
-    // Find largest original step size which doesn't change numClamping
-    while (true)
-    {
-      world->setExternalForces(mPreStepTorques);
-      world->setCachedLCPSolution(mPreStepLCPCache);
-      world->setVelocities(mPreStepVelocity);
-      Eigen::VectorXd perturbedPlus = Eigen::VectorXd(mPreStepPosition);
-      perturbedPlus(i) += originalStepSize;
-      world->setPositions(perturbedPlus);
-      std::shared_ptr<neural::BackpropSnapshot> snapshotPlus
-          = neural::forwardPass(world, true);
-      world->setExternalForces(mPreStepTorques);
-      world->setCachedLCPSolution(mPreStepLCPCache);
-      world->setVelocities(mPreStepVelocity);
-      Eigen::VectorXd perturbedMinus = Eigen::VectorXd(mPreStepPosition);
-      perturbedMinus(i) -= originalStepSize;
-      world->setPositions(perturbedMinus);
-      std::shared_ptr<neural::BackpropSnapshot> snapshotMinus
-          = neural::forwardPass(world, true);
-
-      if ((!areResultsStandardized() || snapshotPlus->areResultsStandardized())
-          && snapshotPlus->getNumClamping() == getNumClamping()
-          && snapshotPlus->getNumUpperBound() == getNumUpperBound()
-          && (!areResultsStandardized() || snapshotMinus->areResultsStandardized())
-          && snapshotMinus->getNumClamping() == getNumClamping()
-          && snapshotMinus->getNumUpperBound() == getNumUpperBound())
-      {
-        velPlus = snapshotPlus->getPostStepVelocity();
-        velMinus = snapshotMinus->getPostStepVelocity();
-        break;
-      }
-      originalStepSize *= 0.5;
-
-      if (std::abs(originalStepSize) <= 1e-20)
-      {
-        std::cout << "Found a non-differentiabe point in getting pos-vel Jac:"
-                  << std::endl;
-        printReplicationInstructions(world);
-      }
-      assert(std::abs(originalStepSize) > 1e-20);
-    }
-
-    tab[0][0] = (velPlus - velMinus) / (2 * originalStepSize);
-
-    double stepSize = originalStepSize;
-    double bestError = std::numeric_limits<double>::max();
-
-    // Iterate over smaller and smaller step sizes
-    for (int iTab = 1; iTab < tabSize; iTab++)
-    {
-      stepSize /= con;
-
-      world->setExternalForces(mPreStepTorques);
-      world->setCachedLCPSolution(mPreStepLCPCache);
-      world->setVelocities(mPreStepVelocity);
-      Eigen::VectorXd perturbedPlus = Eigen::VectorXd(mPreStepPosition);
-      perturbedPlus(i) += stepSize;
-      world->setPositions(perturbedPlus);
-      std::shared_ptr<neural::BackpropSnapshot> snapshotPlus
-          = neural::forwardPass(world, true);
-      velPlus = snapshotPlus->getPostStepVelocity();
-      if (!((!areResultsStandardized() || snapshotPlus->areResultsStandardized())
-            && snapshotPlus->getNumClamping() == getNumClamping()
-            && snapshotPlus->getNumUpperBound() == getNumUpperBound()))
-      {
-        assert(false && "Lowering EPS in finiteDifferenceRiddersPosVelJacobian() "
-                      "caused numClamping() or numUpperBound() to change.");
-      }
-      world->setExternalForces(mPreStepTorques);
-      world->setCachedLCPSolution(mPreStepLCPCache);
-      world->setVelocities(mPreStepVelocity);
-      Eigen::VectorXd perturbedMinus = Eigen::VectorXd(mPreStepPosition);
-      perturbedMinus(i) -= stepSize;
-      world->setPositions(perturbedMinus);
-      std::shared_ptr<neural::BackpropSnapshot> snapshotMinus
-          = neural::forwardPass(world, true);
-      velMinus = snapshotMinus->getPostStepVelocity();
-      if (!((!areResultsStandardized() || snapshotMinus->areResultsStandardized())
-            && snapshotMinus->getNumClamping() == getNumClamping()
-            && snapshotMinus->getNumUpperBound() == getNumUpperBound()))
-      {
-        assert(false && "Lowering EPS in finiteDifferenceRiddersPosVelJacobian() "
-                      "caused numClamping() or numUpperBound() to change.");
-      }
-      
-      tab[0][iTab] = (velPlus - velMinus) / (2 * stepSize);
-
-      double fac = con2;
-      // Compute extrapolations of increasing orders, requiring no new evaluations
-      for (int jTab = 1; jTab <= iTab; jTab++)
-      {
-        tab[jTab][iTab] = (tab[jTab-1][iTab] * fac - tab[jTab-1][iTab-1]) /
-                              (fac - 1.0);
-        fac = con2 * fac;
-        double currError = 
-          std::max((tab[jTab][iTab] - tab[jTab-1][iTab]).array().abs().maxCoeff(),
-                   (tab[jTab][iTab] - tab[jTab-1][iTab-1]).array().abs().maxCoeff());
-        if (currError < bestError)
-        {
-          bestError = currError;
-          J.col(i).noalias() = tab[jTab][iTab];
-        }
-      }
-
-      // If higher order is worse by a significant factor, quit early.
-      if ((tab[iTab][iTab] - tab[iTab-1][iTab-1]).array().abs().maxCoeff() >= 
-          safeThreshold * bestError)
-      {
-        break;
-      }
-    }
-  }
-
-  snapshot.restore();
-  world->getConstraintSolver()->setGradientEnabled(oldGradientEnabled);
-  world->setPenetrationCorrectionEnabled(oldPenetrationCorrectionEnabled);
-  world->setConstraintForceMixingEnabled(oldCFM);
-
-  return J;
-}
-
-//==============================================================================
-Eigen::MatrixXd BackpropSnapshot::finiteDifferenceForceVelJacobian(
-    WorldPtr world, bool useRidders)
-{
-  if (useRidders) return finiteDifferenceRiddersForceVelJacobian(world);
-
-  RestorableSnapshot snapshot(world);
-
-  Eigen::MatrixXd J(mNumDOFs, mNumDOFs);
-
-  bool oldGradientEnabled = world->getConstraintSolver()->getGradientEnabled();
-  world->getConstraintSolver()->setGradientEnabled(true);
-
-  world->setPositions(mPreStepPosition);
-  world->setVelocities(mPreStepVelocity);
-  world->setExternalForces(mPreStepTorques);
-  world->setCachedLCPSolution(mPreStepLCPCache);
-  world->step(false);
-
-  Eigen::VectorXd originalForces = world->getExternalForces();
-  Eigen::VectorXd originalVel = world->getVelocities();
-
-  double EPSILON = 1e-7;
-  for (std::size_t i = 0; i < world->getNumDofs(); i++)
-  {
-    snapshot.restore();
-
-    Eigen::VectorXd perturbedVelPos = world->getVelocities();
-    Eigen::VectorXd perturbedVelNeg = world->getVelocities();
-
-    double epsPos = EPSILON;
-    while (true)
-    {
-      // Get predicted next vel
-      world->setPositions(mPreStepPosition);
-      world->setVelocities(mPreStepVelocity);
-      world->setCachedLCPSolution(mPreStepLCPCache);
-      Eigen::VectorXd tweakedForces = Eigen::VectorXd(mPreStepTorques);
-      tweakedForces(i) += epsPos;
-      world->setExternalForces(tweakedForces);
-
-      BackpropSnapshotPtr ptr = neural::forwardPass(world, true);
-      if ((!areResultsStandardized() || ptr->areResultsStandardized())
-          && ptr->getNumClamping() == getNumClamping()
-          && ptr->getNumUpperBound() == getNumUpperBound())
-      {
-        perturbedVelPos = ptr->getPostStepVelocity();
-        break;
-      }
-      epsPos *= 0.5;
-
-      assert(std::abs(epsPos) > 1e-20);
-    }
-
-    double epsNeg = EPSILON;
-    while (true)
-    {
-      // Get predicted next vel
-      world->setPositions(mPreStepPosition);
-      world->setVelocities(mPreStepVelocity);
-      world->setCachedLCPSolution(mPreStepLCPCache);
-      Eigen::VectorXd tweakedForces = Eigen::VectorXd(mPreStepTorques);
-      tweakedForces(i) -= epsNeg;
-      world->setExternalForces(tweakedForces);
-
-      BackpropSnapshotPtr ptr = neural::forwardPass(world, true);
-      if ((!areResultsStandardized() || ptr->areResultsStandardized())
-          && ptr->getNumClamping() == getNumClamping()
-          && ptr->getNumUpperBound() == getNumUpperBound())
-      {
-        perturbedVelNeg = ptr->getPostStepVelocity();
-        break;
-      }
-      epsNeg *= 0.5;
-
-      assert(std::abs(epsNeg) > 1e-20);
-    }
-
-    J.col(i).noalias()
-        = (perturbedVelPos - perturbedVelNeg) / (epsPos + epsNeg);
-  }
-
-  /*
-  double EPSILON = 1e-7;
-  for (std::size_t i = 0; i < world->getNumDofs(); i++)
-  {
-    snapshot.restore();
-
-    world->setPositions(mPreStepPosition);
-    world->setVelocities(mPreStepVelocity);
-    Eigen::VectorXd tweakedForcesPos = Eigen::VectorXd::Zero(originalForces);
-    tweakedForcesPos(i) += EPSILON;
-    world->setExternalForces(tweakedForcesPos);
-    world->step(false);
-    Eigen::VectorXd velPos = world->getVelocities();
-
-    world->setPositions(mPreStepPosition);
-    world->setVelocities(mPreStepVelocity);
-    Eigen::VectorXd tweakedForcesNeg = Eigen::VectorXd::Zero(originalForces);
-    tweakedForcesNeg(i) -= EPSILON;
-    world->setExternalForces(tweakedForcesNeg);
-    world->step(false);
-    Eigen::VectorXd velNeg = world->getVelocities();
-
-    Eigen::VectorXd velChange = (velPos - velNeg) / (2 * EPSILON);
-    J.col(i).noalias() = velChange;
-  }
-  */
-
-  snapshot.restore();
-  world->getConstraintSolver()->setGradientEnabled(oldGradientEnabled);
-
-  return J;
-}
-
-//==============================================================================
-Eigen::MatrixXd BackpropSnapshot::finiteDifferenceRiddersForceVelJacobian(
-    WorldPtr world)
-{
-  RestorableSnapshot snapshot(world);
-
-  Eigen::MatrixXd J(mNumDOFs, mNumDOFs);
-
-  bool oldGradientEnabled = world->getConstraintSolver()->getGradientEnabled();
-  world->getConstraintSolver()->setGradientEnabled(true);
-
-  world->setPositions(mPreStepPosition);
-  world->setVelocities(mPreStepVelocity);
-  world->setExternalForces(mPreStepTorques);
-  world->setCachedLCPSolution(mPreStepLCPCache);
-  world->step(false);
-
-  double originalStepSize = 1e-4; 
-  const double con = 1.4, con2 = (con * con); 
-  const double safeThreshold = 2.0; 
-  const int tabSize = 10;
-
-  for (std::size_t i = 0; i < world->getNumDofs(); i++)
-  {
-    // Neville tableau of finite difference results
-    std::array<std::array<Eigen::VectorXd, tabSize>, tabSize> tab;
-
-    snapshot.restore();
-
-    Eigen::VectorXd velPlus;
-    Eigen::VectorXd velMinus;
-
-    // Find largest original step size which doesn't change numClamping
-    while (true)
-    {
-      world->setPositions(mPreStepPosition);
-      world->setVelocities(mPreStepVelocity);
-      world->setCachedLCPSolution(mPreStepLCPCache);
-      Eigen::VectorXd perturbedPlus = Eigen::VectorXd(mPreStepTorques);
-      perturbedPlus(i) += originalStepSize;
-      world->setExternalForces(perturbedPlus);
-      std::shared_ptr<neural::BackpropSnapshot> snapshotPlus
-          = neural::forwardPass(world, true);
-      world->setPositions(mPreStepPosition);
-      world->setVelocities(mPreStepVelocity);
-      world->setCachedLCPSolution(mPreStepLCPCache);
-      Eigen::VectorXd perturbedMinus = Eigen::VectorXd(mPreStepTorques);
-      perturbedMinus(i) -= originalStepSize;
-      world->setExternalForces(perturbedMinus);
-      std::shared_ptr<neural::BackpropSnapshot> snapshotMinus
-          = neural::forwardPass(world, true);
-
-      if ((!areResultsStandardized() || snapshotPlus->areResultsStandardized())
-          && snapshotPlus->getNumClamping() == getNumClamping()
-          && snapshotPlus->getNumUpperBound() == getNumUpperBound()
-          && (!areResultsStandardized() || snapshotMinus->areResultsStandardized())
-          && snapshotMinus->getNumClamping() == getNumClamping()
-          && snapshotMinus->getNumUpperBound() == getNumUpperBound())
-      {
-        velPlus = snapshotPlus->getPostStepVelocity();
-        velMinus = snapshotMinus->getPostStepVelocity();
-        break;
-      }
-      originalStepSize *= 0.5;
-
-      assert(std::abs(originalStepSize) > 1e-20);
-    }
-    tab[0][0] = (velPlus - velMinus) / (2 * originalStepSize);
-
-    double stepSize = originalStepSize;
-    double bestError = std::numeric_limits<double>::max();
-
-    // Iterate over smaller and smaller step sizes
-    for (int iTab = 1; iTab < tabSize; iTab++)
-    {
-      stepSize /= con;
-
-      world->setPositions(mPreStepPosition);
-      world->setVelocities(mPreStepVelocity);
-      world->setCachedLCPSolution(mPreStepLCPCache);
-      Eigen::VectorXd perturbedPlus = Eigen::VectorXd(mPreStepTorques);
-      perturbedPlus(i) += stepSize;
-      world->setExternalForces(perturbedPlus);
-      std::shared_ptr<neural::BackpropSnapshot> snapshotPlus
-          = neural::forwardPass(world, true);
-      velPlus = snapshotPlus->getPostStepVelocity();
-      if (!((!areResultsStandardized() || snapshotPlus->areResultsStandardized())
-            && snapshotPlus->getNumClamping() == getNumClamping()
-            && snapshotPlus->getNumUpperBound() == getNumUpperBound()))
-      {
-        assert(false && "Lowering EPS in finiteDifferenceRiddersForceVelJacobian() "
-                      "caused numClamping() or numUpperBound() to change.");
-      }
-      world->setPositions(mPreStepPosition);
-      world->setVelocities(mPreStepVelocity);
-      world->setCachedLCPSolution(mPreStepLCPCache);
-      Eigen::VectorXd perturbedMinus = Eigen::VectorXd(mPreStepTorques);
-      perturbedMinus(i) -= stepSize;
-      world->setExternalForces(perturbedMinus);
-      std::shared_ptr<neural::BackpropSnapshot> snapshotMinus
-          = neural::forwardPass(world, true);
-      velMinus = snapshotMinus->getPostStepVelocity();
-      if (!((!areResultsStandardized() || snapshotMinus->areResultsStandardized())
-            && snapshotMinus->getNumClamping() == getNumClamping()
-            && snapshotMinus->getNumUpperBound() == getNumUpperBound()))
-      {
-        assert(false && "Lowering EPS in finiteDifferenceRiddersForceVelJacobian() "
-                      "caused numClamping() or numUpperBound() to change.");
-      }
-      
-      tab[0][iTab] = (velPlus - velMinus) / (2 * stepSize);
-
-      double fac = con2;
-      // Compute extrapolations of increasing orders, requiring no new evaluations
-      for (int jTab = 1; jTab <= iTab; jTab++)
-      {
-        tab[jTab][iTab] = (tab[jTab-1][iTab] * fac - tab[jTab-1][iTab-1]) /
-                              (fac - 1.0);
-        fac = con2 * fac;
-        double currError = 
-          std::max((tab[jTab][iTab] - tab[jTab-1][iTab]).array().abs().maxCoeff(),
-                   (tab[jTab][iTab] - tab[jTab-1][iTab-1]).array().abs().maxCoeff());
-        if (currError < bestError)
-        {
-          bestError = currError;
-          J.col(i).noalias() = tab[jTab][iTab];
-        }
-      }
-
-      // If higher order is worse by a significant factor, quit early.
-      if ((tab[iTab][iTab] - tab[iTab-1][iTab-1]).array().abs().maxCoeff() >= 
-          safeThreshold * bestError)
-      {
-        break;
-      }
-    }
-  }
-
-  snapshot.restore();
-  world->getConstraintSolver()->setGradientEnabled(oldGradientEnabled);
-
-  return J;
-}
-
-//==============================================================================
-Eigen::MatrixXd BackpropSnapshot::finiteDifferenceMassVelJacobian(
-    simulation::WorldPtr world, bool useRidders)
-{
-  if (useRidders) return finiteDifferenceRiddersMassVelJacobian(world);
-
-  RestorableSnapshot snapshot(world);
-
-  bool oldGradientEnabled = world->getConstraintSolver()->getGradientEnabled();
-  // world->getConstraintSolver()->setGradientEnabled(false);
-
-  world->setPositions(mPreStepPosition);
-  world->setVelocities(mPreStepVelocity);
-  world->setExternalForces(mPreStepTorques);
-  world->setCachedLCPSolution(mPreStepLCPCache);
-  world->step(false);
-
-  Eigen::VectorXd originalMass = world->getWrtMass()->get(world.get());
-  Eigen::VectorXd originalVel = world->getVelocities();
-
-  Eigen::MatrixXd J(mNumDOFs, originalMass.size());
-
-  double EPSILON = 1e-7;
-  for (std::size_t i = 0; i < originalMass.size(); i++)
-  {
-    snapshot.restore();
-
-    world->setPositions(mPreStepPosition);
-    world->setVelocities(mPreStepVelocity);
-    Eigen::VectorXd tweakedMass = Eigen::VectorXd(originalMass);
-    tweakedMass(i) += EPSILON;
-    world->getWrtMass()->set(world.get(), tweakedMass);
-
-    world->step(false);
-
-    Eigen::VectorXd velChange
-        = (world->getVelocities() - originalVel) / EPSILON;
-    J.col(i).noalias() = velChange;
-  }
-
-  snapshot.restore();
-  world->getConstraintSolver()->setGradientEnabled(oldGradientEnabled);
-
-  return J;
-}
-
-//==============================================================================
-Eigen::MatrixXd BackpropSnapshot::finiteDifferenceRiddersMassVelJacobian(
-    simulation::WorldPtr world)
-{
-  RestorableSnapshot snapshot(world);
-
-  bool oldGradientEnabled = world->getConstraintSolver()->getGradientEnabled();
-  // world->getConstraintSolver()->setGradientEnabled(false);
-
-  world->setPositions(mPreStepPosition);
-  world->setVelocities(mPreStepVelocity);
-  world->setExternalForces(mPreStepTorques);
-  world->setCachedLCPSolution(mPreStepLCPCache);
-  world->step(false);
-
-  const double originalStepSize = 1e-3; 
-  const double con = 1.4, con2 = (con * con); 
-  const double safeThreshold = 2.0; 
-  const int tabSize = 10;
-
-  Eigen::VectorXd originalMass = world->getWrtMass()->get(world.get());
-  Eigen::VectorXd velPlus;
-  Eigen::VectorXd velMinus;
-
-  Eigen::MatrixXd J(mNumDOFs, originalMass.size());
-
-  for (std::size_t i = 0; i < originalMass.size(); i++)
-  {
-    double stepSize = originalStepSize;
-    double bestError = std::numeric_limits<double>::max();
-
-    // Neville tableau of finite difference results
-    std::array<std::array<Eigen::VectorXd, tabSize>, tabSize> tab;
-
-    snapshot.restore();
-
-    world->setPositions(mPreStepPosition);
-    world->setVelocities(mPreStepVelocity);
-    Eigen::VectorXd perturbedPlus = Eigen::VectorXd(originalMass);
-    perturbedPlus(i) += stepSize;
-    world->getWrtMass()->set(world.get(), perturbedPlus);
-    std::shared_ptr<neural::BackpropSnapshot> snapshotPlus
-          = neural::forwardPass(world, true);
-    velPlus = snapshotPlus->getPostStepVelocity();
-    world->setPositions(mPreStepPosition);
-    world->setVelocities(mPreStepVelocity);
-    Eigen::VectorXd perturbedMinus = Eigen::VectorXd(originalMass);
-    perturbedMinus(i) -= stepSize;
-    world->getWrtMass()->set(world.get(), perturbedMinus);
-    std::shared_ptr<neural::BackpropSnapshot> snapshotMinus
-          = neural::forwardPass(world, true);
-    velMinus = snapshotMinus->getPostStepVelocity();
-
-    tab[0][0] = (velPlus - velMinus) / (2 * stepSize);
-
-    // Iterate over smaller and smaller step sizes
-    for (int iTab = 1; iTab < tabSize; iTab++)
-    {
-      stepSize /= con;
-
-      world->setPositions(mPreStepPosition);
-      world->setVelocities(mPreStepVelocity);
-      perturbedPlus = Eigen::VectorXd(originalMass);
-      perturbedPlus(i) += stepSize;
-      world->getWrtMass()->set(world.get(), perturbedPlus);
-      std::shared_ptr<neural::BackpropSnapshot> snapshotPlus
-            = neural::forwardPass(world, true);
-      velPlus = snapshotPlus->getPostStepVelocity();
-      world->setPositions(mPreStepPosition);
-      world->setVelocities(mPreStepVelocity);
-      perturbedMinus = Eigen::VectorXd(originalMass);
-      perturbedMinus(i) -= stepSize;
-      world->getWrtMass()->set(world.get(), perturbedMinus);
-      std::shared_ptr<neural::BackpropSnapshot> snapshotMinus
-            = neural::forwardPass(world, true);
-      velMinus = snapshotMinus->getPostStepVelocity();
-      
-      tab[0][iTab] = (velPlus - velMinus) / (2 * stepSize);
-
-      double fac = con2;
-      // Compute extrapolations of increasing orders, requiring no new evaluations
-      for (int jTab = 1; jTab <= iTab; jTab++)
-      {
-        tab[jTab][iTab] = (tab[jTab-1][iTab] * fac - tab[jTab-1][iTab-1]) /
-                              (fac - 1.0);
-        fac = con2 * fac;
-        double currError = 
-          std::max((tab[jTab][iTab] - tab[jTab-1][iTab]).array().abs().maxCoeff(),
-                   (tab[jTab][iTab] - tab[jTab-1][iTab-1]).array().abs().maxCoeff());
-        if (currError < bestError)
-        {
-          bestError = currError;
-          J.col(i).noalias() = tab[jTab][iTab];
-        }
-      }
-
-      // If higher order is worse by a significant factor, quit early.
-      if ((tab[iTab][iTab] - tab[iTab-1][iTab-1]).array().abs().maxCoeff() >= 
-          safeThreshold * bestError)
-      {
-        break;
-      }
-    }
-  }
-
-  snapshot.restore();
-  world->getConstraintSolver()->setGradientEnabled(oldGradientEnabled);
-
-  return J;
-}
-
-//==============================================================================
-Eigen::MatrixXd BackpropSnapshot::finiteDifferencePosPosJacobian(
-    WorldPtr world, std::size_t subdivisions, bool useRidders)
-{
-  if (useRidders) return finiteDifferenceRiddersPosPosJacobian(world, subdivisions);
-
-  RestorableSnapshot snapshot(world);
-
-  double oldTimestep = world->getTimeStep();
-  world->setTimeStep(oldTimestep / subdivisions);
-  bool oldGradientEnabled = world->getConstraintSolver()->getGradientEnabled();
-  world->getConstraintSolver()->setGradientEnabled(true);
-
-  Eigen::MatrixXd J(mNumDOFs, mNumDOFs);
-
-  world->setPositions(mPreStepPosition);
-  world->setVelocities(mPreStepVelocity);
-  world->setExternalForces(mPreStepTorques);
-  world->setCachedLCPSolution(mPreStepLCPCache);
-
-  for (std::size_t j = 0; j < subdivisions; j++)
-    world->step(false);
-
-  Eigen::VectorXd originalPosition = world->getPositions();
-
-  if (subdivisions == 1)
-  {
-    double EPSILON = 1e-6;
-    for (std::size_t i = 0; i < world->getNumDofs(); i++)
-    {
-      snapshot.restore();
-
-      world->setVelocities(mPreStepVelocity);
-      world->setExternalForces(mPreStepTorques);
-      world->setCachedLCPSolution(mPreStepLCPCache);
-
-      Eigen::VectorXd tweakedPositions = mPreStepPosition;
-      tweakedPositions(i) += EPSILON;
-      world->setPositions(tweakedPositions);
-      world->step(false);
-      Eigen::VectorXd posChange = world->getPositions();
-
-      world->setVelocities(mPreStepVelocity);
-      world->setExternalForces(mPreStepTorques);
-      world->setCachedLCPSolution(mPreStepLCPCache);
-
-      tweakedPositions = mPreStepPosition;
-      tweakedPositions(i) -= EPSILON;
-      world->setPositions(tweakedPositions);
-      world->step(false);
-      Eigen::VectorXd negChange = world->getPositions();
-
-      J.col(i).noalias() = (posChange - negChange) / (2 * EPSILON);
-    }
-  }
-  else
-  {
-    // IMPORTANT: EPSILON must be larger than the distance traveled in a single
-    // subdivided timestep. Ideally much larger.
-    double EPSILON = 1e-2 / subdivisions;
-    for (std::size_t i = 0; i < world->getNumDofs(); i++)
-    {
-      snapshot.restore();
-
-      world->setVelocities(mPreStepVelocity);
-      world->setExternalForces(mPreStepTorques);
-      world->setCachedLCPSolution(mPreStepLCPCache);
-
-      Eigen::VectorXd tweakedPositions = Eigen::VectorXd(mPreStepPosition);
-      tweakedPositions(i) += EPSILON;
-      world->setPositions(tweakedPositions);
-
-      for (std::size_t j = 0; j < subdivisions; j++)
-        world->step(false);
-
-      Eigen::VectorXd posChange
-          = (world->getPositions() - originalPosition) / EPSILON;
-      J.col(i).noalias() = posChange;
-    }
-  }
-
-  world->setTimeStep(oldTimestep);
-  world->getConstraintSolver()->setGradientEnabled(oldGradientEnabled);
-  snapshot.restore();
-
-  return J;
-}
-
-//==============================================================================
-Eigen::MatrixXd BackpropSnapshot::finiteDifferenceRiddersPosPosJacobian(
-    WorldPtr world, std::size_t subdivisions)
-{
-  RestorableSnapshot snapshot(world);
-
-  double oldTimestep = world->getTimeStep();
-  world->setTimeStep(oldTimestep / subdivisions);
-  bool oldGradientEnabled = world->getConstraintSolver()->getGradientEnabled();
-  world->getConstraintSolver()->setGradientEnabled(true);
-
-  Eigen::MatrixXd J(mNumDOFs, mNumDOFs);
-
-  world->setPositions(mPreStepPosition);
-  world->setVelocities(mPreStepVelocity);
-  world->setExternalForces(mPreStepTorques);
-  world->setCachedLCPSolution(mPreStepLCPCache);
-
-  for (std::size_t j = 0; j < subdivisions; j++)
-    world->step(false);
-
-  const double originalStepSize = 1e-3 / subdivisions; 
-  const double con = 1.4, con2 = (con * con); 
-  const double safeThreshold = 2.0; 
-  const int tabSize = 10;
-
-  for (std::size_t i = 0; i < world->getNumDofs(); i++)
-  {
-    double stepSize = originalStepSize;
-    double bestError = std::numeric_limits<double>::max();
-
-    // Neville tableau of finite difference results
-    std::array<std::array<Eigen::VectorXd, tabSize>, tabSize> tab;
-
-    snapshot.restore();
-
-    world->setVelocities(mPreStepVelocity);
-    world->setExternalForces(mPreStepTorques);
-    world->setCachedLCPSolution(mPreStepLCPCache);
-    Eigen::VectorXd perturbedPlus = Eigen::VectorXd(mPreStepPosition);
-    perturbedPlus(i) += stepSize;
-    world->setPositions(perturbedPlus);
-    for (std::size_t j = 0; j < subdivisions; j++) world->step(false);
-    Eigen::VectorXd posPlus = world->getPositions();
-
-    world->setVelocities(mPreStepVelocity);
-    world->setExternalForces(mPreStepTorques);
-    world->setCachedLCPSolution(mPreStepLCPCache);
-    Eigen::VectorXd perturbedMinus = Eigen::VectorXd(mPreStepPosition);
-    perturbedMinus(i) -= stepSize;
-    world->setPositions(perturbedMinus);
-    for (std::size_t j = 0; j < subdivisions; j++) world->step(false);
-    Eigen::VectorXd posMinus = world->getPositions();
-
-    tab[0][0] = (posPlus - posMinus) / (2 * stepSize);
-
-    // Iterate over smaller and smaller step sizes
-    for (int iTab = 1; iTab < tabSize; iTab++)
-    {
-      stepSize /= con;
-
-      world->setVelocities(mPreStepVelocity);
-      world->setExternalForces(mPreStepTorques);
-      world->setCachedLCPSolution(mPreStepLCPCache);
-      perturbedPlus = Eigen::VectorXd(mPreStepPosition);
-      perturbedPlus(i) += stepSize;
-      world->setPositions(perturbedPlus);
-      for (std::size_t j = 0; j < subdivisions; j++) world->step(false);
-      posPlus = world->getPositions();
-      
-      world->setVelocities(mPreStepVelocity);
-      world->setExternalForces(mPreStepTorques);
-      world->setCachedLCPSolution(mPreStepLCPCache);
-      perturbedMinus = Eigen::VectorXd(mPreStepPosition);
-      perturbedMinus(i) -= stepSize;
-      world->setPositions(perturbedMinus);
-      for (std::size_t j = 0; j < subdivisions; j++) world->step(false);
-      posMinus = world->getPositions();
-      
-      tab[0][iTab] = (posPlus - posMinus) / (2 * stepSize);
-
-      double fac = con2;
-      // Compute extrapolations of increasing orders, requiring no new evaluations
-      for (int jTab = 1; jTab <= iTab; jTab++)
-      {
-        tab[jTab][iTab] = (tab[jTab-1][iTab] * fac - tab[jTab-1][iTab-1]) /
-                              (fac - 1.0);
-        fac = con2 * fac;
-        double currError = 
-          std::max((tab[jTab][iTab] - tab[jTab-1][iTab]).array().abs().maxCoeff(),
-                   (tab[jTab][iTab] - tab[jTab-1][iTab-1]).array().abs().maxCoeff());
-        if (currError < bestError)
+  return world->getFiniteDifferenceEngine()->jacobian(
+      world,
+      inputDim,
+      mNumDOFs,
+      [&](const WorldPtr& clone, int column, double step, Eigen::VectorXd& out) {
+        clone->setPositions(mPreStepPosition);
+        clone->setVelocities(mPreStepVelocity);
+        clone->setExternalForces(mPreStepTorques);
+        clone->setCachedLCPSolution(mPreStepLCPCache);
+        perturb(clone, column, step);
+
+        bool accepted = true;
+        if (subdivisions == 1)
         {
-          bestError = currError;
-          J.col(i).noalias() = tab[jTab][iTab];
+          std::shared_ptr<BackpropSnapshot> snapshot
+              = neural::forwardPass(clone, false);
+          out = outputPositions ? snapshot->getPostStepPosition()
+                                : snapshot->getPostStepVelocity();
+          if (requireSameClamping)
+          {
+            accepted
+                = (!areResultsStandardized()
+                   || snapshot->areResultsStandardized())
+                  && snapshot->getNumClamping() == getNumClamping()
+                  && snapshot->getNumUpperBound() == getNumUpperBound();
+          }
+        }
+        else
+        {
+          clone->setTimeStep(timeStep / subdivisions);
+          for (std::size_t j = 0; j < subdivisions; j++)
+            clone->step(false);
+          clone->setTimeStep(timeStep);
+          out = outputPositions ? clone->getPositions()
+                                : clone->getVelocities();
         }
-      }
-
-      // If higher order is worse by a significant factor, quit early.
-      if ((tab[iTab][iTab] - tab[iTab-1][iTab-1]).array().abs().maxCoeff() >= 
-          safeThreshold * bestError)
-      {
-        break;
-      }
-    }
-  }
-
-  world->setTimeStep(oldTimestep);
-  world->getConstraintSolver()->setGradientEnabled(oldGradientEnabled);
-  snapshot.restore();
 
-  return J;
+        // Undo any changes to persistent properties of the clone
+        perturb(clone, column, 0.0);
+        return accepted;
+      },
+      scheme,
+      eps);
 }
 
 //==============================================================================
-Eigen::MatrixXd BackpropSnapshot::finiteDifferenceVelPosJacobian(
-    WorldPtr world, std::size_t subdivisions, bool useRidders)
+Eigen::MatrixXd BackpropSnapshot::finiteDifferenceVelVelJacobian(
+    WorldPtr world, bool useRidders)
 {
-  if (useRidders) return finiteDifferenceRiddersVelPosJacobian(world, subdivisions);
-
-  RestorableSnapshot snapshot(world);
-
-  double oldTimestep = world->getTimeStep();
-  world->setTimeStep(oldTimestep / subdivisions);
-  bool oldGradientEnabled = world->getConstraintSolver()->getGradientEnabled();
-  // world->getConstraintSolver()->setGradientEnabled(false);
-
-  Eigen::MatrixXd J(mNumDOFs, mNumDOFs);
-
-  world->setPositions(mPreStepPosition);
-  world->setVelocities(mPreStepVelocity);
-  world->setExternalForces(mPreStepTorques);
-  world->setCachedLCPSolution(mPreStepLCPCache);
-
-  for (std::size_t j = 0; j < subdivisions; j++)
-    world->step(false);
+  if (useRidders) return finiteDifferenceRiddersVelVelJacobian(world);
 
-  Eigen::VectorXd originalPosition = world->getPositions();
+  return finiteDifferenceStepJacobian(
+      world,
+      mNumDOFs,
+      [this](const WorldPtr& world, int i, double eps) {
+        Eigen::VectorXd tweakedVel = mPreStepVelocity;
+        tweakedVel(i) += eps;
+        world->setVelocities(tweakedVel);
+      },
+      false,
+      true,
+      FD_CENTRAL,
+      1e-7);
+}
 
-  if (subdivisions == 1)
-  {
-    double EPSILON = 1e-6;
-    for (std::size_t i = 0; i < world->getNumDofs(); i++)
-    {
-      snapshot.restore();
+//==============================================================================
+Eigen::MatrixXd
+BackpropSnapshot::finiteDifferenceRiddersVelVelJacobian(WorldPtr world)
+{
+  return finiteDifferenceStepJacobian(
+      world,
+      mNumDOFs,
+      [this](const WorldPtr& world, int i, double eps) {
+        Eigen::VectorXd tweakedVel = mPreStepVelocity;
+        tweakedVel(i) += eps;
+        world->setVelocities(tweakedVel);
+      },
+      false,
+      true,
+      FD_RIDDERS,
+      1e-4);
+}
 
-      world->setPositions(mPreStepPosition);
-      world->setExternalForces(mPreStepTorques);
-      world->setCachedLCPSolution(mPreStepLCPCache);
+//==============================================================================
+Eigen::MatrixXd BackpropSnapshot::finiteDifferencePosVelJacobian(
+    simulation::WorldPtr world, bool useRidders)
+{
+  if (useRidders) return finiteDifferenceRiddersPosVelJacobian(world);
 
-      Eigen::VectorXd tweakedVelocity = mPreStepVelocity;
-      tweakedVelocity(i) += EPSILON;
-      world->setVelocities(tweakedVelocity);
-      world->step(false);
-      Eigen::VectorXd posChange = world->getPositions();
+  return finiteDifferenceStepJacobian(
+      world,
+      mNumDOFs,
+      [this](const WorldPtr& world, int i, double eps) {
+        world->setPenetrationCorrectionEnabled(false);
+        world->setConstraintForceMixingEnabled(false);
+        Eigen::VectorXd tweakedPos = mPreStepPosition;
+        tweakedPos(i) += eps;
+        world->setPositions(tweakedPos);
+      },
+      false,
+      true,
+      FD_CENTRAL,
+      1e-7);
+}
 
-      world->setPositions(mPreStepPosition);
-      world->setExternalForces(mPreStepTorques);
-      world->setCachedLCPSolution(mPreStepLCPCache);
+//==============================================================================
+Eigen::MatrixXd BackpropSnapshot::finiteDifferenceRiddersPosVelJacobian(
+    simulation::WorldPtr world)
+{
+  return finiteDifferenceStepJacobian(
+      world,
+      mNumDOFs,
+      [this](const WorldPtr& world, int i, double eps) {
+        world->setPenetrationCorrectionEnabled(false);
+        world->setConstraintForceMixingEnabled(false);
+        Eigen::VectorXd tweakedPos = mPreStepPosition;
+        tweakedPos(i) += eps;
+        world->setPositions(tweakedPos);
+      },
+      false,
+      true,
+      FD_RIDDERS,
+      1e-4);
+}
 
-      tweakedVelocity = mPreStepVelocity;
-      tweakedVelocity(i) -= EPSILON;
-      world->setVelocities(tweakedVelocity);
-      world->step(false);
-      Eigen::VectorXd negChange = world->getPositions();
+//==============================================================================
+Eigen::MatrixXd BackpropSnapshot::finiteDifferenceForceVelJacobian(
+    WorldPtr world, bool useRidders)
+{
+  if (useRidders) return finiteDifferenceRiddersForceVelJacobian(world);
 
-      J.col(i).noalias() = (posChange - negChange) / (2 * EPSILON);
-    }
-  }
-  else
-  {
-    double EPSILON = 1e-3 / subdivisions;
-    for (std::size_t i = 0; i < world->getNumDofs(); i++)
-    {
-      snapshot.restore();
+  return finiteDifferenceStepJacobian(
+      world,
+      mNumDOFs,
+      [this](const WorldPtr& world, int i, double eps) {
+        Eigen::VectorXd tweakedForces = mPreStepTorques;
+        tweakedForces(i) += eps;
+        world->setExternalForces(tweakedForces);
+      },
+      false,
+      true,
+      FD_CENTRAL,
+      1e-7);
+}
 
-      world->setPositions(mPreStepPosition);
-      world->setExternalForces(mPreStepTorques);
-      world->setCachedLCPSolution(mPreStepLCPCache);
+//==============================================================================
+Eigen::MatrixXd BackpropSnapshot::finiteDifferenceRiddersForceVelJacobian(
+    WorldPtr world)
+{
+  return finiteDifferenceStepJacobian(
+      world,
+      mNumDOFs,
+      [this](const WorldPtr& world, int i, double eps) {
+        Eigen::VectorXd tweakedForces = mPreStepTorques;
+        tweakedForces(i) += eps;
+        world->setExternalForces(tweakedForces);
+      },
+      false,
+      true,
+      FD_RIDDERS,
+      1e-4);
+}
 
-      Eigen::VectorXd tweakedVelocity = Eigen::VectorXd(mPreStepVelocity);
-      tweakedVelocity(i) += EPSILON;
-      world->setVelocities(tweakedVelocity);
+//==============================================================================
+Eigen::MatrixXd BackpropSnapshot::finiteDifferenceMassVelJacobian(
+    simulation::WorldPtr world, bool useRidders)
+{
+  if (useRidders) return finiteDifferenceRiddersMassVelJacobian(world);
 
-      for (std::size_t j = 0; j < subdivisions; j++)
-        world->step(false);
+  Eigen::VectorXd originalMass = world->getWrtMass()->get(world.get());
+  return finiteDifferenceStepJacobian(
+      world,
+      originalMass.size(),
+      [&originalMass](const WorldPtr& world, int i, double eps) {
+        Eigen::VectorXd tweakedMass = originalMass;
+        tweakedMass(i) += eps;
+        world->getWrtMass()->set(world.get(), tweakedMass);
+      },
+      false,
+      false,
+      FD_FORWARD,
+      1e-7);
+}
 
-      Eigen::VectorXd posChange
-          = (world->getPositions() - originalPosition) / EPSILON;
-      J.col(i).noalias() = posChange;
-    }
-  }
+//==============================================================================
+Eigen::MatrixXd BackpropSnapshot::finiteDifferenceRiddersMassVelJacobian(
+    simulation::WorldPtr world)
+{
+  Eigen::VectorXd originalMass = world->getWrtMass()->get(world.get());
+  return finiteDifferenceStepJacobian(
+      world,
+      originalMass.size(),
+      [&originalMass](const WorldPtr& world, int i, double eps) {
+        Eigen::VectorXd tweakedMass = originalMass;
+        tweakedMass(i) += eps;
+        world->getWrtMass()->set(world.get(), tweakedMass);
+      },
+      false,
+      false,
+      FD_RIDDERS,
+      1e-3);
+}
 
-  world->setTimeStep(oldTimestep);
-  world->getConstraintSolver()->setGradientEnabled(oldGradientEnabled);
-  snapshot.restore();
+//==============================================================================
+Eigen::MatrixXd BackpropSnapshot::finiteDifferencePosPosJacobian(
+    WorldPtr world, std::size_t subdivisions, bool useRidders)
+{
+  if (useRidders) return finiteDifferenceRiddersPosPosJacobian(world, subdivisions);
 
-  return J;
+  // IMPORTANT: When we subdivide, EPSILON must be larger than the distance
+  // traveled in a single subdivided timestep. Ideally much larger.
+  return finiteDifferenceStepJacobian(
+      world,
+      mNumDOFs,
+      [this](const WorldPtr& world, int i, double eps) {
+        Eigen::VectorXd tweakedPositions = mPreStepPosition;
+        tweakedPositions(i) += eps;
+        world->setPositions(tweakedPositions);
+      },
+      true,
+      false,
+      subdivisions == 1 ? FD_CENTRAL : FD_FORWARD,
+      subdivisions == 1 ? 1e-6 : 1e-2 / subdivisions,
+      subdivisions);
 }
 
 //==============================================================================
-Eigen::MatrixXd BackpropSnapshot::finiteDifferenceRiddersVelPosJacobian(
+Eigen::MatrixXd BackpropSnapshot::finiteDifferenceRiddersPosPosJacobian(
     WorldPtr world, std::size_t subdivisions)
 {
-  RestorableSnapshot snapshot(world);
-
-  double oldTimestep = world->getTimeStep();
-  world->setTimeStep(oldTimestep / subdivisions);
-  bool oldGradientEnabled = world->getConstraintSolver()->getGradientEnabled();
-  // world->getConstraintSolver()->setGradientEnabled(false);
-
-  Eigen::MatrixXd J(mNumDOFs, mNumDOFs);
-
-  world->setPositions(mPreStepPosition);
-  world->setVelocities(mPreStepVelocity);
-  world->setExternalForces(mPreStepTorques);
-  world->setCachedLCPSolution(mPreStepLCPCache);
-
-  for (std::size_t j = 0; j < subdivisions; j++)
-    world->step(false);
-
-  const double originalStepSize = 1e-3 / subdivisions; 
-  const double con = 1.4, con2 = (con * con); 
-  const double safeThreshold = 2.0; 
-  const int tabSize = 10;
-
-  for (std::size_t i = 0; i < world->getNumDofs(); i++)
-  {
-    double stepSize = originalStepSize;
-    double bestError = std::numeric_limits<double>::max();
-
-    // Neville tableau of finite difference results
-    std::array<std::array<Eigen::VectorXd, tabSize>, tabSize> tab;
-
-    snapshot.restore();
-
-    world->setPositions(mPreStepPosition);
-    world->setExternalForces(mPreStepTorques);
-    world->setCachedLCPSolution(mPreStepLCPCache);
-    Eigen::VectorXd perturbedPlus = Eigen::VectorXd(mPreStepVelocity);
-    perturbedPlus(i) += stepSize;
-    world->setVelocities(perturbedPlus);
-    for (std::size_t j = 0; j < subdivisions; j++) world->step(false);
-    Eigen::VectorXd posPlus = world->getPositions();
-
-    world->setPositions(mPreStepPosition);
-    world->setExternalForces(mPreStepTorques);
-    world->setCachedLCPSolution(mPreStepLCPCache);
-    Eigen::VectorXd perturbedMinus = Eigen::VectorXd(mPreStepVelocity);
-    perturbedMinus(i) -= stepSize;
-    world->setVelocities(perturbedMinus);
-    for (std::size_t j = 0; j < subdivisions; j++) world->step(false);
-    Eigen::VectorXd posMinus = world->getPositions();
-
-    tab[0][0] = (posPlus - posMinus) / (2 * stepSize);
-
-    // Iterate over smaller and smaller step sizes
-    for (int iTab = 1; iTab < tabSize; iTab++)
-    {
-      stepSize /= con;
-
-      world->setPositions(mPreStepPosition);
-      world->setExternalForces(mPreStepTorques);
-      world->setCachedLCPSolution(mPreStepLCPCache);
-      perturbedPlus = Eigen::VectorXd(mPreStepVelocity);
-      perturbedPlus(i) += stepSize;
-      world->setVelocities(perturbedPlus);
-      for (std::size_t j = 0; j < subdivisions; j++) world->step(false);
-      posPlus = world->getPositions();
-
-      world->setPositions(mPreStepPosition);
-      world->setExternalForces(mPreStepTorques);
-      world->setCachedLCPSolution(mPreStepLCPCache);
-      perturbedMinus = Eigen::VectorXd(mPreStepVelocity);
-      perturbedMinus(i) -= stepSize;
-      world->setVelocities(perturbedMinus);
-      for (std::size_t j = 0; j < subdivisions; j++) world->step(false);
-      posMinus = world->getPositions();
-      
-      tab[0][iTab] = (posPlus - posMinus) / (2 * stepSize);
-
-      double fac = con2;
-      // Compute extrapolations of increasing orders, requiring no new evaluations
-      for (int jTab = 1; jTab <= iTab; jTab++)
-      {
-        tab[jTab][iTab] = (tab[jTab-1][iTab] * fac - tab[jTab-1][iTab-1]) /
-                              (fac - 1.0);
-        fac = con2 * fac;
-        double currError = 
-          std::max((tab[jTab][iTab] - tab[jTab-1][iTab]).array().abs().maxCoeff(),
-                   (tab[jTab][iTab] - tab[jTab-1][iTab-1]).array().abs().maxCoeff());
-        if (currError < bestError)
-        {
-          bestError = currError;
-          J.col(i).noalias() = tab[jTab][iTab];
-        }
-      }
-
-      // If higher order is worse by a significant factor, quit early.
-      if ((tab[iTab][iTab] - tab[iTab-1][iTab-1]).array().abs().maxCoeff() >= 
-          safeThreshold * bestError)
-      {
-        break;
-      }
-    }
-  }
-
-  world->setTimeStep(oldTimestep);
-  world->getConstraintSolver()->setGradientEnabled(oldGradientEnabled);
-  snapshot.restore();
-
-  return J;
+  return finiteDifferenceStepJacobian(
+      world,
+      mNumDOFs,
+      [this](const WorldPtr& world, int i, double eps) {
+        Eigen::VectorXd tweakedPositions = mPreStepPosition;
+        tweakedPositions(i) += eps;
+        world->setPositions(tweakedPositions);
+      },
+      true,
+      false,
+      FD_RIDDERS,
+      1e-3 / subdivisions,
+      subdivisions);
 }
 
 //==============================================================================
-/// This computes and returns the whole wrt-vel jacobian by finite
-/// differences. This is SUPER SUPER SLOW, and is only here for testing.
-Eigen::MatrixXd BackpropSnapshot::finiteDifferenceVelJacobianWrt(
-    simulation::WorldPtr world, WithRespectTo* wrt, bool useRidders)
+Eigen::MatrixXd BackpropSnapshot::finiteDifferenceVelPosJacobian(
+    WorldPtr world, std::size_t subdivisions, bool useRidders)
 {
-  if (useRidders) return finiteDifferenceRiddersVelJacobianWrt(world, wrt);
-
-  RestorableSnapshot snapshot(world);
-
-  int wrtDim = wrt->dim(world.get());
-  Eigen::MatrixXd J(mNumDOFs, wrtDim);
-
-  bool oldGradientEnabled = world->getConstraintSolver()->getGradientEnabled();
-  // world->getConstraintSolver()->setGradientEnabled(false);
-
-  Eigen::VectorXd originalWrt = wrt->get(world.get());
-
-  world->setPositions(mPreStepPosition);
-  world->setVelocities(mPreStepVelocity);
-  world->setExternalForces(mPreStepTorques);
-  world->setCachedLCPSolution(mPreStepLCPCache);
-  world->step(false);
-
-  Eigen::VectorXd originalVel = world->getVelocities();
-
-  double EPSILON = 1e-7;
-  for (std::size_t i = 0; i < wrtDim; i++)
-  {
-    snapshot.restore();
-
-    world->setPositions(mPreStepPosition);
-    world->setVelocities(mPreStepVelocity);
-    Eigen::VectorXd tweakedWrt = Eigen::VectorXd(originalWrt);
-    tweakedWrt(i) += EPSILON;
-    wrt->set(world.get(), tweakedWrt);
+  if (useRidders) return finiteDifferenceRiddersVelPosJacobian(world, subdivisions);
 
-    world->step(false);
+  return finiteDifferenceStepJacobian(
+      world,
+      mNumDOFs,
+      [this](const WorldPtr& world, int i, double eps) {
+        Eigen::VectorXd tweakedVelocity = mPreStepVelocity;
+        tweakedVelocity(i) += eps;
+        world->setVelocities(tweakedVelocity);
+      },
+      true,
+      false,
+      subdivisions == 1 ? FD_CENTRAL : FD_FORWARD,
+      subdivisions == 1 ? 1e-6 : 1e-3 / subdivisions,
+      subdivisions);
+}
 
-    Eigen::VectorXd velChange
-        = (world->getVelocities() - originalVel) / EPSILON;
-    J.col(i).noalias() = velChange;
-  }
+//==============================================================================
+Eigen::MatrixXd BackpropSnapshot::finiteDifferenceRiddersVelPosJacobian(
+    WorldPtr world, std::size_t subdivisions)
+{
+  return finiteDifferenceStepJacobian(
+      world,
+      mNumDOFs,
+      [this](const WorldPtr& world, int i, double eps) {
+        Eigen::VectorXd tweakedVelocity = mPreStepVelocity;
+        tweakedVelocity(i) += eps;
+        world->setVelocities(tweakedVelocity);
+      },
+      true,
+      false,
+      FD_RIDDERS,
+      1e-3 / subdivisions,
+      subdivisions);
+}
 
-  snapshot.restore();
-  world->getConstraintSolver()->setGradientEnabled(oldGradientEnabled);
+//==============================================================================
+/// This computes and returns the whole wrt-vel jacobian by finite
+/// differences. This is SUPER SUPER SLOW, and is only here for testing.
+Eigen::MatrixXd BackpropSnapshot::finiteDifferenceVelJacobianWrt(
+    simulation::WorldPtr world, WithRespectTo* wrt, bool useRidders)
+{
+  if (useRidders) return finiteDifferenceRiddersVelJacobianWrt(world, wrt);
 
-  return J;
+  Eigen::VectorXd originalWrt = wrt->get(world.get());
+  return finiteDifferenceStepJacobian(
+      world,
+      originalWrt.size(),
+      [wrt, &originalWrt](const WorldPtr& world, int i, double eps) {
+        Eigen::VectorXd tweakedWrt = originalWrt;
+        tweakedWrt(i) += eps;
+        wrt->set(world.get(), tweakedWrt);
+      },
+      false,
+      false,
+      FD_FORWARD,
+      1e-7);
 }
 
 //==============================================================================
@@ -3434,104 +2986,19 @@ Eigen::MatrixXd BackpropSnapshot::finiteDifferenceVelJacobianWrt(
 Eigen::MatrixXd BackpropSnapshot::finiteDifferenceRiddersVelJacobianWrt(
     simulation::WorldPtr world, WithRespectTo* wrt)
 {
-  RestorableSnapshot snapshot(world);
-
-  int wrtDim = wrt->dim(world.get());
-  Eigen::MatrixXd J(mNumDOFs, wrtDim);
-
-  bool oldGradientEnabled = world->getConstraintSolver()->getGradientEnabled();
-  // world->getConstraintSolver()->setGradientEnabled(false);
-
-  const double originalStepSize = 1e-3; 
-  const double con = 1.4, con2 = (con * con); 
-  const double safeThreshold = 2.0; 
-  const int tabSize = 10;
-
   Eigen::VectorXd originalWrt = wrt->get(world.get());
-
-  world->setPositions(mPreStepPosition);
-  world->setVelocities(mPreStepVelocity);
-  world->setExternalForces(mPreStepTorques);
-  world->setCachedLCPSolution(mPreStepLCPCache);
-  world->step(false);
-
-  for (std::size_t i = 0; i < wrtDim; i++)
-  {
-    double stepSize = originalStepSize;
-    double bestError = std::numeric_limits<double>::max();
-
-    // Neville tableau of finite difference results
-    std::array<std::array<Eigen::VectorXd, tabSize>, tabSize> tab;
-
-    snapshot.restore();
-
-    Eigen::VectorXd perturbedPlus = Eigen::VectorXd(originalWrt);
-    perturbedPlus(i) += stepSize;
-    wrt->set(world.get(), perturbedPlus);
-    std::shared_ptr<neural::BackpropSnapshot> snapshotPlus
-            = neural::forwardPass(world, true);
-    Eigen:: VectorXd velPlus = snapshotPlus->getPostStepVelocity();
-
-    Eigen::VectorXd perturbedMinus = Eigen::VectorXd(originalWrt);
-    perturbedMinus(i) -= stepSize;
-    wrt->set(world.get(), perturbedMinus);
-    std::shared_ptr<neural::BackpropSnapshot> snapshotMinus
-            = neural::forwardPass(world, true);
-    Eigen:: VectorXd velMinus = snapshotMinus->getPostStepVelocity();
-
-    tab[0][0] = (velPlus - velMinus) / (2 * stepSize);
-
-    // Iterate over smaller and smaller step sizes
-    for (int iTab = 1; iTab < tabSize; iTab++)
-    {
-      stepSize /= con;
-
-      perturbedPlus = Eigen::VectorXd(originalWrt);
-      perturbedPlus(i) += stepSize;
-      wrt->set(world.get(), perturbedPlus);
-      std::shared_ptr<neural::BackpropSnapshot> snapshotPlus
-              = neural::forwardPass(world, true);
-      velPlus = snapshotPlus->getPostStepVelocity();
-
-      perturbedMinus = Eigen::VectorXd(originalWrt);
-      perturbedMinus(i) -= stepSize;
-      wrt->set(world.get(), perturbedMinus);
-      std::shared_ptr<neural::BackpropSnapshot> snapshotMinus
-              = neural::forwardPass(world, true);
-      velMinus = snapshotMinus->getPostStepVelocity();
-      
-      tab[0][iTab] = (velPlus - velMinus) / (2 * stepSize);
-
-      double fac = con2;
-      // Compute extrapolations of increasing orders, requiring no new evaluations
-      for (int jTab = 1; jTab <= iTab; jTab++)
-      {
-        tab[jTab][iTab] = (tab[jTab-1][iTab] * fac - tab[jTab-1][iTab-1]) /
-                              (fac - 1.0);
-        fac = con2 * fac;
-        double currError = 
-          std::max((tab[jTab][iTab] - tab[jTab-1][iTab]).array().abs().maxCoeff(),
-                   (tab[jTab][iTab] - tab[jTab-1][iTab-1]).array().abs().maxCoeff());
-        if (currError < bestError)
-        {
-          bestError = currError;
-          J.col(i).noalias() = tab[jTab][iTab];
-        }
-      }
-
-      // If higher order is worse by a significant factor, quit early.
-      if ((tab[iTab][iTab] - tab[iTab-1][iTab-1]).array().abs().maxCoeff() >= 
-          safeThreshold * bestError)
-      {
-        break;
-      }
-    }
-  }
-
-  snapshot.restore();
-  world->getConstraintSolver()->setGradientEnabled(oldGradientEnabled);
-
-  return J;
+  return finiteDifferenceStepJacobian(
+      world,
+      originalWrt.size(),
+      [wrt, &originalWrt](const WorldPtr& world, int i, double eps) {
+        Eigen::VectorXd tweakedWrt = originalWrt;
+        tweakedWrt(i) += eps;
+        wrt->set(world.get(), tweakedWrt);
+      },
+      false,
+      false,
+      FD_RIDDERS,
+      1e-3);
 }
 
 //==============================================================================
@@ -3542,57 +3009,19 @@ Eigen::MatrixXd BackpropSnapshot::finiteDifferencePosJacobianWrt(
 {
   if (useRidders) return finiteDifferenceRiddersPosJacobianWrt(world, wrt);
 
-  RestorableSnapshot snapshot(world);
-
-  int wrtDim = wrt->dim(world.get());
-  Eigen::MatrixXd J(mNumDOFs, wrtDim);
-
-  bool oldGradientEnabled = world->getConstraintSolver()->getGradientEnabled();
-  // world->getConstraintSolver()->setGradientEnabled(false);
-
   Eigen::VectorXd originalWrt = wrt->get(world.get());
-
-  world->setPositions(mPreStepPosition);
-  world->setVelocities(mPreStepVelocity);
-  world->setExternalForces(mPreStepTorques);
-  world->setCachedLCPSolution(mPreStepLCPCache);
-  world->step(false);
-
-  Eigen::VectorXd originalPos = world->getPositions();
-
-  double EPSILON = 1e-6;
-  for (std::size_t i = 0; i < wrtDim; i++)
-  {
-    snapshot.restore();
-    world->setPositions(mPreStepPosition);
-    world->setVelocities(mPreStepVelocity);
-    world->setExternalForces(mPreStepTorques);
-    world->setCachedLCPSolution(mPreStepLCPCache);
-    Eigen::VectorXd tweakedWrt = Eigen::VectorXd(originalWrt);
-    tweakedWrt(i) += EPSILON;
-    wrt->set(world.get(), tweakedWrt);
-    world->step(false);
-    Eigen::VectorXd pos = world->getPositions();
-
-    snapshot.restore();
-    world->setPositions(mPreStepPosition);
-    world->setVelocities(mPreStepVelocity);
-    world->setExternalForces(mPreStepTorques);
-    world->setCachedLCPSolution(mPreStepLCPCache);
-    tweakedWrt = Eigen::VectorXd(originalWrt);
-    tweakedWrt(i) -= EPSILON;
-    wrt->set(world.get(), tweakedWrt);
-    world->step(false);
-    Eigen::VectorXd neg = world->getPositions();
-
-    Eigen::VectorXd posChange = (pos - neg) / (2 * EPSILON);
-    J.col(i).noalias() = posChange;
-  }
-
-  snapshot.restore();
-  world->getConstraintSolver()->setGradientEnabled(oldGradientEnabled);
-
-  return J;
+  return finiteDifferenceStepJacobian(
+      world,
+      originalWrt.size(),
+      [wrt, &originalWrt](const WorldPtr& world, int i, double eps) {
+        Eigen::VectorXd tweakedWrt = originalWrt;
+        tweakedWrt(i) += eps;
+        wrt->set(world.get(), tweakedWrt);
+      },
+      true,
+      false,
+      FD_CENTRAL,
+      1e-6);
 }
 
 //==============================================================================
@@ -3602,118 +3031,19 @@ Eigen::MatrixXd BackpropSnapshot::finiteDifferencePosJacobianWrt(
 Eigen::MatrixXd BackpropSnapshot::finiteDifferenceRiddersPosJacobianWrt(
     simulation::WorldPtr world, WithRespectTo* wrt)
 {
-  RestorableSnapshot snapshot(world);
-
-  int wrtDim = wrt->dim(world.get());
-  Eigen::MatrixXd J(mNumDOFs, wrtDim);
-
-  bool oldGradientEnabled = world->getConstraintSolver()->getGradientEnabled();
-  // world->getConstraintSolver()->setGradientEnabled(false);
-
-  const double originalStepSize = 1e-3; 
-  const double con = 1.4, con2 = (con * con); 
-  const double safeThreshold = 2.0; 
-  const int tabSize = 10;
-
   Eigen::VectorXd originalWrt = wrt->get(world.get());
-
-  world->setPositions(mPreStepPosition);
-  world->setVelocities(mPreStepVelocity);
-  world->setExternalForces(mPreStepTorques);
-  world->setCachedLCPSolution(mPreStepLCPCache);
-  world->step(false);
-
-  for (std::size_t i = 0; i < wrtDim; i++)
-  {
-    double stepSize = originalStepSize;
-    double bestError = std::numeric_limits<double>::max();
-
-    // Neville tableau of finite difference results
-    std::array<std::array<Eigen::VectorXd, tabSize>, tabSize> tab;
-
-    snapshot.restore();
-
-    world->setPositions(mPreStepPosition);
-    world->setVelocities(mPreStepVelocity);
-    world->setExternalForces(mPreStepTorques);
-    world->setCachedLCPSolution(mPreStepLCPCache);
-    Eigen::VectorXd perturbedPlus = Eigen::VectorXd(originalWrt);
-    perturbedPlus(i) += stepSize;
-    wrt->set(world.get(), perturbedPlus);
-    std::shared_ptr<neural::BackpropSnapshot> snapshotPlus
-            = neural::forwardPass(world, true);
-    Eigen:: VectorXd posPlus = snapshotPlus->getPostStepPosition();
-    world->setPositions(mPreStepPosition);
-    world->setVelocities(mPreStepVelocity);
-    world->setExternalForces(mPreStepTorques);
-    world->setCachedLCPSolution(mPreStepLCPCache);
-    Eigen::VectorXd perturbedMinus = Eigen::VectorXd(originalWrt);
-    perturbedMinus(i) -= stepSize;
-    wrt->set(world.get(), perturbedMinus);
-    std::shared_ptr<neural::BackpropSnapshot> snapshotMinus
-            = neural::forwardPass(world, true);
-    Eigen:: VectorXd posMinus = snapshotMinus->getPostStepPosition();
-
-    tab[0][0] = (posPlus - posMinus) / (2 * stepSize);
-
-    // Iterate over smaller and smaller step sizes
-    for (int iTab = 1; iTab < tabSize; iTab++)
-    {
-      stepSize /= con;
-
-      world->setPositions(mPreStepPosition);
-      world->setVelocities(mPreStepVelocity);
-      world->setExternalForces(mPreStepTorques);
-      world->setCachedLCPSolution(mPreStepLCPCache);
-      perturbedPlus = Eigen::VectorXd(originalWrt);
-      perturbedPlus(i) += stepSize;
-      wrt->set(world.get(), perturbedPlus);
-      std::shared_ptr<neural::BackpropSnapshot> snapshotPlus
-              = neural::forwardPass(world, true);
-      posPlus = snapshotPlus->getPostStepPosition();
-      world->setPositions(mPreStepPosition);
-      world->setVelocities(mPreStepVelocity);
-      world->setExternalForces(mPreStepTorques);
-      world->setCachedLCPSolution(mPreStepLCPCache);
-      perturbedMinus = Eigen::VectorXd(originalWrt);
-      perturbedMinus(i) -= stepSize;
-      wrt->set(world.get(), perturbedMinus);
-      std::shared_ptr<neural::BackpropSnapshot> snapshotMinus
-              = neural::forwardPass(world, true);
-      posMinus = snapshotMinus->getPostStepPosition();
-
-      tab[0][0] = (posPlus - posMinus) / (2 * stepSize);
-
-      double fac = con2;
-      // Compute extrapolations of increasing orders, requiring no new evaluations
-      for (int jTab = 1; jTab <= iTab; jTab++)
-      {
-        tab[jTab][iTab] = (tab[jTab-1][iTab] * fac - tab[jTab-1][iTab-1]) /
-                              (fac - 1.0);
-        fac = con2 * fac;
-        double currError = 
-          std::max((tab[jTab][iTab] - tab[jTab-1][iTab]).array().abs().maxCoeff(),
-                   (tab[jTab][iTab] - tab[jTab-1][iTab-1]).array().abs().maxCoeff());
-        if (currError < bestError)
-        {
-          bestError = currError;
-          J.col(i).noalias() = tab[jTab][iTab];
-        }
-      }
-
-      // If higher order is worse by a significant factor, quit early.
-      if ((tab[iTab][iTab] - tab[iTab-1][iTab-1]).array().abs().maxCoeff() >= 
-          safeThreshold * bestError)
-      {
-        break;
-      }
-    }
-  }
-
-  snapshot.restore();
-  world->getConstraintSolver()->setGradientEnabled(oldGradientEnabled);
-
-  return J;
+  return finiteDifferenceStepJacobian(
+      world,
+      originalWrt.size(),
+      [wrt, &originalWrt](const WorldPtr& world, int i, double eps) {
+        Eigen::VectorXd tweakedWrt = originalWrt;
+        tweakedWrt(i) += eps;
+        wrt->set(world.get(), tweakedWrt);
+      },
+      true,
+      false,
+      FD_RIDDERS,
+      1e-3);
 }
 
 /*
@@ -4839,15 +4169,100 @@ Eigen::MatrixXd BackpropSnapshot::getJacobianOfProjectionIntoClampsMatrix(
 Eigen::MatrixXd BackpropSnapshot::getJacobianOfMinv(
     simulation::WorldPtr world, Eigen::VectorXd tau, WithRespectTo* wrt)
 {
+  if (dynamic_cast<WithRespectToMass*>(wrt) != nullptr
+      || wrt == WithRespectTo::POSITION)
+  {
+    // Mass properties and positions don't couple skeletons together, so the
+    // Jacobian is block diagonal, and each skeleton can compute its block
+    // analytically
+    Eigen::MatrixXd J = Eigen::MatrixXd::Zero(mNumDOFs, wrt->dim(world.get()));
+    int wrtCursor = 0;
+    int dofCursor = 0;
+    for (std::size_t i = 0; i < world->getNumSkeletons(); i++)
+    {
+      auto skel = world->getSkeleton(i);
+      int dofs = skel->getNumDofs();
+      int skelWrtDim = wrt->dim(skel.get());
+      J.block(dofCursor, wrtCursor, dofs, skelWrtDim)
+          = skel->getJacobianOfMinv(tau.segment(dofCursor, dofs), wrt);
+      wrtCursor += skelWrtDim;
+      dofCursor += dofs;
+    }
+    return J;
+  }
   return finiteDifferenceJacobianOfMinv(world, tau, wrt);
 }
 
+//==============================================================================
+/// This returns getJacobianOfMinv(world, tau, WithRespectTo::POSITION) * D,
+/// without forming the Jacobian
+Eigen::MatrixXd BackpropSnapshot::getJacobianOfMinvWrtPositionTimes(
+    simulation::WorldPtr world,
+    const Eigen::VectorXd& tau,
+    const Eigen::MatrixXd& D)
+{
+  Eigen::MatrixXd result = Eigen::MatrixXd::Zero(mNumDOFs, D.cols());
+  int cursor = 0;
+  for (std::size_t i = 0; i < world->getNumSkeletons(); i++)
+  {
+    auto skel = world->getSkeleton(i);
+    int dofs = skel->getNumDofs();
+    result.middleRows(cursor, dofs) = skel->getJacobianOfMinvWrtPositionTimes(
+        tau.segment(cursor, dofs), D.middleRows(cursor, dofs));
+    cursor += dofs;
+  }
+  return result;
+}
+
+//==============================================================================
+/// This returns getJacobianOfMinv(world, tau, WithRespectTo::POSITION)^T * u,
+/// without forming the Jacobian
+Eigen::VectorXd BackpropSnapshot::getJacobianOfMinvWrtPositionTransposeTimes(
+    simulation::WorldPtr world,
+    const Eigen::VectorXd& tau,
+    const Eigen::VectorXd& u)
+{
+  Eigen::VectorXd result = Eigen::VectorXd::Zero(mNumDOFs);
+  int cursor = 0;
+  for (std::size_t i = 0; i < world->getNumSkeletons(); i++)
+  {
+    auto skel = world->getSkeleton(i);
+    int dofs = skel->getNumDofs();
+    result.segment(cursor, dofs)
+        = skel->getJacobianOfMinvWrtPositionTransposeTimes(
+            tau.segment(cursor, dofs), u.segment(cursor, dofs));
+    cursor += dofs;
+  }
+  return result;
+}
+
 //==============================================================================
 /// This returns the jacobian of C(pos, inertia, vel), holding everything
 /// constant except the value of WithRespectTo
 Eigen::MatrixXd BackpropSnapshot::getJacobianOfC(
     simulation::WorldPtr world, WithRespectTo* wrt)
 {
+  if (dynamic_cast<WithRespectToMass*>(wrt) != nullptr
+      || wrt == WithRespectTo::POSITION || wrt == WithRespectTo::VELOCITY)
+  {
+    // Mass properties, positions and velocities don't couple skeletons
+    // together, so the Jacobian is block diagonal, and each skeleton can
+    // compute its block analytically
+    Eigen::MatrixXd J = Eigen::MatrixXd::Zero(mNumDOFs, wrt->dim(world.get()));
+    int wrtCursor = 0;
+    int dofCursor = 0;
+    for (std::size_t i = 0; i < world->getNumSkeletons(); i++)
+    {
+      auto skel = world->getSkeleton(i);
+      int dofs = skel->getNumDofs();
+      int skelWrtDim = wrt->dim(skel.get());
+      J.block(dofCursor, wrtCursor, dofs, skelWrtDim)
+          = skel->getJacobianOfC(wrt);
+      wrtCursor += skelWrtDim;
+      dofCursor += dofs;
+    }
+    return J;
+  }
   return finiteDifferenceJacobianOfC(world, wrt);
 }
 
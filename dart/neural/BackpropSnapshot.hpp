@@ -1,12 +1,14 @@
 #ifndef DART_NEURAL_SNAPSHOT_HPP_
 #define DART_NEURAL_SNAPSHOT_HPP_
 
+#include <mutex>
 #include <unordered_map>
 #include <vector>
 
 #include <Eigen/Dense>
 
 #include "dart/neural/DifferentiableContactConstraint.hpp"
+#include "dart/neural/FiniteDifferenceEngine.hpp"
 #include "dart/neural/NeuralConstants.hpp"
 #include "dart/neural/NeuralUtils.hpp"
 #include "dart/neural/WithRespectTo.hpp"
@@ -48,6 +50,39 @@ public:
       PerformanceLog* perfLog = nullptr,
       bool exploreAlternateStrategies = false);
 
+  /// This computes the same result as backprop(), but with vector-Jacobian
+  /// products, so it doesn't form the N x N pos-pos, vel-pos, vel-vel or
+  /// force-vel Jacobians. The loss is pushed back through the integrator one
+  /// joint at a time, through Minv with the implicit mass matrix, through the
+  /// clamping LCP with the pseudoinverse each constraint group caches, through
+  /// the contact geometry with each constraint's sparse force Jacobian, and
+  /// through C(pos, vel) and Minv(pos) with each skeleton's reverse sweep. The
+  /// mass derivatives still come from the mass-vel Jacobian, so backprop()
+  /// only uses this path when the world has no mass dimensions. This doesn't
+  /// clip the gradients to the bounds.
+  void backpropWithoutJacobians(
+      simulation::WorldPtr world,
+      LossGradient& thisTimestepLoss,
+      const LossGradient& nextTimestepLoss,
+      PerformanceLog* perfLog = nullptr);
+
+  /// This computes J * d for k directions at once, where J is the Jacobian of
+  /// the state after this timestep, without forming J. Each column of dPos,
+  /// dVel and dForce (and dMass, if it isn't empty) is one direction. This
+  /// returns the tangent of the next position and velocity along each of them.
+  /// C and Minv are applied with each skeleton's forward sweeps, the contact
+  /// geometry derivatives with each constraint's sparse force Jacobian, and Q
+  /// with the pseudoinverse each constraint group caches, so no N x N
+  /// Jacobian is formed. The one exception is the mass term: if dMass isn't
+  /// empty, that comes from the mass-vel Jacobian.
+  StateTangentBatch jvp(
+      simulation::WorldPtr world,
+      const Eigen::MatrixXd& dPos,
+      const Eigen::MatrixXd& dVel,
+      const Eigen::MatrixXd& dForce,
+      const Eigen::MatrixXd& dMass = Eigen::MatrixXd::Zero(0, 0),
+      PerformanceLog* perfLog = nullptr);
+
   /// This zeros out any components of the gradient that would want to push us
   /// out of the box-bounds encoded in the world for pos, vel, or force.
   void clipLossGradientsToBounds(
@@ -113,6 +148,10 @@ public:
   /// during the forward pass, BEFORE the timestep.
   Eigen::VectorXd getPreStepTorques();
 
+  /// Returns the cached LCP solution the world had BEFORE the timestep, which
+  /// warm starts the LCP
+  Eigen::VectorXd getPreStepLCPCache();
+
   /// Returns a concatenated vector of all the Skeletons' velocity()'s in the
   /// World, in order in which the Skeletons appear in the World's
   /// getSkeleton(i) returns them, AFTER integrating forward dynamics but BEFORE
@@ -176,6 +215,14 @@ public:
   /// to clamping indices.
   Eigen::MatrixXd getClampingAMatrix();
 
+  /// This is Q = A_c^T * Minv * (A_c + A_ub * E) for the whole world, a block
+  /// diagonal concatenation of the Q each constraint group caches.
+  Eigen::MatrixXd getClampingQ();
+
+  /// This is the pseudoinverse of getClampingQ(), assembled from the
+  /// factorizations each constraint group caches, so Q is never refactored.
+  Eigen::MatrixXd getClampingQPseudoInverse();
+
   /// This returns the pos-C(pos,vel) Jacobian for the whole world, a block
   /// diagonal concatenation of the skeleton pos-C(pos,vel) Jacobians.
   Eigen::MatrixXd getPosCJacobian(simulation::WorldPtr world);
@@ -279,6 +326,17 @@ public:
   Eigen::MatrixXd getProjectionIntoClampsMatrix(
       simulation::WorldPtr world, bool forFiniteDifferencing = false);
 
+  /// This returns the transpose of the integrator's pos-pos Jacobian (or
+  /// vel-pos Jacobian, if `wrtVel`) times x, ignoring bounces, without
+  /// forming it
+  Eigen::VectorXd integratorJacobianTransposeTimes(
+      simulation::WorldPtr world, const Eigen::VectorXd& x, bool wrtVel);
+
+  /// This returns the integrator's pos-pos Jacobian (or vel-pos Jacobian, if
+  /// `wrtVel`) times x, ignoring bounces, without forming it
+  Eigen::MatrixXd integratorJacobianTimes(
+      simulation::WorldPtr world, const Eigen::MatrixXd& x, bool wrtVel);
+
   /// This replaces x with the result of M*x in place, without explicitly
   /// forming M
   Eigen::VectorXd implicitMultiplyByMassMatrix(
@@ -420,6 +478,20 @@ public:
   Eigen::MatrixXd getJacobianOfMinv(
       simulation::WorldPtr world, Eigen::VectorXd tau, WithRespectTo* wrt);
 
+  /// This returns getJacobianOfMinv(world, tau, WithRespectTo::POSITION) * D,
+  /// one skeleton at a time, without forming the Jacobian
+  Eigen::MatrixXd getJacobianOfMinvWrtPositionTimes(
+      simulation::WorldPtr world,
+      const Eigen::VectorXd& tau,
+      const Eigen::MatrixXd& D);
+
+  /// This returns getJacobianOfMinv(world, tau, WithRespectTo::POSITION)^T * u,
+  /// one skeleton at a time, without forming the Jacobian
+  Eigen::VectorXd getJacobianOfMinvWrtPositionTransposeTimes(
+      simulation::WorldPtr world,
+      const Eigen::VectorXd& tau,
+      const Eigen::VectorXd& u);
+
   /// This computes and returns the jacobian of M^{-1}(pos, inertia) * tau by
   /// finite differences. This is SUPER SLOW, and is only here for testing.
   Eigen::MatrixXd finiteDifferenceJacobianOfMinv(
@@ -670,6 +742,29 @@ public:
       std::shared_ptr<simulation::World> world, int numSamples);
 
 protected:
+  /// This finite differences the post-step velocities (or positions, if
+  /// `outputPositions` is true) with respect to `inputDim` inputs, on the
+  /// world's FiniteDifferenceEngine. Each evaluation resets a World clone to
+  /// our pre-step state and then calls `perturb(world, column, eps)` to nudge
+  /// the input. `perturb` is called again with eps = 0 after the step, so
+  /// it can undo changes to persistent properties of the World (like link
+  /// masses) before the clone gets reused.
+  ///
+  /// If `requireSameClamping` is true, steps that change the number of
+  /// clamping or upper bounded constraints get rejected and shrunk. If
+  /// `subdivisions` > 1, we take that many steps of 1/subdivisions the
+  /// timestep instead of a single forwardPass().
+  Eigen::MatrixXd finiteDifferenceStepJacobian(
+      simulation::WorldPtr world,
+      int inputDim,
+      const std::function<void(
+          const simulation::WorldPtr& world, int column, double eps)>& perturb,
+      bool outputPositions,
+      bool requireSameClamping,
+      FiniteDifferenceScheme scheme,
+      double eps,
+      std::size_t subdivisions = 1);
+
   /// If this is true, we use finite-differencing to compute all of the
   /// requested Jacobians. This override can be useful to verify if there's a
   /// bug in the analytical Jacobians that's causing learning to not converge.
@@ -752,6 +847,15 @@ private:
   bool mCachedMassVelDirty;
   Eigen::MatrixXd mCachedMassVel;
 
+  /// This guards the cached Jacobians above, and the Q factorizations cached
+  /// in mGradientMatrices, so that callers which have released the Python GIL
+  /// can't refill or dirty them concurrently. It's recursive because the
+  /// getters call each other. Each cache is written
+  /// exactly once, on its first compute (benchmarkJacobians() times its
+  /// recomputes in scratch buffers), so the references the getters return stay
+  /// valid and unchanged for the life of the snapshot.
+  std::recursive_mutex mCacheMutex;
+
   Eigen::VectorXd scratch(simulation::WorldPtr world);
 
   enum MatrixToAssemble
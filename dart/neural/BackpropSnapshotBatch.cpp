@@ -0,0 +1,157 @@
+#include "dart/neural/BackpropSnapshotBatch.hpp"
+
+#include "dart/neural/BackpropSnapshot.hpp"
+#include "dart/simulation/World.hpp"
+
+namespace dart {
+namespace neural {
+
+//==============================================================================
+BackpropSnapshotBatch::BackpropSnapshotBatch(
+    std::shared_ptr<simulation::WorldBatch> batch,
+    std::vector<std::shared_ptr<BackpropSnapshot>> snapshots)
+  : mWorldBatch(batch), mSnapshots(snapshots)
+{
+  assert((int)mSnapshots.size() == mWorldBatch->getBatchSize());
+}
+
+//==============================================================================
+/// Returns the number of snapshots in this batch
+int BackpropSnapshotBatch::getBatchSize() const
+{
+  return static_cast<int>(mSnapshots.size());
+}
+
+//==============================================================================
+/// Returns the snapshot for a single batch entry
+std::shared_ptr<BackpropSnapshot> BackpropSnapshotBatch::getSnapshot(
+    int index) const
+{
+  assert(index >= 0 && index < getBatchSize());
+  return mSnapshots[index];
+}
+
+//==============================================================================
+/// Returns the WorldBatch these snapshots were recorded on
+std::shared_ptr<simulation::WorldBatch> BackpropSnapshotBatch::getWorldBatch()
+    const
+{
+  return mWorldBatch;
+}
+
+//==============================================================================
+/// This computes the implicit backprop for every entry in the batch, in
+/// parallel.
+void BackpropSnapshotBatch::backprop(
+    LossGradientBatch& thisTimestepLoss,
+    const LossGradientBatch& nextTimestepLoss)
+{
+  int batchSize = getBatchSize();
+  int dofs = mWorldBatch->getNumDofs();
+  assert(nextTimestepLoss.lossWrtPosition.cols() == batchSize);
+  assert(nextTimestepLoss.lossWrtVelocity.cols() == batchSize);
+
+  thisTimestepLoss.lossWrtPosition = Eigen::MatrixXd::Zero(dofs, batchSize);
+  thisTimestepLoss.lossWrtVelocity = Eigen::MatrixXd::Zero(dofs, batchSize);
+  thisTimestepLoss.lossWrtTorque = Eigen::MatrixXd::Zero(dofs, batchSize);
+  // The mass gradient length depends on the World, so we size it on the fly
+  std::vector<Eigen::VectorXd> lossWrtMass(batchSize);
+
+  bool hasMassLoss = nextTimestepLoss.lossWrtMass.cols() == batchSize;
+
+  // BackpropSnapshot::backprop() sets the world to the snapshot's pre-step
+  // state itself, and restores it afterwards, so the state the batch loads into
+  // each worker World doesn't matter here, and comes back out unchanged.
+  mWorldBatch->parallelForEachEntry(
+      [&](int index, const std::shared_ptr<simulation::World>& world) {
+        LossGradient next;
+        next.lossWrtPosition = nextTimestepLoss.lossWrtPosition.col(index);
+        next.lossWrtVelocity = nextTimestepLoss.lossWrtVelocity.col(index);
+        if (hasMassLoss)
+        {
+          next.lossWrtMass = nextTimestepLoss.lossWrtMass.col(index);
+        }
+        else
+        {
+          next.lossWrtMass = Eigen::VectorXd::Zero(world->getMassDims());
+        }
+
+        LossGradient thisLoss;
+        mSnapshots[index]->backprop(world, thisLoss, next);
+
+        thisTimestepLoss.lossWrtPosition.col(index) = thisLoss.lossWrtPosition;
+        thisTimestepLoss.lossWrtVelocity.col(index) = thisLoss.lossWrtVelocity;
+        thisTimestepLoss.lossWrtTorque.col(index) = thisLoss.lossWrtTorque;
+        lossWrtMass[index] = thisLoss.lossWrtMass;
+      });
+
+  int massDims = batchSize > 0 ? lossWrtMass[0].size() : 0;
+  thisTimestepLoss.lossWrtMass = Eigen::MatrixXd::Zero(massDims, batchSize);
+  for (int i = 0; i < batchSize; i++)
+  {
+    thisTimestepLoss.lossWrtMass.col(i) = lossWrtMass[i];
+  }
+}
+
+//==============================================================================
+/// Returns the positions before the step, one column per batch entry
+Eigen::MatrixXd BackpropSnapshotBatch::getPreStepPosition()
+{
+  Eigen::MatrixXd result(mWorldBatch->getNumDofs(), getBatchSize());
+  for (int i = 0; i < getBatchSize(); i++)
+    result.col(i) = mSnapshots[i]->getPreStepPosition();
+  return result;
+}
+
+//==============================================================================
+/// Returns the velocities before the step, one column per batch entry
+Eigen::MatrixXd BackpropSnapshotBatch::getPreStepVelocity()
+{
+  Eigen::MatrixXd result(mWorldBatch->getNumDofs(), getBatchSize());
+  for (int i = 0; i < getBatchSize(); i++)
+    result.col(i) = mSnapshots[i]->getPreStepVelocity();
+  return result;
+}
+
+//==============================================================================
+/// Returns the torques before the step, one column per batch entry
+Eigen::MatrixXd BackpropSnapshotBatch::getPreStepTorques()
+{
+  Eigen::MatrixXd result(mWorldBatch->getNumDofs(), getBatchSize());
+  for (int i = 0; i < getBatchSize(); i++)
+    result.col(i) = mSnapshots[i]->getPreStepTorques();
+  return result;
+}
+
+//==============================================================================
+/// Returns the positions after the step, one column per batch entry
+Eigen::MatrixXd BackpropSnapshotBatch::getPostStepPosition()
+{
+  Eigen::MatrixXd result(mWorldBatch->getNumDofs(), getBatchSize());
+  for (int i = 0; i < getBatchSize(); i++)
+    result.col(i) = mSnapshots[i]->getPostStepPosition();
+  return result;
+}
+
+//==============================================================================
+/// Returns the velocities after the step, one column per batch entry
+Eigen::MatrixXd BackpropSnapshotBatch::getPostStepVelocity()
+{
+  Eigen::MatrixXd result(mWorldBatch->getNumDofs(), getBatchSize());
+  for (int i = 0; i < getBatchSize(); i++)
+    result.col(i) = mSnapshots[i]->getPostStepVelocity();
+  return result;
+}
+
+//==============================================================================
+/// Returns the torques after the step, one column per batch entry
+Eigen::MatrixXd BackpropSnapshotBatch::getPostStepTorques()
+{
+  Eigen::MatrixXd result(mWorldBatch->getNumDofs(), getBatchSize());
+  for (int i = 0; i < getBatchSize(); i++)
+    result.col(i) = mSnapshots[i]->getPostStepTorques();
+  return result;
+}
+
+} // namespace neural
+} // namespace dart
@@ -0,0 +1,73 @@
+#ifndef DART_NEURAL_SNAPSHOT_BATCH_HPP_
+#define DART_NEURAL_SNAPSHOT_BATCH_HPP_
+
+#include <memory>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/neural/NeuralUtils.hpp"
+#include "dart/simulation/WorldBatch.hpp"
+
+namespace dart {
+namespace neural {
+
+class BackpropSnapshot;
+
+/// This holds the BackpropSnapshots from a single forwardPassBatch(), one per
+/// batch entry, and knows how to backprop through all of them at once on the
+/// WorldBatch's thread pool. Gradients come in and go out as
+/// LossGradientBatch matrices, with one column per batch entry.
+class BackpropSnapshotBatch
+{
+public:
+  BackpropSnapshotBatch(
+      std::shared_ptr<simulation::WorldBatch> batch,
+      std::vector<std::shared_ptr<BackpropSnapshot>> snapshots);
+
+  /// Returns the number of snapshots in this batch
+  int getBatchSize() const;
+
+  /// Returns the snapshot for a single batch entry
+  std::shared_ptr<BackpropSnapshot> getSnapshot(int index) const;
+
+  /// Returns the WorldBatch these snapshots were recorded on
+  std::shared_ptr<simulation::WorldBatch> getWorldBatch() const;
+
+  /// This computes the implicit backprop for every entry in the batch, in
+  /// parallel. Column `i` of each matrix in `nextTimestepLoss` is the loss
+  /// gradient for entry `i` after the step, and column `i` of each matrix in
+  /// `thisTimestepLoss` gets filled in with the loss gradient before the step.
+  ///
+  /// This doesn't change the state of the WorldBatch.
+  void backprop(
+      LossGradientBatch& thisTimestepLoss,
+      const LossGradientBatch& nextTimestepLoss);
+
+  /// Returns the positions before the step, one column per batch entry
+  Eigen::MatrixXd getPreStepPosition();
+
+  /// Returns the velocities before the step, one column per batch entry
+  Eigen::MatrixXd getPreStepVelocity();
+
+  /// Returns the torques before the step, one column per batch entry
+  Eigen::MatrixXd getPreStepTorques();
+
+  /// Returns the positions after the step, one column per batch entry
+  Eigen::MatrixXd getPostStepPosition();
+
+  /// Returns the velocities after the step, one column per batch entry
+  Eigen::MatrixXd getPostStepVelocity();
+
+  /// Returns the torques after the step, one column per batch entry
+  Eigen::MatrixXd getPostStepTorques();
+
+protected:
+  std::shared_ptr<simulation::WorldBatch> mWorldBatch;
+  std::vector<std::shared_ptr<BackpropSnapshot>> mSnapshots;
+};
+
+} // namespace neural
+} // namespace dart
+
+#endif
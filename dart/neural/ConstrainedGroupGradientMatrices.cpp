@@ -11,6 +11,7 @@
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/neural/NeuralUtils.hpp"
 #include "dart/neural/RestorableSnapshot.hpp"
+#include "dart/neural/WithRespectToMass.hpp"
 #include "dart/simulation/World.hpp"
 
 using namespace dart;
@@ -27,7 +28,10 @@ namespace neural {
 //==============================================================================
 ConstrainedGroupGradientMatrices::ConstrainedGroupGradientMatrices(
     constraint::ConstrainedGroup& group, double timeStep)
-  : mFinalized(false), mDeliberatelyIgnoreFriction(false)
+  : mFinalized(false),
+    mDeliberatelyIgnoreFriction(false),
+    mClampingQDirty(true),
+    mUseSparseA(false)
 {
   mTimeStep = timeStep;
   assert(mClampingConstraints.size() == 0);
@@ -84,6 +88,7 @@ ConstrainedGroupGradientMatrices::ConstrainedGroupGradientMatrices(
 //==============================================================================
 ConstrainedGroupGradientMatrices::ConstrainedGroupGradientMatrices(
     int numDofs, int numConstraintDim, double timeStep)
+  : mClampingQDirty(true), mUseSparseA(false)
 {
   mNumDOFs = numDofs;
   mNumConstraintDim = numConstraintDim;
@@ -156,6 +161,28 @@ void ConstrainedGroupGradientMatrices::measureConstraintImpulse(
   mMassedImpulseTests.push_back(massedImpulseTest);
 }
 
+//==============================================================================
+/// This is the same as measureConstraintImpulse(), except that the caller
+/// passes in the velocity change of each skeleton in
+/// `constraint->getSkeletons()`, in that order.
+void ConstrainedGroupGradientMatrices::measureConstraintImpulse(
+    const constraint::ConstraintBasePtr& constraint,
+    const std::vector<Eigen::VectorXd>& skelVelocityChanges)
+{
+  Eigen::VectorXd massedImpulseTest = Eigen::VectorXd::Zero(mNumDOFs);
+  std::vector<SkeletonPtr> skels = constraint->getSkeletons();
+  assert(skels.size() == skelVelocityChanges.size());
+  for (std::size_t i = 0; i < skels.size(); i++)
+  {
+    std::size_t offset = mSkeletonOffset[skels[i]->getName()];
+    std::size_t dofs = skels[i]->getNumDofs();
+    assert(skelVelocityChanges[i].size() == dofs);
+
+    massedImpulseTest.segment(offset, dofs) = skelVelocityChanges[i];
+  }
+  mMassedImpulseTests.push_back(massedImpulseTest);
+}
+
 //==============================================================================
 void ConstrainedGroupGradientMatrices::mockMeasureConstraintImpulse(
     Eigen::VectorXd massedImpulseTest)
@@ -181,6 +208,36 @@ void ConstrainedGroupGradientMatrices::registerLCPResults(
   mB = b;
   mAColNorms = aColNorms;
   mA = A;
+  mSparseA.resize(0, 0);
+  mUseSparseA = false;
+  mDeliberatelyIgnoreFriction = deliberatelyIgnoreFriction;
+}
+
+//==============================================================================
+/// This is the same as registerLCPResults() above, except that A is the
+/// block-sparse Delassus matrix the solver built.
+void ConstrainedGroupGradientMatrices::registerLCPResults(
+    Eigen::VectorXd X,
+    Eigen::VectorXd hi,
+    Eigen::VectorXd lo,
+    Eigen::VectorXi fIndex,
+    Eigen::VectorXd b,
+    const constraint::BlockSparseDelassus& A,
+    bool deliberatelyIgnoreFriction)
+{
+  mX = X;
+  mHi = hi;
+  mLo = lo;
+  mFIndex = fIndex;
+  mB = b;
+  mSparseA = A.toSparse();
+  mAColNorms.resize(mSparseA.rows());
+  for (int i = 0; i < mSparseA.rows(); i++)
+  {
+    mAColNorms(i) = mSparseA.row(i).squaredNorm();
+  }
+  mA.resize(0, 0);
+  mUseSparseA = true;
   mDeliberatelyIgnoreFriction = deliberatelyIgnoreFriction;
 }
 
@@ -190,6 +247,11 @@ void ConstrainedGroupGradientMatrices::registerLCPResults(
 bool ConstrainedGroupGradientMatrices::isSolutionValid(
     const Eigen::VectorXd& mX)
 {
+  if (mUseSparseA)
+  {
+    return constraint::LCPUtils::isLCPSolutionValid(
+        mSparseA, mX, mB, mHi, mLo, mFIndex, mDeliberatelyIgnoreFriction);
+  }
   return constraint::LCPUtils::isLCPSolutionValid(
       mA, mX, mB, mHi, mLo, mFIndex, mDeliberatelyIgnoreFriction);
 }
@@ -211,7 +273,7 @@ bool ConstrainedGroupGradientMatrices::opportunisticallyStandardizeResults(
   {
     // a 0-size solution is always valid, as long as it's not trivially broken
     // (wrong dimensions)
-    return mX.size() == mA.rows();
+    return mX.size() == (mUseSparseA ? mSparseA.rows() : mA.rows());
   }
   const Eigen::MatrixXd& A_c = getClampingConstraintMatrix();
   if (A_c.cols() == 0)
@@ -230,39 +292,8 @@ bool ConstrainedGroupGradientMatrices::opportunisticallyStandardizeResults(
       return false;
     }
   }
-  const Eigen::MatrixXd& A_ub = getUpperBoundConstraintMatrix();
-  const Eigen::MatrixXd& E = getUpperBoundMappingMatrix();
-  Eigen::MatrixXd A_c_ub_E = A_c + A_ub * E;
-
-  Eigen::MatrixXd Q = A_c.transpose() * mMinv * A_c_ub_E;
   Eigen::VectorXd b = getClampingConstraintRelativeVels();
-
-  if (A_ub.cols() == 0)
-  {
-    Eigen::MatrixXd realQ = getClampingAMatrix();
-#ifndef NDEBUG
-    // Sanity check
-    Eigen::MatrixXd diff = Q - realQ;
-    assert(std::abs(diff.maxCoeff()) < 1e-11);
-    assert(std::abs(diff.minCoeff()) < 1e-11);
-#endif
-    Q = realQ;
-  }
-  /*
-    else
-    {
-  #ifndef NDEBUG
-      // Sanity check
-      Eigen::MatrixXd realQ = getClampingAMatrix();
-      Eigen::MatrixXd diff = Q - realQ;
-      // These should usually not be equal, but it's not a requirement
-      assert(
-          std::abs(diff.maxCoeff()) > 1e-11 || std::abs(diff.minCoeff()) >
-  1e-11); #endif
-    }
-  */
-
-  Eigen::VectorXd f_c = Q.completeOrthogonalDecomposition().solve(b);
+  Eigen::VectorXd f_c = getClampingQDecomposition().solve(b);
   Eigen::VectorXd originalF_c = getClampingConstraintImpulses();
 
   bool anyNewlyNotClamping = false;
@@ -476,6 +507,9 @@ void ConstrainedGroupGradientMatrices::constructMatrices(
   // deduplicateConstraints();
 
   mContactConstraintMappings = mFIndex;
+  // Everything Q is built from is about to change
+  mClampingQDirty = true;
+
   // Group the constraints based on their solution values into three buckets:
   //
   // - "Clamping": These are constraints that have non-zero constraint forces
@@ -838,6 +872,23 @@ void ConstrainedGroupGradientMatrices::constructMatrices(
     if (mContactConstraintMappings(row) == neural::ConstraintMapping::CLAMPING)
     {
       int clampingRow = mClampingIndex[row];
+      if (mUseSparseA)
+      {
+        // The sparse path never fills mA, so read the stored nonzeros
+        for (Eigen::SparseMatrix<double, Eigen::RowMajor>::InnerIterator it(
+                 mSparseA, row);
+             it;
+             ++it)
+        {
+          if (mContactConstraintMappings(it.col())
+              == neural::ConstraintMapping::CLAMPING)
+          {
+            int clampingCol = mClampingIndex[it.col()];
+            mClampingAMatrix(clampingRow, clampingCol) = it.value();
+          }
+        }
+        continue;
+      }
       for (size_t col = 0; col < mNumConstraintDim; col++)
       {
         if (mContactConstraintMappings(col)
@@ -1494,6 +1545,27 @@ ConstrainedGroupGradientMatrices::estimateClampingConstraintImpulses(
 Eigen::MatrixXd ConstrainedGroupGradientMatrices::getJacobianOfMinv(
     simulation::WorldPtr world, Eigen::VectorXd tau, WithRespectTo* wrt)
 {
+  if (dynamic_cast<WithRespectToMass*>(wrt) != nullptr
+      || wrt == WithRespectTo::POSITION)
+  {
+    Eigen::MatrixXd J
+        = Eigen::MatrixXd::Zero(mNumDOFs, getWrtDim(world, wrt));
+
+    int wrtCursor = 0;
+    int dofCursor = 0;
+    for (const std::string& skelName : mSkeletons)
+    {
+      auto skel = world->getSkeleton(skelName);
+      int dofs = skel->getNumDofs();
+      int skelWrtDim = wrt->dim(skel.get());
+      J.block(dofCursor, wrtCursor, dofs, skelWrtDim)
+          = skel->getJacobianOfMinv(tau.segment(dofCursor, dofs), wrt);
+      wrtCursor += skelWrtDim;
+      dofCursor += dofs;
+    }
+
+    return J;
+  }
   return finiteDifferenceJacobianOfMinv(world, tau, wrt);
 }
 
@@ -2037,6 +2109,61 @@ const Eigen::MatrixXd& ConstrainedGroupGradientMatrices::getClampingAMatrix()
   return mClampingAMatrix;
 }
 
+//==============================================================================
+/// This is Q = A_c^T * Minv * (A_c + A_ub * E), cached until the next call to
+/// constructMatrices().
+const Eigen::MatrixXd& ConstrainedGroupGradientMatrices::getClampingQ()
+{
+  if (mClampingQDirty)
+  {
+    const Eigen::MatrixXd& A_c = getClampingConstraintMatrix();
+    const Eigen::MatrixXd& A_ub = getUpperBoundConstraintMatrix();
+    const Eigen::MatrixXd& E = getUpperBoundMappingMatrix();
+
+    if (A_ub.cols() == 0)
+    {
+      mClampingQ = getClampingAMatrix();
+#ifndef NDEBUG
+      // Sanity check
+      Eigen::MatrixXd diff = A_c.transpose() * mMinv * A_c - mClampingQ;
+      assert(diff.size() == 0 || std::abs(diff.maxCoeff()) < 1e-11);
+      assert(diff.size() == 0 || std::abs(diff.minCoeff()) < 1e-11);
+#endif
+    }
+    else
+    {
+      mClampingQ = A_c.transpose() * mMinv * (A_c + A_ub * E);
+    }
+    if (mClampingQ.size() > 0)
+    {
+      mClampingQDecomposition.compute(mClampingQ);
+      mClampingQPseudoInverse = mClampingQDecomposition.pseudoInverse();
+    }
+    else
+    {
+      mClampingQPseudoInverse = Eigen::MatrixXd::Zero(0, 0);
+    }
+    mClampingQDirty = false;
+  }
+  return mClampingQ;
+}
+
+//==============================================================================
+const Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXd>&
+ConstrainedGroupGradientMatrices::getClampingQDecomposition()
+{
+  getClampingQ();
+  return mClampingQDecomposition;
+}
+
+//==============================================================================
+const Eigen::MatrixXd&
+ConstrainedGroupGradientMatrices::getClampingQPseudoInverse()
+{
+  getClampingQ();
+  return mClampingQPseudoInverse;
+}
+
 //==============================================================================
 const Eigen::VectorXd&
 ConstrainedGroupGradientMatrices::getClampingConstraintImpulses() const
@@ -7,7 +7,9 @@
 #include <vector>
 
 #include <Eigen/Dense>
+#include <Eigen/SparseCore>
 
+#include "dart/constraint/BlockSparseDelassus.hpp"
 #include "dart/neural/DifferentiableContactConstraint.hpp"
 #include "dart/neural/NeuralConstants.hpp"
 #include "dart/neural/NeuralUtils.hpp"
@@ -70,6 +72,15 @@ public:
       const std::shared_ptr<constraint::ConstraintBase>& constraint,
       std::size_t constraintIndex);
 
+  /// This is the same as measureConstraintImpulse(), except that instead of
+  /// reading velocity changes off of skeletons that have just had an impulse
+  /// applied, the caller passes in the velocity change of each skeleton in
+  /// `constraint->getSkeletons()`, in that order. This lets callers compute
+  /// the impulse response for many constraint dimensions at once.
+  void measureConstraintImpulse(
+      const std::shared_ptr<constraint::ConstraintBase>& constraint,
+      const std::vector<Eigen::VectorXd>& skelVelocityChanges);
+
   /// This will attempt to quickly solve an LCP by exploiting locality in the
   /// solution. Assuming we were initialized at the last solution, there's
   /// actually a good chance that we're still in all the same force categories.
@@ -99,6 +110,19 @@ public:
       Eigen::MatrixXd A,
       bool deliberatelyIgnoreFriction);
 
+  /// This is the same as registerLCPResults() above, except that A is the
+  /// block-sparse Delassus matrix the solver built, so nobody ever needs to
+  /// form a dense copy of it. We read the column norms off its rows, since A
+  /// is symmetric.
+  void registerLCPResults(
+      Eigen::VectorXd mX,
+      Eigen::VectorXd hi,
+      Eigen::VectorXd lo,
+      Eigen::VectorXi fIndex,
+      Eigen::VectorXd b,
+      const constraint::BlockSparseDelassus& A,
+      bool deliberatelyIgnoreFriction);
+
   /// If possible (because A is rank-deficient), this changes mX to be the
   /// least-squares minimal solution. This makes mX unique for a given set of
   /// inputs, rather than leaving the exact solution undefined. This can also be
@@ -326,6 +350,19 @@ public:
   /// to clamping indices.
   const Eigen::MatrixXd& getClampingAMatrix() const;
 
+  /// This is Q = A_c^T * Minv * (A_c + A_ub * E), which maps clamping impulses
+  /// to clamping relative velocities. It's computed on first use, and cached
+  /// until the next call to constructMatrices().
+  const Eigen::MatrixXd& getClampingQ();
+
+  /// This is the complete orthogonal decomposition of getClampingQ(), cached
+  /// along with it.
+  const Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXd>&
+  getClampingQDecomposition();
+
+  /// This is the pseudoinverse of getClampingQ(), cached along with it.
+  const Eigen::MatrixXd& getClampingQPseudoInverse();
+
   /// Returns the constraint impulses along the clamping constraints
   const Eigen::VectorXd& getClampingConstraintImpulses() const;
 
@@ -469,6 +506,14 @@ public:
   /// to clamping indices.
   Eigen::MatrixXd mClampingAMatrix;
 
+  /// These are getClampingQ(), its factorization and its pseudoinverse. They
+  /// are only valid while mClampingQDirty is false.
+  Eigen::MatrixXd mClampingQ;
+  Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXd>
+      mClampingQDecomposition;
+  Eigen::MatrixXd mClampingQPseudoInverse;
+  bool mClampingQDirty;
+
   /// This is the inverse mass matrix computed in the constuctor
   Eigen::MatrixXd mMinv;
 
@@ -549,6 +594,11 @@ public:
   Eigen::VectorXd mAColNorms;
   Eigen::MatrixXd mA;
 
+  /// If the solver handed us a BlockSparseDelassus, this holds A instead of
+  /// mA, and mUseSparseA is true
+  Eigen::SparseMatrix<double, Eigen::RowMajor> mSparseA;
+  bool mUseSparseA;
+
   /// This holds the outputs of the impulse tests we run to create the
   /// constraint matrices. We shuffle these vectors into the columns of
   /// mClampingConstraintMatrix and mUpperBoundConstraintMatrix depending on the
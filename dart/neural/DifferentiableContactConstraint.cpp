@@ -1575,6 +1575,129 @@ DifferentiableContactConstraint::getConstraintForcesJacobian(
   return mWorldConstraintJacCache;
 }
 
+//==============================================================================
+/// This returns the entries of row `row` of getConstraintForcesJacobian() that
+/// come from moving the screw axis of `dofs[row]`, as (column, value) pairs.
+std::vector<std::pair<int, double>>
+DifferentiableContactConstraint::getConstraintForceAxisGradients(
+    std::shared_ptr<simulation::World> world,
+    const std::vector<dynamics::DegreeOfFreedom*>& dofs,
+    int row,
+    const Eigen::Vector6d& force)
+{
+  std::vector<std::pair<int, double>> gradients;
+  double multiple = getForceMultiple(dofs[row]);
+  if (multiple == 0.0)
+    return gradients;
+
+  Eigen::Vector6d axisWorldTwist = getWorldScrewAxisForForce(dofs[row]);
+  dynamics::Joint* jointCursor = dofs[row]->getJoint();
+
+  // Include all the DOFs in this joint, if it's a FreeJoint or BallJoint
+  if (jointCursor->getType() != dynamics::FreeJoint::getStaticType()
+      && jointCursor->getType() != dynamics::BallJoint::getStaticType())
+  {
+    dynamics::BodyNode* cursorParentBody = jointCursor->getParentBodyNode();
+    jointCursor = cursorParentBody == nullptr
+                      ? nullptr
+                      : cursorParentBody->getParentJoint();
+  }
+
+  while (jointCursor != nullptr)
+  {
+    for (int i = 0; i < jointCursor->getNumDofs(); i++)
+    {
+      int wrt = jointCursor->getIndexInSkeleton(i)
+                + world->getSkeletonDofOffset(jointCursor->getSkeleton());
+      Eigen::Vector6d screwAxisGradient
+          = getScrewAxisForForceGradient_Optimized(
+              dofs[row], dofs[wrt], axisWorldTwist);
+      gradients.emplace_back(wrt, multiple * screwAxisGradient.dot(force));
+    }
+    dynamics::BodyNode* cursorParentBody = jointCursor->getParentBodyNode();
+    jointCursor = cursorParentBody == nullptr
+                      ? nullptr
+                      : cursorParentBody->getParentJoint();
+  }
+
+  return gradients;
+}
+
+//==============================================================================
+/// This gives getConstraintForcesJacobian(world) * D, without forming the
+/// Jacobian if it isn't already cached.
+Eigen::MatrixXd
+DifferentiableContactConstraint::getConstraintForcesJacobianTimes(
+    std::shared_ptr<simulation::World> world, const Eigen::MatrixXd& D)
+{
+  if (!mWorldConstraintJacCacheDirty)
+  {
+    return mWorldConstraintJacCache * D;
+  }
+
+  int dim = world->getNumDofs();
+  assert(D.rows() == dim);
+  Eigen::Vector6d force = getWorldForce();
+  std::vector<dynamics::DegreeOfFreedom*> dofs = world->getDofs();
+  // Every row shares the contact force Jacobian, so apply it to D once
+  Eigen::MatrixXd forceJacTimesD = getContactForceJacobian(world) * D;
+
+  Eigen::MatrixXd result = Eigen::MatrixXd::Zero(dim, D.cols());
+  for (int row = 0; row < dim; row++)
+  {
+    double multiple = getForceMultiple(dofs[row]);
+    if (multiple == 0.0)
+      continue;
+
+    Eigen::Vector6d axis = getWorldScrewAxisForForce(dofs[row]);
+    result.row(row) = multiple * axis.transpose() * forceJacTimesD;
+    for (const std::pair<int, double>& gradient :
+         getConstraintForceAxisGradients(world, dofs, row, force))
+    {
+      result.row(row) += gradient.second * D.row(gradient.first);
+    }
+  }
+  return result;
+}
+
+//==============================================================================
+/// This gives getConstraintForcesJacobian(world)^T * U, without forming the
+/// Jacobian if it isn't already cached.
+Eigen::MatrixXd
+DifferentiableContactConstraint::getConstraintForcesJacobianTransposeTimes(
+    std::shared_ptr<simulation::World> world, const Eigen::MatrixXd& U)
+{
+  if (!mWorldConstraintJacCacheDirty)
+  {
+    return mWorldConstraintJacCache.transpose() * U;
+  }
+
+  int dim = world->getNumDofs();
+  assert(U.rows() == dim);
+  Eigen::Vector6d force = getWorldForce();
+  std::vector<dynamics::DegreeOfFreedom*> dofs = world->getDofs();
+
+  Eigen::MatrixXd result = Eigen::MatrixXd::Zero(dim, U.cols());
+  // This collects sum(multiple * axis * U.row(row)), so the contact force
+  // Jacobian only gets applied once
+  Eigen::MatrixXd axesTimesU = Eigen::MatrixXd::Zero(6, U.cols());
+  for (int row = 0; row < dim; row++)
+  {
+    double multiple = getForceMultiple(dofs[row]);
+    if (multiple == 0.0)
+      continue;
+
+    axesTimesU += multiple * getWorldScrewAxisForForce(dofs[row]) * U.row(row);
+    for (const std::pair<int, double>& gradient :
+         getConstraintForceAxisGradients(world, dofs, row, force))
+    {
+      result.row(gradient.first) += gradient.second * U.row(row);
+    }
+  }
+  result += getContactForceJacobian(world).transpose() * axesTimesU;
+  return result;
+}
+
 //==============================================================================
 /// This computes and returns the analytical Jacobian relating how changes in
 /// the positions of wrt's DOFs changes the constraint forces on skel.
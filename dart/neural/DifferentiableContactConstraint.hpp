@@ -4,6 +4,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <Eigen/Dense>
@@ -214,6 +215,18 @@ public:
       std::shared_ptr<simulation::World> world,
       std::vector<std::shared_ptr<dynamics::Skeleton>> skels);
 
+  /// This gives getConstraintForcesJacobian(world) * D. If the Jacobian isn't
+  /// already cached, this doesn't form it: every row is the contact force
+  /// Jacobian dotted with that DOF's axis, plus a few entries for the joints
+  /// above it, so this is O(n * D.cols()).
+  Eigen::MatrixXd getConstraintForcesJacobianTimes(
+      std::shared_ptr<simulation::World> world, const Eigen::MatrixXd& D);
+
+  /// This gives getConstraintForcesJacobian(world)^T * U, the same way as
+  /// getConstraintForcesJacobianTimes().
+  Eigen::MatrixXd getConstraintForcesJacobianTransposeTimes(
+      std::shared_ptr<simulation::World> world, const Eigen::MatrixXd& U);
+
   /// This returns the skeletons that this contact constraint interacts with.
   const std::vector<std::shared_ptr<dynamics::Skeleton>>& getSkeletons();
 
@@ -368,6 +381,15 @@ public:
   /// Pretty much only public for testing
   double getForceMultiple(dynamics::DegreeOfFreedom* dof);
 
+  /// This returns the entries of row `row` of getConstraintForcesJacobian()
+  /// that come from moving the screw axis of `dofs[row]`, as (column, value)
+  /// pairs. These are only nonzero for the joints above `dofs[row]`.
+  std::vector<std::pair<int, double>> getConstraintForceAxisGradients(
+      std::shared_ptr<simulation::World> world,
+      const std::vector<dynamics::DegreeOfFreedom*>& dofs,
+      int row,
+      const Eigen::Vector6d& force);
+
 public:
   /// Returns true if this dof moves this body node
   bool isParent(
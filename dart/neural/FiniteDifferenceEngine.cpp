@@ -0,0 +1,459 @@
+#include "dart/neural/FiniteDifferenceEngine.hpp"
+
+#include <array>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <string>
+
+#include "dart/collision/CollisionDetector.hpp"
+#include "dart/constraint/ConstraintSolver.hpp"
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/DegreeOfFreedom.hpp"
+#include "dart/dynamics/Joint.hpp"
+#include "dart/dynamics/ShapeNode.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/simulation/World.hpp"
+
+namespace dart {
+namespace neural {
+
+namespace {
+
+void hashCombine(std::size_t& seed, std::size_t value)
+{
+  seed ^= value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+}
+
+void hashMatrix(std::size_t& seed, const Eigen::MatrixXd& matrix)
+{
+  hashCombine(seed, matrix.rows());
+  hashCombine(seed, matrix.cols());
+  for (int i = 0; i < matrix.size(); i++)
+  {
+    hashCombine(seed, std::hash<double>()(matrix.data()[i]));
+  }
+}
+
+/// This hashes everything about a World's structure that syncWorldClones()
+/// doesn't copy over on its own: which skeletons there are, how they're
+/// connected, their joint types, offsets and axes, their collision shapes, and
+/// the collision detector. If this changes, the clones are stale.
+std::size_t getStructuralSignature(simulation::World* world)
+{
+  std::size_t seed = 0;
+  hashCombine(
+      seed,
+      std::hash<std::string>()(
+          world->getConstraintSolver()->getCollisionDetector()->getType()));
+  hashCombine(seed, world->getNumSkeletons());
+  for (std::size_t i = 0; i < world->getNumSkeletons(); i++)
+  {
+    dynamics::Skeleton* skel = world->getSkeleton(i).get();
+    hashCombine(seed, std::hash<const void*>()(skel));
+    hashCombine(seed, std::hash<std::string>()(skel->getName()));
+    hashCombine(seed, skel->getNumDofs());
+    hashCombine(seed, skel->isMobile());
+    hashCombine(seed, skel->getSelfCollisionCheck());
+    hashCombine(seed, skel->getAdjacentBodyCheck());
+    hashCombine(seed, skel->getNumBodyNodes());
+    for (std::size_t j = 0; j < skel->getNumBodyNodes(); j++)
+    {
+      dynamics::BodyNode* node = skel->getBodyNode(j);
+      dynamics::BodyNode* parent = node->getParentBodyNode();
+      hashCombine(seed, parent ? parent->getIndexInSkeleton() + 1 : 0);
+
+      dynamics::Joint* joint = node->getParentJoint();
+      hashCombine(seed, std::hash<std::string>()(joint->getType()));
+      hashCombine(seed, joint->getActuatorType());
+      hashMatrix(seed, joint->getTransformFromParentBodyNode().matrix());
+      hashMatrix(seed, joint->getTransformFromChildBodyNode().matrix());
+      // The relative Jacobian at the zero configuration captures joint axes,
+      // without us having to know about every joint type
+      hashMatrix(
+          seed,
+          joint->getRelativeJacobian(
+              Eigen::VectorXd::Zero(joint->getNumDofs())));
+
+      // Clones share Shape objects with the original, so resizing a shape in
+      // place is already visible to them. Swapping or moving one isn't.
+      const std::size_t numShapeNodes = node->getNumShapeNodes();
+      hashCombine(seed, numShapeNodes);
+      for (std::size_t k = 0; k < numShapeNodes; k++)
+      {
+        const dynamics::ShapeNode* shapeNode = node->getShapeNode(k);
+        hashCombine(seed, std::hash<const void*>()(shapeNode->getShape().get()));
+        hashMatrix(seed, shapeNode->getRelativeTransform().matrix());
+        const dynamics::CollisionAspect* collision
+            = shapeNode->getCollisionAspect();
+        hashCombine(seed, collision == nullptr ? 0 : 1);
+        if (collision != nullptr)
+        {
+          hashCombine(seed, collision->getCollidable());
+        }
+      }
+    }
+  }
+  return seed;
+}
+
+} // namespace
+
+//==============================================================================
+FiniteDifferenceEngine::FiniteDifferenceEngine(int numThreads)
+  : mClonedStructure(0)
+{
+  if (numThreads <= 0)
+  {
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  mNumThreads = numThreads;
+  if (mNumThreads > 1)
+  {
+    // Before using Eigen in a multi-threaded environment, we need to
+    // explicitly call this (at least prior to Eigen 3.3)
+    Eigen::initParallel();
+    mPool = std::make_unique<common::ThreadPool>(mNumThreads);
+  }
+}
+
+//==============================================================================
+/// Returns the number of workers columns are spread across
+int FiniteDifferenceEngine::getNumThreads() const
+{
+  return mNumThreads;
+}
+
+//==============================================================================
+/// This computes an (outputDim x inputDim) Jacobian, evaluating `eval` on
+/// the workers.
+Eigen::MatrixXd FiniteDifferenceEngine::jacobian(
+    int inputDim,
+    int outputDim,
+    const EvalFn& eval,
+    FiniteDifferenceScheme scheme,
+    double eps)
+{
+  Eigen::MatrixXd J = Eigen::MatrixXd::Zero(outputDim, inputDim);
+  if (inputDim == 0)
+    return J;
+
+  // Forward differences share a single baseline across every column, so we
+  // compute that up front, before fanning out.
+  Eigen::VectorXd baseline;
+  if (scheme == FD_FORWARD)
+  {
+    eval(0, 0, 0.0, baseline);
+    assert(baseline.size() == outputDim);
+  }
+
+  parallelForColumns(inputDim, [&](int column, int worker) {
+    if (scheme == FD_FORWARD)
+    {
+      Eigen::VectorXd perturbed;
+      double step = evalShrinkingStep(eval, worker, column, eps, perturbed);
+      J.col(column) = (perturbed - baseline) / step;
+    }
+    else if (scheme == FD_CENTRAL)
+    {
+      centralColumn(eval, worker, column, eps, J.col(column));
+    }
+    else
+    {
+      riddersColumn(eval, worker, column, eps, J.col(column));
+    }
+  });
+
+  return J;
+}
+
+//==============================================================================
+/// This computes an (outputDim x inputDim) Jacobian, evaluating `eval` on
+/// per-worker clones of `world`. `world` itself is never modified.
+Eigen::MatrixXd FiniteDifferenceEngine::jacobian(
+    std::shared_ptr<simulation::World> world,
+    int inputDim,
+    int outputDim,
+    const WorldEvalFn& eval,
+    FiniteDifferenceScheme scheme,
+    double eps)
+{
+  syncWorldClones(world);
+  return jacobian(
+      inputDim,
+      outputDim,
+      [&](int worker, int column, double step, Eigen::VectorXd& out) {
+        return eval(mWorldClones[worker], column, step, out);
+      },
+      scheme,
+      eps);
+}
+
+//==============================================================================
+/// This drops all the cached World clones, so the next World Jacobian
+/// re-clones from scratch.
+void FiniteDifferenceEngine::clearWorldClones()
+{
+  mWorldClones.clear();
+  mClonedFrom.reset();
+  mClonedStructure = 0;
+}
+
+//==============================================================================
+/// This makes sure we have one clone of `world` per worker, and copies
+/// `world`'s current state and settings into each of them.
+void FiniteDifferenceEngine::syncWorldClones(
+    std::shared_ptr<simulation::World> world)
+{
+  // Structural edits (adding skeletons, moving joints, swapping shapes, etc)
+  // can't be patched onto the existing clones the way state can, so those
+  // mean we have to clone again from scratch
+  std::size_t structure = getStructuralSignature(world.get());
+  bool needsClone = mClonedFrom.lock() != world
+                    || (int)mWorldClones.size() != mNumThreads
+                    || structure != mClonedStructure;
+  if (needsClone)
+  {
+    mWorldClones.clear();
+    for (int i = 0; i < mNumThreads; i++)
+    {
+      std::shared_ptr<simulation::World> clone = world->clone();
+      // The clones are already running one per worker, so they shouldn't
+      // spin up pools of their own
+      clone->setFiniteDifferenceThreads(1);
+      mWorldClones.push_back(clone);
+    }
+    mClonedFrom = world;
+    mClonedStructure = structure;
+  }
+
+  Eigen::VectorXd positions = world->getPositions();
+  Eigen::VectorXd velocities = world->getVelocities();
+  Eigen::VectorXd forces = world->getExternalForces();
+  Eigen::VectorXd lcpCache = world->getCachedLCPSolution();
+  Eigen::VectorXd positionUpperLimits = world->getPositionUpperLimits();
+  Eigen::VectorXd positionLowerLimits = world->getPositionLowerLimits();
+  Eigen::VectorXd velocityUpperLimits = world->getVelocityUpperLimits();
+  Eigen::VectorXd velocityLowerLimits = world->getVelocityLowerLimits();
+  Eigen::VectorXd forceUpperLimits = world->getExternalForceUpperLimits();
+  Eigen::VectorXd forceLowerLimits = world->getExternalForceLowerLimits();
+  bool gradientEnabled = world->getConstraintSolver()->getGradientEnabled();
+
+  for (std::shared_ptr<simulation::World>& clone : mWorldClones)
+  {
+    clone->setGravity(world->getGravity());
+    clone->setTimeStep(world->getTimeStep());
+    clone->setTime(world->getTime());
+    clone->setConstraintForceMixingEnabled(
+        world->getConstraintForceMixingEnabled());
+    clone->setContactClippingDepth(world->getContactClippingDepth());
+    clone->setPenetrationCorrectionEnabled(
+        world->getPenetrationCorrectionEnabled());
+    clone->setParallelVelocityAndPositionUpdates(
+        world->getParallelVelocityAndPositionUpdates());
+    clone->getConstraintSolver()->setGradientEnabled(gradientEnabled);
+
+    // Physical parameters are what gets tuned most often between calls
+    // (during system ID, for instance), so we keep those in sync too. Only
+    // touching the ones that changed keeps us from dirtying every cached M
+    // matrix.
+    for (std::size_t i = 0; i < world->getNumSkeletons(); i++)
+    {
+      dynamics::Skeleton* skel = world->getSkeleton(i).get();
+      dynamics::Skeleton* cloneSkel = clone->getSkeleton(i).get();
+      for (std::size_t j = 0; j < skel->getNumBodyNodes(); j++)
+      {
+        dynamics::BodyNode* node = skel->getBodyNode(j);
+        dynamics::BodyNode* cloneNode = cloneSkel->getBodyNode(j);
+        const dynamics::Inertia& inertia = node->getInertia();
+        if (!(cloneNode->getInertia() == inertia))
+        {
+          cloneNode->setInertia(inertia);
+        }
+        if (cloneNode->getFrictionCoeff() != node->getFrictionCoeff())
+        {
+          cloneNode->setFrictionCoeff(node->getFrictionCoeff());
+        }
+        if (cloneNode->getRestitutionCoeff() != node->getRestitutionCoeff())
+        {
+          cloneNode->setRestitutionCoeff(node->getRestitutionCoeff());
+        }
+      }
+      for (std::size_t j = 0; j < skel->getNumDofs(); j++)
+      {
+        dynamics::DegreeOfFreedom* dof = skel->getDof(j);
+        dynamics::DegreeOfFreedom* cloneDof = cloneSkel->getDof(j);
+        if (cloneDof->getDampingCoefficient() != dof->getDampingCoefficient())
+        {
+          cloneDof->setDampingCoefficient(dof->getDampingCoefficient());
+        }
+        if (cloneDof->getSpringStiffness() != dof->getSpringStiffness())
+        {
+          cloneDof->setSpringStiffness(dof->getSpringStiffness());
+        }
+        if (cloneDof->getRestPosition() != dof->getRestPosition())
+        {
+          cloneDof->setRestPosition(dof->getRestPosition());
+        }
+        if (cloneDof->getCoulombFriction() != dof->getCoulombFriction())
+        {
+          cloneDof->setCoulombFriction(dof->getCoulombFriction());
+        }
+      }
+    }
+
+    clone->setPositionUpperLimits(positionUpperLimits);
+    clone->setPositionLowerLimits(positionLowerLimits);
+    clone->setVelocityUpperLimits(velocityUpperLimits);
+    clone->setVelocityLowerLimits(velocityLowerLimits);
+    clone->setExternalForceUpperLimits(forceUpperLimits);
+    clone->setExternalForceLowerLimits(forceLowerLimits);
+
+    clone->setPositions(positions);
+    clone->setVelocities(velocities);
+    clone->setExternalForces(forces);
+    clone->setCachedLCPSolution(lcpCache);
+  }
+}
+
+//==============================================================================
+/// This runs `fn(column, worker)` for every column in [0, n)
+void FiniteDifferenceEngine::parallelForColumns(
+    int n, const std::function<void(int column, int worker)>& fn)
+{
+  if (!mPool)
+  {
+    for (int i = 0; i < n; i++)
+    {
+      fn(i, 0);
+    }
+    return;
+  }
+  mPool->parallelFor(n, fn);
+}
+
+//==============================================================================
+/// This evaluates `eval` at +eps or -eps (by sign), halving the step until
+/// `eval` accepts it. Returns the accepted step size.
+double FiniteDifferenceEngine::evalShrinkingStep(
+    const EvalFn& eval,
+    int worker,
+    int column,
+    double eps,
+    Eigen::VectorXd& out)
+{
+  while (!eval(worker, column, eps, out))
+  {
+    eps *= 0.5;
+    if (std::abs(eps) <= 1e-20)
+    {
+      assert(
+          false
+          && "FiniteDifferenceEngine couldn't find a step size small enough "
+             "to be accepted. This is probably a non-differentiable point.");
+      break;
+    }
+  }
+  return eps;
+}
+
+//==============================================================================
+/// One column of a central differences Jacobian
+void FiniteDifferenceEngine::centralColumn(
+    const EvalFn& eval,
+    int worker,
+    int column,
+    double eps,
+    Eigen::Ref<Eigen::VectorXd> out)
+{
+  Eigen::VectorXd plus;
+  Eigen::VectorXd minus;
+  // The two sides may have to shrink by different amounts, so this isn't
+  // necessarily a symmetric difference
+  double epsPos = evalShrinkingStep(eval, worker, column, eps, plus);
+  double epsNeg = evalShrinkingStep(eval, worker, column, -eps, minus);
+  out = (plus - minus) / (epsPos - epsNeg);
+}
+
+//==============================================================================
+/// One column of a Ridders extrapolated Jacobian
+void FiniteDifferenceEngine::riddersColumn(
+    const EvalFn& eval,
+    int worker,
+    int column,
+    double eps,
+    Eigen::Ref<Eigen::VectorXd> out)
+{
+  const double con = 1.4, con2 = (con * con);
+  const double safeThreshold = 2.0;
+  const int tabSize = 10;
+
+  // Neville tableau of finite difference results
+  std::array<std::array<Eigen::VectorXd, tabSize>, tabSize> tab;
+
+  Eigen::VectorXd plus;
+  Eigen::VectorXd minus;
+
+  // Find largest original step size that both sides accept
+  double stepSize = eps;
+  while (!(eval(worker, column, stepSize, plus)
+           && eval(worker, column, -stepSize, minus)))
+  {
+    stepSize *= 0.5;
+    if (stepSize <= 1e-20)
+    {
+      assert(
+          false
+          && "FiniteDifferenceEngine couldn't find a step size small enough "
+             "to be accepted. This is probably a non-differentiable point.");
+      break;
+    }
+  }
+
+  tab[0][0] = (plus - minus) / (2 * stepSize);
+  out = tab[0][0];
+  double bestError = std::numeric_limits<double>::max();
+
+  // Iterate over smaller and smaller step sizes
+  for (int iTab = 1; iTab < tabSize; iTab++)
+  {
+    stepSize /= con;
+
+    // A smaller step should never be rejected if a bigger one was accepted,
+    // but if it is we just keep our best estimate so far
+    if (!eval(worker, column, stepSize, plus)
+        || !eval(worker, column, -stepSize, minus))
+    {
+      break;
+    }
+
+    tab[0][iTab] = (plus - minus) / (2 * stepSize);
+
+    double fac = con2;
+    // Compute extrapolations of increasing orders, requiring no new evaluations
+    for (int jTab = 1; jTab <= iTab; jTab++)
+    {
+      tab[jTab][iTab]
+          = (tab[jTab - 1][iTab] * fac - tab[jTab - 1][iTab - 1]) / (fac - 1.0);
+      fac = con2 * fac;
+      double currError = std::max(
+          (tab[jTab][iTab] - tab[jTab - 1][iTab]).array().abs().maxCoeff(),
+          (tab[jTab][iTab] - tab[jTab - 1][iTab - 1]).array().abs().maxCoeff());
+      if (currError < bestError)
+      {
+        bestError = currError;
+        out = tab[jTab][iTab];
+      }
+    }
+
+    // If higher order is worse by a significant factor, quit early.
+    if ((tab[iTab][iTab] - tab[iTab - 1][iTab - 1]).array().abs().maxCoeff()
+        >= safeThreshold * bestError)
+    {
+      break;
+    }
+  }
+}
+
+} // namespace neural
+} // namespace dart
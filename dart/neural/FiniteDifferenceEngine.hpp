@@ -0,0 +1,154 @@
+#ifndef DART_NEURAL_FINITE_DIFFERENCE_ENGINE_HPP_
+#define DART_NEURAL_FINITE_DIFFERENCE_ENGINE_HPP_
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/common/ThreadPool.hpp"
+
+namespace dart {
+namespace simulation {
+class World;
+}
+
+namespace neural {
+
+enum FiniteDifferenceScheme
+{
+  /// (f(x + eps) - f(x)) / eps. One evaluation per column, plus one shared
+  /// baseline evaluation, but only first order accurate.
+  FD_FORWARD,
+  /// (f(x + eps) - f(x - eps)) / 2*eps. Two evaluations per column.
+  FD_CENTRAL,
+  /// Ridders' method: central differences at shrinking step sizes,
+  /// extrapolated to a step size of zero with a Neville tableau. Much more
+  /// accurate than FD_CENTRAL, but takes up to 20 evaluations per column.
+  FD_RIDDERS
+};
+
+/// This computes finite difference Jacobians one column per task, spread
+/// across a persistent thread pool.
+///
+/// The expensive thing to finite difference in this codebase is a World, so
+/// the engine also keeps one clone of a World per worker thread. Those clones
+/// are reused between calls. Before each call they get re-synced with the
+/// caller's World (state, limits, inertia, friction, restitution, damping,
+/// springs, and world-level settings), which is much cheaper than cloning
+/// again. We also check a signature of the World's structure (skeletons, joint
+/// types, offsets and axes, collision shapes), and clone again from scratch
+/// whenever that changes.
+///
+/// Evaluation functions return false to signal that a perturbation was too
+/// big (for example, it changed which contacts are clamping), and the engine
+/// will halve the step size and try again.
+class FiniteDifferenceEngine
+{
+public:
+  /// This evaluates the function we're differentiating with input `column`
+  /// perturbed by `eps` (which may be negative, or zero for the unperturbed
+  /// baseline), and writes the result to `out`. `worker` is the index of the
+  /// calling worker, in [0, getNumThreads()), so callers can keep per-worker
+  /// scratch state without locking.
+  typedef std::function<bool(
+      int worker, int column, double eps, Eigen::VectorXd& out)>
+      EvalFn;
+
+  /// This is the same as EvalFn, except that instead of a worker index it gets
+  /// the calling worker's private clone of the World.
+  typedef std::function<bool(
+      const std::shared_ptr<simulation::World>& world,
+      int column,
+      double eps,
+      Eigen::VectorXd& out)>
+      WorldEvalFn;
+
+  /// This creates an engine with `numThreads` workers. If `numThreads` is <= 0,
+  /// we use one thread per hardware core. With exactly one thread, columns
+  /// are evaluated inline on the calling thread.
+  explicit FiniteDifferenceEngine(int numThreads = 0);
+
+  /// Returns the number of workers columns are spread across
+  int getNumThreads() const;
+
+  /// This computes an (outputDim x inputDim) Jacobian, evaluating `eval` on
+  /// the workers. `eps` is the step size for FD_FORWARD and FD_CENTRAL, and
+  /// the starting (largest) step size for FD_RIDDERS.
+  Eigen::MatrixXd jacobian(
+      int inputDim,
+      int outputDim,
+      const EvalFn& eval,
+      FiniteDifferenceScheme scheme,
+      double eps);
+
+  /// This computes an (outputDim x inputDim) Jacobian, evaluating `eval` on
+  /// per-worker clones of `world`. `world` itself is never modified.
+  Eigen::MatrixXd jacobian(
+      std::shared_ptr<simulation::World> world,
+      int inputDim,
+      int outputDim,
+      const WorldEvalFn& eval,
+      FiniteDifferenceScheme scheme,
+      double eps);
+
+  /// This drops all the cached World clones, so the next World Jacobian
+  /// re-clones from scratch.
+  void clearWorldClones();
+
+protected:
+  /// This makes sure we have one clone of `world` per worker, and copies
+  /// `world`'s current state and settings into each of them.
+  void syncWorldClones(std::shared_ptr<simulation::World> world);
+
+  /// This runs `fn(column, worker)` for every column in [0, n)
+  void parallelForColumns(
+      int n, const std::function<void(int column, int worker)>& fn);
+
+  /// This evaluates `eval` at +eps or -eps (by sign), halving the step until
+  /// `eval` accepts it. Returns the accepted step size.
+  double evalShrinkingStep(
+      const EvalFn& eval,
+      int worker,
+      int column,
+      double eps,
+      Eigen::VectorXd& out);
+
+  /// One column of a central differences Jacobian
+  void centralColumn(
+      const EvalFn& eval,
+      int worker,
+      int column,
+      double eps,
+      Eigen::Ref<Eigen::VectorXd> out);
+
+  /// One column of a Ridders extrapolated Jacobian
+  void riddersColumn(
+      const EvalFn& eval,
+      int worker,
+      int column,
+      double eps,
+      Eigen::Ref<Eigen::VectorXd> out);
+
+  int mNumThreads;
+
+  /// This is null when we only have a single thread, in which case we run
+  /// everything inline on the caller's thread
+  std::unique_ptr<common::ThreadPool> mPool;
+
+  /// One clone of the last World we were asked to differentiate, per worker
+  std::vector<std::shared_ptr<simulation::World>> mWorldClones;
+
+  /// The World that mWorldClones were cloned from. This is weak, so that a new
+  /// World that happens to be allocated at the same address never matches.
+  std::weak_ptr<simulation::World> mClonedFrom;
+
+  /// The structural signature of mClonedFrom when we cloned it
+  std::size_t mClonedStructure;
+};
+
+} // namespace neural
+} // namespace dart
+
+#endif
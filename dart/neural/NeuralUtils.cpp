@@ -6,11 +6,13 @@
 #include "dart/constraint/ConstraintSolver.hpp"
 #include "dart/math/Geometry.hpp"
 #include "dart/neural/BackpropSnapshot.hpp"
+#include "dart/neural/BackpropSnapshotBatch.hpp"
 #include "dart/neural/ConstrainedGroupGradientMatrices.hpp"
 #include "dart/neural/MappedBackpropSnapshot.hpp"
 #include "dart/neural/Mapping.hpp"
 #include "dart/neural/RestorableSnapshot.hpp"
 #include "dart/simulation/World.hpp"
+#include "dart/simulation/WorldBatch.hpp"
 
 namespace dart {
 namespace neural {
@@ -65,6 +67,77 @@ std::shared_ptr<BackpropSnapshot> forwardPass(
   return snapshot;
 }
 
+//==============================================================================
+/// Takes a step from every start state in `states`, and returns a batch of
+/// snapshots which can be used to backpropagate gradients for all of them at
+/// once.
+std::shared_ptr<BackpropSnapshotBatch> forwardPassBatch(
+    std::shared_ptr<simulation::World> world,
+    const Eigen::MatrixXd& states,
+    const Eigen::MatrixXd& torques,
+    int numThreads)
+{
+  int dofs = world->getNumDofs();
+  assert(states.rows() == 2 * dofs);
+  assert(torques.rows() == dofs);
+  assert(states.cols() == torques.cols());
+
+  std::shared_ptr<simulation::WorldBatch> batch
+      = std::make_shared<simulation::WorldBatch>(
+          world, states.cols(), numThreads);
+  batch->positions() = states.topRows(dofs);
+  batch->velocities() = states.bottomRows(dofs);
+  batch->externalForces() = torques;
+
+  return forwardPassBatch(batch);
+}
+
+//==============================================================================
+/// Takes a step on every entry in `batch`, advancing the batch's state, and
+/// returns a batch of snapshots which can be used to backpropagate gradients
+/// for all of them at once.
+std::shared_ptr<BackpropSnapshotBatch> forwardPassBatch(
+    std::shared_ptr<simulation::WorldBatch> batch)
+{
+  std::vector<std::shared_ptr<BackpropSnapshot>> snapshots(
+      batch->getBatchSize());
+
+  // The batch holds the authoritative copy of every entry's state, and each
+  // worker World gets overwritten with the next entry's state anyways, so
+  // there's no need for the RestorableSnapshot dance that an idempotent
+  // forwardPass() does.
+  batch->parallelForEachEntry(
+      [&](int index, const std::shared_ptr<simulation::World>& world) {
+        snapshots[index] = forwardPass(world, false);
+      });
+  batch->setTime(batch->getTime() + batch->getTimeStep());
+
+  return std::make_shared<BackpropSnapshotBatch>(batch, snapshots);
+}
+
+//==============================================================================
+/// This loads `positions`, `velocities` and `torques` into `batch`, and then
+/// takes a step on every entry.
+std::shared_ptr<BackpropSnapshotBatch> forwardPassBatch(
+    std::shared_ptr<simulation::WorldBatch> batch,
+    const Eigen::MatrixXd& positions,
+    const Eigen::MatrixXd& velocities,
+    const Eigen::MatrixXd& torques)
+{
+  assert(positions.rows() == batch->getNumDofs());
+  assert(positions.cols() == batch->getBatchSize());
+  assert(velocities.rows() == positions.rows());
+  assert(velocities.cols() == positions.cols());
+  assert(torques.rows() == positions.rows());
+  assert(torques.cols() == positions.cols());
+
+  batch->positions() = positions;
+  batch->velocities() = velocities;
+  batch->externalForces() = torques;
+
+  return forwardPassBatch(batch);
+}
+
 //==============================================================================
 /// Takes a step in the world, and returns a mapped snapshot which can be used
 /// to backpropagate gradients and compute Jacobians in the mapped space
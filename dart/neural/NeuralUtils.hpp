@@ -17,6 +17,7 @@ class ConstrainedGroup;
 }
 namespace simulation {
 class World;
+class WorldBatch;
 }
 
 namespace neural {
@@ -29,12 +30,31 @@ struct LossGradient
   Eigen::VectorXd lossWrtMass;
 };
 
+/// This is a LossGradient for a whole batch of timesteps, with each entry in
+/// the batch stacked as a column of each matrix.
+struct LossGradientBatch
+{
+  Eigen::MatrixXd lossWrtPosition;
+  Eigen::MatrixXd lossWrtVelocity;
+  Eigen::MatrixXd lossWrtTorque;
+  Eigen::MatrixXd lossWrtMass;
+};
+
+/// This is a batch of tangents of the state after a timestep, one direction
+/// per column, as returned by BackpropSnapshot::jvp().
+struct StateTangentBatch
+{
+  Eigen::MatrixXd dPosition;
+  Eigen::MatrixXd dVelocity;
+};
+
 // We don't issue a full import here, because we want this file to be safe to
 // import from anywhere else in DART
 class ConstrainedGroupGradientMatrices;
 class BackpropSnapshot;
 class Mapping;
 class MappedBackpropSnapshot;
+class BackpropSnapshotBatch;
 
 std::shared_ptr<ConstrainedGroupGradientMatrices> createGradientMatrices(
     constraint::ConstrainedGroup& group, double timeStep);
@@ -44,6 +64,39 @@ std::shared_ptr<ConstrainedGroupGradientMatrices> createGradientMatrices(
 std::shared_ptr<BackpropSnapshot> forwardPass(
     std::shared_ptr<simulation::World> world, bool idempotent = false);
 
+/// Takes a step from every start state in `states` (a (2*dofs x batch)
+/// matrix, with positions stacked above velocities in each column) under the
+/// matching column of `torques`, and returns a batch of snapshots which can be
+/// used to backpropagate gradients for all of them at once. The steps run in
+/// parallel on a pool of `numThreads` clones of `world`, and `world` itself is
+/// left untouched.
+///
+/// This clones `world` on every call. If you're calling this in a hot loop,
+/// hold onto a WorldBatch and use the overload below instead, which reuses the
+/// same clones and threads every time.
+std::shared_ptr<BackpropSnapshotBatch> forwardPassBatch(
+    std::shared_ptr<simulation::World> world,
+    const Eigen::MatrixXd& states,
+    const Eigen::MatrixXd& torques,
+    int numThreads = 0);
+
+/// Takes a step on every entry in `batch`, advancing the batch's state, and
+/// returns a batch of snapshots which can be used to backpropagate gradients
+/// for all of them at once.
+std::shared_ptr<BackpropSnapshotBatch> forwardPassBatch(
+    std::shared_ptr<simulation::WorldBatch> batch);
+
+/// This loads `positions`, `velocities` and `torques` (each a (dofs x batch)
+/// matrix, one column per entry) into `batch`, and then takes a step on every
+/// entry just like the overload above. This lets a caller that holds the whole
+/// batch of inputs (like a batched PyTorch layer) run a step with a single
+/// call, reusing the batch's cloned Worlds and threads.
+std::shared_ptr<BackpropSnapshotBatch> forwardPassBatch(
+    std::shared_ptr<simulation::WorldBatch> batch,
+    const Eigen::MatrixXd& positions,
+    const Eigen::MatrixXd& velocities,
+    const Eigen::MatrixXd& torques);
+
 /// Takes a step in the world, and returns a mapped snapshot which can be used
 /// to backpropagate gradients and compute Jacobians in the mapped space
 std::shared_ptr<MappedBackpropSnapshot> mappedForwardPass(
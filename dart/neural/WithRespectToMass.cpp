@@ -156,6 +156,32 @@ void WrtMassBodyNodyEntry::get(
   }
 }
 
+//==============================================================================
+common::aligned_vector<Eigen::Matrix6d>
+WrtMassBodyNodyEntry::getSpatialTensorGradients(dynamics::Skeleton* skel)
+{
+  const dynamics::Inertia& inertia
+      = skel->getBodyNode(linkName)->getInertia();
+
+  dynamics::Inertia::Param first = dynamics::Inertia::Param::MASS;
+  if (type == INERTIA_COM)
+    first = dynamics::Inertia::Param::COM_X;
+  else if (type == INERTIA_DIAGONAL)
+    first = dynamics::Inertia::Param::I_XX;
+  else if (type == INERTIA_OFF_DIAGONAL)
+    first = dynamics::Inertia::Param::I_XY;
+
+  // The values of every entry type are laid out in the same order as
+  // dynamics::Inertia::Param, so we can just count up from the first one
+  common::aligned_vector<Eigen::Matrix6d> gradients;
+  for (int i = 0; i < dim(); i++)
+  {
+    gradients.push_back(inertia.getSpatialTensorGradientWrtParameter(
+        static_cast<dynamics::Inertia::Param>(first + i)));
+  }
+  return gradients;
+}
+
 //==============================================================================
 /// This registers that we'd like to keep track of this node's mass in this
 /// way in this differentiation
@@ -204,13 +230,15 @@ WrtMassBodyNodyEntry& WithRespectToMass::registerNode(
 /// This returns the entry object corresponding to this node
 WrtMassBodyNodyEntry& WithRespectToMass::getNode(dynamics::BodyNode* node)
 {
-  std::string skelName = node->getSkeleton()->getName();
-  std::vector<WrtMassBodyNodyEntry>& skelEntries = mEntries[skelName];
-  for (WrtMassBodyNodyEntry& entry : skelEntries)
+  auto it = mEntries.find(node->getSkeleton()->getName());
+  if (it != mEntries.end())
   {
-    if (entry.linkName == node->getName())
+    for (WrtMassBodyNodyEntry& entry : it->second)
     {
-      return entry;
+      if (entry.linkName == node->getName())
+      {
+        return entry;
+      }
     }
   }
   assert(false);
@@ -219,6 +247,20 @@ WrtMassBodyNodyEntry& WithRespectToMass::getNode(dynamics::BodyNode* node)
   throw std::runtime_error{"Execution should never reach this point"};
 }
 
+//==============================================================================
+/// This returns all the entries we're tracking for this skeleton
+std::vector<WrtMassBodyNodyEntry>& WithRespectToMass::getNodes(
+    dynamics::Skeleton* skel)
+{
+  // Like dim(), this has to use find() so that it never inserts, since it's
+  // called concurrently from the FiniteDifferenceEngine's worker threads.
+  static std::vector<WrtMassBodyNodyEntry> empty;
+  auto it = mEntries.find(skel->getName());
+  if (it == mEntries.end())
+    return empty;
+  return it->second;
+}
+
 //==============================================================================
 /// This returns this WRT from the world as a vector
 Eigen::VectorXd WithRespectToMass::get(simulation::World* world)
@@ -241,9 +283,10 @@ Eigen::VectorXd WithRespectToMass::get(simulation::World* world)
 /// This returns this WRT from this skeleton as a vector
 Eigen::VectorXd WithRespectToMass::get(dynamics::Skeleton* skel)
 {
-  std::vector<WrtMassBodyNodyEntry>& skelEntries = mEntries[skel->getName()];
-  if (skelEntries.size() == 0)
+  auto it = mEntries.find(skel->getName());
+  if (it == mEntries.end() || it->second.size() == 0)
     return Eigen::VectorXd::Zero(0);
+  std::vector<WrtMassBodyNodyEntry>& skelEntries = it->second;
   int cursor = 0;
   int skelDim = dim(skel);
   Eigen::VectorXd result = Eigen::VectorXd::Zero(skelDim);
@@ -275,9 +318,10 @@ void WithRespectToMass::set(simulation::World* world, Eigen::VectorXd value)
 /// This sets the skeleton's state based on our WRT
 void WithRespectToMass::set(dynamics::Skeleton* skel, Eigen::VectorXd value)
 {
-  std::vector<WrtMassBodyNodyEntry>& skelEntries = mEntries[skel->getName()];
-  if (skelEntries.size() == 0)
+  auto it = mEntries.find(skel->getName());
+  if (it == mEntries.end() || it->second.size() == 0)
     return;
+  std::vector<WrtMassBodyNodyEntry>& skelEntries = it->second;
   int cursor = 0;
   for (WrtMassBodyNodyEntry& entry : skelEntries)
   {
@@ -303,9 +347,14 @@ int WithRespectToMass::dim(simulation::World* world)
 /// This gives the dimensions of the WRT
 int WithRespectToMass::dim(dynamics::Skeleton* skel)
 {
-  std::vector<WrtMassBodyNodyEntry>& skelEntries = mEntries[skel->getName()];
+  // We use find() rather than operator[] here (and in get() and set()), so
+  // that lookups never insert. That keeps these safe to call from several
+  // threads at once, which the FiniteDifferenceEngine relies on.
+  auto it = mEntries.find(skel->getName());
+  if (it == mEntries.end())
+    return 0;
   int skelDim = 0;
-  for (WrtMassBodyNodyEntry& entry : skelEntries)
+  for (WrtMassBodyNodyEntry& entry : it->second)
   {
     skelDim += entry.dim();
   }
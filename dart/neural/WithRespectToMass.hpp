@@ -8,6 +8,8 @@
 
 #include <Eigen/Dense>
 
+#include "dart/common/Memory.hpp"
+#include "dart/math/MathTypes.hpp"
 #include "dart/neural/WithRespectTo.hpp"
 
 namespace dart {
@@ -43,6 +45,13 @@ struct WrtMassBodyNodyEntry
   void get(dynamics::Skeleton* skel, Eigen::Ref<Eigen::VectorXd> out);
 
   void set(dynamics::Skeleton* skel, const Eigen::Ref<Eigen::VectorXd>& val);
+
+  /// This returns the derivative of the node's spatial inertia tensor with
+  /// respect to each value in this entry, in the same order as get() and
+  /// set(). The spatial inertia is all the dynamics ever see of the mass
+  /// properties, so this is enough to differentiate M and C analytically.
+  common::aligned_vector<Eigen::Matrix6d> getSpatialTensorGradients(
+      dynamics::Skeleton* skel);
 };
 
 class WithRespectToMass : public WithRespectTo
@@ -62,6 +71,10 @@ public:
   /// assertion if this node doesn't exist
   WrtMassBodyNodyEntry& getNode(dynamics::BodyNode* node);
 
+  /// This returns all the entries we're tracking for this skeleton, in the
+  /// order they appear in get() and set()
+  std::vector<WrtMassBodyNodyEntry>& getNodes(dynamics::Skeleton* skel);
+
   //////////////////////////////////////////////////////////////
   // Implement all the methods we need
   //////////////////////////////////////////////////////////////
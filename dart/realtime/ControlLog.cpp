@@ -1,117 +1,183 @@
 #include "dart/realtime/ControlLog.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 namespace dart {
 namespace realtime {
 
-ControlLog::ControlLog(int dim, int millisPerStep)
-  : mDim(dim), mMillisPerStep(millisPerStep), mLogEnd(0L)
+ControlLog::ControlLog(int dim, long nanosPerStep, int capacity)
+  : mDim(dim),
+    mNanosPerStep(nanosPerStep),
+    mCapacity(capacity),
+    mLogStart(0L),
+    mLogEnd(0L),
+    mHead(0L),
+    mTail(0L),
+    mLog(Eigen::MatrixXd::Zero(dim, capacity))
 {
 }
 
-void ControlLog::record(long time, Eigen::VectorXd control)
+void ControlLog::record(
+    long time, const Eigen::Ref<const Eigen::VectorXd>& control)
 {
+  if (mHead == mTail)
+  {
+    mLock.beginWrite();
+    if (time > mLogEnd)
+      mLogEnd = time;
+    mLogStart = time;
+    mLog.col(0) = control;
+    mTail = 0L;
+    mHead = 1L;
+    mLock.endWrite();
+    return;
+  }
+
+  long newest = mHead - 1;
+  long logEnd = mLogStart + newest * mNanosPerStep;
+  long steps = (long)floor((double)(time - logEnd) / mNanosPerStep);
+  // This means we're recording backwards in time, which shouldn't be allowed.
+  if (steps < 0)
+  {
+    assert(
+        false && "ControlLog::record() expects time to monotonically increase");
+    return;
+  }
+
+  mLock.beginWrite();
   if (time > mLogEnd)
     mLogEnd = time;
-  if (mLog.size() == 0)
+  // This means we're overwriting the last element of the log, cause we haven't
+  // had time to run a full timestep since our last recorded value
+  if (steps == 0)
   {
-    mLogStart = time;
-    mLog.push_back(control);
+    mLog.col(newest % mCapacity) = control;
   }
+  // Otherwise, we need to extend the last recorded force until just before
+  // this timestep, on the assumption that the motors have been executing that
+  // command until they were updated. We only bother to fill in the steps that
+  // will still be in the ring afterwards.
   else
   {
-    long logEnd = mLogStart + ((mLog.size() - 1) * mMillisPerStep);
-    int steps = (int)floor((double)(time - logEnd) / mMillisPerStep);
-    // This means we're recording backwards in time, which shouldn't be allowed.
-    if (steps < 0)
-    {
-      assert(
-          false
-          && "ControlLog::record() expects time to monotonically increase");
-      return;
-    }
-    // This means we're overwriting the last element of the log, cause we
-    // haven't had time to run a full timestep since our last recorded value
-    if (steps == 0)
-    {
-      mLog[mLog.size() - 1] = control;
-      return;
-    }
-    // Otherwise, we need to extend the last recorded force until just before
-    // this timestep, on the assumption that the motors have been executing that
-    // command until they were updated.
-    Eigen::VectorXd last = mLog[mLog.size() - 1];
-    for (int i = 0; i < steps - 1; i++)
+    long target = newest + steps;
+    long fillFrom = std::max(newest + 1, target - mCapacity + 1);
+    for (long i = fillFrom; i < target; i++)
     {
-      mLog.push_back(last);
+      mLog.col(i % mCapacity) = mLog.col(newest % mCapacity);
     }
-    mLog.push_back(control);
+    mLog.col(target % mCapacity) = control;
+    mHead = target + 1;
+    if (mHead - mTail > mCapacity)
+      mTail = mHead - mCapacity;
   }
+  mLock.endWrite();
 }
 
 long ControlLog::last()
 {
-  return mLogEnd;
+  long seq;
+  long logEnd;
+  do
+  {
+    seq = mLock.beginRead();
+    logEnd = mLogEnd;
+  } while (!mLock.endRead(seq));
+  return logEnd;
 }
 
 Eigen::VectorXd ControlLog::get(long time)
 {
-  // If we haven't recorded anything yet, default to 0
-  if (mLog.size() == 0)
+  Eigen::VectorXd control(mDim);
+  get(time, control);
+  return control;
+}
+
+/// This is the same as get(), but it writes into `controlOut`, so it doesn't
+/// need to allocate
+void ControlLog::get(long time, Eigen::Ref<Eigen::VectorXd> controlOut)
+{
+  long seq;
+  do
   {
-    return Eigen::VectorXd::Zero(mDim);
-  }
+    seq = mLock.beginRead();
+    long head = mHead;
+    long tail = mTail;
+
+    // If we haven't recorded anything yet, default to 0
+    if (head <= tail)
+    {
+      controlOut.setZero();
+      continue;
+    }
 
-  int steps = (int)floor((double)(time - mLogStart) / mMillisPerStep);
-  // If we're out of bounds in the past, extend our initial force
-  if (steps <= 0)
-    return mLog[0];
-  // If we're out of bounds in the future, extend our last force
-  if (steps >= mLog.size())
-    return mLog[mLog.size() - 1];
-  // Otherwise return the recorded force
-  return mLog[steps];
+    long step = (long)floor((double)(time - mLogStart) / mNanosPerStep);
+    // If we're out of bounds in the past, extend our initial force
+    if (step < tail)
+      step = tail;
+    // If we're out of bounds in the future, extend our last force
+    if (step >= head)
+      step = head - 1;
+    // Otherwise return the recorded force
+    controlOut = mLog.col(step % mCapacity);
+  } while (!mLock.endRead(seq));
 }
 
 void ControlLog::discardBefore(long time)
 {
-  if (time <= mLogStart || mLog.size() == 0)
+  if (mHead == mTail)
+    return;
+  long tailStart = mLogStart + mTail * mNanosPerStep;
+  if (time <= tailStart)
     return;
-  int discardSteps = (int)ceil((double)(time - mLogStart) / mMillisPerStep);
+  long discardSteps = (long)ceil((double)(time - tailStart) / mNanosPerStep);
+
+  mLock.beginWrite();
   // This means we're throwing out the whole log, just extrapolate the last
   // known force
-  if (discardSteps >= mLog.size())
+  if (discardSteps >= mHead - mTail)
   {
-    Eigen::VectorXd last = mLog[mLog.size() - 1];
-    mLog.clear();
-    mLog.push_back(last);
+    mLog.col(0) = mLog.col((mHead - 1) % mCapacity);
     mLogStart = time;
-    return;
+    mTail = 0L;
+    mHead = 1L;
   }
-  // Otherwise we're just snipping part of the log, so copy just the bit we care
-  // about, and throw away the rest
-  std::vector<Eigen::VectorXd> trimmedLog;
-  for (int i = discardSteps; i < mLog.size(); i++)
+  // Otherwise we're just snipping part of the log
+  else
   {
-    trimmedLog.push_back(mLog[i]);
+    mTail += discardSteps;
   }
-  mLog = trimmedLog;
-  mLogStart += discardSteps * mMillisPerStep;
+  mLock.endWrite();
 }
 
-void ControlLog::setMillisPerStep(int newMillisPerStep)
+/// This resamples the log onto a new timestep. Unlike the rest of the writer's
+/// methods, this allocates.
+void ControlLog::setNanosPerStep(long newNanosPerStep)
 {
-  int duration = mLog.size() * mMillisPerStep;
-  int newSteps = (int)ceil((double)duration / newMillisPerStep);
+  long size = mHead - mTail;
+  long tailStart = mLogStart + mTail * mNanosPerStep;
+  long duration = size * mNanosPerStep;
+  long newSteps = (long)ceil((double)duration / newNanosPerStep);
+  // If the resampled log doesn't fit, keep the most recent part of it
+  long first = std::max(0L, newSteps - mCapacity);
 
-  std::vector<Eigen::VectorXd> newLog;
-  for (int i = 0; i < newSteps; i++)
+  Eigen::MatrixXd resampled(mDim, newSteps - first);
+  for (long i = first; i < newSteps; i++)
   {
-    newLog.push_back(get(mLogStart + i * newMillisPerStep));
+    resampled.col(i - first) = get(tailStart + i * newNanosPerStep);
   }
 
-  mMillisPerStep = newMillisPerStep;
-  mLog = newLog;
+  mLock.beginWrite();
+  mNanosPerStep = newNanosPerStep;
+  mLogStart = tailStart;
+  mTail = first;
+  mHead = newSteps;
+  for (long i = first; i < newSteps; i++)
+  {
+    mLog.col(i % mCapacity) = resampled.col(i - first);
+  }
+  mLock.endWrite();
 }
 
 } // namespace realtime
-} // namespace dart
\ No newline at end of file
+} // namespace dart
@@ -5,33 +5,61 @@
 
 #include <Eigen/Dense>
 
+#include "dart/realtime/SeqLock.hpp"
+
 namespace dart {
 namespace realtime {
 
+/// This is a log of the controls we've sent, on a fixed timestep.
+///
+/// It keeps the most recent `capacity` steps in a ring buffer, allocated up
+/// front, so recording never allocates. Since the steps are evenly spaced,
+/// looking up a time is just arithmetic.
+///
+/// One thread may call record(), discardBefore() and setNanosPerStep(), while
+/// any number of other threads call get() and last(). Readers never block the
+/// writer.
 class ControlLog
 {
 public:
-  ControlLog(int dim, int millisPerStep);
+  ControlLog(int dim, long nanosPerStep, int capacity = 10000);
 
-  void record(long time, Eigen::VectorXd control);
+  void record(long time, const Eigen::Ref<const Eigen::VectorXd>& control);
 
   long last();
 
   Eigen::VectorXd get(long time);
 
+  /// This is the same as get(), but it writes into `controlOut`, so it doesn't
+  /// need to allocate
+  void get(long time, Eigen::Ref<Eigen::VectorXd> controlOut);
+
   void discardBefore(long time);
 
-  void setMillisPerStep(int millisPerStep);
+  /// This resamples the log onto a new timestep. Unlike the rest of the
+  /// writer's methods, this allocates.
+  void setNanosPerStep(long nanosPerStep);
 
 protected:
   int mDim;
-  int mMillisPerStep;
+  long mNanosPerStep;
+  int mCapacity;
+
+  /// This is the time at the start of step 0. Step i starts at
+  /// (mLogStart + i * mNanosPerStep).
   long mLogStart;
   long mLogEnd;
-  std::vector<Eigen::VectorXd> mLog;
+
+  /// The log holds steps [mTail, mHead). Step i lives in column
+  /// (i % mCapacity) of mLog.
+  long mHead;
+  long mTail;
+  Eigen::MatrixXd mLog;
+
+  SeqLock mLock;
 };
 
 } // namespace realtime
 } // namespace dart
 
-#endif
\ No newline at end of file
+#endif
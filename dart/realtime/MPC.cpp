@@ -1,22 +1,22 @@
 #include "dart/realtime/MPC.hpp"
 
-#include "dart/realtime/Millis.hpp"
+#include "dart/realtime/Nanos.hpp"
 
 namespace dart {
 namespace realtime {
 
-/// This calls getForce() with the current system clock as the time parameter
+/// This calls getForce() with monotonicNanos() as the time parameter
 Eigen::VectorXd MPC::getForceNow()
 {
-  return getForce(timeSinceEpochMillis());
+  return getForce(monotonicNanos());
 }
 
-/// This calls recordGroundTruthState() with the current system clock as the
-/// time parameter
+/// This calls recordGroundTruthState() with monotonicNanos() as the time
+/// parameter
 void MPC::recordGroundTruthStateNow(
     Eigen::VectorXd pos, Eigen::VectorXd vel, Eigen::VectorXd mass)
 {
-  recordGroundTruthState(timeSinceEpochMillis(), pos, vel, mass);
+  recordGroundTruthState(monotonicNanos(), pos, vel, mass);
 }
 
 } // namespace realtime
@@ -10,6 +10,8 @@
 namespace dart {
 namespace realtime {
 
+/// All the times MPC deals with are in nanoseconds, and any `now` should come
+/// from monotonicNanos().
 class MPC
 {
 public:
@@ -19,12 +21,12 @@ public:
   /// computed anything for this instant yet, this just returns 0s.
   virtual Eigen::VectorXd getForce(long now) = 0;
 
-  /// This calls getForce() with the current system clock as the time parameter
+  /// This calls getForce() with monotonicNanos() as the time parameter
   virtual Eigen::VectorXd getForceNow();
 
-  /// This returns how many millis we have left until we've run out of plan.
+  /// This returns how many nanos we have left until we've run out of plan.
   /// This can be a negative number, if we've run past our plan.
-  virtual long getRemainingPlanBufferMillis() = 0;
+  virtual long getRemainingPlanBufferNanos() = 0;
 
   /// This records the current state of the world based on some external sensing
   /// and inference. This resets the error in our model just assuming the world
@@ -33,8 +35,8 @@ public:
       long time, Eigen::VectorXd pos, Eigen::VectorXd vel, Eigen::VectorXd mass)
       = 0;
 
-  /// This calls recordGroundTruthState() with the current system clock as the
-  /// time parameter
+  /// This calls recordGroundTruthState() with monotonicNanos() as the time
+  /// parameter
   virtual void recordGroundTruthStateNow(
       Eigen::VectorXd pos, Eigen::VectorXd vel, Eigen::VectorXd mass);
 
@@ -44,7 +46,9 @@ public:
   /// This stops our main thread, waits for it to finish, and then returns
   virtual void stop() = 0;
 
-  /// This registers a listener to get called when we finish replanning
+  /// This registers a listener to get called when we finish replanning. The
+  /// listener gets the start time of the new plan, the plan itself, and how
+  /// many nanos it took to compute.
   virtual void registerReplanningListener(
       std::function<void(long, const trajectory::TrajectoryRollout*, long)>
           replanListener)
@@ -7,7 +7,7 @@
 
 #include "dart/performance/PerformanceLog.hpp"
 #include "dart/proto/SerializeEigen.hpp"
-#include "dart/realtime/Millis.hpp"
+#include "dart/realtime/Nanos.hpp"
 #include "dart/realtime/RealTimeControlBuffer.hpp"
 #include "dart/simulation/World.hpp"
 #include "dart/trajectory/IPOptOptimizer.hpp"
@@ -26,26 +26,29 @@ namespace realtime {
 MPCLocal::MPCLocal(
     std::shared_ptr<simulation::World> world,
     std::shared_ptr<trajectory::LossFn> loss,
-    int planningHorizonMillis)
+    long planningHorizonNanos)
   : mRunning(false),
     mWorld(world),
     mLoss(loss),
     mObservationLog(
-        timeSinceEpochMillis(),
+        monotonicNanos(),
         world->getPositions(),
         world->getVelocities(),
         world->getMasses()),
     mEnableLinesearch(true),
     mEnableOptimizationGuards(false),
     mRecordIterations(false),
-    mPlanningHorizonMillis(planningHorizonMillis),
-    mMillisPerStep(1000 * world->getTimeStep()),
-    mSteps((int)ceil((double)planningHorizonMillis / mMillisPerStep)),
+    mEnableAnytimeReplanning(false),
+    mPlanningHorizonNanos(planningHorizonNanos),
+    mNanosPerStep(secondsToNanos(world->getTimeStep())),
+    mSteps((int)ceil((double)planningHorizonNanos / mNanosPerStep)),
     mShotLength(50),
     mMaxIterations(5),
-    mMillisInAdvanceToPlan(0),
+    mNanosInAdvanceToPlan(0L),
     mLastOptimizedTime(0L),
-    mBuffer(RealTimeControlBuffer(world->getNumDofs(), mSteps, mMillisPerStep)),
+    mReplanStartTime(0L),
+    mReplanDeadline(0L),
+    mBuffer(RealTimeControlBuffer(world->getNumDofs(), mSteps, mNanosPerStep)),
     mSilent(false)
 {
 }
@@ -59,13 +62,16 @@ MPCLocal::MPCLocal(const MPCLocal& mpc)
     mEnableLinesearch(mpc.mEnableLinesearch),
     mEnableOptimizationGuards(mpc.mEnableOptimizationGuards),
     mRecordIterations(mpc.mRecordIterations),
-    mPlanningHorizonMillis(mpc.mPlanningHorizonMillis),
-    mMillisPerStep(mpc.mMillisPerStep),
+    mEnableAnytimeReplanning(mpc.mEnableAnytimeReplanning),
+    mPlanningHorizonNanos(mpc.mPlanningHorizonNanos),
+    mNanosPerStep(mpc.mNanosPerStep),
     mSteps(mpc.mSteps),
     mShotLength(mpc.mShotLength),
     mMaxIterations(mpc.mMaxIterations),
-    mMillisInAdvanceToPlan(mpc.mMillisInAdvanceToPlan),
+    mNanosInAdvanceToPlan(mpc.mNanosInAdvanceToPlan),
     mLastOptimizedTime(mpc.mLastOptimizedTime),
+    mReplanStartTime(0L),
+    mReplanDeadline(0L),
     mBuffer(mpc.mBuffer),
     mSilent(mpc.mSilent)
 {
@@ -113,11 +119,11 @@ Eigen::VectorXd MPCLocal::getForce(long now)
   return mBuffer.getPlannedForce(now);
 }
 
-/// This returns how many millis we have left until we've run out of plan.
+/// This returns how many nanos we have left until we've run out of plan.
 /// This can be a negative number, if we've run past our plan.
-long MPCLocal::getRemainingPlanBufferMillis()
+long MPCLocal::getRemainingPlanBufferNanos()
 {
-  return mBuffer.getPlanBufferMillisAfter(timeSinceEpochMillis());
+  return mBuffer.getPlanBufferNanosAfter(monotonicNanos());
 }
 
 /// This can completely silence log output
@@ -151,6 +157,16 @@ void MPCLocal::setRecordIterations(bool enabled)
   mRecordIterations = enabled;
 }
 
+/// Defaults to false. This publishes the plan into the control buffer after
+/// every iteration of the optimizer, rather than only once it finishes, and
+/// cuts each replan short once half of the plan we had left when it started has
+/// been used up. That keeps the controller fed with the best plan we have so
+/// far, even when an optimization takes longer than usual.
+void MPCLocal::setEnableAnytimeReplanning(bool enabled)
+{
+  mEnableAnytimeReplanning = enabled;
+}
+
 /// This gets the current maximum number of iterations that IPOPT will be
 /// allowed to run during an optimization.
 int MPCLocal::getMaxIterations()
@@ -176,8 +192,11 @@ void MPCLocal::recordGroundTruthState(
   mObservationLog.observe(time, pos, vel, mass);
 }
 
-/// This optimizes a block of the plan, starting at `startTime`
-void MPCLocal::optimizePlan(long startTime)
+/// This optimizes a block of the plan, starting at `startTime`. If `deadline`
+/// is positive, the optimizer stops after the first iteration that finishes
+/// past that time. It always takes at least one step, so even a deadline
+/// that's already passed gets an optimized plan.
+void MPCLocal::optimizePlan(long startTime, long deadline)
 {
   // We don't allow time to go backwards, because that leads to all sorts of
   // issues. We can get called for a time before a time we already optimized
@@ -223,6 +242,14 @@ void MPCLocal::optimizePlan(long startTime)
       createOpt->end();
     }
 
+    // The IPOPT problem that we reoptimize later is created by this first
+    // optimize() call, and it keeps the callbacks it was created with, so we
+    // only need to register this once.
+    mOptimizer->registerIntermediateCallback(
+        [this](Problem* problem, int iter, double, double) {
+          return onOptimizerIteration(problem, iter);
+        });
+
     if (!mProblem)
     {
       std::shared_ptr<MultiShot> multishot = std::make_shared<MultiShot>(
@@ -233,14 +260,18 @@ void MPCLocal::optimizePlan(long startTime)
 
     PerformanceLog* optimizeTrack = log->startRun("Optimize");
 
+    mReplanStartTime = startTime;
+    mReplanDeadline = deadline;
+    mReplanWorld = worldClone;
     mSolution = mOptimizer->optimize(mProblem.get());
+    mReplanWorld = nullptr;
     optimizeTrack->end();
 
     mLastOptimizedTime = startTime;
 
     mBuffer.setForcePlan(
         startTime,
-        timeSinceEpochMillis(),
+        monotonicNanos(),
         mProblem->getRolloutCache(worldClone)->getForcesConst());
 
     log->end();
@@ -252,21 +283,22 @@ void MPCLocal::optimizePlan(long startTime)
   {
     std::shared_ptr<simulation::World> worldClone = mWorld->clone();
 
-    int diff = startTime - mLastOptimizedTime;
-    int steps = floor((double)diff / mMillisPerStep);
-    int roundedDiff = steps * mMillisPerStep;
+    long diff = startTime - mLastOptimizedTime;
+    int steps = floor((double)diff / mNanosPerStep);
+    long roundedDiff = steps * mNanosPerStep;
     long roundedStartTime = mLastOptimizedTime + roundedDiff;
-    long totalPlanTime = mSteps * mMillisPerStep;
+    long totalPlanTime = mSteps * mNanosPerStep;
     double percentage = (double)roundedDiff * 100.0 / totalPlanTime;
 
     if (!mSilent)
     {
-      std::cout << "Advancing plan by " << roundedDiff << "ms = " << steps
-                << " steps, " << (percentage) << "% of total " << totalPlanTime
+      std::cout << "Advancing plan by " << roundedDiff / NANOS_PER_MILLI
+                << "ms = " << steps << " steps, " << (percentage)
+                << "% of total " << totalPlanTime / NANOS_PER_MILLI
                 << "ms plan time" << std::endl;
     }
 
-    long startComputeWallTime = timeSinceEpochMillis();
+    long startComputeWallTime = monotonicNanos();
 
     mBuffer.estimateWorldStateAt(
         worldClone, &mObservationLog, roundedStartTime);
@@ -277,18 +309,24 @@ void MPCLocal::optimizePlan(long startTime)
         worldClone->getVelocities(),
         steps);
 
+    mReplanStartTime = roundedStartTime;
+    mReplanDeadline = deadline;
+    mReplanWorld = worldClone;
     mSolution->reoptimize();
+    mReplanWorld = nullptr;
 
     // std::cout << "MPCLocal::optimizePlan() mBuffer.setForcePlan()" <<
     // std::endl;
 
+    // The problem starts at `roundedStartTime`, not `startTime`, because we
+    // only advanced it by a whole number of steps
     mBuffer.setForcePlan(
-        startTime,
-        timeSinceEpochMillis(),
+        roundedStartTime,
+        monotonicNanos(),
         mProblem->getRolloutCache(worldClone)->getForcesConst());
 
     long computeDurationWallTime
-        = timeSinceEpochMillis() - startComputeWallTime;
+        = monotonicNanos() - startComputeWallTime;
 
     // Call any listeners that might be waiting on us
     for (auto listener : mReplannedListeners)
@@ -303,11 +341,12 @@ void MPCLocal::optimizePlan(long startTime)
     {
       double factorOfSafety = 0.5;
       std::cout << " -> We were allowed "
-                << (int)floor(roundedDiff * factorOfSafety)
-                << "ms to solve this problem (" << roundedDiff
-                << "ms new planning * " << factorOfSafety
-                << " factor of safety), and it took us "
-                << computeDurationWallTime << "ms" << std::endl;
+                << (long)floor(roundedDiff * factorOfSafety) / NANOS_PER_MILLI
+                << "ms to solve this problem ("
+                << roundedDiff / NANOS_PER_MILLI << "ms new planning * "
+                << factorOfSafety << " factor of safety), and it took us "
+                << computeDurationWallTime / NANOS_PER_MILLI << "ms"
+                << std::endl;
     }
 
     mLastOptimizedTime = roundedStartTime;
@@ -320,34 +359,34 @@ void MPCLocal::optimizePlan(long startTime)
 /// and increasing the parallelism. We can also change the step size in the
 /// physics engine to produce less accurate results, but keep up with the
 /// world in fewer steps.
-void MPCLocal::adjustPerformance(long lastOptimizeTimeMillis)
+void MPCLocal::adjustPerformance(long lastOptimizeTimeNanos)
 {
   // This ensures that we don't "optimize our way out of sync", by letting the
   // optimizer change forces that already happened by the time the optimization
   // finishes, leading to us getting out of sync. Better to make our plans start
   // into the future.
-  mMillisInAdvanceToPlan = 1.2 * lastOptimizeTimeMillis;
+  mNanosInAdvanceToPlan = 1.2 * lastOptimizeTimeNanos;
   // Don't go more than 200ms into the future, cause then errors have a chance
   // to propagate
-  if (mMillisInAdvanceToPlan > 200)
-    mMillisInAdvanceToPlan = 200;
+  if (mNanosInAdvanceToPlan > 200 * NANOS_PER_MILLI)
+    mNanosInAdvanceToPlan = 200 * NANOS_PER_MILLI;
 
   /*
-  double millisToComputeEachStep = (double)lastOptimizeTimeMillis / mSteps;
+  double nanosToComputeEachStep = (double)lastOptimizeTimeNanos / mSteps;
   // Our safety margin is 3x, we want to be at least 3 times as fast as real
   // time
-  long desiredMillisPerStep = 3 * millisToComputeEachStep;
+  long desiredNanosPerStep = 3 * nanosToComputeEachStep;
 
   // This means our simulation step is too small, and we risk overflowing our
   // buffer before optimization finishes
-  if (desiredMillisPerStep > mMillisPerStep)
+  if (desiredNanosPerStep > mNanosPerStep)
   {
     std::cout << "Detected we're going too slow! Increasing timestep size from "
-              << mMillisPerStep << "ms -> " << desiredMillisPerStep << "ms"
+              << mNanosPerStep << "ns -> " << desiredNanosPerStep << "ns"
               << std::endl;
 
-    mBuffer.setMillisPerStep(mMillisPerStep);
-    mMillisPerStep = desiredMillisPerStep;
+    mBuffer.setNanosPerStep(mNanosPerStep);
+    mNanosPerStep = desiredNanosPerStep;
   }
   */
 }
@@ -450,8 +489,8 @@ grpc::Status RPCWrapperMPCLocal::ListenForUpdates(
           long duration) {
         reply.mutable_rollout()->Clear();
         rollout->serialize(*reply.mutable_rollout());
-        reply.set_starttime(startTime);
-        reply.set_replandurationmillis(duration);
+        reply.set_starttime(monotonicToWallNanos(startTime));
+        reply.set_replandurationnanos(duration);
         writer->Write(reply);
       });
 
@@ -469,7 +508,7 @@ grpc::Status RPCWrapperMPCLocal::RecordGroundTruthState(
 {
   // std::cout << "gRPC server: RecordGroundTruthState" << std::endl;
   mLocal.recordGroundTruthState(
-      request->time(),
+      wallToMonotonicNanos(request->time()),
       deserializeVector(request->pos()),
       deserializeVector(request->vel()),
       deserializeVector(request->mass()));
@@ -484,10 +523,26 @@ grpc::Status RPCWrapperMPCLocal::ObserveForce(
 {
   // std::cout << "gRPC server: ObserveForce" << std::endl;
   mLocal.mBuffer.manuallyRecordObservedForce(
-      request->time(), deserializeVector(request->force()));
+      wallToMonotonicNanos(request->time()),
+      deserializeVector(request->force()));
   return grpc::Status::OK;
 }
 
+/// This returns the deadline for a replan that begins at `now`, or 0 if it
+/// shouldn't have one. In anytime mode, that leaves the controller half of the
+/// plan it has left. There's never a deadline before we've published a first
+/// plan, because until then there's no buffer to measure against.
+long MPCLocal::getReplanDeadline(long now)
+{
+  if (!mEnableAnytimeReplanning || mSolution == nullptr)
+  {
+    return 0L;
+  }
+  // If the buffer has already run dry, this deadline has passed, so we'll
+  // publish whatever the first iteration comes up with.
+  return now + mBuffer.getPlanBufferNanosAfter(now) / 2;
+}
+
 /// This is the function for the optimization thread to run when we're live
 void MPCLocal::optimizationThreadLoop()
 {
@@ -501,12 +556,46 @@ void MPCLocal::optimizationThreadLoop()
 
   while (mRunning)
   {
-    long startTime = timeSinceEpochMillis();
-    optimizePlan(startTime + mMillisInAdvanceToPlan);
-    long endTime = timeSinceEpochMillis();
+    long startTime = monotonicNanos();
+    optimizePlan(
+        startTime + mNanosInAdvanceToPlan, getReplanDeadline(startTime));
+    long endTime = monotonicNanos();
     adjustPerformance(endTime - startTime);
   }
 }
 
+/// This gets called by the optimizer after every iteration. It publishes
+/// intermediate plans, if we're in anytime mode, and returns false to stop the
+/// optimizer once we've hit our deadline.
+bool MPCLocal::onOptimizerIteration(trajectory::Problem* problem, int iter)
+{
+  // We only know which world to roll out in while optimizePlan() is running
+  if (mReplanWorld == nullptr)
+    return true;
+
+  // Iteration 0 is just the plan we started from, which is already in the
+  // buffer, so there's nothing new to publish
+  if (mEnableAnytimeReplanning && iter > 0)
+  {
+    mBuffer.setForcePlan(
+        mReplanStartTime,
+        monotonicNanos(),
+        problem->getRolloutCache(mReplanWorld)->getForcesConst());
+  }
+
+  // Iteration 0 hasn't taken a step yet, so stopping there would publish the
+  // un-optimized warm start. We always let the optimizer take at least one.
+  if (iter >= 1 && mReplanDeadline > 0 && monotonicNanos() >= mReplanDeadline)
+  {
+    if (!mSilent)
+    {
+      std::cout << "Stopping replanning after " << iter
+                << " iterations, because we hit our deadline" << std::endl;
+    }
+    return false;
+  }
+  return true;
+}
+
 } // namespace realtime
 } // namespace dart
\ No newline at end of file
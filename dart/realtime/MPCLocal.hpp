@@ -36,7 +36,7 @@ public:
   MPCLocal(
       std::shared_ptr<simulation::World> world,
       std::shared_ptr<trajectory::LossFn> loss,
-      int planningHorizonMillis);
+      long planningHorizonNanos);
 
   /// Copy constructor
   MPCLocal(const MPCLocal& mpc);
@@ -65,9 +65,9 @@ public:
   /// computed anything for this instant yet, this just returns 0s.
   Eigen::VectorXd getForce(long now) override;
 
-  /// This returns how many millis we have left until we've run out of plan.
+  /// This returns how many nanos we have left until we've run out of plan.
   /// This can be a negative number, if we've run past our plan.
-  long getRemainingPlanBufferMillis() override;
+  long getRemainingPlanBufferNanos() override;
 
   /// This can completely silence log output
   void setSilent(bool silent);
@@ -88,6 +88,13 @@ public:
   /// short time. Otherwise the log will grow without bound.
   void setRecordIterations(bool enabled);
 
+  /// Defaults to false. This publishes the plan into the control buffer after
+  /// every iteration of the optimizer, rather than only once it finishes, and
+  /// cuts each replan short once half of the plan we had left when it started
+  /// has been used up. That keeps the controller fed with the best plan we have
+  /// so far, even when an optimization takes longer than usual.
+  void setEnableAnytimeReplanning(bool enabled);
+
   /// This gets the current maximum number of iterations that IPOPT will be
   /// allowed to run during an optimization.
   int getMaxIterations();
@@ -107,16 +114,25 @@ public:
       Eigen::VectorXd vel,
       Eigen::VectorXd mass) override;
 
-  /// This optimizes a block of the plan, starting at `startTime`
-  void optimizePlan(long startTime);
+  /// This optimizes a block of the plan, starting at `startTime`. If
+  /// `deadline` is positive, the optimizer stops after the first iteration
+  /// that finishes past that time. It always takes at least one step, so
+  /// even a deadline that's already passed gets an optimized plan.
+  void optimizePlan(long startTime, long deadline = 0L);
+
+  /// This returns the deadline for a replan that begins at `now`, or 0 if it
+  /// shouldn't have one. In anytime mode, that leaves the controller half of
+  /// the plan it has left. There's never a deadline before we've published a
+  /// first plan, because until then there's no buffer to measure against.
+  long getReplanDeadline(long now);
 
   /// This adjusts parameters to make sure we're keeping up with real time. We
-  /// can compute how many (ms / step) it takes us to optimize plans. Sometimes
-  /// we can decrease (ms / step) by increasing the length of the optimization
+  /// can compute how many (ns / step) it takes us to optimize plans. Sometimes
+  /// we can decrease (ns / step) by increasing the length of the optimization
   /// and increasing the parallelism. We can also change the step size in the
   /// physics engine to produce less accurate results, but keep up with the
   /// world in fewer steps.
-  void adjustPerformance(long lastOptimizeTimeMillis);
+  void adjustPerformance(long lastOptimizeTimeNanos);
 
   /// This starts our main thread and begins running optimizations
   void start() override;
@@ -141,6 +157,11 @@ protected:
   /// This is the function for the optimization thread to run when we're live
   void optimizationThreadLoop();
 
+  /// This gets called by the optimizer after every iteration. It publishes
+  /// intermediate plans, if we're in anytime mode, and returns false to stop
+  /// the optimizer once we've hit our deadline.
+  bool onOptimizerIteration(trajectory::Problem* problem, int iter);
+
   bool mRunning;
   std::shared_ptr<simulation::World> mWorld;
   std::shared_ptr<trajectory::LossFn> mLoss;
@@ -150,14 +171,21 @@ protected:
   bool mEnableLinesearch;
   bool mEnableOptimizationGuards;
   bool mRecordIterations;
+  bool mEnableAnytimeReplanning;
 
-  int mPlanningHorizonMillis;
-  int mMillisPerStep;
+  long mPlanningHorizonNanos;
+  long mNanosPerStep;
   int mSteps;
   int mShotLength;
   int mMaxIterations;
-  int mMillisInAdvanceToPlan;
+  long mNanosInAdvanceToPlan;
   long mLastOptimizedTime;
+
+  // The replan that's currently running, for onOptimizerIteration()
+  long mReplanStartTime;
+  long mReplanDeadline;
+  std::shared_ptr<simulation::World> mReplanWorld;
+
   RealTimeControlBuffer mBuffer;
   std::thread mOptimizationThread;
   bool mSilent;
@@ -6,22 +6,25 @@
 
 #include "dart/proto/SerializeEigen.hpp"
 #include "dart/realtime/MPCLocal.hpp"
-#include "dart/realtime/Millis.hpp"
+#include "dart/realtime/Nanos.hpp"
 #include "dart/simulation/World.hpp"
 
 namespace dart {
 namespace realtime {
 
-// RealTimeControlBuffer(int forceDim, int steps, int millisPerStep);
+// RealTimeControlBuffer(int forceDim, int steps, long nanosPerStep);
 
-/// This connects to an MPC remote server
+/// This connects to an MPC remote server. Times cross the wire as wall-clock
+/// nanoseconds since the epoch, and each side converts to and from its own
+/// monotonic clock, so the server can be on any machine with a synchronized
+/// wall clock.
 MPCRemote::MPCRemote(
-    const std::string& host, int port, int dofs, int steps, int millisPerStep)
+    const std::string& host, int port, int dofs, int steps, long nanosPerStep)
   : mRunning(false),
     mChannel(grpc::CreateChannel(
         host + ":" + std::to_string(port), grpc::InsecureChannelCredentials())),
     mStub(proto::MPCService::NewStub(mChannel)),
-    mBuffer(dofs, steps, millisPerStep)
+    mBuffer(dofs, steps, nanosPerStep)
 {
 }
 
@@ -32,7 +35,7 @@ MPCRemote::MPCRemote(MPCLocal& local, int /* ignored */)
     mChannel(nullptr),
     mStub(nullptr),
     mBuffer(RealTimeControlBuffer(
-        local.mWorld->getNumDofs(), local.mSteps, local.mMillisPerStep))
+        local.mWorld->getNumDofs(), local.mSteps, local.mNanosPerStep))
 {
   int port = (rand() % 2000) + 2000;
 
@@ -83,11 +86,11 @@ Eigen::VectorXd MPCRemote::getForce(long now)
   return mBuffer.getPlannedForce(now);
 }
 
-/// This returns how many millis we have left until we've run out of plan.
+/// This returns how many nanos we have left until we've run out of plan.
 /// This can be a negative number, if we've run past our plan.
-long MPCRemote::getRemainingPlanBufferMillis()
+long MPCRemote::getRemainingPlanBufferNanos()
 {
-  return mBuffer.getPlanBufferMillisAfter(timeSinceEpochMillis());
+  return mBuffer.getPlanBufferNanosAfter(monotonicNanos());
 }
 
 /// This records the current state of the world based on some external sensing
@@ -101,7 +104,7 @@ void MPCRemote::recordGroundTruthState(
   grpc::ClientContext context;
 
   proto::MPCRecordGroundTruthStateRequest request;
-  request.set_time(time);
+  request.set_time(monotonicToWallNanos(time));
   proto::serializeVector(*request.mutable_pos(), pos);
   proto::serializeVector(*request.mutable_vel(), vel);
   proto::serializeVector(*request.mutable_mass(), mass);
@@ -132,7 +135,7 @@ void MPCRemote::start()
   grpc::ClientContext context;
 
   proto::MPCStartRequest request;
-  request.set_clientclock(timeSinceEpochMillis());
+  request.set_clientclock(monotonicToWallNanos(monotonicNanos()));
 
   proto::MPCStartReply reply;
 
@@ -164,12 +167,13 @@ void MPCRemote::start()
       trajectory::TrajectoryRolloutReal rollout
           = trajectory::TrajectoryRollout::deserialize(reply.rollout());
 
+      long startTime = wallToMonotonicNanos(reply.starttime());
       mBuffer.setForcePlan(
-          reply.starttime(), timeSinceEpochMillis(), rollout.getForcesConst());
+          startTime, monotonicNanos(), rollout.getForcesConst());
 
       for (auto listener : mReplannedListeners)
       {
-        listener(reply.starttime(), &rollout, reply.replandurationmillis());
+        listener(startTime, &rollout, reply.replandurationnanos());
       }
     }
   });
@@ -187,7 +191,7 @@ void MPCRemote::stop()
   grpc::ClientContext context;
 
   proto::MPCStopRequest request;
-  request.set_clientclock(timeSinceEpochMillis());
+  request.set_clientclock(monotonicToWallNanos(monotonicNanos()));
 
   proto::MPCStopReply reply;
 
@@ -21,13 +21,16 @@ namespace realtime {
 class MPCRemote : public MPC
 {
 public:
-  /// This connects to an MPC remote server
+  /// This connects to an MPC remote server. Times cross the wire as wall-clock
+  /// nanoseconds since the epoch, and each side converts to and from its own
+  /// monotonic clock, so the server can be on any machine with a synchronized
+  /// wall clock.
   MPCRemote(
       const std::string& host,
       int port,
       int dofs,
       int steps,
-      int millisPerStep);
+      long nanosPerStep);
 
   /// This forks the process, starts a server on another process, and connects
   /// to it
@@ -37,9 +40,9 @@ public:
   /// computed anything for this instant yet, this just returns 0s.
   Eigen::VectorXd getForce(long now) override;
 
-  /// This returns how many millis we have left until we've run out of plan.
+  /// This returns how many nanos we have left until we've run out of plan.
   /// This can be a negative number, if we've run past our plan.
-  long getRemainingPlanBufferMillis() override;
+  long getRemainingPlanBufferNanos() override;
 
   /// This records the current state of the world based on some external sensing
   /// and inference. This resets the error in our model just assuming the world
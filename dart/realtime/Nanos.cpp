@@ -0,0 +1,64 @@
+#include "dart/realtime/Nanos.hpp"
+
+#include <chrono>
+#include <cmath>
+
+#include <time.h>
+
+namespace dart {
+namespace realtime {
+
+long monotonicNanos()
+{
+#ifdef __linux__
+  // Ticker sleeps with clock_nanosleep() against this exact clock, so we read
+  // it directly rather than trusting steady_clock to be the same one
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (long)now.tv_sec * NANOS_PER_SECOND + now.tv_nsec;
+#else
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch())
+      .count();
+#endif
+}
+
+namespace {
+
+/// This reads how far ahead of the monotonic clock the wall clock is. NTP can
+/// slew or step the wall clock at any time, so we read this fresh every time
+/// we convert, instead of caching it.
+long wallMinusMonotonicNanos()
+{
+#ifdef __linux__
+  struct timespec wall;
+  clock_gettime(CLOCK_REALTIME, &wall);
+  return (long)wall.tv_sec * NANOS_PER_SECOND + wall.tv_nsec - monotonicNanos();
+#else
+  using namespace std::chrono;
+  long wall
+      = duration_cast<nanoseconds>(system_clock::now().time_since_epoch())
+            .count();
+  return wall - monotonicNanos();
+#endif
+}
+
+} // namespace
+
+long monotonicToWallNanos(long monotonic)
+{
+  return monotonic + wallMinusMonotonicNanos();
+}
+
+long wallToMonotonicNanos(long wall)
+{
+  return wall - wallMinusMonotonicNanos();
+}
+
+long secondsToNanos(double seconds)
+{
+  return std::lround(seconds * NANOS_PER_SECOND);
+}
+
+} // namespace realtime
+} // namespace dart
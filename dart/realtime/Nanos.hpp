@@ -0,0 +1,37 @@
+#ifndef DART_REALTIME_NANOS
+#define DART_REALTIME_NANOS
+
+namespace dart {
+namespace realtime {
+
+constexpr long NANOS_PER_MILLI = 1000000L;
+constexpr long NANOS_PER_SECOND = 1000000000L;
+
+/// This returns the current time in nanoseconds, from a monotonic clock. All
+/// the timestamps in the realtime package come from here. Unlike
+/// timeSinceEpochMillis(), this never jumps when NTP adjusts the system clock,
+/// but it counts from an arbitrary point (usually boot), so these times only
+/// make sense compared against each other on the same machine.
+long monotonicNanos();
+
+/// This converts a monotonicNanos() timestamp into nanoseconds since the Unix
+/// epoch on the wall clock, using the offset between the two clocks right now.
+/// Monotonic times mean nothing on another machine, so this is how to send one
+/// across the network. The receiver converts it back with
+/// wallToMonotonicNanos(), and the result is as accurate as the two machines'
+/// wall clocks are synchronized (e.g. by NTP).
+long monotonicToWallNanos(long monotonic);
+
+/// This is the inverse of monotonicToWallNanos(). It converts nanoseconds since
+/// the Unix epoch on the wall clock into a monotonicNanos() timestamp on this
+/// machine.
+long wallToMonotonicNanos(long wall);
+
+/// This converts a duration in seconds (like World::getTimeStep()) into
+/// nanoseconds, rounding to the nearest nanosecond.
+long secondsToNanos(double seconds);
+
+} // namespace realtime
+} // namespace dart
+
+#endif
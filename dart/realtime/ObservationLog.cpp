@@ -14,33 +14,78 @@ ObservationLog::ObservationLog(
     long startTime,
     Eigen::VectorXd initialPos,
     Eigen::VectorXd initialVel,
-    Eigen::VectorXd initialMass)
-  : mDofs(initialPos.size()), mMassDim(initialMass.size()), mMass(initialMass)
+    Eigen::VectorXd initialMass,
+    int capacity)
+  : mDofs(initialPos.size()),
+    mMassDim(initialMass.size()),
+    mCapacity(capacity),
+    mTimes(capacity, 0L),
+    mPoses(Eigen::MatrixXd::Zero(initialPos.size(), capacity)),
+    mVels(Eigen::MatrixXd::Zero(initialVel.size(), capacity)),
+    mHead(0L),
+    mTail(0L),
+    mMass(initialMass)
 {
-  mObservations.emplace_back(startTime, initialPos, initialVel);
+  observe(startTime, initialPos, initialVel, initialMass);
 }
 
+/// This records an observation. Times should never go backwards, and if they
+/// do we drop the observation.
 void ObservationLog::observe(
     long time,
-    Eigen::VectorXd pos,
-    Eigen::VectorXd vel,
+    const Eigen::Ref<const Eigen::VectorXd>& pos,
+    const Eigen::Ref<const Eigen::VectorXd>& vel,
     // TODO(keenon): Support mass observations
-    Eigen::VectorXd /* mass */)
+    const Eigen::Ref<const Eigen::VectorXd>& /* mass */)
 {
-  mObservations.emplace_back(time, pos, vel);
+  // An out of order observation would have to be inserted into the middle of
+  // the ring, and it's stale anyway, so we just drop it
+  if (mHead > mTail && time < mTimes[(mHead - 1) % mCapacity])
+    return;
+
+  mLock.beginWrite();
+  long slot = mHead % mCapacity;
+  mTimes[slot] = time;
+  mPoses.col(slot) = pos;
+  mVels.col(slot) = vel;
+  mHead++;
+  if (mHead - mTail > mCapacity)
+    mTail = mHead - mCapacity;
+  mLock.endWrite();
 }
 
 Observation ObservationLog::getClosestObservationBefore(long time)
 {
-  for (int i = mObservations.size() - 1; i >= 0; i--)
+  Observation closest(0L, Eigen::VectorXd(mDofs), Eigen::VectorXd(mDofs));
+  bool beforeInitialization;
+
+  long seq;
+  do
+  {
+    seq = mLock.beginRead();
+    long head = mHead;
+    long tail = mTail;
+
+    long index = firstIndexAfter(time, tail, head) - 1;
+    beforeInitialization = index < tail;
+    // If everything we have is after `time`, fall back to the oldest
+    // observation we have
+    if (beforeInitialization)
+      index = tail;
+    long slot = index % mCapacity;
+
+    closest.time = mTimes[slot];
+    closest.pos = mPoses.col(slot);
+    closest.vel = mVels.col(slot);
+  } while (!mLock.endRead(seq));
+
+  if (beforeInitialization)
   {
-    if (mObservations[i].time <= time)
-      return mObservations[i];
+    std::cout << "WARNING: Asked for an observation before our initialization. "
+                 "Returning our initialization"
+              << std::endl;
   }
-  std::cout << "WARNING: Asked for an observation before our initialization. "
-               "Returning our initialization"
-            << std::endl;
-  return mObservations[0];
+  return closest;
 }
 
 Eigen::VectorXd ObservationLog::getMass()
@@ -48,27 +93,43 @@ Eigen::VectorXd ObservationLog::getMass()
   return mMass;
 }
 
+/// This throws away every observation before `time`, except that we always
+/// keep at least the most recent one.
 void ObservationLog::discardBefore(long time)
 {
-  int discardBeforeIndex = -1;
-  for (int i = mObservations.size() - 1; i >= 0; i--)
-  {
-    if (mObservations[i].time < time)
-    {
-      discardBeforeIndex = i;
-      break;
-    }
-  }
-  if (discardBeforeIndex == -1)
-    return;
+  // Times are integers, so the first observation after (time - 1) is the
+  // first observation at or after `time`
+  long newTail = firstIndexAfter(time - 1, mTail, mHead);
+  if (newTail > mHead - 1)
+    newTail = mHead - 1;
+
+  mLock.beginWrite();
+  mTail = newTail;
+  mLock.endWrite();
+}
+
+/// This returns the index of the first observation in [tail, head) with a
+/// time after `time`, or `head` if there isn't one.
+long ObservationLog::firstIndexAfter(long time, long tail, long head) const
+{
+  // If a reader calls this during a write, `tail` and `head` may not be
+  // consistent, so we clamp to the buffer size to keep every index we read in
+  // bounds. The reader will throw away the result anyway.
+  if (head - tail > mCapacity)
+    tail = head - mCapacity;
 
-  std::vector<Observation> newObservations;
-  for (int i = discardBeforeIndex + 1; i < mObservations.size(); i++)
+  long low = tail;
+  long high = head;
+  while (low < high)
   {
-    newObservations.push_back(mObservations[i]);
+    long mid = low + (high - low) / 2;
+    if (mTimes[mid % mCapacity] <= time)
+      low = mid + 1;
+    else
+      high = mid;
   }
-  mObservations = newObservations;
+  return low;
 }
 
 } // namespace realtime
-} // namespace dart
\ No newline at end of file
+} // namespace dart
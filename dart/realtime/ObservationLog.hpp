@@ -5,6 +5,8 @@
 
 #include <Eigen/Dense>
 
+#include "dart/realtime/SeqLock.hpp"
+
 namespace dart {
 namespace realtime {
 
@@ -17,6 +19,15 @@ struct Observation
   Observation(long time, Eigen::VectorXd pos, Eigen::VectorXd vel);
 };
 
+/// This is a log of observed world states.
+///
+/// It keeps the most recent `capacity` observations in a ring buffer,
+/// allocated up front, so observing never allocates. Observations are kept
+/// sorted by time, so lookups are a binary search.
+///
+/// One thread may call observe() and discardBefore(), while any number of
+/// other threads call getClosestObservationBefore(). Readers never block the
+/// writer.
 class ObservationLog
 {
 public:
@@ -24,28 +35,49 @@ public:
       long startTime,
       Eigen::VectorXd initialPos,
       Eigen::VectorXd initialVel,
-      Eigen::VectorXd initialMass);
+      Eigen::VectorXd initialMass,
+      int capacity = 10000);
 
+  /// This records an observation. Times should never go backwards, and if
+  /// they do we drop the observation.
   void observe(
       long time,
-      Eigen::VectorXd pos,
-      Eigen::VectorXd vel,
-      Eigen::VectorXd mass);
+      const Eigen::Ref<const Eigen::VectorXd>& pos,
+      const Eigen::Ref<const Eigen::VectorXd>& vel,
+      const Eigen::Ref<const Eigen::VectorXd>& mass);
 
   Observation getClosestObservationBefore(long time);
 
   Eigen::VectorXd getMass();
 
+  /// This throws away every observation before `time`, except that we always
+  /// keep at least the most recent one.
   void discardBefore(long time);
 
 protected:
+  /// This returns the index of the first observation in [tail, head) with a
+  /// time after `time`, or `head` if there isn't one.
+  long firstIndexAfter(long time, long tail, long head) const;
+
   int mDofs;
   int mMassDim;
-  std::vector<Observation> mObservations;
+  int mCapacity;
+
+  /// These are the ring buffers. Observation i lives in slot (i % mCapacity).
+  std::vector<long> mTimes;
+  Eigen::MatrixXd mPoses;
+  Eigen::MatrixXd mVels;
+
+  /// The log holds observations [mTail, mHead). These only ever increase.
+  long mHead;
+  long mTail;
+
   Eigen::VectorXd mMass;
+
+  SeqLock mLock;
 };
 
 } // namespace realtime
 } // namespace dart
 
-#endif
\ No newline at end of file
+#endif
@@ -1,5 +1,6 @@
 #include "dart/realtime/RealTimeControlBuffer.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 #include "dart/simulation/World.hpp"
@@ -7,61 +8,66 @@
 namespace dart {
 namespace realtime {
 
+constexpr int RealTimeControlBuffer::FRESH_BIT;
+constexpr int RealTimeControlBuffer::INDEX_MASK;
+
 RealTimeControlBuffer::RealTimeControlBuffer(
-    int forceDim, int steps, int millisPerStep)
+    int forceDim, int steps, long nanosPerStep)
   : mForceDim(forceDim),
-    mNumSteps(steps),
-    mMillisPerStep(millisPerStep),
-    mActiveBuffer(UNINITIALIZED),
-    mBufA(Eigen::MatrixXd::Zero(forceDim, steps)),
-    mBufB(Eigen::MatrixXd::Zero(forceDim, steps)),
-    mControlLog(ControlLog(forceDim, millisPerStep))
+    mWriteIndex(0),
+    mPublishedIndex(1),
+    mReadIndex(2),
+    mMiddle(1),
+    mPlanEnd(0L),
+    mControlLog(ControlLog(forceDim, nanosPerStep))
 {
+  for (int i = 0; i < 3; i++)
+  {
+    mBuffers[i].forces = Eigen::MatrixXd::Zero(forceDim, steps);
+    mBuffers[i].startTime = 0L;
+    mBuffers[i].nanosPerStep = nanosPerStep;
+    mBuffers[i].numSteps = steps;
+    mBuffers[i].initialized = false;
+  }
 }
 
-/// Gets the force at a given timestep
-Eigen::VectorXd RealTimeControlBuffer::getPlannedForce(long time, bool dontLog)
+/// This isn't thread safe, so only copy a buffer that nobody is using
+RealTimeControlBuffer::RealTimeControlBuffer(
+    const RealTimeControlBuffer& other)
+  : mForceDim(other.mForceDim),
+    mWriteIndex(other.mWriteIndex),
+    mPublishedIndex(other.mPublishedIndex),
+    mReadIndex(other.mReadIndex),
+    mMiddle(other.mMiddle.load()),
+    mPlanEnd(other.mPlanEnd.load()),
+    mControlLog(other.mControlLog)
 {
-  if (mActiveBuffer == UNINITIALIZED)
+  for (int i = 0; i < 3; i++)
   {
-    // Unitialized, default to no force
-    return Eigen::VectorXd::Zero(mForceDim);
-  }
-  int elapsed = time - mLastWroteBufferAt;
-  if (elapsed < 0)
-  {
-    // Asking for some time in the past, default to no force
-    return Eigen::VectorXd::Zero(mForceDim);
+    mBuffers[i] = other.mBuffers[i];
   }
+}
 
-  int step = (int)floor((double)elapsed / mMillisPerStep);
-  if (step < mNumSteps)
-  {
-    if (mActiveBuffer == BUF_A)
-    {
-      if (!dontLog)
-        mControlLog.record(time, mBufA.col(step));
-      return mBufA.col(step);
-    }
-    else if (mActiveBuffer == BUF_B)
-    {
-      if (!dontLog)
-        mControlLog.record(time, mBufB.col(step));
-      return mBufB.col(step);
-    }
-    else
-      assert(false && "Should never reach this point");
-  }
-  else
+/// Gets the force at a given timestep
+Eigen::VectorXd RealTimeControlBuffer::getPlannedForce(long time, bool dontLog)
+{
+  Eigen::VectorXd force = Eigen::VectorXd::Zero(mForceDim);
+  getPlannedForce(time, force, dontLog);
+  return force;
+}
+
+/// This is the same as getPlannedForce() above, but it writes the force into
+/// `forceOut`, so that it doesn't need to allocate.
+void RealTimeControlBuffer::getPlannedForce(
+    long time, Eigen::Ref<Eigen::VectorXd> forceOut, bool dontLog)
+{
+  const ForcePlan& plan = mBuffers[acquireLatestPlan()];
+  readPlannedForce(plan, time, forceOut);
+  // We only log once there's a plan, and we're not asking about the past
+  if (!dontLog && plan.initialized && time >= plan.startTime)
   {
-    // std::cout << "WARNING: MPC isn't keeping up!" << std::endl;
-    Eigen::VectorXd oob = Eigen::VectorXd::Zero(mForceDim);
-    if (!dontLog)
-      mControlLog.record(time, oob);
-    return oob;
+    mControlLog.record(time, forceOut);
   }
-  // The code should never reach here, but it's here to keep the compiler happy
-  throw std::runtime_error{"Execution should never reach this point"};
 }
 
 /// This gets planned forces starting at `start`, and continuing for the
@@ -71,37 +77,29 @@ Eigen::VectorXd RealTimeControlBuffer::getPlannedForce(long time, bool dontLog)
 void RealTimeControlBuffer::getPlannedForcesStartingAt(
     long start, Eigen::Ref<Eigen::MatrixXd> forcesOut)
 {
-  if (mActiveBuffer == UNINITIALIZED)
+  const ForcePlan& plan = mBuffers[mPublishedIndex];
+  if (!plan.initialized)
   {
     // Unitialized, default to 0
     forcesOut.setZero();
     return;
   }
-  int elapsed = start - mLastWroteBufferAt;
+  long elapsed = start - plan.startTime;
   if (elapsed < 0)
   {
     // Asking for some time in the past, default to 0
     forcesOut.setZero();
     return;
   }
-  int startStep = (int)floor((double)elapsed / mMillisPerStep);
-  if (startStep < mNumSteps)
+  int numSteps = plan.numSteps;
+  int startStep = (int)floor((double)elapsed / plan.nanosPerStep);
+  if (startStep < numSteps)
   {
-    // Copy the appropriate block of our active buffer to the forcesOut block
-    if (mActiveBuffer == BUF_A)
-    {
-      forcesOut.block(0, 0, mForceDim, mNumSteps - startStep)
-          = mBufA.block(0, startStep, mForceDim, mNumSteps - startStep);
-    }
-    else if (mActiveBuffer == BUF_B)
-    {
-      forcesOut.block(0, 0, mForceDim, mNumSteps - startStep)
-          = mBufB.block(0, startStep, mForceDim, mNumSteps - startStep);
-    }
-    else
-      assert(false && "Should never reach this point");
+    // Copy the appropriate block of the plan to the forcesOut block
+    forcesOut.block(0, 0, mForceDim, numSteps - startStep)
+        = plan.forces.block(0, startStep, mForceDim, numSteps - startStep);
     // Zero out the remainder of the forcesOut block
-    forcesOut.block(0, mNumSteps - startStep, mForceDim, startStep).setZero();
+    forcesOut.block(0, numSteps - startStep, mForceDim, startStep).setZero();
   }
   else
   {
@@ -113,92 +111,84 @@ void RealTimeControlBuffer::getPlannedForcesStartingAt(
 /// This swaps in a new buffer of forces. The assumption is that "startAt" is
 /// before "now", because we'll erase old data in this process.
 void RealTimeControlBuffer::setForcePlan(
-    long startAt, long now, Eigen::MatrixXd forces)
+    long startAt, long now, const Eigen::Ref<const Eigen::MatrixXd>& forces)
 {
+  const ForcePlan& current = mBuffers[mPublishedIndex];
+  ForcePlan& next = mBuffers[mWriteIndex];
+  const int numSteps = current.numSteps;
+  const long nanosPerStep = current.nanosPerStep;
+  const int forceSteps
+      = std::min(numSteps, static_cast<int>(forces.cols()));
+
   if (startAt > now)
   {
-    long padMillis = startAt - now;
-    int padSteps = (int)floor((double)padMillis / mMillisPerStep);
+    long padNanos = startAt - now;
+    int padSteps = (int)floor((double)padNanos / nanosPerStep);
     // If we're trying to set the force plan too far out in the future, this
     // whole exercise is a no-op
-    if (padSteps >= mNumSteps)
+    if (padSteps >= numSteps)
     {
       return;
     }
     // Otherwise, we're going to copy part of the existing plan
     int currentStep
-        = (int)floor((double)(now - mLastWroteBufferAt) / mMillisPerStep);
-    int remainingSteps = mNumSteps - currentStep;
-    mLastWroteBufferAt = now;
+        = (int)floor((double)(now - current.startTime) / nanosPerStep);
+    int remainingSteps = numSteps - currentStep;
+
+    next.startTime = now;
+    next.nanosPerStep = nanosPerStep;
+    next.numSteps = numSteps;
+    next.initialized = true;
 
     // If we've overflowed our old buffer, this is bad, but recoverable. We'll
     // just not copy anything from our old plan, since it's all in the past now
     // anyways.
     if (remainingSteps < 0)
     {
-      mBufA = forces;
-      mActiveBuffer = BUF_A;
+      next.forces.leftCols(forceSteps) = forces.leftCols(forceSteps);
+      next.forces.middleCols(forceSteps, numSteps - forceSteps).setZero();
+      publishBackBuffer();
       return;
     }
 
     int copySteps = padSteps;
     int zeroSteps = 0;
-    int useSteps = mNumSteps - padSteps;
+    int useSteps = numSteps - padSteps;
     if (padSteps > remainingSteps)
     {
       copySteps = remainingSteps;
       zeroSteps = padSteps - remainingSteps;
-      useSteps = mNumSteps - padSteps;
+      useSteps = numSteps - padSteps;
     }
-    assert(copySteps + zeroSteps + useSteps == mNumSteps);
+    assert(copySteps + zeroSteps + useSteps == numSteps);
+    useSteps = std::min(useSteps, forceSteps);
 
-    if (mActiveBuffer == UNINITIALIZED)
+    if (current.initialized)
     {
-      mBufA.block(0, 0, mForceDim, copySteps).setZero();
-      mBufA.block(0, copySteps, mForceDim, zeroSteps).setZero();
-      mBufA.block(0, copySteps + zeroSteps, mForceDim, useSteps)
-          = forces.block(0, 0, mForceDim, useSteps);
-      mActiveBuffer = BUF_A;
+      next.forces.block(0, 0, mForceDim, copySteps)
+          = current.forces.block(0, numSteps - copySteps, mForceDim, copySteps);
     }
-    else if (mActiveBuffer == BUF_B)
-    {
-      mBufA.block(0, 0, mForceDim, copySteps)
-          = mBufB.block(0, mNumSteps - copySteps, mForceDim, copySteps);
-      mBufA.block(0, copySteps, mForceDim, zeroSteps).setZero();
-      mBufA.block(0, copySteps + zeroSteps, mForceDim, useSteps)
-          = forces.block(0, 0, mForceDim, useSteps);
-      mActiveBuffer = BUF_A;
-    }
-    else if (mActiveBuffer == BUF_A)
+    else
     {
-      mBufB.block(0, 0, mForceDim, copySteps)
-          = mBufA.block(0, mNumSteps - copySteps, mForceDim, copySteps);
-      mBufB.block(0, copySteps, mForceDim, zeroSteps).setZero();
-      mBufB.block(0, copySteps + zeroSteps, mForceDim, useSteps)
-          = forces.block(0, 0, mForceDim, useSteps);
-      mActiveBuffer = BUF_B;
+      next.forces.block(0, 0, mForceDim, copySteps).setZero();
     }
+    next.forces.block(0, copySteps, mForceDim, zeroSteps).setZero();
+    next.forces.block(0, copySteps + zeroSteps, mForceDim, useSteps)
+        = forces.block(0, 0, mForceDim, useSteps);
+    int filled = copySteps + zeroSteps + useSteps;
+    next.forces.middleCols(filled, numSteps - filled).setZero();
   }
   else
   {
-    mLastWroteBufferAt = startAt;
-    if (mActiveBuffer == UNINITIALIZED || mActiveBuffer == BUF_B)
-    {
-      mBufA = forces;
-      // Crucial for lock-free behavior: copy the buffer BEFORE setting the
-      // active buffer. Not a huge deal if we're a bit off here in the
-      // optimizer, but not ideal.
-      mActiveBuffer = BUF_A;
-    }
-    else
-    {
-      mBufB = forces;
-      // Crucial for lock-free behavior: copy the buffer BEFORE setting the
-      // active buffer. Not a huge deal if we're a bit off here in the
-      // optimizer, but not ideal.
-      mActiveBuffer = BUF_B;
-    }
+    next.startTime = startAt;
+    next.nanosPerStep = nanosPerStep;
+    next.numSteps = numSteps;
+    next.initialized = true;
+    next.forces.leftCols(forceSteps) = forces.leftCols(forceSteps);
+    next.forces.middleCols(forceSteps, numSteps - forceSteps).setZero();
   }
+
+  publishBackBuffer();
 }
 
 /// This retrieves the state of the world at a given time, assuming that we've
@@ -207,8 +197,12 @@ void RealTimeControlBuffer::setForcePlan(
 void RealTimeControlBuffer::estimateWorldStateAt(
     std::shared_ptr<simulation::World> world, ObservationLog* log, long time)
 {
+  // We're on the planning thread, so we read from the plan we last published
+  const ForcePlan& plan = mBuffers[mPublishedIndex];
+  Eigen::VectorXd plannedForce = Eigen::VectorXd::Zero(mForceDim);
+
   Observation obs = log->getClosestObservationBefore(time);
-  int elapsedSinceObservation = time - obs.time;
+  long elapsedSinceObservation = time - obs.time;
   if (elapsedSinceObservation < 0)
   {
     assert(
@@ -216,7 +210,7 @@ void RealTimeControlBuffer::estimateWorldStateAt(
         && "estimateWorldStateAt() cannot ask far a time before the earliest available observation.");
   }
   int stepsSinceObservation
-      = (int)floor((double)elapsedSinceObservation / mMillisPerStep);
+      = (int)floor((double)elapsedSinceObservation / plan.nanosPerStep);
   /*
   std::cout << "RealTimeControlBuffer time: " << time << std::endl;
   std::cout << "RealTimeControlBuffer obs.time: " << obs.time << std::endl;
@@ -231,16 +225,18 @@ void RealTimeControlBuffer::estimateWorldStateAt(
   world->setMasses(log->getMass());
   for (int i = 0; i < stepsSinceObservation; i++)
   {
-    long at = obs.time + i * mMillisPerStep;
+    long at = obs.time + i * plan.nanosPerStep;
     // In the future, project assuming planned forces
     if (at > mControlLog.last())
     {
-      world->setExternalForces(getPlannedForce(at, true));
+      readPlannedForce(plan, at, plannedForce);
+      world->setExternalForces(plannedForce);
     }
     // In the past, project using known forces read from the buffer
     else
     {
-      world->setExternalForces(mControlLog.get(at));
+      mControlLog.get(at, plannedForce);
+      world->setExternalForces(plannedForce);
     }
     world->step();
   }
@@ -249,18 +245,12 @@ void RealTimeControlBuffer::estimateWorldStateAt(
 /// This rescales the timestep size. This is useful because larger timesteps
 /// mean fewer time steps per real unit of time, and thus we can run our
 /// optimization slower and still keep up with real life.
-void RealTimeControlBuffer::setMillisPerStep(int newMillisPerStep)
+void RealTimeControlBuffer::setNanosPerStep(long newNanosPerStep)
 {
-  mControlLog.setMillisPerStep(newMillisPerStep);
-  if (mActiveBuffer == BUF_A)
-  {
-    rescaleBuffer(mBufA, mMillisPerStep, newMillisPerStep);
-  }
-  else if (mActiveBuffer == BUF_B)
-  {
-    rescaleBuffer(mBufB, mMillisPerStep, newMillisPerStep);
-  }
-  mMillisPerStep = newMillisPerStep;
+  mControlLog.setNanosPerStep(newNanosPerStep);
+  rescaleBuffer(
+      mBuffers[mPublishedIndex], mBuffers[mWriteIndex], newNanosPerStep);
+  publishBackBuffer();
 }
 
 /// This changes the number of steps. Fewer steps mean we can compute a buffer
@@ -268,33 +258,33 @@ void RealTimeControlBuffer::setMillisPerStep(int newMillisPerStep)
 /// probably has a nonlinear effect on runtime.
 void RealTimeControlBuffer::setNumSteps(int newNumSteps)
 {
-  Eigen::MatrixXd newBuf = Eigen::MatrixXd::Zero(mForceDim, newNumSteps);
-
-  int minLen = newNumSteps;
-  if (mNumSteps < minLen)
-    minLen = mNumSteps;
-
-  if (mActiveBuffer == BUF_A)
+  if (newNumSteps > mBuffers[mWriteIndex].forces.cols())
   {
-    newBuf.block(0, 0, mForceDim, minLen)
-        = mBufA.block(0, 0, mForceDim, minLen);
-  }
-  else if (mActiveBuffer == BUF_B)
-  {
-    newBuf.block(0, 0, mForceDim, minLen)
-        = mBufB.block(0, 0, mForceDim, minLen);
+    // This reallocates, so it's only safe before the control thread starts
+    for (int i = 0; i < 3; i++)
+    {
+      mBuffers[i].forces.conservativeResize(Eigen::NoChange, newNumSteps);
+    }
   }
 
-  mBufA = newBuf;
-  mBufB = newBuf;
+  const ForcePlan& current = mBuffers[mPublishedIndex];
+  ForcePlan& next = mBuffers[mWriteIndex];
+
+  int minLen = std::min(newNumSteps, current.numSteps);
+  next.forces.leftCols(minLen) = current.forces.leftCols(minLen);
+  next.forces.middleCols(minLen, newNumSteps - minLen).setZero();
+  next.startTime = current.startTime;
+  next.nanosPerStep = current.nanosPerStep;
+  next.numSteps = newNumSteps;
+  next.initialized = current.initialized;
+  publishBackBuffer();
 }
 
-/// This returns the number of millis we have left in the plan after `time`.
+/// This returns the number of nanos we have left in the plan after `time`.
 /// This can be a negative number.
-long RealTimeControlBuffer::getPlanBufferMillisAfter(long time)
+long RealTimeControlBuffer::getPlanBufferNanosAfter(long time)
 {
-  long planEnd = mLastWroteBufferAt + (mNumSteps * mMillisPerStep);
-  return planEnd - time;
+  return mPlanEnd.load(std::memory_order_acquire) - time;
 }
 
 /// This is useful when we're replicating a log across a network boundary,
@@ -305,33 +295,100 @@ void RealTimeControlBuffer::manuallyRecordObservedForce(
   mControlLog.record(time, observation);
 }
 
-/// This is a helper to rescale the timestep size of a buffer while leaving
-/// the data otherwise unchanged.
+/// This is a helper to read the force at `time` from `plan`, into `forceOut`
+void RealTimeControlBuffer::readPlannedForce(
+    const ForcePlan& plan, long time, Eigen::Ref<Eigen::VectorXd> forceOut)
+{
+  if (!plan.initialized)
+  {
+    // Unitialized, default to no force
+    forceOut.setZero();
+    return;
+  }
+  long elapsed = time - plan.startTime;
+  if (elapsed < 0)
+  {
+    // Asking for some time in the past, default to no force
+    forceOut.setZero();
+    return;
+  }
+
+  int step = (int)floor((double)elapsed / plan.nanosPerStep);
+  if (step < plan.numSteps)
+  {
+    forceOut = plan.forces.col(step);
+  }
+  else
+  {
+    // std::cout << "WARNING: MPC isn't keeping up!" << std::endl;
+    forceOut.setZero();
+  }
+}
+
+/// This is a helper to rescale the timestep size of `from` into `to`, while
+/// leaving the data otherwise unchanged.
 void RealTimeControlBuffer::rescaleBuffer(
-    Eigen::MatrixXd& buf, int oldMillisPerStep, int newMillisPerStep)
+    const ForcePlan& from, ForcePlan& to, long newNanosPerStep)
 {
-  Eigen::MatrixXd newBuf = Eigen::MatrixXd::Zero(buf.rows(), buf.cols());
+  const long oldNanosPerStep = from.nanosPerStep;
+  const int numSteps = from.numSteps;
+  to.forces.leftCols(numSteps).setZero();
 
-  for (int i = mNumSteps - 1; i >= 0; i--)
+  for (int i = numSteps - 1; i >= 0; i--)
   {
-    if (newMillisPerStep > oldMillisPerStep)
+    if (newNanosPerStep > oldNanosPerStep)
     {
       // If we're increasing the step size, there's more than one old column per
       // new column, so map from old to new
-      int newCol = floor((double)(i * oldMillisPerStep) / newMillisPerStep);
-      newBuf.col(newCol) = buf.col(i);
+      int newCol = floor((double)(i * oldNanosPerStep) / newNanosPerStep);
+      to.forces.col(newCol) = from.forces.col(i);
     }
     else
     {
       // If we're increasing the step size, there's more than one new column per
       // old column, so map from new to old
-      int oldCol = floor((double)(i * newMillisPerStep) / oldMillisPerStep);
-      newBuf.col(i) = buf.col(oldCol);
+      int oldCol = floor((double)(i * newNanosPerStep) / oldNanosPerStep);
+      to.forces.col(i) = from.forces.col(oldCol);
     }
   }
 
-  buf = newBuf;
+  to.startTime = from.startTime;
+  to.nanosPerStep = newNanosPerStep;
+  to.numSteps = numSteps;
+  to.initialized = from.initialized;
+}
+
+/// The planning thread calls this once it's done filling in the back buffer,
+/// to make it visible to the control thread.
+void RealTimeControlBuffer::publishBackBuffer()
+{
+  const ForcePlan& plan = mBuffers[mWriteIndex];
+  long planEnd = plan.startTime + (long)plan.numSteps * plan.nanosPerStep;
+
+  // The release half of this makes sure everything we wrote into the back
+  // buffer is visible to the control thread once it swaps the buffer out of
+  // the middle slot.
+  int previous
+      = mMiddle.exchange(mWriteIndex | FRESH_BIT, std::memory_order_acq_rel);
+  mPublishedIndex = mWriteIndex;
+  mWriteIndex = previous & INDEX_MASK;
+
+  mPlanEnd.store(planEnd, std::memory_order_release);
+}
+
+/// The control thread calls this to get the index of the freshest plan that's
+/// been published.
+int RealTimeControlBuffer::acquireLatestPlan()
+{
+  if (mMiddle.load(std::memory_order_relaxed) & FRESH_BIT)
+  {
+    // Hand back the buffer we were reading, and take the fresh one. The
+    // acquire half of this pairs with the release in publishBackBuffer().
+    int fresh = mMiddle.exchange(mReadIndex, std::memory_order_acq_rel);
+    mReadIndex = fresh & INDEX_MASK;
+  }
+  return mReadIndex;
 }
 
 } // namespace realtime
-} // namespace dart
\ No newline at end of file
+} // namespace dart
@@ -1,6 +1,7 @@
 #ifndef DART_REALTIME_BUFFER
 #define DART_REALTIME_BUFFER
 
+#include <atomic>
 #include <memory>
 #include <vector>
 
@@ -16,23 +17,73 @@ class World;
 
 namespace realtime {
 
-enum BufferSwitchEnum
+/// This is a single copy of the force plan, along with the timing information
+/// needed to read it. RealTimeControlBuffer keeps three of these.
+struct ForcePlan
 {
-  UNINITIALIZED,
-  BUF_A,
-  BUF_B
+  /// This is (forceDim x capacity). Only the first `numSteps` columns are part
+  /// of the plan, the rest is just preallocated space.
+  Eigen::MatrixXd forces;
+
+  /// This is the time when this plan was written, which is when its first
+  /// column starts
+  long startTime;
+
+  /// This is how long each column of `forces` lasts
+  long nanosPerStep;
+
+  int numSteps;
+
+  /// False until the first call to setForcePlan()
+  bool initialized;
 };
 
+/// This passes force plans from a planning thread (like MPCLocal's
+/// optimization thread) to a hard-real-time control thread.
+///
+/// It's a lock-free triple buffer. The planner writes into a back buffer that
+/// nobody else can see, and then atomically swaps it into the middle slot. The
+/// controller atomically swaps the middle slot out whenever it's holding a
+/// stale plan. Neither side ever waits on the other, so getPlannedForce() is
+/// wait-free, and since all three buffers (and the control log) are allocated
+/// up front, it never allocates either, as long as you use the overload that
+/// writes into an existing vector.
+///
+/// All times are in nanoseconds, usually from monotonicNanos().
+///
+/// This supports exactly one planning thread and one control thread:
+///
+/// - The control thread may call getPlannedForce().
+/// - The planning thread may call setForcePlan(), setNanosPerStep(),
+///   setNumSteps(), getPlannedForcesStartingAt() and estimateWorldStateAt().
+///   The reads among these see the last plan the planning thread published,
+///   not the one the controller is reading.
+/// - Any thread may call getPlanBufferNanosAfter().
+///
+/// The log of applied forces has a single writer too. That's normally
+/// getPlannedForce(), but when the forces are applied somewhere else (like
+/// across a network), it's manuallyRecordObservedForce() instead, and the
+/// control thread should pass `dontLog`. setNanosPerStep() also rewrites the
+/// log, so it can only be called while nobody else is writing the log.
 class RealTimeControlBuffer
 {
 public:
-  RealTimeControlBuffer(int forceDim, int steps, int millisPerStep);
+  RealTimeControlBuffer(int forceDim, int steps, long nanosPerStep);
+
+  /// This isn't thread safe, so only copy a buffer that nobody is using
+  RealTimeControlBuffer(const RealTimeControlBuffer& other);
 
   /// Gets the force at a given timestep. This HAS SIDE EFFECTS! We actually
   /// keep track of what forces were read, and assume that they're "immediately"
   /// applied to the real world after they're read.
   Eigen::VectorXd getPlannedForce(long time, bool dontLog = false);
 
+  /// This is the same as getPlannedForce() above, but it writes the force into
+  /// `forceOut` (which must have length forceDim), so that it doesn't need to
+  /// allocate.
+  void getPlannedForce(
+      long time, Eigen::Ref<Eigen::VectorXd> forceOut, bool dontLog = false);
+
   /// This gets planned forces starting at `start`, and continuing for the
   /// length of our buffer size `mSteps`. This is useful for initializing MPC
   /// runs. It supports walking off the end of known future, and assumes 0
@@ -43,7 +94,8 @@ public:
   /// This swaps in a new buffer of forces. If "startAt" is after "now", this
   /// will copy enough of the current buffer into our updated buffer to keep the
   /// current trajectory.
-  void setForcePlan(long startAt, long now, Eigen::MatrixXd forces);
+  void setForcePlan(
+      long startAt, long now, const Eigen::Ref<const Eigen::MatrixXd>& forces);
 
   /// This retrieves the state of the world at a given time, assuming that we've
   /// been applying forces from the buffer since the last state that we fully
@@ -54,16 +106,20 @@ public:
   /// This rescales the timestep size. This is useful because larger timesteps
   /// mean fewer time steps per real unit of time, and thus we can run our
   /// optimization slower and still keep up with real life.
-  void setMillisPerStep(int millisPerStep);
+  void setNanosPerStep(long nanosPerStep);
 
   /// This changes the number of steps. Fewer steps mean we can compute a buffer
   /// faster, but it also means we have less time to compute the buffer. This
   /// probably has a nonlinear effect on runtime.
+  ///
+  /// Growing past the number of steps this buffer was constructed with has to
+  /// reallocate all three buffers, which isn't safe while the control thread
+  /// is reading. Only do that before the control thread starts.
   void setNumSteps(int numSteps);
 
-  /// This returns the number of millis we have left in the plan after `time`.
+  /// This returns the number of nanos we have left in the plan after `time`.
   /// This can be a negative number.
-  long getPlanBufferMillisAfter(long time);
+  long getPlanBufferNanosAfter(long time);
 
   /// This is useful when we're replicating a log across a network boundary,
   /// which comes up in distributed MPC.
@@ -71,25 +127,56 @@ public:
 
 protected:
   int mForceDim;
-  int mNumSteps;
-  int mMillisPerStep;
 
-  /// This is a helper to rescale the timestep size of a buffer while leaving
-  /// the data otherwise unchanged.
-  void rescaleBuffer(
-      Eigen::MatrixXd& buf, int oldMillisPerStep, int newMillisPerStep);
-
-  /// This controls which of our buffers is currently active
-  BufferSwitchEnum mActiveBuffer;
-
-  /// This is the A buffer of forces
-  Eigen::MatrixXd mBufA;
+  /// This is a helper to read the force at `time` from `plan`, into
+  /// `forceOut`. It doesn't log anything.
+  void readPlannedForce(
+      const ForcePlan& plan, long time, Eigen::Ref<Eigen::VectorXd> forceOut);
 
-  /// This is the B buffer of forces
-  Eigen::MatrixXd mBufB;
-
-  /// This is the time when the last buffer was written to
-  long mLastWroteBufferAt;
+  /// This is a helper to rescale the timestep size of `from` into `to`, while
+  /// leaving the data otherwise unchanged.
+  void rescaleBuffer(
+      const ForcePlan& from, ForcePlan& to, long newNanosPerStep);
+
+  /// The planning thread calls this once it's done filling in the back buffer
+  /// (mBuffers[mWriteIndex]), to make it visible to the control thread.
+  void publishBackBuffer();
+
+  /// The control thread calls this to get the index of the freshest plan
+  /// that's been published.
+  int acquireLatestPlan();
+
+  /// The low bits of mMiddle are the index of the buffer in the middle slot.
+  /// This bit is set when the planning thread has put a plan there that the
+  /// control thread hasn't picked up yet.
+  static constexpr int FRESH_BIT = 4;
+  static constexpr int INDEX_MASK = 3;
+
+  /// These are the three buffers we rotate between
+  ForcePlan mBuffers[3];
+
+  /// This is the buffer the planning thread is writing. Only the planning
+  /// thread touches this.
+  int mWriteIndex;
+
+  /// This is the buffer the planning thread published most recently. That
+  /// buffer is either in the middle slot or being read by the control thread,
+  /// so it can't get written until the planning thread publishes again, and
+  /// it's safe for the planning thread to read. Only the planning thread
+  /// touches this.
+  int mPublishedIndex;
+
+  /// This is the buffer the control thread is reading. Only the control thread
+  /// touches this.
+  int mReadIndex;
+
+  /// This is the buffer in the middle slot, and the FRESH_BIT. This is the
+  /// only state shared between the two threads.
+  std::atomic<int> mMiddle;
+
+  /// This is the end time of the most recently published plan, so that any
+  /// thread can check how much plan we have left.
+  std::atomic<long> mPlanEnd;
 
   /// This keeps a log of all the control outputs we send, so that we can get
   /// the current state on request, even if we last had an observation a while
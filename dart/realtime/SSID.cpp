@@ -1,11 +1,19 @@
 #include "dart/realtime/SSID.hpp"
 
+#include <condition_variable>
+#include <exception>
+#include <future>
+#include <limits>
+#include <mutex>
 #include <thread>
 
-#include "dart/realtime/Millis.hpp"
+#include "dart/common/ThreadPool.hpp"
+#include "dart/realtime/Nanos.hpp"
 #include "dart/simulation/World.hpp"
 #include "dart/trajectory/IPOptOptimizer.hpp"
 #include "dart/trajectory/MultiShot.hpp"
+#include "dart/trajectory/SGDOptimizer.hpp"
+#include "dart/trajectory/SingleShot.hpp"
 #include "dart/trajectory/TrajectoryRollout.hpp"
 
 #include "signal.h"
@@ -19,15 +27,17 @@ namespace realtime {
 SSID::SSID(
     std::shared_ptr<simulation::World> world,
     std::shared_ptr<trajectory::LossFn> loss,
-    int planningHistoryMillis,
+    long planningHistoryNanos,
     int sensorDim)
   : mRunning(false),
     mWorld(world),
     mLoss(loss),
-    mPlanningHistoryMillis(planningHistoryMillis),
+    mPlanningHistoryNanos(planningHistoryNanos),
     mSensorDim(sensorDim),
     mSensorLog(VectorLog(sensorDim)),
-    mControlLog(VectorLog(world->getNumDofs()))
+    mControlLog(VectorLog(world->getNumDofs())),
+    mHypothesisOptimizerFactory(&SSID::createDefaultHypothesisOptimizer),
+    mNumThreads(0)
 {
   int dofs = world->getNumDofs();
   mInitialPosEstimator
@@ -35,6 +45,12 @@ SSID::SSID(
           return Eigen::VectorXd::Zero(dofs);
         };
 
+  mOptimizer = createDefaultOptimizer();
+}
+
+/// This creates the default IPOPT optimizer for SSID
+std::shared_ptr<trajectory::Optimizer> SSID::createDefaultOptimizer()
+{
   std::shared_ptr<IPOptOptimizer> ipoptOptimizer
       = std::make_shared<IPOptOptimizer>();
   ipoptOptimizer->setCheckDerivatives(false);
@@ -45,7 +61,18 @@ SSID::SSID(
   ipoptOptimizer->setRecordIterations(false);
   ipoptOptimizer->setLBFGSHistoryLength(5);
   ipoptOptimizer->setSilenceOutput(true);
-  mOptimizer = ipoptOptimizer;
+  return ipoptOptimizer;
+}
+
+/// This creates the default optimizer for each hypothesis. That's SGD rather
+/// than IPOPT, because IPOPT's default linear solver (MUMPS) can't run on
+/// several threads at once, which would leave the hypotheses taking turns.
+std::shared_ptr<trajectory::Optimizer> SSID::createDefaultHypothesisOptimizer()
+{
+  std::shared_ptr<SGDOptimizer> sgdOptimizer = std::make_shared<SGDOptimizer>();
+  sgdOptimizer->setIterationLimit(20);
+  sgdOptimizer->setSuppressOutput(true);
+  return sgdOptimizer;
 }
 
 /// This updates the loss function that we're going to move in real time to
@@ -91,16 +118,61 @@ std::shared_ptr<trajectory::Problem> SSID::getProblem()
   return mProblem;
 }
 
+/// This adds a hypothesis to run inference on. Each hypothesis gets its own
+/// clone of the world, which `initializer` gets to set up first. That's the
+/// place to pick a different initial guess for the masses, or a different
+/// subset of parameters to tune. Hypotheses are all optimized at the same time
+/// on a thread pool, and every round of inference reports the best fitting
+/// one. If there are no hypotheses, we optimize setProblem()'s problem on the
+/// original world instead. This should be called before start().
+void SSID::addHypothesis(
+    std::function<void(std::shared_ptr<simulation::World>)> initializer)
+{
+  Hypothesis hypothesis;
+  hypothesis.initializer = initializer;
+  hypothesis.loss = std::numeric_limits<double>::infinity();
+  mHypotheses.push_back(hypothesis);
+  // Let the pool get resized to fit the new number of hypotheses
+  mThreadPool = nullptr;
+}
+
+/// This sets the function that creates an optimizer for each hypothesis.
+/// Optimizers keep per-run state (like their intermediate callbacks), so
+/// hypotheses never share one. By default, each gets an SGD optimizer (see
+/// createDefaultHypothesisOptimizer()). Hypotheses whose optimizer can't run
+/// concurrently (see Optimizer::canOptimizeConcurrently()) take turns with each
+/// other, but never hold up anything outside this SSID. This should be called
+/// before start().
+void SSID::setHypothesisOptimizerFactory(
+    std::function<std::shared_ptr<trajectory::Optimizer>()> factory)
+{
+  mHypothesisOptimizerFactory = factory;
+  // Hypotheses that already have an optimizer get a new one next round
+  for (Hypothesis& hypothesis : mHypotheses)
+  {
+    hypothesis.optimizer = nullptr;
+  }
+}
+
+/// This sets the number of threads to run hypotheses on. If `numThreads` is <=
+/// 0 (the default), we use one thread per hardware core. We never use more
+/// threads than there are hypotheses. This should be called before start().
+void SSID::setNumThreads(int numThreads)
+{
+  mNumThreads = numThreads;
+  mThreadPool = nullptr;
+}
+
 /// This logs that the sensor output is a specific vector now
 void SSID::registerSensorsNow(Eigen::VectorXd sensors)
 {
-  return registerSensors(timeSinceEpochMillis(), sensors);
+  return registerSensors(monotonicNanos(), sensors);
 }
 
 /// This logs that the controls are a specific vector now
 void SSID::registerControlsNow(Eigen::VectorXd controls)
 {
-  return registerControls(timeSinceEpochMillis(), controls);
+  return registerControls(monotonicNanos(), controls);
 }
 
 /// This logs that the sensor output was a specific vector at a specific
@@ -137,10 +209,28 @@ void SSID::stop()
 /// This runs inference to find mutable values, starting at `startTime`
 void SSID::runInference(long startTime)
 {
-  long startComputeWallTime = timeSinceEpochMillis();
+  long startComputeWallTime = monotonicNanos();
+
+  long nanosPerStep = secondsToNanos(mWorld->getTimeStep());
+  int steps = ceil((double)mPlanningHistoryNanos / nanosPerStep);
+
+  Eigen::MatrixXd forceHistory = mControlLog.getValues(
+      startTime - mPlanningHistoryNanos, steps, nanosPerStep);
+  Eigen::MatrixXd sensorHistory = mSensorLog.getValues(
+      startTime - mPlanningHistoryNanos, steps, nanosPerStep);
+  Eigen::VectorXd startPos = mInitialPosEstimator(sensorHistory, startTime);
 
-  int millisPerStep = (mWorld->getTimeStep() * 1000);
-  int steps = ceil((double)mPlanningHistoryMillis / millisPerStep);
+  if (!mHypotheses.empty())
+  {
+    runHypotheses(
+        startTime,
+        startComputeWallTime,
+        steps,
+        forceHistory,
+        sensorHistory,
+        startPos);
+    return;
+  }
 
   if (!mProblem)
   {
@@ -152,8 +242,6 @@ void SSID::runInference(long startTime)
 
   // Every turn, we need to pin all the forces
 
-  Eigen::MatrixXd forceHistory = mControlLog.getValues(
-      startTime - mPlanningHistoryMillis, steps, millisPerStep);
   for (int i = 0; i < steps; i++)
   {
     mProblem->pinForce(i, forceHistory.col(i));
@@ -161,18 +249,16 @@ void SSID::runInference(long startTime)
 
   // We also need to set all the sensor history into metadata
 
-  Eigen::MatrixXd sensorHistory = mSensorLog.getValues(
-      startTime - mPlanningHistoryMillis, steps, millisPerStep);
   mProblem->setMetadata("forces", forceHistory);
   mProblem->setMetadata("sensors", sensorHistory);
 
-  mProblem->setStartPos(mInitialPosEstimator(sensorHistory, startTime));
+  mProblem->setStartPos(startPos);
 
   // Then actually run the optimization
 
   mSolution = mOptimizer->optimize(mProblem.get());
 
-  long computeDurationWallTime = timeSinceEpochMillis() - startComputeWallTime;
+  long computeDurationWallTime = monotonicNanos() - startComputeWallTime;
 
   const trajectory::TrajectoryRollout* cache
       = mProblem->getRolloutCache(mWorld);
@@ -187,6 +273,142 @@ void SSID::runInference(long startTime)
   }
 }
 
+/// This runs one round of inference on every hypothesis in parallel
+void SSID::runHypotheses(
+    long startTime,
+    long startComputeWallTime,
+    int steps,
+    const Eigen::MatrixXd& forceHistory,
+    const Eigen::MatrixXd& sensorHistory,
+    const Eigen::VectorXd& startPos)
+{
+  int numHypotheses = mHypotheses.size();
+
+  for (Hypothesis& hypothesis : mHypotheses)
+  {
+    if (!hypothesis.problem)
+    {
+      hypothesis.world = mWorld->clone();
+      // Clones inherit our finite difference threads, but the hypotheses
+      // already have the thread pool to themselves
+      hypothesis.world->setFiniteDifferenceThreads(1);
+      hypothesis.initializer(hypothesis.world);
+      // We use single shooting, so that optimizers that can't enforce
+      // multiple shooting's knot constraints (like SGD) still work here
+      hypothesis.problem = std::make_shared<SingleShot>(
+          hypothesis.world, *mLoss.get(), steps, true);
+    }
+    if (!hypothesis.optimizer)
+    {
+      hypothesis.optimizer = mHypothesisOptimizerFactory();
+    }
+
+    for (int i = 0; i < steps; i++)
+    {
+      hypothesis.problem->pinForce(i, forceHistory.col(i));
+    }
+    hypothesis.problem->setMetadata("forces", forceHistory);
+    hypothesis.problem->setMetadata("sensors", sensorHistory);
+    hypothesis.problem->setStartPos(startPos);
+  }
+
+  if (!mThreadPool)
+  {
+    int numThreads = mNumThreads > 0
+                         ? mNumThreads
+                         : (int)std::thread::hardware_concurrency();
+    if (numThreads <= 0 || numThreads > numHypotheses)
+      numThreads = numHypotheses;
+    mThreadPool = std::make_shared<common::ThreadPool>(numThreads);
+  }
+
+  // Workers append the index of each hypothesis to `finished` as it finishes,
+  // so we can report it straight away instead of waiting for the slowest one
+  std::mutex finishedMutex;
+  std::condition_variable finishedChanged;
+  std::vector<int> finished;
+  std::vector<std::exception_ptr> errors(numHypotheses);
+
+  // Hypotheses with optimizers that aren't safe to run concurrently (like
+  // IPOPT with MUMPS) take turns on this
+  std::mutex serialOptimizerMutex;
+
+  std::vector<std::future<void>> futures;
+  for (int i = 0; i < numHypotheses; i++)
+  {
+    futures.push_back(mThreadPool->submit([&, i](int /* worker */) {
+      Hypothesis& hypothesis = mHypotheses[i];
+      try
+      {
+        std::unique_lock<std::mutex> serialLock;
+        if (!hypothesis.optimizer->canOptimizeConcurrently())
+        {
+          serialLock = std::unique_lock<std::mutex>(serialOptimizerMutex);
+        }
+        hypothesis.solution
+            = hypothesis.optimizer->optimize(hypothesis.problem.get());
+        hypothesis.loss = hypothesis.problem->getLoss(hypothesis.world);
+      }
+      catch (...)
+      {
+        errors[i] = std::current_exception();
+      }
+      {
+        std::lock_guard<std::mutex> lock(finishedMutex);
+        finished.push_back(i);
+      }
+      finishedChanged.notify_one();
+    }));
+  }
+
+  double bestLoss = std::numeric_limits<double>::infinity();
+  int numReported = 0;
+  while (numReported < numHypotheses)
+  {
+    std::vector<int> newlyFinished;
+    {
+      std::unique_lock<std::mutex> lock(finishedMutex);
+      finishedChanged.wait(
+          lock, [&]() { return (int)finished.size() > numReported; });
+      newlyFinished.assign(finished.begin() + numReported, finished.end());
+    }
+    numReported += newlyFinished.size();
+
+    for (int i : newlyFinished)
+    {
+      Hypothesis& hypothesis = mHypotheses[i];
+      if (errors[i] || !(hypothesis.loss < bestLoss))
+        continue;
+      bestLoss = hypothesis.loss;
+
+      long computeDurationWallTime = monotonicNanos() - startComputeWallTime;
+
+      const trajectory::TrajectoryRollout* cache
+          = hypothesis.problem->getRolloutCache(hypothesis.world);
+
+      Eigen::VectorXd pos = cache->getPosesConst().col(steps - 1);
+      Eigen::VectorXd vel = cache->getVelsConst().col(steps - 1);
+      Eigen::VectorXd mass = hypothesis.world->getMasses();
+
+      mSolution = hypothesis.solution;
+      for (auto listener : mInferListeners)
+      {
+        listener(startTime, pos, vel, mass, computeDurationWallTime);
+      }
+    }
+  }
+
+  for (std::future<void>& future : futures)
+  {
+    future.get();
+  }
+  for (std::exception_ptr& error : errors)
+  {
+    if (error)
+      std::rethrow_exception(error);
+  }
+}
+
 /// This registers a listener to get called when we finish replanning
 void SSID::registerInferListener(
     std::function<
@@ -209,13 +431,13 @@ void SSID::optimizationThreadLoop()
 
   while (mRunning)
   {
-    long startTime = timeSinceEpochMillis();
-    if (mControlLog.availableHistoryBefore(startTime) > mPlanningHistoryMillis)
+    long startTime = monotonicNanos();
+    if (mControlLog.availableHistoryBefore(startTime) > mPlanningHistoryNanos)
     {
       std::cout << "Running inference" << std::endl;
       runInference(startTime);
     }
-    // long endTime = timeSinceEpochMillis();
+    // long endTime = monotonicNanos();
   }
 }
 
@@ -1,14 +1,20 @@
 #ifndef DART_REALTIME_SSID
 #define DART_REALTIME_SSID
 
+#include <functional>
 #include <memory>
 #include <thread>
+#include <vector>
 
 #include <Eigen/Dense>
 
 #include "dart/realtime/VectorLog.hpp"
 
 namespace dart {
+namespace common {
+class ThreadPool;
+}
+
 namespace simulation {
 class World;
 }
@@ -23,13 +29,16 @@ class Optimizer;
 namespace realtime {
 
 // SSID = System + State IDentification
+//
+// All times are in nanoseconds, and any `now` should come from
+// monotonicNanos().
 class SSID
 {
 public:
   SSID(
       std::shared_ptr<simulation::World> world,
       std::shared_ptr<trajectory::LossFn> loss,
-      int planningHistoryMillis,
+      long planningHistoryNanos,
       int sensorDim);
 
   /// This updates the loss function that we're going to move in real time to
@@ -58,6 +67,44 @@ public:
   /// This returns the current problem definition that MPC is using
   std::shared_ptr<trajectory::Problem> getProblem();
 
+  /// This adds a hypothesis to run inference on. Each hypothesis gets its own
+  /// clone of the world, which `initializer` gets to set up first. That's the
+  /// place to pick a different initial guess for the masses, or a different
+  /// subset of parameters to tune. Hypotheses are all optimized at the same
+  /// time on a thread pool, and every round of inference reports the best
+  /// fitting one. If there are no hypotheses, we optimize setProblem()'s
+  /// problem on the original world instead. This should be called before
+  /// start().
+  ///
+  /// Every hypothesis gets its own optimizer from
+  /// setHypothesisOptimizerFactory(), and its world is capped at one finite
+  /// difference thread, since the hypotheses already use up the thread pool.
+  /// Hypotheses are optimized with single shooting over the whole history.
+  void addHypothesis(
+      std::function<void(std::shared_ptr<simulation::World>)> initializer);
+
+  /// This sets the function that creates an optimizer for each hypothesis.
+  /// Optimizers keep per-run state (like their intermediate callbacks), so
+  /// hypotheses never share one. By default, each gets an SGD optimizer (see
+  /// createDefaultHypothesisOptimizer()). Hypotheses whose optimizer can't run
+  /// concurrently (see Optimizer::canOptimizeConcurrently()) take turns with
+  /// each other, but never hold up anything outside this SSID. This should be
+  /// called before start().
+  void setHypothesisOptimizerFactory(
+      std::function<std::shared_ptr<trajectory::Optimizer>()> factory);
+
+  /// This creates the default optimizer for each hypothesis. That's SGD rather
+  /// than IPOPT, because IPOPT's default linear solver (MUMPS) can't run on
+  /// several threads at once, which would leave the hypotheses taking turns.
+  static std::shared_ptr<trajectory::Optimizer>
+  createDefaultHypothesisOptimizer();
+
+  /// This sets the number of threads to run hypotheses on. If `numThreads` is
+  /// <= 0 (the default), we use one thread per hardware core. We never use
+  /// more threads than there are hypotheses. This should be called before
+  /// start().
+  void setNumThreads(int numThreads);
+
   /// This logs that the sensor output is a specific vector now
   void registerSensorsNow(Eigen::VectorXd sensors);
 
@@ -80,7 +127,14 @@ public:
   /// This runs inference to find mutable values, starting at `startTime`
   void runInference(long startTime);
 
-  /// This registers a listener to get called when we finish replanning
+  /// This registers a listener to get called when we finish inference. The
+  /// listener gets the time we inferred the state at, the state, and how many
+  /// nanos inference took.
+  ///
+  /// With several hypotheses, this gets called as soon as the first one
+  /// finishes, and then again every time a later one fits the sensor history
+  /// better than any we've reported so far this round. It's always called from
+  /// the thread running inference, never from the thread pool.
   void registerInferListener(
       std::function<
           void(long, Eigen::VectorXd, Eigen::VectorXd, Eigen::VectorXd, long)>
@@ -90,10 +144,32 @@ protected:
   /// This is the function for the optimization thread to run when we're live
   void optimizationThreadLoop();
 
+  /// This creates the default IPOPT optimizer for SSID
+  static std::shared_ptr<trajectory::Optimizer> createDefaultOptimizer();
+
+  struct Hypothesis
+  {
+    std::function<void(std::shared_ptr<simulation::World>)> initializer;
+    std::shared_ptr<simulation::World> world;
+    std::shared_ptr<trajectory::Optimizer> optimizer;
+    std::shared_ptr<trajectory::Problem> problem;
+    std::shared_ptr<trajectory::Solution> solution;
+    double loss;
+  };
+
+  /// This runs one round of inference on every hypothesis in parallel
+  void runHypotheses(
+      long startTime,
+      long startComputeWallTime,
+      int steps,
+      const Eigen::MatrixXd& forceHistory,
+      const Eigen::MatrixXd& sensorHistory,
+      const Eigen::VectorXd& startPos);
+
   bool mRunning;
   std::shared_ptr<simulation::World> mWorld;
   std::shared_ptr<trajectory::LossFn> mLoss;
-  int mPlanningHistoryMillis;
+  long mPlanningHistoryNanos;
   int mSensorDim;
   VectorLog mSensorLog;
   VectorLog mControlLog;
@@ -103,6 +179,12 @@ protected:
   std::shared_ptr<trajectory::Solution> mSolution;
   std::thread mOptimizationThread;
 
+  std::vector<Hypothesis> mHypotheses;
+  std::function<std::shared_ptr<trajectory::Optimizer>()>
+      mHypothesisOptimizerFactory;
+  int mNumThreads;
+  std::shared_ptr<common::ThreadPool> mThreadPool;
+
   // These are listeners that get called when we finish replanning
   std::vector<std::function<void(
       long, Eigen::VectorXd, Eigen::VectorXd, Eigen::VectorXd, long)> >
@@ -0,0 +1,67 @@
+#include "dart/realtime/SeqLock.hpp"
+
+#include <thread>
+
+namespace dart {
+namespace realtime {
+
+SeqLock::SeqLock() : mSequence(0L)
+{
+}
+
+/// Copies start out unlocked. This isn't thread safe, so only copy a lock that
+/// nobody is writing.
+SeqLock::SeqLock(const SeqLock& /* other */) : mSequence(0L)
+{
+}
+
+/// Like copying, this isn't thread safe, so it leaves the sequence alone
+SeqLock& SeqLock::operator=(const SeqLock& /* other */)
+{
+  return *this;
+}
+
+/// The writer calls this before it starts changing the protected data
+void SeqLock::beginWrite()
+{
+  mSequence.store(
+      mSequence.load(std::memory_order_relaxed) + 1,
+      std::memory_order_relaxed);
+  // This keeps the data writes from getting reordered before the sequence
+  // number goes odd
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+/// The writer calls this once it's done changing the protected data
+void SeqLock::endWrite()
+{
+  mSequence.store(
+      mSequence.load(std::memory_order_relaxed) + 1,
+      std::memory_order_release);
+}
+
+/// Readers call this before they read the protected data. This spins while a
+/// write is in progress, and returns a sequence number to pass to endRead().
+long SeqLock::beginRead() const
+{
+  long sequence = mSequence.load(std::memory_order_acquire);
+  while (sequence & 1)
+  {
+    std::this_thread::yield();
+    sequence = mSequence.load(std::memory_order_acquire);
+  }
+  return sequence;
+}
+
+/// Readers call this after they're done reading. This returns false if the
+/// data changed while we were reading it.
+bool SeqLock::endRead(long sequence) const
+{
+  // This keeps the data reads from getting reordered after we check the
+  // sequence number
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return mSequence.load(std::memory_order_relaxed) == sequence;
+}
+
+} // namespace realtime
+} // namespace dart
@@ -0,0 +1,62 @@
+#ifndef DART_REALTIME_SEQLOCK
+#define DART_REALTIME_SEQLOCK
+
+#include <atomic>
+
+namespace dart {
+namespace realtime {
+
+/// This is a sequence lock, which protects data that has exactly one writer
+/// and any number of readers, without ever making the writer wait.
+///
+/// The writer brackets every change with beginWrite() and endWrite(), which
+/// never block. Readers copy out what they need between beginRead() and
+/// endRead(), and if endRead() returns false the writer changed the data
+/// underneath them, so they throw away their copy and try again:
+///
+///   long seq;
+///   do
+///   {
+///     seq = lock.beginRead();
+///     // ... copy out the data ...
+///   } while (!lock.endRead(seq));
+///
+/// Since a reader can see the data half-written before it retries, readers
+/// must never act on what they've read until endRead() succeeds, and must
+/// keep their indexing in bounds even if the data is garbage.
+class SeqLock
+{
+public:
+  SeqLock();
+
+  /// Copies start out unlocked. This isn't thread safe, so only copy a lock
+  /// that nobody is writing.
+  SeqLock(const SeqLock& other);
+
+  /// Like copying, this isn't thread safe, so it leaves the sequence alone
+  SeqLock& operator=(const SeqLock& other);
+
+  /// The writer calls this before it starts changing the protected data
+  void beginWrite();
+
+  /// The writer calls this once it's done changing the protected data
+  void endWrite();
+
+  /// Readers call this before they read the protected data. This spins while
+  /// a write is in progress, and returns a sequence number to pass to
+  /// endRead().
+  long beginRead() const;
+
+  /// Readers call this after they're done reading. This returns false if the
+  /// data changed while we were reading it.
+  bool endRead(long sequence) const;
+
+protected:
+  /// This is odd while a write is in progress
+  std::atomic<long> mSequence;
+};
+
+} // namespace realtime
+} // namespace dart
+
+#endif
@@ -1,13 +1,41 @@
 #include "dart/realtime/Ticker.hpp"
 
-#include "dart/realtime/Millis.hpp"
+#include <chrono>
+
+#include <errno.h>
+#include <time.h>
+
+#include "dart/realtime/Nanos.hpp"
 
 namespace dart {
 namespace realtime {
 
+namespace {
+
+/// Only the ticking thread writes the stats, so this doesn't need a CAS loop
+void recordMax(std::atomic<long>& max, long value)
+{
+  if (value > max.load(std::memory_order_relaxed))
+    max.store(value, std::memory_order_relaxed);
+}
+
+} // namespace
+
 Ticker::Ticker(double secondsPerTick)
-  : mRunning(false), mSecondsPerTick(secondsPerTick)
+  : mRunning(false), mSecondsPerTick(secondsPerTick), mMainThread(nullptr)
 {
+  resetStats();
+}
+
+/// This copies the rate and the listeners, but not the running thread or the
+/// stats
+Ticker::Ticker(const Ticker& other)
+  : mRunning(false),
+    mSecondsPerTick(other.mSecondsPerTick),
+    mMainThread(nullptr),
+    mListeners(other.mListeners)
+{
+  resetStats();
 }
 
 Ticker::~Ticker()
@@ -30,6 +58,7 @@ void Ticker::start()
 {
   if (mRunning)
     return;
+  resetStats();
   mRunning = true;
   mMainThread = new std::thread(&Ticker::mainLoop, this);
 }
@@ -41,23 +70,87 @@ void Ticker::stop()
   mRunning = false;
   mMainThread->join();
   delete mMainThread;
+  mMainThread = nullptr;
+}
+
+/// This returns the timing statistics since start() or resetStats(). This is
+/// safe to call while the Ticker is running.
+TickerStats Ticker::getStats()
+{
+  TickerStats stats;
+  stats.numTicks = mNumTicks.load(std::memory_order_relaxed);
+  stats.numOverruns = mNumOverruns.load(std::memory_order_relaxed);
+  stats.numSkippedTicks = mNumSkippedTicks.load(std::memory_order_relaxed);
+  stats.worstOverrunNanos = mWorstOverrunNanos.load(std::memory_order_relaxed);
+  stats.worstWakeupLatencyNanos
+      = mWorstWakeupLatencyNanos.load(std::memory_order_relaxed);
+  return stats;
+}
+
+/// This zeros the timing statistics
+void Ticker::resetStats()
+{
+  mNumTicks = 0L;
+  mNumOverruns = 0L;
+  mNumSkippedTicks = 0L;
+  mWorstOverrunNanos = 0L;
+  mWorstWakeupLatencyNanos = 0L;
 }
 
 void Ticker::mainLoop()
 {
+  const long period = secondsToNanos(mSecondsPerTick);
+  long deadline = monotonicNanos();
+
   while (mRunning)
   {
-    int interval = (int)(mSecondsPerTick * 1000);
-    auto x = std::chrono::steady_clock::now()
-             + std::chrono::milliseconds(interval);
-    long millis = timeSinceEpochMillis();
+    long now = monotonicNanos();
+    if (now < deadline)
+    {
+      sleepUntil(deadline);
+      now = monotonicNanos();
+      recordMax(mWorstWakeupLatencyNanos, now - deadline);
+    }
 
-    for (auto listener : mListeners)
-      listener(millis);
+    for (auto& listener : mListeners)
+      listener(now);
+    mNumTicks.fetch_add(1L, std::memory_order_relaxed);
 
-    std::this_thread::sleep_until(x);
+    deadline += period;
+    long finished = monotonicNanos();
+    if (finished > deadline)
+    {
+      // This tick ran into the next one. We run the next tick right away, but
+      // drop any deadlines after it that have also already passed, rather than
+      // firing them all back to back.
+      long overrun = finished - deadline;
+      long skipped = overrun / period;
+      mNumOverruns.fetch_add(1L, std::memory_order_relaxed);
+      mNumSkippedTicks.fetch_add(skipped, std::memory_order_relaxed);
+      recordMax(mWorstOverrunNanos, overrun);
+      deadline += skipped * period;
+    }
+  }
+}
+
+/// This sleeps until `deadline`, an absolute time from monotonicNanos()
+void Ticker::sleepUntil(long deadline)
+{
+#ifdef __linux__
+  struct timespec until;
+  until.tv_sec = deadline / NANOS_PER_SECOND;
+  until.tv_nsec = deadline % NANOS_PER_SECOND;
+  // Because the deadline is absolute, going back to sleep after a signal
+  // wakes us up early doesn't push it back
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, nullptr)
+         == EINTR)
+  {
   }
+#else
+  std::this_thread::sleep_until(std::chrono::steady_clock::time_point(
+      std::chrono::nanoseconds(deadline)));
+#endif
 }
 
 } // namespace realtime
-} // namespace dart
\ No newline at end of file
+} // namespace dart
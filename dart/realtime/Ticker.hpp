@@ -1,6 +1,7 @@
 #ifndef DART_TICKER
 #define DART_TICKER
 
+#include <atomic>
 #include <functional>
 #include <thread>
 #include <vector>
@@ -8,10 +9,44 @@
 namespace dart {
 namespace realtime {
 
+/// These are the timing statistics a Ticker keeps about itself since start()
+/// (or the last resetStats()). All durations are in nanoseconds.
+struct TickerStats
+{
+  /// How many ticks we've called the listeners for
+  long numTicks;
+
+  /// How many ticks ran past the deadline of the tick after them
+  long numOverruns;
+
+  /// How many deadlines we skipped because an overrunning tick ran past them.
+  /// We don't try to catch up on these, because a burst of back-to-back ticks
+  /// is usually worse for a controller than a dropped one.
+  long numSkippedTicks;
+
+  /// The furthest past the next deadline that a tick has run
+  long worstOverrunNanos;
+
+  /// The latest we've ever woken up after a deadline. This is the scheduling
+  /// jitter of the machine, and doesn't count overruns.
+  long worstWakeupLatencyNanos;
+};
+
+/// This calls its listeners at a fixed rate, with the current monotonicNanos()
+/// as the argument.
+///
+/// Ticks are scheduled against absolute deadlines (start + k * period) rather
+/// than by sleeping for a period after each tick, so the time spent in the
+/// listeners and any wakeup latency don't accumulate into drift.
 class Ticker
 {
 public:
   Ticker(double secondsPerTick);
+
+  /// This copies the rate and the listeners, but not the running thread or
+  /// the stats
+  Ticker(const Ticker& other);
+
   ~Ticker();
   void registerTickListener(std::function<void(long)> listener);
   /// Remove all tick listeners, without deleting the Ticker
@@ -20,16 +55,35 @@ public:
   void start();
   void stop();
 
+  /// This returns the timing statistics since start() or resetStats(). This
+  /// is safe to call while the Ticker is running.
+  TickerStats getStats();
+
+  /// This zeros the timing statistics
+  void resetStats();
+
 protected:
   void mainLoop();
-  bool mRunning;
+
+  /// This sleeps until `deadline`, an absolute time from monotonicNanos()
+  static void sleepUntil(long deadline);
+
+  std::atomic<bool> mRunning;
 
   double mSecondsPerTick;
   std::thread* mMainThread;
   std::vector<std::function<void(long)>> mListeners;
+
+  // These are the TickerStats. They're written by the ticking thread, and may
+  // be read from any thread.
+  std::atomic<long> mNumTicks;
+  std::atomic<long> mNumOverruns;
+  std::atomic<long> mNumSkippedTicks;
+  std::atomic<long> mWorstOverrunNanos;
+  std::atomic<long> mWorstWakeupLatencyNanos;
 };
 
 } // namespace realtime
 } // namespace dart
 
-#endif
\ No newline at end of file
+#endif
@@ -3,88 +3,120 @@
 namespace dart {
 namespace realtime {
 
-VectorObservation::VectorObservation(long time, Eigen::VectorXd value)
-  : time(time), value(value)
+VectorLog::VectorLog(int dim, int capacity)
+  : mDim(dim),
+    mCapacity(capacity),
+    mTimes(capacity, 0L),
+    mValues(Eigen::MatrixXd::Zero(dim, capacity)),
+    mHead(0L),
+    mTail(0L)
 {
 }
 
-VectorLog::VectorLog(int dim) : mDim(dim), mStartTime(0L)
+/// This records `val` at `time`. Times should never go backwards, and if they
+/// do we drop the record.
+void VectorLog::record(long time, const Eigen::Ref<const Eigen::VectorXd>& val)
 {
-}
-
-void VectorLog::record(long time, Eigen::VectorXd val)
-{
-  if (mObservations.size() == 0)
-    mStartTime = time;
   assert(val.size() == mDim);
-  mObservations.emplace_back(time, val);
+  // An out of order record would have to be inserted into the middle of the
+  // ring, and it's stale anyway, so we just drop it
+  if (mHead > mTail && time < mTimes[(mHead - 1) % mCapacity])
+    return;
+
+  mLock.beginWrite();
+  long slot = mHead % mCapacity;
+  mTimes[slot] = time;
+  mValues.col(slot) = val;
+  mHead++;
+  if (mHead - mTail > mCapacity)
+    mTail = mHead - mCapacity;
+  mLock.endWrite();
 }
 
-Eigen::MatrixXd VectorLog::getValues(long start, int steps, long millisPerStep)
+/// This returns a (dim x steps) matrix, where column i is the most recent value
+/// recorded at or before `start + i * nanosPerStep`, or zeros if we don't have
+/// one.
+Eigen::MatrixXd VectorLog::getValues(long start, int steps, long nanosPerStep)
 {
   Eigen::MatrixXd observations = Eigen::MatrixXd::Zero(mDim, steps);
 
-  Eigen::VectorXd cursorValue = Eigen::VectorXd::Zero(mDim);
-  int cursorStep = 0;
-  for (const VectorObservation& obs : mObservations)
+  long seq;
+  do
   {
-    int step = ceil((double)(obs.time - start) / millisPerStep);
-    if (step > steps - 1)
-      break;
-    if (step >= cursorStep)
+    seq = mLock.beginRead();
+    long head = mHead;
+    long tail = mTail;
+
+    // This is the most recent record at or before the current step. It's
+    // (tail - 1) when there isn't one.
+    long cursor = firstIndexAfter(start, tail, head) - 1;
+    for (int step = 0; step < steps; step++)
     {
-      // Sweep the last cursor value forward to the current step
-      while (cursorStep < step)
+      long stepTime = start + step * nanosPerStep;
+      while (cursor + 1 < head && mTimes[(cursor + 1) % mCapacity] <= stepTime)
       {
-        observations.col(cursorStep) = cursorValue;
-        cursorStep++;
+        cursor++;
       }
-      // Set the current value to the current state
-      cursorValue = obs.value;
-      observations.col(step) = cursorValue;
-      assert(cursorStep == step);
+      if (cursor < tail)
+        observations.col(step).setZero();
+      else
+        observations.col(step) = mValues.col(cursor % mCapacity);
     }
-    else
-    {
-      cursorValue = obs.value;
-    }
-  }
-  // Sweep the last cursor value forward to the end of the block
-  while (cursorStep < steps)
-  {
-    observations.col(cursorStep) = cursorValue;
-    cursorStep++;
-  }
+  } while (!mLock.endRead(seq));
 
   return observations;
 }
 
+/// This returns how far back before `time` our oldest record goes
 long VectorLog::availableHistoryBefore(long time)
 {
-  return time - mStartTime;
+  long seq;
+  long history;
+  do
+  {
+    seq = mLock.beginRead();
+    if (mHead == mTail)
+      history = 0L;
+    else
+      history = time - mTimes[mTail % mCapacity];
+  } while (!mLock.endRead(seq));
+  return history;
 }
 
+/// This throws away every record before `time`
 void VectorLog::discardBefore(long time)
 {
-  int discardBeforeIndex = -1;
-  for (int i = mObservations.size() - 1; i >= 0; i--)
-  {
-    if (mObservations[i].time < time)
-    {
-      discardBeforeIndex = i;
-      break;
-    }
-  }
-  if (discardBeforeIndex == -1)
-    return;
+  // Times are integers, so the first record after (time - 1) is the first
+  // record at or after `time`
+  long newTail = firstIndexAfter(time - 1, mTail, mHead);
+
+  mLock.beginWrite();
+  mTail = newTail;
+  mLock.endWrite();
+}
 
-  std::vector<VectorObservation> newObservations;
-  for (int i = discardBeforeIndex + 1; i < mObservations.size(); i++)
+/// This returns the index of the first record in [tail, head) with a time
+/// after `time`, or `head` if there isn't one.
+long VectorLog::firstIndexAfter(long time, long tail, long head) const
+{
+  // If a reader calls this during a write, `tail` and `head` may not be
+  // consistent, so we clamp to the buffer size to keep every index we read in
+  // bounds. The reader will throw away the result anyway.
+  if (head - tail > mCapacity)
+    tail = head - mCapacity;
+
+  long low = tail;
+  long high = head;
+  while (low < high)
   {
-    newObservations.push_back(mObservations[i]);
+    long mid = low + (high - low) / 2;
+    if (mTimes[mid % mCapacity] <= time)
+      low = mid + 1;
+    else
+      high = mid;
   }
-  mObservations = newObservations;
+  return low;
 }
 
 } // namespace realtime
-} // namespace dart
\ No newline at end of file
+} // namespace dart
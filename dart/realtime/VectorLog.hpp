@@ -5,37 +5,62 @@
 
 #include <Eigen/Dense>
 
+#include "dart/realtime/SeqLock.hpp"
+
 namespace dart {
 namespace realtime {
 
-struct VectorObservation
-{
-  long time;
-  Eigen::VectorXd value;
-
-  VectorObservation(long time, Eigen::VectorXd value);
-};
-
+/// This is a log of timestamped vectors, like sensor readings, that can be
+/// resampled onto a fixed timestep.
+///
+/// It keeps the most recent `capacity` records in a ring buffer, allocated up
+/// front, so recording never allocates. Records are kept sorted by time, so
+/// queries binary search for where they start rather than scanning the whole
+/// log.
+///
+/// One thread may call record() and discardBefore(), while any number of
+/// other threads call getValues() and availableHistoryBefore(). Readers never
+/// block the writer.
 class VectorLog
 {
 public:
-  VectorLog(int dim);
+  VectorLog(int dim, int capacity = 10000);
 
-  void record(long time, Eigen::VectorXd val);
+  /// This records `val` at `time`. Times should never go backwards, and if
+  /// they do we drop the record.
+  void record(long time, const Eigen::Ref<const Eigen::VectorXd>& val);
 
-  Eigen::MatrixXd getValues(long start, int steps, long millisPerStep);
+  /// This returns a (dim x steps) matrix, where column i is the most recent
+  /// value recorded at or before `start + i * nanosPerStep`, or zeros if we
+  /// don't have one.
+  Eigen::MatrixXd getValues(long start, int steps, long nanosPerStep);
 
+  /// This throws away every record before `time`
   void discardBefore(long time);
 
+  /// This returns how far back before `time` our oldest record goes
   long availableHistoryBefore(long time);
 
 protected:
+  /// This returns the index of the first record in [tail, head) with a time
+  /// after `time`, or `head` if there isn't one.
+  long firstIndexAfter(long time, long tail, long head) const;
+
   int mDim;
-  long mStartTime;
-  std::vector<VectorObservation> mObservations;
+  int mCapacity;
+
+  /// These are the ring buffers. Record i lives in slot (i % mCapacity).
+  std::vector<long> mTimes;
+  Eigen::MatrixXd mValues;
+
+  /// The log holds records [mTail, mHead). These only ever increase.
+  long mHead;
+  long mTail;
+
+  SeqLock mLock;
 };
 
 } // namespace realtime
 } // namespace dart
 
-#endif
\ No newline at end of file
+#endif
@@ -51,6 +51,7 @@
 #include "dart/dynamics/DegreeOfFreedom.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/neural/ConstrainedGroupGradientMatrices.hpp"
+#include "dart/neural/FiniteDifferenceEngine.hpp"
 #include "dart/neural/WithRespectToMass.hpp"
 #include "dart/server/RawJsonUtils.hpp"
 
@@ -85,7 +86,8 @@ World::World(const std::string& _name)
     mPenetrationCorrectionEnabled(false),
     mWrtMass(std::make_shared<neural::WithRespectToMass>()),
     mUseFDOverride(false),
-    mSlowDebugResultsAgainstFD(false)
+    mSlowDebugResultsAgainstFD(false),
+    mFiniteDifferenceThreads(1)
 {
   mIndices.push_back(0);
 
@@ -121,6 +123,9 @@ WorldPtr World::clone() const
   // Copy the WithRespectToMass pointer, so we have the same object
   worldClone->mWrtMass = mWrtMass;
 
+  // The clone gets its own FiniteDifferenceEngine lazily, if it ever needs one
+  worldClone->mFiniteDifferenceThreads = mFiniteDifferenceThreads;
+
   auto cd = getConstraintSolver()->getCollisionDetector();
   worldClone->getConstraintSolver()->setCollisionDetector(
       cd->cloneWithoutCollisionObjects());
@@ -575,6 +580,41 @@ bool World::getSlowDebugResultsAgainstFD()
   return mSlowDebugResultsAgainstFD;
 }
 
+//==============================================================================
+/// This returns the engine we use to compute finite difference Jacobians
+/// through this world. It keeps a thread pool and a clone of this world per
+/// thread around between calls, and is created lazily on first use.
+std::shared_ptr<neural::FiniteDifferenceEngine>
+World::getFiniteDifferenceEngine()
+{
+  if (!mFiniteDifferenceEngine)
+  {
+    mFiniteDifferenceEngine = std::make_shared<neural::FiniteDifferenceEngine>(
+        mFiniteDifferenceThreads);
+  }
+  return mFiniteDifferenceEngine;
+}
+
+//==============================================================================
+/// This sets the number of threads (and clones of this world) that finite
+/// difference Jacobians get spread across. If this is <= 0, we use one
+/// thread per hardware core. Defaults to 1.
+void World::setFiniteDifferenceThreads(int numThreads)
+{
+  if (numThreads == mFiniteDifferenceThreads)
+    return;
+  mFiniteDifferenceThreads = numThreads;
+  // Drop the old engine (and its threads and clones). We'll make a new one
+  // with the right number of threads next time we need it.
+  mFiniteDifferenceEngine = nullptr;
+}
+
+//==============================================================================
+int World::getFiniteDifferenceThreads()
+{
+  return mFiniteDifferenceThreads;
+}
+
 //==============================================================================
 int World::getSimFrames() const
 {
@@ -1180,7 +1220,7 @@ Eigen::VectorXd World::getMassLowerLimits()
 }
 
 //==============================================================================
-void World::setPositions(Eigen::VectorXd position)
+void World::setPositions(const Eigen::Ref<const Eigen::VectorXd>& position)
 {
   std::size_t cursor = 0;
   for (std::size_t i = 0; i < mSkeletons.size(); i++)
@@ -1192,7 +1232,7 @@ void World::setPositions(Eigen::VectorXd position)
 }
 
 //==============================================================================
-void World::setVelocities(Eigen::VectorXd velocity)
+void World::setVelocities(const Eigen::Ref<const Eigen::VectorXd>& velocity)
 {
   std::size_t cursor = 0;
   for (std::size_t i = 0; i < mSkeletons.size(); i++)
@@ -1216,7 +1256,8 @@ void World::setAccelerations(Eigen::VectorXd accelerations)
 }
 
 //==============================================================================
-void World::setExternalForces(Eigen::VectorXd forces)
+void World::setExternalForces(
+    const Eigen::Ref<const Eigen::VectorXd>& forces)
 {
   std::size_t cursor = 0;
   for (std::size_t i = 0; i < mSkeletons.size(); i++)
@@ -78,6 +78,7 @@ class CollisionResult;
 
 namespace neural {
 class WithRespectToMass;
+class FiniteDifferenceEngine;
 }
 
 namespace simulation {
@@ -293,11 +294,11 @@ public:
 
   /// Sets the position of all the skeletons in the world from a single
   /// concatenated state vector
-  void setPositions(Eigen::VectorXd position);
+  void setPositions(const Eigen::Ref<const Eigen::VectorXd>& position);
 
   /// Sets the velocities of all the skeletons in the world from a single
   /// concatenated state vector
-  void setVelocities(Eigen::VectorXd velocity);
+  void setVelocities(const Eigen::Ref<const Eigen::VectorXd>& velocity);
 
   /// Sets the accelerations of all the skeletons in the world from a single
   /// concatenated state vector
@@ -305,7 +306,7 @@ public:
 
   /// Sets the forces of all the skeletons in the world from a single
   /// concatenated state vector
-  void setExternalForces(Eigen::VectorXd torques);
+  void setExternalForces(const Eigen::Ref<const Eigen::VectorXd>& torques);
 
   // Sets the upper limits of all the joints from a single vector
   void setExternalForceUpperLimits(Eigen::VectorXd limits);
@@ -510,6 +511,21 @@ public:
 
   bool getSlowDebugResultsAgainstFD();
 
+  /// This returns the engine we use to compute finite difference Jacobians
+  /// through this world. It keeps a thread pool and a clone of this world per
+  /// thread around between calls, and is created lazily on first use.
+  std::shared_ptr<neural::FiniteDifferenceEngine> getFiniteDifferenceEngine();
+
+  /// This sets the number of threads (and clones of this world) that finite
+  /// difference Jacobians get spread across. If this is <= 0, we use one
+  /// thread per hardware core. Defaults to 1, because Worlds are often cloned
+  /// into code that's already running in parallel (WorldBatch, MultiShot, SSID
+  /// hypotheses, etc), and a pool per clone would oversubscribe the machine.
+  /// Clones inherit this setting.
+  void setFiniteDifferenceThreads(int numThreads);
+
+  int getFiniteDifferenceThreads();
+
 protected:
   /// If this is true, we use finite-differencing to compute all of the
   /// requested Jacobians. This override can be useful to verify if there's a
@@ -619,6 +635,12 @@ protected:
 
   std::shared_ptr<neural::WithRespectToMass> mWrtMass;
 
+  /// The number of threads finite difference Jacobians get spread across
+  int mFiniteDifferenceThreads;
+
+  /// This is null until the first finite difference Jacobian asks for it
+  std::shared_ptr<neural::FiniteDifferenceEngine> mFiniteDifferenceEngine;
+
 public:
   //--------------------------------------------------------------------------
   // Slot registers
@@ -0,0 +1,218 @@
+#include "dart/simulation/WorldBatch.hpp"
+
+#include "dart/simulation/World.hpp"
+
+namespace dart {
+namespace simulation {
+
+//==============================================================================
+WorldBatch::WorldBatch(
+    std::shared_ptr<World> world, int batchSize, int numThreads)
+  : mBatchSize(batchSize),
+    mNumDofs(world->getNumDofs()),
+    mTime(world->getTime()),
+    mPool(std::make_unique<common::ThreadPool>(numThreads))
+{
+  // Before using Eigen in a multi-threaded environment, we need to explicitly
+  // call this (at least prior to Eigen 3.3)
+  Eigen::initParallel();
+
+  mPositions = Eigen::MatrixXd::Zero(mNumDofs, mBatchSize);
+  mVelocities = Eigen::MatrixXd::Zero(mNumDofs, mBatchSize);
+  mExternalForces = Eigen::MatrixXd::Zero(mNumDofs, mBatchSize);
+  mLCPCaches.resize(mBatchSize);
+
+  for (int i = 0; i < mPool->getNumThreads(); i++)
+  {
+    mWorkerWorlds.push_back(world->clone());
+  }
+
+  setAllFromWorld(world);
+}
+
+//==============================================================================
+/// Returns the number of independent worlds in this batch
+int WorldBatch::getBatchSize() const
+{
+  return mBatchSize;
+}
+
+//==============================================================================
+/// Returns the number of DOFs in each world in this batch
+int WorldBatch::getNumDofs() const
+{
+  return mNumDofs;
+}
+
+//==============================================================================
+/// Returns the number of worker threads (and cloned Worlds) we step with
+int WorldBatch::getNumThreads() const
+{
+  return mPool->getNumThreads();
+}
+
+//==============================================================================
+/// This copies the current state of `world` into every entry in the batch.
+void WorldBatch::setAllFromWorld(std::shared_ptr<World> world)
+{
+  assert((int)world->getNumDofs() == mNumDofs);
+  mPositions.colwise() = world->getPositions();
+  mVelocities.colwise() = world->getVelocities();
+  mExternalForces.colwise() = world->getExternalForces();
+  Eigen::VectorXd lcpCache = world->getCachedLCPSolution();
+  for (int i = 0; i < mBatchSize; i++)
+  {
+    mLCPCaches[i] = lcpCache;
+  }
+  mTime = world->getTime();
+}
+
+//==============================================================================
+/// This copies the state of a single batch entry into `world`
+void WorldBatch::copyToWorld(int index, std::shared_ptr<World> world) const
+{
+  assert(index >= 0 && index < mBatchSize);
+  loadEntry(index, world);
+  world->setTime(mTime);
+}
+
+//==============================================================================
+const Eigen::MatrixXd& WorldBatch::getPositions() const
+{
+  return mPositions;
+}
+
+//==============================================================================
+const Eigen::MatrixXd& WorldBatch::getVelocities() const
+{
+  return mVelocities;
+}
+
+//==============================================================================
+const Eigen::MatrixXd& WorldBatch::getExternalForces() const
+{
+  return mExternalForces;
+}
+
+//==============================================================================
+void WorldBatch::setPositions(const Eigen::MatrixXd& positions)
+{
+  assert(positions.rows() == mNumDofs && positions.cols() == mBatchSize);
+  mPositions = positions;
+}
+
+//==============================================================================
+void WorldBatch::setVelocities(const Eigen::MatrixXd& velocities)
+{
+  assert(velocities.rows() == mNumDofs && velocities.cols() == mBatchSize);
+  mVelocities = velocities;
+}
+
+//==============================================================================
+void WorldBatch::setExternalForces(const Eigen::MatrixXd& forces)
+{
+  assert(forces.rows() == mNumDofs && forces.cols() == mBatchSize);
+  mExternalForces = forces;
+}
+
+//==============================================================================
+Eigen::Ref<Eigen::MatrixXd> WorldBatch::positions()
+{
+  return mPositions;
+}
+
+//==============================================================================
+Eigen::Ref<Eigen::MatrixXd> WorldBatch::velocities()
+{
+  return mVelocities;
+}
+
+//==============================================================================
+Eigen::Ref<Eigen::MatrixXd> WorldBatch::externalForces()
+{
+  return mExternalForces;
+}
+
+//==============================================================================
+double WorldBatch::getTime() const
+{
+  return mTime;
+}
+
+//==============================================================================
+void WorldBatch::setTime(double time)
+{
+  mTime = time;
+}
+
+//==============================================================================
+/// Returns the timestep of the template World
+double WorldBatch::getTimeStep() const
+{
+  return mWorkerWorlds[0]->getTimeStep();
+}
+
+//==============================================================================
+/// This takes a single timestep on every world in the batch, in parallel.
+void WorldBatch::step(bool resetCommand)
+{
+  rollout(1, resetCommand);
+}
+
+//==============================================================================
+/// This takes `numSteps` timesteps on every world in the batch, holding the
+/// external forces constant.
+void WorldBatch::rollout(int numSteps, bool resetCommand)
+{
+  if (numSteps <= 0)
+    return;
+
+  parallelForEachEntry([&](int index, const std::shared_ptr<World>& world) {
+    for (int i = 0; i < numSteps; i++)
+    {
+      // World::step() clears forces when resetCommand is true, so we have to
+      // re-apply them every step to hold them constant across the rollout
+      world->setExternalForces(mExternalForces.col(index));
+      world->step(resetCommand);
+    }
+  });
+
+  mTime += numSteps * getTimeStep();
+}
+
+//==============================================================================
+/// This runs `fn(index, world)` for every entry in the batch, in parallel.
+void WorldBatch::parallelForEachEntry(
+    const std::function<void(int index, const std::shared_ptr<World>& world)>&
+        fn)
+{
+  mPool->parallelFor(mBatchSize, [&](int index, int worker) {
+    const std::shared_ptr<World>& world = mWorkerWorlds[worker];
+    loadEntry(index, world);
+    fn(index, world);
+    storeEntry(index, world);
+  });
+}
+
+//==============================================================================
+/// This copies the state of entry `index` into `world`
+void WorldBatch::loadEntry(int index, const std::shared_ptr<World>& world) const
+{
+  world->setPositions(mPositions.col(index));
+  world->setVelocities(mVelocities.col(index));
+  world->setExternalForces(mExternalForces.col(index));
+  world->setCachedLCPSolution(mLCPCaches[index]);
+}
+
+//==============================================================================
+/// This copies the state of `world` back into entry `index`
+void WorldBatch::storeEntry(int index, const std::shared_ptr<World>& world)
+{
+  mPositions.col(index) = world->getPositions();
+  mVelocities.col(index) = world->getVelocities();
+  mExternalForces.col(index) = world->getExternalForces();
+  mLCPCaches[index] = world->getCachedLCPSolution();
+}
+
+} // namespace simulation
+} // namespace dart
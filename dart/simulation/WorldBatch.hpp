@@ -0,0 +1,141 @@
+#ifndef DART_SIMULATION_WORLD_BATCH_HPP_
+#define DART_SIMULATION_WORLD_BATCH_HPP_
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/common/ThreadPool.hpp"
+#include "dart/simulation/SmartPointer.hpp"
+
+namespace dart {
+namespace simulation {
+
+/// This holds the state of N independent copies of a single template World,
+/// and steps all of them at once across a thread pool. This is meant for
+/// workloads like RL and sampling-based MPC, where we want thousands of
+/// rollouts of the same robot per iteration.
+///
+/// State is kept in structure-of-arrays form: each of positions, velocities
+/// and forces is a single (numDofs x batchSize) matrix, with one column per
+/// batch entry. We don't keep a World per batch entry. Instead, we clone the
+/// template World once per worker thread, and each worker loads a column of
+/// state into its World, steps it, and writes the result back. That means the
+/// number of Skeleton graphs we keep around scales with the number of cores,
+/// not the number of rollouts.
+class WorldBatch
+{
+public:
+  /// This creates a batch of `batchSize` copies of `world`'s current state.
+  /// If `numThreads` is <= 0, we use one thread per hardware core.
+  WorldBatch(
+      std::shared_ptr<World> world, int batchSize, int numThreads = 0);
+
+  /// Returns the number of independent worlds in this batch
+  int getBatchSize() const;
+
+  /// Returns the number of DOFs in each world in this batch
+  int getNumDofs() const;
+
+  /// Returns the number of worker threads (and cloned Worlds) we step with
+  int getNumThreads() const;
+
+  /// This copies the current state of `world` into every entry in the batch.
+  /// `world` must have the same structure as the template World.
+  void setAllFromWorld(std::shared_ptr<World> world);
+
+  /// This copies the state of a single batch entry into `world`
+  void copyToWorld(int index, std::shared_ptr<World> world) const;
+
+  /// Returns the positions of the whole batch, one column per world
+  const Eigen::MatrixXd& getPositions() const;
+
+  /// Returns the velocities of the whole batch, one column per world
+  const Eigen::MatrixXd& getVelocities() const;
+
+  /// Returns the external forces of the whole batch, one column per world
+  const Eigen::MatrixXd& getExternalForces() const;
+
+  /// Sets the positions of the whole batch, one column per world
+  void setPositions(const Eigen::MatrixXd& positions);
+
+  /// Sets the velocities of the whole batch, one column per world
+  void setVelocities(const Eigen::MatrixXd& velocities);
+
+  /// Sets the external forces of the whole batch, one column per world
+  void setExternalForces(const Eigen::MatrixXd& forces);
+
+  /// This gives direct mutable access to the positions matrix, for callers
+  /// that want to fill it in place
+  Eigen::Ref<Eigen::MatrixXd> positions();
+
+  /// This gives direct mutable access to the velocities matrix, for callers
+  /// that want to fill it in place
+  Eigen::Ref<Eigen::MatrixXd> velocities();
+
+  /// This gives direct mutable access to the external forces matrix, for
+  /// callers that want to fill it in place
+  Eigen::Ref<Eigen::MatrixXd> externalForces();
+
+  /// Returns the simulation time shared by every entry in the batch
+  double getTime() const;
+
+  /// Sets the simulation time shared by every entry in the batch
+  void setTime(double time);
+
+  /// Returns the timestep of the template World
+  double getTimeStep() const;
+
+  /// This takes a single timestep on every world in the batch, in parallel.
+  /// \param[in] resetCommand True if you want to reset to zero the external
+  /// forces after the simulation step, same as World::step()
+  void step(bool resetCommand = true);
+
+  /// This takes `numSteps` timesteps on every world in the batch, holding the
+  /// external forces constant. Each worker runs all the steps for a batch
+  /// entry back to back, so this is cheaper than calling step() in a loop.
+  void rollout(int numSteps, bool resetCommand = true);
+
+  /// This runs `fn(index, world)` for every entry in the batch, in parallel.
+  /// `world` is the calling worker's cloned World, already loaded with the
+  /// state of entry `index`. Once `fn` returns, whatever state it left in
+  /// `world` is copied back into the batch. This is the building block for
+  /// anything that wants to do more per entry than a plain step(), like
+  /// recording BackpropSnapshots.
+  void parallelForEachEntry(
+      const std::function<void(int index, const std::shared_ptr<World>& world)>&
+          fn);
+
+protected:
+  /// This copies the state of entry `index` into `world`
+  void loadEntry(int index, const std::shared_ptr<World>& world) const;
+
+  /// This copies the state of `world` back into entry `index`
+  void storeEntry(int index, const std::shared_ptr<World>& world);
+
+  int mBatchSize;
+  int mNumDofs;
+  double mTime;
+
+  Eigen::MatrixXd mPositions;
+  Eigen::MatrixXd mVelocities;
+  Eigen::MatrixXd mExternalForces;
+
+  /// The LCP solver warm starts from the previous step's solution, so we
+  /// have to keep one cache per batch entry to match what an individual World
+  /// would compute. These vary in length step to step, so they can't live in a
+  /// single matrix.
+  std::vector<Eigen::VectorXd> mLCPCaches;
+
+  /// One clone of the template World per worker thread
+  std::vector<std::shared_ptr<World>> mWorkerWorlds;
+
+  std::unique_ptr<common::ThreadPool> mPool;
+};
+
+} // namespace simulation
+} // namespace dart
+
+#endif
@@ -33,7 +33,8 @@ IPOptOptimizer::IPOptOptimizer()
     mSuppressOutput(false),
     mSilenceOutput(false),
     mDisableLinesearch(false),
-    mRecordIterations(true)
+    mRecordIterations(true),
+    mLinearSolver("mumps")
 {
 }
 
@@ -51,9 +52,8 @@ std::shared_ptr<Solution> IPOptOptimizer::optimize(
   // Note: The following choices are only examples, they might not be
   //       suitable for your optimization problem.
   app->Options()->SetNumericValue("tol", mTolerance);
-  app->Options()->SetStringValue(
-      "linear_solver",
-      "mumps"); // ma27, ma55, ma77, ma86, ma97, parsido, wsmp, mumps, custom
+  // ma27, ma55, ma77, ma86, ma97, parsido, wsmp, mumps, custom
+  app->Options()->SetStringValue("linear_solver", mLinearSolver);
 
   app->Options()->SetStringValue(
       "hessian_approximation", "limited-memory"); // limited-memory, exacty
@@ -225,5 +225,17 @@ void IPOptOptimizer::setRecordIterations(bool recordIterations)
   mRecordIterations = recordIterations;
 }
 
+//==============================================================================
+void IPOptOptimizer::setLinearSolver(const std::string& linearSolver)
+{
+  mLinearSolver = linearSolver;
+}
+
+//==============================================================================
+bool IPOptOptimizer::canOptimizeConcurrently() const
+{
+  return mLinearSolver != "mumps";
+}
+
 } // namespace trajectory
 } // namespace dart
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include <functional>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include <Eigen/Dense>
@@ -61,6 +62,16 @@ public:
 
   void setRecordIterations(bool recordIterations);
 
+  /// This sets the linear solver IPOPT uses. Defaults to "mumps". MUMPS keeps
+  /// global state, so it isn't safe to have several MUMPS solves running at
+  /// once (see canOptimizeConcurrently()). If your IPOPT build has a linear
+  /// solver that's safe to run concurrently, picking it here lets several
+  /// IPOptOptimizers solve at once.
+  void setLinearSolver(const std::string& linearSolver);
+
+  // Documentation inherited
+  bool canOptimizeConcurrently() const override;
+
 protected:
   int mIterationLimit;
   double mTolerance;
@@ -74,6 +85,7 @@ protected:
   bool mSilenceOutput;
   bool mDisableLinesearch;
   bool mRecordIterations;
+  std::string mLinearSolver;
 };
 
 } // namespace trajectory
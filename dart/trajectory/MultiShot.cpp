@@ -1,6 +1,5 @@
 #include "dart/trajectory/MultiShot.hpp"
 
-#include <future>
 #include <vector>
 
 #include "dart/dynamics/Skeleton.hpp"
@@ -224,23 +223,19 @@ void MultiShot::computeConstraints(
 
   if (mParallelOperationsEnabled)
   {
-    std::vector<std::future<void>> futures;
-    for (int i = 1; i < mShots.size(); i++)
-    {
-      futures.push_back(std::async(
-          &MultiShot::asyncPartComputeConstraints,
-          this,
-          i,
-          mParallelWorlds[i],
-          constraints,
-          cursor,
-          thisLog));
-      cursor += getRepresentationStateSize();
-    }
-    for (int i = 0; i < futures.size(); i++)
-    {
-      futures[i].wait();
-    }
+    int stateDim = getRepresentationStateSize();
+    // Shot i writes the knot point constraint between shots i-1 and i
+    getThreadPool()->parallelForWithAffinity(
+        mShots.size() - 1, [&](int index, int /* worker */) {
+          int i = index + 1;
+          asyncPartComputeConstraints(
+              i,
+              mParallelWorlds[i],
+              constraints,
+              cursor + index * stateDim,
+              thisLog);
+        });
+    cursor += ((int)mShots.size() - 1) * stateDim;
   }
   else
   {
@@ -554,23 +549,29 @@ void MultiShot::backpropJacobian(
   int stateDim = getRepresentationStateSize();
   if (mParallelOperationsEnabled)
   {
-    std::vector<std::future<void>> futures;
+    // Work out where every shot writes before fanning out, so the workers
+    // don't depend on each other
+    std::vector<int> rowCursors;
+    std::vector<int> colCursors;
     for (int i = 1; i < mShots.size(); i++)
     {
-      int dynamicDim = mShots[i - 1]->getFlatDynamicProblemDim(world);
-      futures.push_back(std::async(
-          &MultiShot::asyncPartBackpropJacobian,
-          this,
-          i,
-          mParallelWorlds[i],
-          jacStatic,
-          jacDynamic,
-          rowCursor,
-          colCursor,
-          thisLog));
-      colCursor += dynamicDim;
+      rowCursors.push_back(rowCursor);
+      colCursors.push_back(colCursor);
+      colCursor += mShots[i - 1]->getFlatDynamicProblemDim(world);
       rowCursor += stateDim;
     }
+    getThreadPool()->parallelForWithAffinity(
+        mShots.size() - 1, [&](int index, int /* worker */) {
+          int i = index + 1;
+          asyncPartBackpropJacobian(
+              i,
+              mParallelWorlds[i],
+              jacStatic,
+              jacDynamic,
+              rowCursors[index],
+              colCursors[index],
+              thisLog);
+        });
   }
   else
   {
@@ -809,30 +810,31 @@ void MultiShot::getSparseJacobian(
 
   if (mParallelOperationsEnabled)
   {
-    std::vector<std::future<void>> futures;
+    std::vector<int> cursorsStatic;
+    std::vector<int> cursorsDynamic;
     for (int i = 1; i < mShots.size(); i++)
     {
       int dimStatic = mShots[i - 1]->getFlatStaticProblemDim(world);
       int dimDynamic = mShots[i - 1]->getFlatDynamicProblemDim(world);
 
-      futures.push_back(std::async(
-          &MultiShot::asyncPartGetSparseJacobian,
-          this,
-          i,
-          mParallelWorlds[i],
-          sparseStatic,
-          sparseDynamic,
-          cursorStatic,
-          cursorDynamic,
-          thisLog));
+      cursorsStatic.push_back(cursorStatic);
+      cursorsDynamic.push_back(cursorDynamic);
 
       cursorDynamic += (dimDynamic + 1) * stateDim;
       cursorStatic += dimStatic * stateDim;
     }
-    for (int i = 0; i < futures.size(); i++)
-    {
-      futures[i].wait();
-    }
+    getThreadPool()->parallelForWithAffinity(
+        mShots.size() - 1, [&](int index, int /* worker */) {
+          int i = index + 1;
+          asyncPartGetSparseJacobian(
+              i,
+              mParallelWorlds[i],
+              sparseStatic,
+              sparseDynamic,
+              cursorsStatic[index],
+              cursorsDynamic[index],
+              thisLog);
+        });
   }
   else
   {
@@ -972,25 +974,22 @@ void MultiShot::getStates(
   {
     if (mParallelOperationsEnabled)
     {
-      std::vector<std::future<void>> futures;
+      std::vector<int> cursors;
       for (int i = 0; i < mShots.size(); i++)
       {
-        int steps = mShots[i]->getNumSteps();
-        futures.push_back(std::async(
-            &MultiShot::asyncPartGetStates,
-            this,
-            i,
-            mParallelWorlds[i],
-            rollout,
-            cursor,
-            steps,
-            thisLog));
-        cursor += steps;
-      }
-      for (int i = 0; i < futures.size(); i++)
-      {
-        futures[i].wait();
+        cursors.push_back(cursor);
+        cursor += mShots[i]->getNumSteps();
       }
+      getThreadPool()->parallelForWithAffinity(
+          mShots.size(), [&](int i, int /* worker */) {
+            asyncPartGetStates(
+                i,
+                mParallelWorlds[i],
+                rollout,
+                cursors[i],
+                mShots[i]->getNumSteps(),
+                thisLog);
+          });
     }
     else
     {
@@ -1119,6 +1118,9 @@ Eigen::VectorXi MultiShot::advanceSteps(
   RestorableSnapshot snapshot(world);
 
   const TrajectoryRollout* rollout = getRolloutCache(world);
+  // Copy these out, because advancing the shots invalidates the cache
+  Eigen::MatrixXd oldWorldForces = rollout->getForcesConst();
+  Eigen::MatrixXd oldForces = rollout->getForcesConst(mRepresentationMapping);
 
   int cursor = 0;
   for (int i = 0; i < mShots.size(); i++)
@@ -1141,9 +1143,9 @@ Eigen::VectorXi MultiShot::advanceSteps(
       for (int j = 0; j < steps; j++)
       {
         int t = cursor + j;
-        if (t < rollout->getForcesConst().cols())
+        if (t < oldWorldForces.cols())
         {
-          world->setExternalForces(rollout->getForcesConst().col(t));
+          world->setExternalForces(oldWorldForces.col(t));
         }
         else
         {
@@ -1159,6 +1161,18 @@ Eigen::VectorXi MultiShot::advanceSteps(
   }
   snapshot.restore();
 
+  // Each shot only shifted its own forces, which leaves a gap of 0s at the end
+  // of every shot. Shift the whole trajectory instead, so every shot starts
+  // with the forces that used to follow it.
+  Eigen::MatrixXd newForces
+      = Eigen::MatrixXd::Zero(oldForces.rows(), oldForces.cols());
+  if (steps < oldForces.cols())
+  {
+    newForces.leftCols(oldForces.cols() - steps)
+        = oldForces.rightCols(oldForces.cols() - steps);
+  }
+  setForcesRaw(newForces);
+
   return mapping;
 }
 
@@ -1286,31 +1300,33 @@ void MultiShot::backpropGradientWrt(
   int cursorSteps = 0;
   if (mParallelOperationsEnabled)
   {
-    std::vector<std::future<void>> futures;
     Eigen::VectorXd gradStaticScratch
         = Eigen::VectorXd::Zero(gradStatic.size() * mShots.size());
+    std::vector<int> cursorsDynamicDims;
+    std::vector<int> cursorsSteps;
     for (int i = 0; i < mShots.size(); i++)
     {
-      int steps = mShots[i]->getNumSteps();
-      int dynamicDim = mShots[i]->getFlatDynamicProblemDim(world);
-      futures.push_back(std::async(
-          &MultiShot::asyncPartBackpropGradientWrt,
-          this,
-          i,
-          mParallelWorlds[i],
-          gradWrtRollout,
-          gradStaticScratch.segment(i * gradStatic.size(), gradStatic.size()),
-          gradDynamic,
-          cursorDynamicDims,
-          cursorSteps,
-          thisLog));
-      cursorSteps += steps;
-      cursorDynamicDims += dynamicDim;
+      cursorsDynamicDims.push_back(cursorDynamicDims);
+      cursorsSteps.push_back(cursorSteps);
+      cursorSteps += mShots[i]->getNumSteps();
+      cursorDynamicDims += mShots[i]->getFlatDynamicProblemDim(world);
     }
+    getThreadPool()->parallelForWithAffinity(
+        mShots.size(), [&](int i, int /* worker */) {
+          asyncPartBackpropGradientWrt(
+              i,
+              mParallelWorlds[i],
+              gradWrtRollout,
+              gradStaticScratch.segment(
+                  i * gradStatic.size(), gradStatic.size()),
+              gradDynamic,
+              cursorsDynamicDims[i],
+              cursorsSteps[i],
+              thisLog);
+        });
     gradStatic.setZero();
-    for (int i = 0; i < futures.size(); i++)
+    for (int i = 0; i < mShots.size(); i++)
     {
-      futures[i].wait();
       gradStatic += gradStaticScratch.segment(
           i * gradStatic.size(), gradStatic.size());
     }
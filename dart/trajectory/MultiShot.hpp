@@ -37,6 +37,10 @@ public:
   /// If TRUE, this will use multiple independent threads to compute each
   /// SingleShot's values internally. Currently defaults to FALSE. This should
   /// be considered EXPERIMENTAL! Expect bugs.
+  ///
+  /// Shots are run on the Problem's persistent thread pool (see
+  /// Problem::setNumThreads()), and each shot always prefers the same worker,
+  /// so its World stays warm in that worker's cache between calls.
   void setParallelOperationsEnabled(bool enabled);
 
   /// This sets the mapping we're using to store the representation of the Shot.
@@ -11,5 +11,11 @@ void Optimizer::registerIntermediateCallback(
   mIntermediateCallbacks.push_back(callback);
 }
 
+//==============================================================================
+bool Optimizer::canOptimizeConcurrently() const
+{
+  return true;
+}
+
 } // namespace trajectory
 } // namespace dart
\ No newline at end of file
@@ -22,11 +22,19 @@ public:
 
   /// This registers an intermediate callback, to get called by IPOPT after each
   /// step of optimization. If any callback returns false on a given step, then
-  /// the optimizer will terminate early.
+  /// the optimizer will terminate early. The iteration number is the number of
+  /// steps taken so far, so iteration 0 (if it's reported at all) is always the
+  /// unmodified starting point.
   void registerIntermediateCallback(
       std::function<bool(Problem* problem, int, double primal, double dual)>
           callback);
 
+  /// This returns true if it's safe to run this optimizer at the same time as
+  /// other optimizers of the same kind, on other threads (each with its own
+  /// optimizer and problem). Callers that fan optimizations out across threads
+  /// should take turns running any optimizer that returns false.
+  virtual bool canOptimizeConcurrently() const;
+
 protected:
   std::vector<
       std::function<bool(Problem* problem, int, double primal, double dual)>>
@@ -1,5 +1,6 @@
 #include "dart/trajectory/Problem.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 #include <coin/IpIpoptApplication.hpp>
@@ -24,7 +25,8 @@ Problem::Problem(
     mLoss(loss),
     mSteps(steps),
     mRolloutCacheDirty(true),
-    mExploreAlternateStrategies(false)
+    mExploreAlternateStrategies(false),
+    mNumThreads(0)
 {
   std::shared_ptr<neural::Mapping> identityMapping
       = std::make_shared<neural::IdentityMapping>(world);
@@ -83,6 +85,41 @@ bool Problem::getExploreAlternateStrategies()
   return mExploreAlternateStrategies;
 }
 
+//==============================================================================
+/// This sets the number of worker threads used by Problems that split their
+/// work up in parallel (like MultiShot, when parallel operations are
+/// enabled). If `numThreads` is <= 0, we use one thread per hardware core.
+void Problem::setNumThreads(int numThreads)
+{
+  mNumThreads = numThreads;
+  // The pool is re-created lazily at the new size on the next parallel call
+  mThreadPool = nullptr;
+}
+
+//==============================================================================
+/// This returns the number of worker threads we'll use for parallel
+/// operations
+int Problem::getNumThreads() const
+{
+  if (mThreadPool)
+    return mThreadPool->getNumThreads();
+  if (mNumThreads <= 0)
+    return std::max(1u, std::thread::hardware_concurrency());
+  return mNumThreads;
+}
+
+//==============================================================================
+/// This returns the persistent pool of worker threads for parallel
+/// operations, creating it on first use.
+common::ThreadPool* Problem::getThreadPool()
+{
+  if (!mThreadPool)
+  {
+    mThreadPool = std::make_shared<common::ThreadPool>(mNumThreads);
+  }
+  return mThreadPool.get();
+}
+
 //==============================================================================
 /// This sets the mapping we're using to store the representation of the Shot.
 /// WARNING: THIS IS A POTENTIALLY DESTRUCTIVE OPERATION! This will rewrite
@@ -1155,36 +1192,37 @@ int Problem::getNumberNonZeroJacobian(std::shared_ptr<simulation::World> world)
 //==============================================================================
 /// This computes finite difference Jacobians analagous to backpropJacobians()
 void Problem::finiteDifferenceJacobian(
-    std::shared_ptr<simulation::World> world, Eigen::Ref<Eigen::MatrixXd> jac)
+    std::shared_ptr<simulation::World> world,
+    Eigen::Ref<Eigen::MatrixXd> jac,
+    neural::FiniteDifferenceScheme scheme,
+    double eps)
 {
   int dim = getFlatProblemDim(world);
   int numConstraints = getConstraintDim();
   assert(jac.cols() == dim);
   assert(jac.rows() == numConstraints);
 
-  Eigen::VectorXd originalConstraints = Eigen::VectorXd::Zero(numConstraints);
-  computeConstraints(world, originalConstraints, nullptr);
   Eigen::VectorXd flat = Eigen::VectorXd::Zero(dim);
   flatten(world, flat, nullptr);
 
-  const double EPS = 1e-7;
-
-  Eigen::VectorXd positiveConstraints = Eigen::VectorXd::Zero(numConstraints);
-  Eigen::VectorXd negativeConstraints = Eigen::VectorXd::Zero(numConstraints);
-  for (int i = 0; i < dim; i++)
-  {
-    flat(i) += EPS;
-    unflatten(world, flat, nullptr);
-    computeConstraints(world, positiveConstraints, nullptr);
-    flat(i) -= EPS;
-
-    flat(i) -= EPS;
-    unflatten(world, flat, nullptr);
-    computeConstraints(world, negativeConstraints, nullptr);
-    flat(i) += EPS;
-
-    jac.col(i) = (positiveConstraints - negativeConstraints) / (2 * EPS);
-  }
+  // A Problem keeps its rollout in member caches, and computeConstraints()
+  // reads and writes the World we pass it, so columns can't be evaluated
+  // concurrently here. We still go through the engine (on a single thread) to
+  // share its FD schemes.
+  neural::FiniteDifferenceEngine engine(1);
+  jac = engine.jacobian(
+      dim,
+      numConstraints,
+      [&](int /* worker */, int column, double step, Eigen::VectorXd& out) {
+        Eigen::VectorXd perturbed = flat;
+        perturbed(column) += step;
+        unflatten(world, perturbed, nullptr);
+        out = Eigen::VectorXd::Zero(numConstraints);
+        computeConstraints(world, out, nullptr);
+        return true;
+      },
+      scheme,
+      eps);
 
   // Reset to original state
   unflatten(world, flat, nullptr);
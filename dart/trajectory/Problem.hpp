@@ -7,6 +7,8 @@
 
 #include <Eigen/Dense>
 
+#include "dart/common/ThreadPool.hpp"
+#include "dart/neural/FiniteDifferenceEngine.hpp"
 #include "dart/neural/MappedBackpropSnapshot.hpp"
 #include "dart/neural/Mapping.hpp"
 #include "dart/neural/WithRespectToMass.hpp"
@@ -62,6 +64,17 @@ public:
   /// contact strategies, other than the ones that are technically "correct".
   bool getExploreAlternateStrategies();
 
+  /// This sets the number of worker threads used by Problems that split their
+  /// work up in parallel (like MultiShot, when parallel operations are
+  /// enabled). This is independent of the number of shots: shots are spread
+  /// over however many threads there are. If `numThreads` is <= 0, we use one
+  /// thread per hardware core.
+  void setNumThreads(int numThreads);
+
+  /// This returns the number of worker threads we'll use for parallel
+  /// operations
+  int getNumThreads() const;
+
   /// This returns the whole map for metadata
   std::unordered_map<std::string, Eigen::MatrixXd>& getMetadataMap();
 
@@ -321,9 +334,13 @@ public:
   //////////////////////////////////////////////////////////////////////////////
 
   /// This computes finite difference Jacobians analagous to backpropJacobians()
+  /// using `scheme`. `eps` is the step size, or the starting step size for
+  /// Ridders.
   void finiteDifferenceJacobian(
       std::shared_ptr<simulation::World> world,
-      Eigen::Ref<Eigen::MatrixXd> jac);
+      Eigen::Ref<Eigen::MatrixXd> jac,
+      neural::FiniteDifferenceScheme scheme = neural::FD_CENTRAL,
+      double eps = 1e-7);
 
   /// This computes finite difference Jacobians analagous to
   /// backpropGradient()
@@ -458,6 +475,11 @@ protected:
       PerformanceLog* log = nullptr)
       = 0;
 
+  /// This returns the persistent pool of worker threads for parallel
+  /// operations, creating it on first use. The workers live as long as this
+  /// Problem does (or until setNumThreads() is called again).
+  common::ThreadPool* getThreadPool();
+
 protected:
   std::shared_ptr<simulation::World> mWorld;
   LossFn mLoss;
@@ -471,6 +493,8 @@ protected:
   std::shared_ptr<TrajectoryRolloutReal> mRolloutCache;
   std::shared_ptr<TrajectoryRolloutReal> mGradWrtRolloutCache;
   std::unordered_map<std::string, Eigen::MatrixXd> mMetadata;
+  int mNumThreads;
+  std::shared_ptr<common::ThreadPool> mThreadPool;
 };
 
 } // namespace trajectory
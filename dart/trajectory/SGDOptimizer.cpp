@@ -13,7 +13,10 @@ namespace trajectory {
 
 //==============================================================================
 SGDOptimizer::SGDOptimizer()
-  : mIterationLimit(100), mTolerance(0), mLearningRate(1e-2)
+  : mIterationLimit(100),
+    mTolerance(0),
+    mLearningRate(1e-2),
+    mSuppressOutput(false)
 {
 }
 
@@ -36,19 +39,31 @@ std::shared_ptr<Solution> SGDOptimizer::optimize(
     double improvement = loss - newLoss;
     if (improvement > 0 && improvement < mTolerance)
     {
-      std::cout << "Improvement less than tolerance, converged." << std::endl;
+      if (!mSuppressOutput)
+        std::cout << "Improvement less than tolerance, converged." << std::endl;
       break;
     }
     loss = newLoss;
-    std::cout << "Iter " << i << ": " << newLoss << std::endl;
+    if (!mSuppressOutput)
+      std::cout << "Iter " << i << ": " << newLoss << std::endl;
     shot->getGradientWrtRolloutCache(shot->mWorld);
     shot->backpropGradient(shot->mWorld, grad);
     x -= grad * mLearningRate;
     shot->unflatten(shot->mWorld, x);
 
+    // We've already taken this step, so we report it as step i + 1. That
+    // matches IPOPT, which reports the starting point as iteration 0.
+    bool allCallbacksReturnedTrue = true;
     for (auto callback : mIntermediateCallbacks)
     {
-      callback(shot, i, loss, 0.0);
+      if (!callback(shot, i + 1, loss, 0.0))
+      {
+        allCallbacksReturnedTrue = false;
+      }
+    }
+    if (!allCallbacksReturnedTrue)
+    {
+      break;
     }
   }
 
@@ -73,5 +88,11 @@ void SGDOptimizer::setLearningRate(double learningRate)
   mLearningRate = learningRate;
 }
 
+//==============================================================================
+void SGDOptimizer::setSuppressOutput(bool suppressOutput)
+{
+  mSuppressOutput = suppressOutput;
+}
+
 } // namespace trajectory
 } // namespace dart
\ No newline at end of file
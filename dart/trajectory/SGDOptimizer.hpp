@@ -41,10 +41,13 @@ public:
 
   void setLearningRate(double learningRate);
 
+  void setSuppressOutput(bool suppressOutput);
+
 protected:
   int mIterationLimit;
   double mTolerance;
   double mLearningRate;
+  bool mSuppressOutput;
 };
 
 } // namespace trajectory
@@ -1,5 +1,7 @@
 #include "dart/trajectory/SingleShot.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
 #include "dart/dynamics/Skeleton.hpp"
@@ -35,6 +37,9 @@ SingleShot::SingleShot(
   assert(steps > 0);
   mForces = Eigen::MatrixXd::Zero(world->getNumDofs(), steps);
   mSnapshotsCacheDirty = true;
+  mSnapshotsCacheDirtyFrom = 0;
+  mSnapshotMemoryBudget = 0;
+  mSnapshotsCacheSegment = -1;
   mPinnedForces = Eigen::MatrixXd::Zero(world->getNumDofs(), steps);
   for (int i = 0; i < steps; i++)
   {
@@ -80,18 +85,14 @@ void SingleShot::switchRepresentationMapping(
   // Rewrite the forces in the new mapping
   Eigen::MatrixXd newForces = Eigen::MatrixXd::Zero(
       mMappings[mapping]->getForceDim(), mForces.cols());
-  std::vector<MappedBackpropSnapshotPtr> snapshots
-      = getSnapshots(world, thisLog);
-  for (int i = 0; i < snapshots.size(); i++)
+  for (int i = 0; i < mSteps; i++)
   {
+    MappedBackpropSnapshotPtr ptr = getSnapshot(world, i, thisLog);
     // Set the state in the old mapping
     // TODO:optimize
-    Eigen::VectorXd posCopy
-        = snapshots[i]->getPreStepPosition(mRepresentationMapping);
-    Eigen::VectorXd velCopy
-        = snapshots[i]->getPreStepVelocity(mRepresentationMapping);
-    Eigen::VectorXd forceCopy
-        = snapshots[i]->getPreStepTorques(mRepresentationMapping);
+    Eigen::VectorXd posCopy = ptr->getPreStepPosition(mRepresentationMapping);
+    Eigen::VectorXd velCopy = ptr->getPreStepVelocity(mRepresentationMapping);
+    Eigen::VectorXd forceCopy = ptr->getPreStepTorques(mRepresentationMapping);
     getRepresentation()->setPositions(world, posCopy);
     getRepresentation()->setVelocities(world, velCopy);
     getRepresentation()->setForces(world, forceCopy);
@@ -106,13 +107,13 @@ void SingleShot::switchRepresentationMapping(
   // Rewrite the start state in the new mapping
   getRepresentation()->setPositions(world, mStartPos);
   getRepresentation()->setVelocities(world, mStartVel);
-  Eigen::VectorXd forceCopy
-      = snapshots[0]->getPreStepTorques(mRepresentationMapping);
+  Eigen::VectorXd forceCopy = getSnapshot(world, 0, thisLog)
+                                  ->getPreStepTorques(mRepresentationMapping);
   getRepresentation()->setForces(world, forceCopy);
   mStartPos = mMappings[mapping]->getPositions(world);
   mStartVel = mMappings[mapping]->getVelocities(world);
 
-  mSnapshotsCacheDirty = true;
+  markSnapshotsDirtyFrom(0);
   Problem::switchRepresentationMapping(world, mapping, thisLog);
   snapshot.restore();
 
@@ -233,32 +234,57 @@ void SingleShot::unflatten(
   }
 #endif
 
-  mRolloutCacheDirty = true;
-  mSnapshotsCacheDirty = true;
+  // Track the first timestep whose inputs actually changed, so we only have
+  // to re-simulate from there. Line searches and warm-started replans often
+  // only change later forces, or nothing at all.
+  int firstChanged = mSteps;
 
   int cursorDynamic = Problem::getFlatDynamicProblemDim(world);
   int cursorStatic = Problem::getFlatStaticProblemDim(world);
+  Eigen::VectorXd oldMasses = world->getMasses();
   Problem::unflatten(
       world,
       flatStatic.segment(0, cursorStatic),
       flatDynamic.segment(0, cursorDynamic),
       thisLog);
+  if (world->getMasses() != oldMasses)
+  {
+    firstChanged = 0;
+  }
 
   if (mTuneStartingState)
   {
-    mStartPos = flatDynamic.segment(0, getRepresentation()->getPosDim());
+    Eigen::VectorXd startPos
+        = flatDynamic.segment(0, getRepresentation()->getPosDim());
     cursorDynamic += getRepresentation()->getPosDim();
-    mStartVel
+    Eigen::VectorXd startVel
         = flatDynamic.segment(cursorDynamic, getRepresentation()->getVelDim());
     cursorDynamic += getRepresentation()->getVelDim();
+    if (startPos != mStartPos || startVel != mStartVel)
+    {
+      firstChanged = 0;
+    }
+    mStartPos = startPos;
+    mStartVel = startVel;
   }
   int forceDim = getRepresentation()->getForceDim();
   for (int i = 0; i < mSteps; i++)
   {
+    if (i < firstChanged
+        && flatDynamic.segment(cursorDynamic, forceDim) != mForces.col(i))
+    {
+      firstChanged = i;
+    }
     mForces.col(i) = flatDynamic.segment(cursorDynamic, forceDim);
     cursorDynamic += forceDim;
   }
 
+  if (firstChanged < mSteps)
+  {
+    mRolloutCacheDirty = true;
+    markSnapshotsDirtyFrom(firstChanged);
+  }
+
   assert(cursorDynamic == flatDynamic.size());
   assert(cursorStatic == flatStatic.size());
 
@@ -456,9 +482,6 @@ void SingleShot::backpropJacobianOfFinalState(
 
   Problem::initializeStaticJacobianOfFinalState(world, jacStatic, thisLog);
 
-  std::vector<MappedBackpropSnapshotPtr> snapshots
-      = getSnapshots(world, thisLog);
-
   int posDim = getRepresentation()->getPosDim();
   int velDim = getRepresentation()->getVelDim();
   int forceDim = getRepresentation()->getForceDim();
@@ -483,7 +506,7 @@ void SingleShot::backpropJacobianOfFinalState(
   int cursorDynamic = getFlatDynamicProblemDim(world);
   for (int i = mSteps - 1; i >= 0; i--)
   {
-    MappedBackpropSnapshotPtr ptr = snapshots[i];
+    MappedBackpropSnapshotPtr ptr = getSnapshot(world, i, thisLog);
     TimestepJacobians thisTimestep;
     Eigen::MatrixXd forceVel = ptr->getForceVelJacobian(
         world, mRepresentationMapping, mRepresentationMapping, thisLog);
@@ -633,10 +656,6 @@ void SingleShot::backpropGradientWrt(
   _unused(staticDims);
   assert(gradDynamic.size() == dynamicDims);
 
-  std::vector<MappedBackpropSnapshotPtr> snapshots
-      = getSnapshots(world, thisLog);
-  assert(snapshots.size() == mSteps);
-
   LossGradient nextTimestep;
   nextTimestep.lossWrtPosition
       = Eigen::VectorXd::Zero(mMappings[mRepresentationMapping]->getPosDim());
@@ -671,12 +690,13 @@ void SingleShot::backpropGradientWrt(
         += nextTimestep.lossWrtVelocity;
 
     LossGradient thisTimestep;
-    snapshots[i]->backprop(
-        world,
-        thisTimestep,
-        mappedLosses,
-        thisLog,
-        mExploreAlternateStrategies);
+    getSnapshot(world, i, thisLog)
+        ->backprop(
+            world,
+            thisTimestep,
+            mappedLosses,
+            thisLog,
+            mExploreAlternateStrategies);
 
     Problem::accumulateStaticGradient(world, gradStatic, thisTimestep, thisLog);
 
@@ -727,47 +747,261 @@ std::vector<MappedBackpropSnapshotPtr> SingleShot::getSnapshots(
   }
 #endif
 
-  if (mSnapshotsCacheDirty)
+  std::vector<MappedBackpropSnapshotPtr> snapshots;
+  if (getSnapshotCheckpointInterval() >= mSteps)
+  {
+    refreshSnapshotsCache(world, thisLog);
+    snapshots = mSnapshotsCache;
+  }
+  else
   {
-    PerformanceLog* refreshLog = nullptr;
+    // This defeats the purpose of checkpointing, because we have to hold every
+    // snapshot at once. Prefer getSnapshot() where possible.
+    snapshots.reserve(mSteps);
+    for (int i = 0; i < mSteps; i++)
+    {
+      snapshots.push_back(getSnapshot(world, i, thisLog));
+    }
+  }
+
 #ifdef LOG_PERFORMANCE_SINGLE_SHOT
-    if (thisLog != nullptr)
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+  return snapshots;
+}
+
+//==============================================================================
+/// This returns the snapshot for a single timestep. If we're checkpointing
+/// (see setSnapshotMemoryBudget()), this only re-simulates the segment of
+/// the rollout that holds `step`.
+MappedBackpropSnapshotPtr SingleShot::getSnapshot(
+    std::shared_ptr<simulation::World> world, int step, PerformanceLog* log)
+{
+  assert(step >= 0 && step < mSteps);
+  int interval = getSnapshotCheckpointInterval();
+  if (interval >= mSteps)
+  {
+    refreshSnapshotsCache(world, log);
+    return mSnapshotsCache[step];
+  }
+  loadSnapshotSegment(world, step / interval, log);
+  return mSnapshotsCache[step % interval];
+}
+
+//==============================================================================
+/// This caps how many snapshots (plus checkpointed states) we keep in memory
+/// at once. 0 means no limit.
+void SingleShot::setSnapshotMemoryBudget(int maxSnapshots)
+{
+  assert(maxSnapshots >= 0);
+  if (maxSnapshots != mSnapshotMemoryBudget)
+  {
+    mSnapshotMemoryBudget = maxSnapshots;
+    markSnapshotsDirtyFrom(0);
+    mSnapshotsCache.clear();
+    mCheckpointLCPCaches.clear();
+  }
+}
+
+//==============================================================================
+/// This returns the memory budget set with setSnapshotMemoryBudget()
+int SingleShot::getSnapshotMemoryBudget() const
+{
+  return mSnapshotMemoryBudget;
+}
+
+//==============================================================================
+/// This returns the number of timesteps between checkpoints under the current
+/// memory budget
+int SingleShot::getSnapshotCheckpointInterval() const
+{
+  if (mSnapshotMemoryBudget <= 0 || mSnapshotMemoryBudget >= mSteps)
+  {
+    return mSteps;
+  }
+  // With an interval of k, we hold ceil(steps / k) checkpoints, plus the k
+  // snapshots of the segment we're working on. Take the smallest k that fits,
+  // which re-simulates the least, or the k that minimizes memory if nothing
+  // fits.
+  for (int k = 1; k < mSteps; k++)
+  {
+    if ((mSteps + k - 1) / k + k <= mSnapshotMemoryBudget)
     {
-      refreshLog = thisLog->startRun("SingleShot.getSnapshots#refreshCache");
+      return k;
     }
+  }
+  return std::max(
+      1, static_cast<int>(std::ceil(std::sqrt(static_cast<double>(mSteps)))));
+}
+
+//==============================================================================
+void SingleShot::refreshSnapshotsCache(
+    std::shared_ptr<simulation::World> world, PerformanceLog* log)
+{
+  // The masses can be changed on the world directly, without going through
+  // unflatten(), so we have to check them here
+  Eigen::VectorXd masses = world->getMasses();
+  if (masses.size() != mSnapshotsCacheMasses.size()
+      || masses != mSnapshotsCacheMasses)
+  {
+    markSnapshotsDirtyFrom(0);
+  }
+  if (!mSnapshotsCacheDirty)
+  {
+    return;
+  }
+
+  PerformanceLog* refreshLog = nullptr;
+#ifdef LOG_PERFORMANCE_SINGLE_SHOT
+  if (log != nullptr)
+  {
+    refreshLog = log->startRun("SingleShot.getSnapshots#refreshCache");
+  }
 #endif
-    RestorableSnapshot snapshot(world);
+  RestorableSnapshot snapshot(world);
+
+  int interval = getSnapshotCheckpointInterval();
+  bool checkpointing = interval < mSteps;
+  int numSegments = (mSteps + interval - 1) / interval;
 
+  // Everything before the first dirty timestep is still valid, so we only have
+  // to re-simulate from there (or, if we're checkpointing, from the last
+  // checkpoint before it)
+  int start = 0;
+  if (checkpointing)
+  {
+    if (mCheckpointLCPCaches.size() == numSegments)
+    {
+      start = (mSnapshotsCacheDirtyFrom / interval) * interval;
+    }
+  }
+  else if (mSnapshotsCache.size() == mSteps)
+  {
+    start = mSnapshotsCacheDirtyFrom;
+  }
+
+  if (start == 0)
+  {
     mSnapshotsCache.clear();
-    mSnapshotsCache.reserve(mSteps);
+    mSnapshotsCache.reserve(interval);
+    if (checkpointing)
+    {
+      mCheckpointPositions
+          = Eigen::MatrixXd::Zero(world->getNumDofs(), numSegments);
+      mCheckpointVelocities
+          = Eigen::MatrixXd::Zero(world->getNumDofs(), numSegments);
+      mCheckpointLCPCaches.resize(numSegments);
+    }
+    else
+    {
+      mCheckpointPositions.resize(0, 0);
+      mCheckpointVelocities.resize(0, 0);
+      mCheckpointLCPCaches.clear();
+    }
 
     getRepresentation()->setPositions(world, mStartPos);
     getRepresentation()->setVelocities(world, mStartVel);
+  }
+  else if (checkpointing)
+  {
+    int segment = start / interval;
+    mSnapshotsCache.clear();
+    world->setPositions(mCheckpointPositions.col(segment));
+    world->setVelocities(mCheckpointVelocities.col(segment));
+    world->setCachedLCPSolution(mCheckpointLCPCaches[segment]);
+  }
+  else
+  {
+    // The first stale snapshot still recorded the right state going into its
+    // timestep
+    BackpropSnapshotPtr firstStale
+        = mSnapshotsCache[start]->getUnderlyingSnapshot();
+    world->setPositions(firstStale->getPreStepPosition());
+    world->setVelocities(firstStale->getPreStepVelocity());
+    world->setCachedLCPSolution(firstStale->getPreStepLCPCache());
+    mSnapshotsCache.resize(start);
+  }
 
-    for (int i = 0; i < mSteps; i++)
+  for (int i = start; i < mSteps; i++)
+  {
+    if (checkpointing && i % interval == 0)
     {
-      getRepresentation()->setForces(world, mForces.col(i));
-      mSnapshotsCache.push_back(
-          mappedForwardPass(world, mRepresentationMapping, mMappings));
+      mCheckpointPositions.col(i / interval) = world->getPositions();
+      mCheckpointVelocities.col(i / interval) = world->getVelocities();
+      mCheckpointLCPCaches[i / interval] = world->getCachedLCPSolution();
+      mSnapshotsCache.clear();
     }
+    getRepresentation()->setForces(world, mForces.col(i));
+    mSnapshotsCache.push_back(
+        mappedForwardPass(world, mRepresentationMapping, mMappings));
+  }
 
-    snapshot.restore();
-    mSnapshotsCacheDirty = false;
+  snapshot.restore();
+  mSnapshotsCacheSegment = checkpointing ? numSegments - 1 : -1;
+  mSnapshotsCacheDirty = false;
+  mSnapshotsCacheDirtyFrom = mSteps;
+  mSnapshotsCacheMasses = masses;
 #ifdef LOG_PERFORMANCE_SINGLE_SHOT
-    if (refreshLog != nullptr)
-    {
-      refreshLog->end();
-    }
+  if (refreshLog != nullptr)
+  {
+    refreshLog->end();
+  }
 #endif
+}
+
+//==============================================================================
+void SingleShot::markSnapshotsDirtyFrom(int step)
+{
+  mSnapshotsCacheDirty = true;
+  mSnapshotsCacheDirtyFrom = std::min(mSnapshotsCacheDirtyFrom, step);
+}
+
+//==============================================================================
+void SingleShot::loadSnapshotSegment(
+    std::shared_ptr<simulation::World> world, int segment, PerformanceLog* log)
+{
+  refreshSnapshotsCache(world, log);
+  if (segment == mSnapshotsCacheSegment)
+  {
+    return;
   }
 
+  PerformanceLog* recomputeLog = nullptr;
 #ifdef LOG_PERFORMANCE_SINGLE_SHOT
-  if (thisLog != nullptr)
+  if (log != nullptr)
   {
-    thisLog->end();
+    recomputeLog = log->startRun("SingleShot.loadSnapshotSegment#recompute");
+  }
+#endif
+  RestorableSnapshot snapshot(world);
+
+  int interval = getSnapshotCheckpointInterval();
+  int start = segment * interval;
+  int end = std::min(start + interval, mSteps);
+
+  world->setPositions(mCheckpointPositions.col(segment));
+  world->setVelocities(mCheckpointVelocities.col(segment));
+  world->setCachedLCPSolution(mCheckpointLCPCaches[segment]);
+
+  mSnapshotsCache.clear();
+  for (int i = start; i < end; i++)
+  {
+    getRepresentation()->setForces(world, mForces.col(i));
+    mSnapshotsCache.push_back(
+        mappedForwardPass(world, mRepresentationMapping, mMappings));
+  }
+
+  snapshot.restore();
+  mSnapshotsCacheSegment = segment;
+#ifdef LOG_PERFORMANCE_SINGLE_SHOT
+  if (recomputeLog != nullptr)
+  {
+    recomputeLog->end();
   }
 #endif
-  return mSnapshotsCache;
 }
 
 //==============================================================================
@@ -786,9 +1020,6 @@ void SingleShot::getStates(
   }
 #endif
 
-  std::vector<MappedBackpropSnapshotPtr> snapshots
-      = getSnapshots(world, thisLog);
-
   for (std::string key : rollout->getMappings())
   {
     assert(rollout->getPoses(key).cols() == mSteps);
@@ -797,11 +1028,17 @@ void SingleShot::getStates(
     assert(rollout->getVels(key).rows() == mMappings[key]->getVelDim());
     assert(rollout->getForces(key).cols() == mSteps);
     assert(rollout->getForces(key).rows() == mMappings[key]->getForceDim());
-    for (int i = 0; i < mSteps; i++)
+  }
+  // Walk the timesteps in the outer loop, so that if we're checkpointing we
+  // only re-simulate each segment once
+  for (int i = 0; i < mSteps; i++)
+  {
+    MappedBackpropSnapshotPtr ptr = getSnapshot(world, i, thisLog);
+    for (std::string key : rollout->getMappings())
     {
-      rollout->getPoses(key).col(i) = snapshots[i]->getPostStepPosition(key);
-      rollout->getVels(key).col(i) = snapshots[i]->getPostStepVelocity(key);
-      rollout->getForces(key).col(i) = snapshots[i]->getPreStepTorques(key);
+      rollout->getPoses(key).col(i) = ptr->getPostStepPosition(key);
+      rollout->getVels(key).col(i) = ptr->getPostStepVelocity(key);
+      rollout->getForces(key).col(i) = ptr->getPreStepTorques(key);
     }
   }
   assert(rollout->getMasses().size() == world->getMassDims());
@@ -838,6 +1075,8 @@ void SingleShot::setStates(
   mStartVel = rollout->getVelsConst(mRepresentationMapping).col(0);
   mForces = rollout->getForcesConst(mRepresentationMapping);
   world->setMasses(rollout->getMassesConst());
+  mRolloutCacheDirty = true;
+  markSnapshotsDirtyFrom(0);
 
 #ifdef LOG_PERFORMANCE_SINGLE_SHOT
   if (thisLog != nullptr)
@@ -859,7 +1098,25 @@ void SingleShot::setForcesRaw(Eigen::MatrixXd forces, PerformanceLog* log)
   }
 #endif
 
+  int firstChanged = 0;
+  if (forces.rows() == mForces.rows() && forces.cols() == mForces.cols())
+  {
+    firstChanged = mSteps;
+    for (int i = 0; i < mSteps; i++)
+    {
+      if (forces.col(i) != mForces.col(i))
+      {
+        firstChanged = i;
+        break;
+      }
+    }
+  }
   mForces = forces;
+  if (firstChanged < mSteps)
+  {
+    mRolloutCacheDirty = true;
+    markSnapshotsDirtyFrom(firstChanged);
+  }
 
 #ifdef LOG_PERFORMANCE_SINGLE_SHOT
   if (thisLog != nullptr)
@@ -891,6 +1148,8 @@ Eigen::VectorXi SingleShot::advanceSteps(
         = mForces.block(0, steps, mForces.rows(), mSteps - steps);
   }
   mForces = newForces;
+  mRolloutCacheDirty = true;
+  markSnapshotsDirtyFrom(0);
 
   return mapping;
 }
@@ -926,6 +1185,8 @@ Eigen::VectorXd SingleShot::getStartVel()
 void SingleShot::setStartPos(Eigen::VectorXd startPos)
 {
   mStartPos = startPos;
+  mRolloutCacheDirty = true;
+  markSnapshotsDirtyFrom(0);
 }
 
 //==============================================================================
@@ -933,6 +1194,8 @@ void SingleShot::setStartPos(Eigen::VectorXd startPos)
 void SingleShot::setStartVel(Eigen::VectorXd startVel)
 {
   mStartVel = startVel;
+  mRolloutCacheDirty = true;
+  markSnapshotsDirtyFrom(0);
 }
 
 //==============================================================================
@@ -949,17 +1212,14 @@ Eigen::VectorXd SingleShot::getFinalState(
   }
 #endif
 
-  std::vector<MappedBackpropSnapshotPtr> snapshots
-      = getSnapshots(world, thisLog);
+  MappedBackpropSnapshotPtr last = getSnapshot(world, mSteps - 1, thisLog);
 
   Eigen::VectorXd state = Eigen::VectorXd::Zero(getRepresentationStateSize());
   state.segment(0, getRepresentation()->getPosDim())
-      = snapshots[snapshots.size() - 1]->getPostStepPosition(
-          mRepresentationMapping);
+      = last->getPostStepPosition(mRepresentationMapping);
   state.segment(
       getRepresentation()->getPosDim(), getRepresentation()->getVelDim())
-      = snapshots[snapshots.size() - 1]->getPostStepVelocity(
-          mRepresentationMapping);
+      = last->getPostStepVelocity(mRepresentationMapping);
 
 #ifdef LOG_PERFORMANCE_SINGLE_SHOT
   if (thisLog != nullptr)
@@ -134,6 +134,33 @@ public:
       std::shared_ptr<simulation::World> world,
       PerformanceLog* log = nullptr) override;
 
+  /// This returns the snapshot for a single timestep. If we're checkpointing
+  /// (see setSnapshotMemoryBudget()), this only re-simulates the segment of
+  /// the rollout that holds `step`, and keeps that segment around, so walking
+  /// the timesteps in order (forwards or backwards) re-simulates each segment
+  /// at most once.
+  neural::MappedBackpropSnapshotPtr getSnapshot(
+      std::shared_ptr<simulation::World> world,
+      int step,
+      PerformanceLog* log = nullptr);
+
+  /// This caps how many snapshots (plus checkpointed states) we keep in memory
+  /// at once. 0, the default, means no limit, and we keep a snapshot for every
+  /// timestep. Otherwise we only store the world state at the start of every
+  /// k-th timestep, and re-simulate the snapshots of one segment of k
+  /// timesteps at a time as they're needed, trading an extra forward pass
+  /// during backprop for O(sqrt(steps)) memory. The re-simulation shows up in
+  /// the PerformanceLog as "SingleShot.loadSnapshotSegment#recompute".
+  void setSnapshotMemoryBudget(int maxSnapshots);
+
+  /// This returns the memory budget set with setSnapshotMemoryBudget()
+  int getSnapshotMemoryBudget() const;
+
+  /// This returns the number of timesteps between checkpoints under the
+  /// current memory budget. If we're not checkpointing, this is the number of
+  /// steps.
+  int getSnapshotCheckpointInterval() const;
+
   /// This populates the passed in matrices with the values from this trajectory
   void getStates(
       std::shared_ptr<simulation::World> world,
@@ -206,6 +233,23 @@ public:
       std::shared_ptr<simulation::World> world, double EPS);
 
 private:
+  /// This re-simulates the rollout from the first dirty timestep, if there is
+  /// one. If we're not checkpointing, this keeps every snapshot. Otherwise,
+  /// this records the checkpoints, and keeps the snapshots for the last
+  /// segment.
+  void refreshSnapshotsCache(
+      std::shared_ptr<simulation::World> world, PerformanceLog* log);
+
+  /// This marks every snapshot from `step` onwards as stale
+  void markSnapshotsDirtyFrom(int step);
+
+  /// This re-simulates a segment of the rollout from its checkpoint, leaving
+  /// its snapshots in mSnapshotsCache
+  void loadSnapshotSegment(
+      std::shared_ptr<simulation::World> world,
+      int segment,
+      PerformanceLog* log);
+
   Eigen::VectorXd mStartPos;
   Eigen::VectorXd mStartVel;
   Eigen::MatrixXd mForces;
@@ -213,7 +257,22 @@ private:
   Eigen::MatrixXd mPinnedForces;
 
   bool mSnapshotsCacheDirty;
+  /// If we're checkpointing, this only holds the snapshots for one segment
   std::vector<neural::MappedBackpropSnapshotPtr> mSnapshotsCache;
+
+  /// The first timestep whose snapshot is stale, if mSnapshotsCacheDirty
+  int mSnapshotsCacheDirtyFrom;
+  /// The world's masses when we last simulated
+  Eigen::VectorXd mSnapshotsCacheMasses;
+
+  /// 0 means we keep every snapshot
+  int mSnapshotMemoryBudget;
+  /// The segment held in mSnapshotsCache, or -1 if we're not checkpointing
+  int mSnapshotsCacheSegment;
+  /// The world state at the start of each segment, one per column
+  Eigen::MatrixXd mCheckpointPositions;
+  Eigen::MatrixXd mCheckpointVelocities;
+  std::vector<Eigen::VectorXd> mCheckpointLCPCaches;
 };
 
 } // namespace trajectory
@@ -64,7 +64,23 @@ void BoxedLcpConstraintSolver(py::module& m)
           +[](const dart::constraint::BoxedLcpConstraintSolver* self)
               -> dart::constraint::ConstBoxedLcpSolverPtr {
             return self->getBoxedLcpSolver();
-          });
+          })
+      .def(
+          "setBatchedImpulseTestsEnabled",
+          &dart::constraint::BoxedLcpConstraintSolver::
+              setBatchedImpulseTestsEnabled,
+          ::py::arg("enabled"))
+      .def(
+          "getBatchedImpulseTestsEnabled",
+          &dart::constraint::BoxedLcpConstraintSolver::
+              getBatchedImpulseTestsEnabled)
+      .def(
+          "setSparseLcpThreshold",
+          &dart::constraint::BoxedLcpConstraintSolver::setSparseLcpThreshold,
+          ::py::arg("threshold"))
+      .def(
+          "getSparseLcpThreshold",
+          &dart::constraint::BoxedLcpConstraintSolver::getSparseLcpThreshold);
 }
 
 } // namespace python
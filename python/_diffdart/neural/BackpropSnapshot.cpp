@@ -65,37 +65,54 @@ void BackpropSnapshot(py::module& m)
           ::py::arg("thisTimestepLoss"),
           ::py::arg("nextTimestepLoss"),
           ::py::arg("perfLog") = nullptr,
-          ::py::arg("exploreAlternateStrategies") = false)
+          ::py::arg("exploreAlternateStrategies") = false,
+          ::py::call_guard<py::gil_scoped_release>())
+      // The Jacobian getters fill the snapshot's caches under its own lock, so
+      // they can run without the GIL. Each cache is written once and never
+      // touched again, so we hand back zero-copy views that keep the snapshot
+      // alive. They come from const references, so NumPy marks them read-only.
       .def(
           "getVelVelJacobian",
           &dart::neural::BackpropSnapshot::getVelVelJacobian,
           ::py::arg("world"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::return_value_policy::reference_internal,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getForceVelJacobian",
           &dart::neural::BackpropSnapshot::getForceVelJacobian,
           ::py::arg("world"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::return_value_policy::reference_internal,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getPosPosJacobian",
           &dart::neural::BackpropSnapshot::getPosPosJacobian,
           ::py::arg("world"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::return_value_policy::reference_internal,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getVelPosJacobian",
           &dart::neural::BackpropSnapshot::getVelPosJacobian,
           ::py::arg("world"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::return_value_policy::reference_internal,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getPosVelJacobian",
           &dart::neural::BackpropSnapshot::getPosVelJacobian,
           ::py::arg("world"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::return_value_policy::reference_internal,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getMassVelJacobian",
           &dart::neural::BackpropSnapshot::getMassVelJacobian,
           ::py::arg("world"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::return_value_policy::reference_internal,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getPreStepPosition",
           &dart::neural::BackpropSnapshot::getPreStepPosition)
@@ -121,24 +138,28 @@ void BackpropSnapshot(py::module& m)
           "finiteDifferenceVelVelJacobian",
           &dart::neural::BackpropSnapshot::finiteDifferenceVelVelJacobian,
           ::py::arg("world"),
-          ::py::arg("useRidders") = true)
+          ::py::arg("useRidders") = true,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "finiteDifferenceForceVelJacobian",
           &dart::neural::BackpropSnapshot::finiteDifferenceForceVelJacobian,
           ::py::arg("world"),
-          ::py::arg("useRidders") = true)
+          ::py::arg("useRidders") = true,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "finiteDifferencePosPosJacobian",
           &dart::neural::BackpropSnapshot::finiteDifferencePosPosJacobian,
           ::py::arg("world"),
           ::py::arg("subdivisions"),
-          ::py::arg("useRidders") = true)
+          ::py::arg("useRidders") = true,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "finiteDifferenceVelPosJacobian",
           &dart::neural::BackpropSnapshot::finiteDifferenceVelPosJacobian,
           ::py::arg("world"),
           ::py::arg("subdivisions"),
-          ::py::arg("useRidders") = true)
+          ::py::arg("useRidders") = true,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "benchmarkJacobians",
           &dart::neural::BackpropSnapshot::benchmarkJacobians,
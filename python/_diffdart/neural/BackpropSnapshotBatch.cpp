@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <dart/neural/BackpropSnapshot.hpp>
+#include <dart/neural/BackpropSnapshotBatch.hpp>
+#include <dart/simulation/WorldBatch.hpp>
+#include <pybind11/eigen.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+void BackpropSnapshotBatch(py::module& m)
+{
+  ::py::class_<
+      dart::neural::BackpropSnapshotBatch,
+      std::shared_ptr<dart::neural::BackpropSnapshotBatch>>(
+      m, "BackpropSnapshotBatch")
+      .def(
+          ::py::init<
+              std::shared_ptr<dart::simulation::WorldBatch>,
+              std::vector<std::shared_ptr<dart::neural::BackpropSnapshot>>>(),
+          ::py::arg("batch"),
+          ::py::arg("snapshots"))
+      .def(
+          "getBatchSize", &dart::neural::BackpropSnapshotBatch::getBatchSize)
+      .def(
+          "getSnapshot",
+          &dart::neural::BackpropSnapshotBatch::getSnapshot,
+          ::py::arg("index"))
+      .def(
+          "getWorldBatch",
+          &dart::neural::BackpropSnapshotBatch::getWorldBatch)
+      .def(
+          "backprop",
+          &dart::neural::BackpropSnapshotBatch::backprop,
+          ::py::arg("thisTimestepLoss"),
+          ::py::arg("nextTimestepLoss"),
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "backprop",
+          +[](dart::neural::BackpropSnapshotBatch* self,
+              const Eigen::MatrixXd& lossWrtPosition,
+              const Eigen::MatrixXd& lossWrtVelocity) {
+            // This returns (lossWrtPosition, lossWrtVelocity, lossWrtTorque)
+            // before the step, so callers don't need LossGradientBatch objects
+            dart::neural::LossGradientBatch next;
+            next.lossWrtPosition = lossWrtPosition;
+            next.lossWrtVelocity = lossWrtVelocity;
+            dart::neural::LossGradientBatch thisLoss;
+            self->backprop(thisLoss, next);
+            return std::make_tuple(
+                std::move(thisLoss.lossWrtPosition),
+                std::move(thisLoss.lossWrtVelocity),
+                std::move(thisLoss.lossWrtTorque));
+          },
+          ::py::arg("nextLossWrtPosition"),
+          ::py::arg("nextLossWrtVelocity"),
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "getPreStepPosition",
+          &dart::neural::BackpropSnapshotBatch::getPreStepPosition)
+      .def(
+          "getPreStepVelocity",
+          &dart::neural::BackpropSnapshotBatch::getPreStepVelocity)
+      .def(
+          "getPreStepTorques",
+          &dart::neural::BackpropSnapshotBatch::getPreStepTorques)
+      .def(
+          "getPostStepPosition",
+          &dart::neural::BackpropSnapshotBatch::getPostStepPosition)
+      .def(
+          "getPostStepVelocity",
+          &dart::neural::BackpropSnapshotBatch::getPostStepVelocity)
+      .def(
+          "getPostStepTorques",
+          &dart::neural::BackpropSnapshotBatch::getPostStepTorques);
+}
+
+} // namespace python
+} // namespace dart
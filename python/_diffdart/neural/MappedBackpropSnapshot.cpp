@@ -52,7 +52,8 @@ void MappedBackpropSnapshot(py::module& m)
           ::py::arg("thisTimestepLoss"),
           ::py::arg("nextTimestepLosses"),
           ::py::arg("perfLog") = nullptr,
-          ::py::arg("exploreAlternateStrategies") = false)
+          ::py::arg("exploreAlternateStrategies") = false,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getRepresentation",
           &dart::neural::MappedBackpropSnapshot::getRepresentation)
@@ -63,42 +64,48 @@ void MappedBackpropSnapshot(py::module& m)
           ::py::arg("world"),
           ::py::arg("mapBefore"),
           ::py::arg("mapAfter"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getForceVelJacobian",
           &dart::neural::MappedBackpropSnapshot::getForceVelJacobian,
           ::py::arg("world"),
           ::py::arg("mapBefore"),
           ::py::arg("mapAfter"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getPosPosJacobian",
           &dart::neural::MappedBackpropSnapshot::getPosPosJacobian,
           ::py::arg("world"),
           ::py::arg("mapBefore"),
           ::py::arg("mapAfter"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getVelPosJacobian",
           &dart::neural::MappedBackpropSnapshot::getVelPosJacobian,
           ::py::arg("world"),
           ::py::arg("mapBefore"),
           ::py::arg("mapAfter"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getPosVelJacobian",
           &dart::neural::MappedBackpropSnapshot::getPosVelJacobian,
           ::py::arg("world"),
           ::py::arg("mapBefore"),
           ::py::arg("mapAfter"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getMassVelJacobian",
           &dart::neural::MappedBackpropSnapshot::getMassVelJacobian,
           ::py::arg("world"),
           ::py::arg("mapBefore"),
           ::py::arg("mapAfter"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getPreStepPosition",
           &dart::neural::MappedBackpropSnapshot::getPreStepPosition,
@@ -32,9 +32,11 @@
 
 #include <dart/dynamics/BodyNode.hpp>
 #include <dart/neural/BackpropSnapshot.hpp>
+#include <dart/neural/FiniteDifferenceEngine.hpp>
 #include <dart/neural/MappedBackpropSnapshot.hpp>
 #include <dart/neural/Mapping.hpp>
 #include <dart/neural/NeuralUtils.hpp>
+#include <dart/simulation/WorldBatch.hpp>
 #include <pybind11/eigen.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
@@ -55,6 +57,17 @@ void NeuralUtils(py::module& m)
       .def_readwrite(
           "lossWrtTorque", &dart::neural::LossGradient::lossWrtTorque);
 
+  ::py::class_<dart::neural::LossGradientBatch>(m, "LossGradientBatch")
+      .def(::py::init<>())
+      .def_readwrite(
+          "lossWrtPosition", &dart::neural::LossGradientBatch::lossWrtPosition)
+      .def_readwrite(
+          "lossWrtVelocity", &dart::neural::LossGradientBatch::lossWrtVelocity)
+      .def_readwrite(
+          "lossWrtTorque", &dart::neural::LossGradientBatch::lossWrtTorque)
+      .def_readwrite(
+          "lossWrtMass", &dart::neural::LossGradientBatch::lossWrtMass);
+
   ::py::class_<dart::neural::KnotJacobian>(m, "KnotJacobian")
       .def(::py::init<>())
       .def_readwrite(
@@ -80,18 +93,56 @@ void NeuralUtils(py::module& m)
       .value("POS_SPATIAL", dart::neural::ConvertToSpace::POS_SPATIAL)
       .export_values();
 
+  ::py::enum_<dart::neural::FiniteDifferenceScheme>(m, "FiniteDifferenceScheme")
+      .value("FD_FORWARD", dart::neural::FiniteDifferenceScheme::FD_FORWARD)
+      .value("FD_CENTRAL", dart::neural::FiniteDifferenceScheme::FD_CENTRAL)
+      .value("FD_RIDDERS", dart::neural::FiniteDifferenceScheme::FD_RIDDERS)
+      .export_values();
+
   m.def(
       "forwardPass",
       &dart::neural::forwardPass,
       ::py::arg("world"),
-      ::py::arg("idempotent") = false);
+      ::py::arg("idempotent") = false,
+      ::py::call_guard<py::gil_scoped_release>());
+  m.def(
+      "forwardPassBatch",
+      ::py::overload_cast<
+          std::shared_ptr<dart::simulation::World>,
+          const Eigen::MatrixXd&,
+          const Eigen::MatrixXd&,
+          int>(&dart::neural::forwardPassBatch),
+      ::py::arg("world"),
+      ::py::arg("states"),
+      ::py::arg("torques"),
+      ::py::arg("numThreads") = 0,
+      ::py::call_guard<py::gil_scoped_release>());
+  m.def(
+      "forwardPassBatch",
+      ::py::overload_cast<std::shared_ptr<dart::simulation::WorldBatch>>(
+          &dart::neural::forwardPassBatch),
+      ::py::arg("batch"),
+      ::py::call_guard<py::gil_scoped_release>());
+  m.def(
+      "forwardPassBatch",
+      ::py::overload_cast<
+          std::shared_ptr<dart::simulation::WorldBatch>,
+          const Eigen::MatrixXd&,
+          const Eigen::MatrixXd&,
+          const Eigen::MatrixXd&>(&dart::neural::forwardPassBatch),
+      ::py::arg("batch"),
+      ::py::arg("positions"),
+      ::py::arg("velocities"),
+      ::py::arg("torques"),
+      ::py::call_guard<py::gil_scoped_release>());
   m.def(
       "mappedForwardPass",
       &dart::neural::mappedForwardPass,
       ::py::arg("world"),
       ::py::arg("representation") = "identity",
       ::py::arg("mappings"),
-      ::py::arg("idempotent") = false);
+      ::py::arg("idempotent") = false,
+      ::py::call_guard<py::gil_scoped_release>());
   m.def(
       "convertJointSpaceToWorldSpace",
       &dart::neural::convertJointSpaceToWorldSpace,
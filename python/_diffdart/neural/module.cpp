@@ -44,6 +44,7 @@ void Mapping(py::module& sm);
 void IKMapping(py::module& sm);
 void IdentityMapping(py::module& sm);
 void BackpropSnapshot(py::module& sm);
+void BackpropSnapshotBatch(py::module& sm);
 void MappedBackpropSnapshot(py::module& sm);
 void WithRespectToMass(py::module& sm);
 
@@ -60,6 +61,7 @@ void dart_neural(py::module& m)
   IKMapping(sm);
   IdentityMapping(sm);
   BackpropSnapshot(sm);
+  BackpropSnapshotBatch(sm);
   MappedBackpropSnapshot(sm);
   WithRespectToMass(sm);
 }
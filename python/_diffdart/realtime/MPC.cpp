@@ -49,8 +49,8 @@ void MPC(py::module& m)
   ::py::class_<dart::realtime::MPC, std::shared_ptr<dart::realtime::MPC>>(
       m, "MPC")
       .def(
-          "getRemainingPlanBufferMillis",
-          &dart::realtime::MPC::getRemainingPlanBufferMillis)
+          "getRemainingPlanBufferNanos",
+          &dart::realtime::MPC::getRemainingPlanBufferNanos)
       .def(
           "recordGroundTruthState",
           &dart::realtime::MPC::recordGroundTruthState,
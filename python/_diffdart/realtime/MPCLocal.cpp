@@ -55,10 +55,10 @@ void MPCLocal(py::module& m)
           ::py::init<
               std::shared_ptr<dart::simulation::World>,
               std::shared_ptr<dart::trajectory::LossFn>,
-              int>(),
+              long>(),
           ::py::arg("world"),
           ::py::arg("loss"),
-          ::py::arg("planningHorizonMillis"))
+          ::py::arg("planningHorizonNanos"))
       .def("setLoss", &dart::realtime::MPCLocal::setLoss, ::py::arg("loss"))
       .def(
           "setOptimizer",
@@ -71,8 +71,8 @@ void MPCLocal(py::module& m)
       .def("getProblem", &dart::realtime::MPCLocal::getProblem)
       .def("getOptimizer", &dart::realtime::MPCLocal::getOptimizer)
       .def(
-          "getRemainingPlanBufferMillis",
-          &dart::realtime::MPCLocal::getRemainingPlanBufferMillis)
+          "getRemainingPlanBufferNanos",
+          &dart::realtime::MPCLocal::getRemainingPlanBufferNanos)
       .def(
           "setSilent",
           &dart::realtime::MPCLocal::setSilent,
@@ -85,6 +85,10 @@ void MPCLocal(py::module& m)
           "setEnableOptimizationGuards",
           &dart::realtime::MPCLocal::setEnableOptimizationGuards,
           ::py::arg("enabled"))
+      .def(
+          "setEnableAnytimeReplanning",
+          &dart::realtime::MPCLocal::setEnableAnytimeReplanning,
+          ::py::arg("enabled"))
       .def(
           "setRecordIterations",
           &dart::realtime::MPCLocal::setRecordIterations,
@@ -110,11 +114,12 @@ void MPCLocal(py::module& m)
       .def(
           "optimizePlan",
           &dart::realtime::MPCLocal::optimizePlan,
-          ::py::arg("now"))
+          ::py::arg("now"),
+          ::py::arg("deadline") = 0L)
       .def(
           "adjustPerformance",
           &dart::realtime::MPCLocal::adjustPerformance,
-          ::py::arg("lastOptimizationTimeMillis"))
+          ::py::arg("lastOptimizationTimeNanos"))
       .def("start", &dart::realtime::MPCLocal::start)
       .def("stop", &dart::realtime::MPCLocal::stop)
       .def(
@@ -52,19 +52,19 @@ void MPCRemote(py::module& m)
       dart::realtime::MPC,
       std::shared_ptr<dart::realtime::MPCRemote>>(m, "MPCRemote")
       .def(
-          ::py::init<std::string, int, int, int, int>(),
+          ::py::init<std::string, int, int, int, long>(),
           ::py::arg("host"),
           ::py::arg("port"),
           ::py::arg("dofs"),
           ::py::arg("steps"),
-          ::py::arg("millisPerStep"))
+          ::py::arg("nanosPerStep"))
       .def(
           ::py::init<dart::realtime::MPCLocal&, int>(),
           ::py::arg("local"),
           ::py::arg("ignored") = 0)
       .def(
-          "getRemainingPlanBufferMillis",
-          &dart::realtime::MPCRemote::getRemainingPlanBufferMillis)
+          "getRemainingPlanBufferNanos",
+          &dart::realtime::MPCRemote::getRemainingPlanBufferNanos)
       .def(
           "recordGroundTruthState",
           &dart::realtime::MPCRemote::recordGroundTruthState,
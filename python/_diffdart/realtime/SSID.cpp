@@ -51,11 +51,11 @@ void SSID(py::module& m)
           ::py::init<
               std::shared_ptr<dart::simulation::World>,
               std::shared_ptr<dart::trajectory::LossFn>,
-              int,
+              long,
               int>(),
           ::py::arg("world"),
           ::py::arg("loss"),
-          ::py::arg("planningHorizonMillis"),
+          ::py::arg("planningHistoryNanos"),
           ::py::arg("sensorDim"))
       .def("setLoss", &dart::realtime::SSID::setLoss, ::py::arg("loss"))
       .def(
@@ -66,6 +66,30 @@ void SSID(py::module& m)
           "setProblem", &dart::realtime::SSID::setProblem, ::py::arg("problem"))
       .def("getProblem", &dart::realtime::SSID::getProblem)
       .def("getOptimizer", &dart::realtime::SSID::getOptimizer)
+      .def(
+          "addHypothesis",
+          &dart::realtime::SSID::addHypothesis,
+          ::py::arg("initializer"))
+      .def(
+          "setHypothesisOptimizerFactory",
+          +[](dart::realtime::SSID* self,
+              std::function<std::shared_ptr<dart::trajectory::Optimizer>()>
+                  factory) -> void {
+            // runInference() releases the GIL, and calls this from the
+            // inference thread
+            self->setHypothesisOptimizerFactory([factory]() {
+              py::gil_scoped_acquire acquire;
+              return factory();
+            });
+          },
+          ::py::arg("factory"))
+      .def_static(
+          "createDefaultHypothesisOptimizer",
+          &dart::realtime::SSID::createDefaultHypothesisOptimizer)
+      .def(
+          "setNumThreads",
+          &dart::realtime::SSID::setNumThreads,
+          ::py::arg("numThreads"))
       .def(
           "setInitialPosEstimator",
           &dart::realtime::SSID::setInitialPosEstimator,
@@ -92,11 +116,15 @@ void SSID(py::module& m)
           "start",
           &dart::realtime::SSID::start,
           ::py::call_guard<py::gil_scoped_release>())
-      .def("stop", &dart::realtime::SSID::stop)
+      .def(
+          "stop",
+          &dart::realtime::SSID::stop,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "runInference",
           &dart::realtime::SSID::runInference,
-          ::py::arg("startTime"))
+          ::py::arg("startTime"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "registerInferListener",
           &dart::realtime::SSID::registerInferListener,
@@ -12,6 +12,17 @@ namespace python {
 
 void Ticker(py::module& m)
 {
+  ::py::class_<dart::realtime::TickerStats>(m, "TickerStats")
+      .def_readonly("numTicks", &dart::realtime::TickerStats::numTicks)
+      .def_readonly("numOverruns", &dart::realtime::TickerStats::numOverruns)
+      .def_readonly(
+          "numSkippedTicks", &dart::realtime::TickerStats::numSkippedTicks)
+      .def_readonly(
+          "worstOverrunNanos", &dart::realtime::TickerStats::worstOverrunNanos)
+      .def_readonly(
+          "worstWakeupLatencyNanos",
+          &dart::realtime::TickerStats::worstWakeupLatencyNanos);
+
   ::py::class_<dart::realtime::Ticker, std::shared_ptr<dart::realtime::Ticker>>(
       m, "Ticker")
       .def(::py::init<double>(), ::py::arg("secondsPerTick"))
@@ -55,7 +66,9 @@ void Ticker(py::module& m)
           &dart::realtime::Ticker::start,
           ::py::call_guard<py::gil_scoped_release>())
       .def("stop", &dart::realtime::Ticker::stop)
-      .def("clear", &dart::realtime::Ticker::clear);
+      .def("clear", &dart::realtime::Ticker::clear)
+      .def("getStats", &dart::realtime::Ticker::getStats)
+      .def("resetStats", &dart::realtime::Ticker::resetStats);
 }
 
 } // namespace python
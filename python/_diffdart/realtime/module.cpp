@@ -31,6 +31,7 @@
  */
 
 #include <Eigen/Dense>
+#include <dart/realtime/Nanos.hpp>
 #include <pybind11/eigen.h>
 #include <pybind11/pybind11.h>
 
@@ -52,6 +53,12 @@ void dart_realtime(py::module& m)
       = "This provides a native realtime MPC and SSID framework to DART, "
         "utilizing the trajectory package to solve.";
 
+  sm.def(
+      "monotonicNanos",
+      &dart::realtime::monotonicNanos,
+      "The clock that all realtime timestamps are measured on, in "
+      "nanoseconds");
+
   MPC(sm);
   MPCLocal(sm);
   MPCRemote(sm);
@@ -240,13 +240,15 @@ void World(py::module& m)
           +[](dart::simulation::World* self) -> void { return self->reset(); })
       .def(
           "step",
-          +[](dart::simulation::World* self) -> void { return self->step(); })
+          +[](dart::simulation::World* self) -> void { return self->step(); },
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "step",
           +[](dart::simulation::World* self, bool _resetCommand) -> void {
             return self->step(_resetCommand);
           },
-          ::py::arg("resetCommand"))
+          ::py::arg("resetCommand"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "setTime",
           +[](dart::simulation::World* self, double _time) -> void {
@@ -286,26 +288,33 @@ void World(py::module& m)
           +[](dart::simulation::World* self) -> std::size_t {
             return self->getNumDofs();
           })
+      // The state getters gather from every skeleton into a fresh vector, so
+      // there's nothing persistent to view. Moving that vector hands its
+      // buffer straight to NumPy, so the gather is the only copy.
       .def(
           "getPositions",
           +[](dart::simulation::World* self) -> Eigen::VectorXd {
             return self->getPositions();
-          })
+          },
+          ::py::return_value_policy::move)
       .def(
           "getVelocities",
           +[](dart::simulation::World* self) -> Eigen::VectorXd {
             return self->getVelocities();
-          })
+          },
+          ::py::return_value_policy::move)
       .def(
           "getExternalForces",
           +[](dart::simulation::World* self) -> Eigen::VectorXd {
             return self->getExternalForces();
-          })
+          },
+          ::py::return_value_policy::move)
       .def(
           "getMasses",
           +[](dart::simulation::World* self) -> Eigen::VectorXd {
             return self->getMasses();
-          })
+          },
+          ::py::return_value_policy::move)
       .def(
           "getForceUpperLimits",
           +[](dart::simulation::World* self) -> Eigen::VectorXd {
@@ -348,15 +357,20 @@ void World(py::module& m)
           })
       .def(
           "setPositions",
-          +[](dart::simulation::World* self, Eigen::VectorXd positions)
-              -> void { self->setPositions(positions); })
+          +[](dart::simulation::World* self,
+              const Eigen::Ref<const Eigen::VectorXd>& positions) -> void {
+            self->setPositions(positions);
+          })
       .def(
           "setVelocities",
-          +[](dart::simulation::World* self, Eigen::VectorXd velocities)
-              -> void { self->setVelocities(velocities); })
+          +[](dart::simulation::World* self,
+              const Eigen::Ref<const Eigen::VectorXd>& velocities) -> void {
+            self->setVelocities(velocities);
+          })
       .def(
           "setExternalForces",
-          +[](dart::simulation::World* self, Eigen::VectorXd forces) -> void {
+          +[](dart::simulation::World* self,
+              const Eigen::Ref<const Eigen::VectorXd>& forces) -> void {
             self->setExternalForces(forces);
           })
       .def(
@@ -441,6 +455,13 @@ void World(py::module& m)
       .def(
           "setSlowDebugResultsAgainstFD",
           &dart::simulation::World::setSlowDebugResultsAgainstFD)
+      .def(
+          "setFiniteDifferenceThreads",
+          &dart::simulation::World::setFiniteDifferenceThreads,
+          ::py::arg("numThreads"))
+      .def(
+          "getFiniteDifferenceThreads",
+          &dart::simulation::World::getFiniteDifferenceThreads)
       .def_readonly("onNameChanged", &dart::simulation::World::onNameChanged);
 }
 
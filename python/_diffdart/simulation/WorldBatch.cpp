@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <dart/simulation/World.hpp>
+#include <dart/simulation/WorldBatch.hpp>
+#include <pybind11/eigen.h>
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+void WorldBatch(py::module& m)
+{
+  ::py::class_<
+      dart::simulation::WorldBatch,
+      std::shared_ptr<dart::simulation::WorldBatch>>(m, "WorldBatch")
+      .def(
+          ::py::init<std::shared_ptr<dart::simulation::World>, int, int>(),
+          ::py::arg("world"),
+          ::py::arg("batchSize"),
+          ::py::arg("numThreads") = 0)
+      .def("getBatchSize", &dart::simulation::WorldBatch::getBatchSize)
+      .def("getNumDofs", &dart::simulation::WorldBatch::getNumDofs)
+      .def("getNumThreads", &dart::simulation::WorldBatch::getNumThreads)
+      .def(
+          "setAllFromWorld",
+          &dart::simulation::WorldBatch::setAllFromWorld,
+          ::py::arg("world"))
+      .def(
+          "copyToWorld",
+          &dart::simulation::WorldBatch::copyToWorld,
+          ::py::arg("index"),
+          ::py::arg("world"))
+      .def("getPositions", &dart::simulation::WorldBatch::getPositions)
+      .def("getVelocities", &dart::simulation::WorldBatch::getVelocities)
+      .def(
+          "getExternalForces",
+          &dart::simulation::WorldBatch::getExternalForces)
+      .def(
+          "setPositions",
+          &dart::simulation::WorldBatch::setPositions,
+          ::py::arg("positions"))
+      .def(
+          "setVelocities",
+          &dart::simulation::WorldBatch::setVelocities,
+          ::py::arg("velocities"))
+      .def(
+          "setExternalForces",
+          &dart::simulation::WorldBatch::setExternalForces,
+          ::py::arg("forces"))
+      .def("getTime", &dart::simulation::WorldBatch::getTime)
+      .def(
+          "step",
+          &dart::simulation::WorldBatch::step,
+          ::py::arg("resetCommand") = true,
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "rollout",
+          &dart::simulation::WorldBatch::rollout,
+          ::py::arg("numSteps"),
+          ::py::arg("resetCommand") = true,
+          ::py::call_guard<py::gil_scoped_release>());
+}
+
+} // namespace python
+} // namespace dart
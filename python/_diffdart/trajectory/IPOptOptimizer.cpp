@@ -96,7 +96,11 @@ void IPOptOptimizer(py::module& m)
       .def(
           "setRecordIterations",
           &dart::trajectory::IPOptOptimizer::setRecordIterations,
-          ::py::arg("recordIterations") = true);
+          ::py::arg("recordIterations") = true)
+      .def(
+          "setLinearSolver",
+          &dart::trajectory::IPOptOptimizer::setLinearSolver,
+          ::py::arg("linearSolver"));
   /*
   .def(
       "registerIntermediateCallback",
@@ -102,7 +102,10 @@ void Optimizer(py::module& m)
                 };
             self->registerIntermediateCallback(wrappedCallback);
           },
-          ::py::arg("callback"));
+          ::py::arg("callback"))
+      .def(
+          "canOptimizeConcurrently",
+          &dart::trajectory::Optimizer::canOptimizeConcurrently);
 }
 
 } // namespace python
@@ -204,7 +204,10 @@ virtual void getSparseJacobian(
 
 /// This computes finite difference Jacobians analagous to backpropJacobians()
 void finiteDifferenceJacobian(
-    std::shared_ptr<simulation::World> world, Eigen::Ref<Eigen::MatrixXd> jac);
+    std::shared_ptr<simulation::World> world,
+    Eigen::Ref<Eigen::MatrixXd> jac,
+    neural::FiniteDifferenceScheme scheme = neural::FD_CENTRAL,
+    double eps = 1e-7);
 
 /// This computes finite difference Jacobians analagous to
 /// backpropGradient()
@@ -235,6 +238,11 @@ void Problem(py::module& m)
       .def(
           "getExploreAlternateStrategies",
           &dart::trajectory::Problem::getExploreAlternateStrategies)
+      .def(
+          "setNumThreads",
+          &dart::trajectory::Problem::setNumThreads,
+          ::py::arg("numThreads"))
+      .def("getNumThreads", &dart::trajectory::Problem::getNumThreads)
       .def(
           "addConstraint",
           &dart::trajectory::Problem::addConstraint,
@@ -399,7 +407,9 @@ void Problem(py::module& m)
   "finiteDifferenceJacobian",
   &dart::trajectory::Problem::finiteDifferenceJacobian,
   ::py::arg("world"),
-  ::py::arg("jac"))
+  ::py::arg("jac"),
+  ::py::arg("scheme") = dart::neural::FD_CENTRAL,
+  ::py::arg("eps") = 1e-7)
 .def(
   "finiteDifferenceGradient",
   &dart::trajectory::Problem::finiteDifferenceGradient,
@@ -68,7 +68,11 @@ void SGDOptimizer(py::module& m)
       .def(
           "setLearningRate",
           &dart::trajectory::SGDOptimizer::setLearningRate,
-          ::py::arg("learningRate") = 0.1);
+          ::py::arg("learningRate") = 0.1)
+      .def(
+          "setSuppressOutput",
+          &dart::trajectory::SGDOptimizer::setSuppressOutput,
+          ::py::arg("suppressOutput") = true);
   /*
   .def(
       "registerIntermediateCallback",
@@ -54,7 +54,17 @@ void SingleShot(py::module& m)
           ::py::arg("world"),
           ::py::arg("loss"),
           ::py::arg("steps"),
-          ::py::arg("tuneStartingState") = false);
+          ::py::arg("tuneStartingState") = false)
+      .def(
+          "setSnapshotMemoryBudget",
+          &dart::trajectory::SingleShot::setSnapshotMemoryBudget,
+          ::py::arg("maxSnapshots"))
+      .def(
+          "getSnapshotMemoryBudget",
+          &dart::trajectory::SingleShot::getSnapshotMemoryBudget)
+      .def(
+          "getSnapshotCheckpointInterval",
+          &dart::trajectory::SingleShot::getSnapshotCheckpointInterval);
 }
 
 } // namespace python
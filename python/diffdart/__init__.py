@@ -1,5 +1,6 @@
 from diffdart_libs._diffdart import *
 from .dart_layer import dart_layer
+from .dart_layer_batch import dart_layer_batch
 from .dart_torch_loss_fn import DartTorchLossFn, DartTorchTrajectoryRollout
 from .dart_world_space_transforms import convert_to_world_space_positions_linear, convert_to_world_space_positions_spatial, convert_to_world_space_velocities_linear, convert_to_world_space_velocities_spatial, convert_to_world_space_center_of_mass, convert_to_world_space_center_of_mass_vel_linear, convert_to_world_space_center_of_mass_vel_spatial
 from .dart_gui_server import DartGUI
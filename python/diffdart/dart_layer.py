@@ -40,7 +40,9 @@ class DartLayer(torch.autograd.Function):
         if snapshot_pointer is not None:
             snapshot_pointer.backprop_snapshot = backprop_snapshot
 
-        return (torch.tensor(world.getPositions()), torch.tensor(world.getVelocities()))
+        # getPositions() and getVelocities() hand back freshly allocated arrays,
+        # so we can wrap them directly instead of copying them again
+        return (torch.from_numpy(world.getPositions()), torch.from_numpy(world.getVelocities()))
 
     @staticmethod
     def backward(ctx, grad_pos, grad_vel):
@@ -0,0 +1,71 @@
+import diffdart_libs._diffdart as dart
+import torch
+from typing import Tuple
+
+
+class DartLayerBatch(torch.autograd.Function):
+    """
+    This implements a single, differentiable timestep of a whole WorldBatch as a
+    PyTorch layer. Every row of the input tensors is one entry in the batch.
+    """
+
+    @staticmethod
+    def forward(ctx, batch, pos, vel, torque):
+        """
+        We can't put type annotations on this declaration, because the supertype
+        doesn't have any type annotations and otherwise mypy will complain, so here
+        are the types:
+
+        batch: dart.simulation.WorldBatch
+        pos: torch.Tensor, [B, N]
+        vel: torch.Tensor, [B, N]
+        torque: torch.Tensor, [B, N]
+        -> [torch.Tensor, torch.Tensor]
+        """
+
+        # DART stores a batch with one column per entry, so the transpose of a
+        # row-major [B, N] tensor is already in DART's layout. The whole step
+        # runs in parallel in C++, without the GIL.
+        snapshots: dart.neural.BackpropSnapshotBatch = dart.neural.forwardPassBatch(
+            batch,
+            pos.detach().double().numpy().T,
+            vel.detach().double().numpy().T,
+            torque.detach().double().numpy().T)
+        ctx.snapshots = snapshots
+
+        # These are freshly allocated [N, B] column-major arrays, so their
+        # transposes are [B, N] row-major, and torch can wrap them as they are
+        return (torch.from_numpy(snapshots.getPostStepPosition().T),
+                torch.from_numpy(snapshots.getPostStepVelocity().T))
+
+    @staticmethod
+    def backward(ctx, grad_pos, grad_vel):
+        """
+        In the backward pass we receive Tensors containing the gradient of the loss
+        with respect to the outputs, and we need to compute the gradient of the loss
+        with respect to the inputs, for every entry in the batch at once.
+        """
+        snapshots: dart.neural.BackpropSnapshotBatch = ctx.snapshots
+
+        lossWrtPosition, lossWrtVelocity, lossWrtTorque = snapshots.backprop(
+            grad_pos.detach().double().numpy().T,
+            grad_vel.detach().double().numpy().T)
+
+        return (
+            None,
+            torch.from_numpy(lossWrtPosition.T),
+            torch.from_numpy(lossWrtVelocity.T),
+            torch.from_numpy(lossWrtTorque.T)
+        )
+
+
+def dart_layer_batch(batch: dart.simulation.WorldBatch, pos: torch.Tensor, vel: torch.Tensor,
+                     torque: torch.Tensor) -> Tuple[torch.Tensor, torch.Tensor]:
+    """
+    This does a forward pass on every entry in `batch`, taking the state of entry i
+    from row i of `pos`, `vel` and `torque`, and stores the snapshots needed in
+    order to do a backwards pass. This is the batched version of `dart_layer`, and
+    `batch` is reused across calls, so its cloned Worlds and threads are only
+    created once.
+    """
+    return DartLayerBatch.apply(batch, pos, vel, torque)  # type: ignore
@@ -55,7 +55,7 @@ def main():
 
     def onReplan(time: int, rollout: dart.trajectory.TrajectoryRollout, duration: int):
         gui.stateMachine().renderTrajectoryLines(world, rollout.getPoses())
-    mpc = dart.realtime.MPCLocal(world.clone(), dartLoss, 3000)
+    mpc = dart.realtime.MPCLocal(world.clone(), dartLoss, 3 * 10**9)
     mpc.registerReplaningListener(onReplan)
     mpc.setSilent(True)
 
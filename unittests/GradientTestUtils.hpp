@@ -2619,6 +2619,173 @@ std::cout << "v_t --> p_t+1:" << std::endl
   return true;
 }
 
+bool verifyJvp(WorldPtr world, const neural::BackpropSnapshotPtr& classicPtr)
+{
+  int n = world->getNumDofs();
+  int m = world->getMassDims();
+
+  // Push every column of the identity through in one batch, which should
+  // recover the dense Jacobians exactly
+  Eigen::MatrixXd I = Eigen::MatrixXd::Identity(3 * n + m, 3 * n + m);
+  StateTangentBatch tangent = classicPtr->jvp(
+      world,
+      I.block(0, 0, n, 3 * n + m),
+      I.block(n, 0, n, 3 * n + m),
+      I.block(2 * n, 0, n, 3 * n + m),
+      I.block(3 * n, 0, m, 3 * n + m));
+
+  Eigen::MatrixXd brutePos = Eigen::MatrixXd::Zero(n, 3 * n + m);
+  brutePos.block(0, 0, n, n) = classicPtr->getPosPosJacobian(world);
+  brutePos.block(0, n, n, n) = classicPtr->getVelPosJacobian(world);
+  Eigen::MatrixXd bruteVel = Eigen::MatrixXd::Zero(n, 3 * n + m);
+  bruteVel.block(0, 0, n, n) = classicPtr->getPosVelJacobian(world);
+  bruteVel.block(0, n, n, n) = classicPtr->getVelVelJacobian(world);
+  bruteVel.block(0, 2 * n, n, n) = classicPtr->getForceVelJacobian(world);
+  bruteVel.block(0, 3 * n, n, m) = classicPtr->getMassVelJacobian(world);
+
+  if (!equals(tangent.dPosition, brutePos, 1e-7)
+      || !equals(tangent.dVelocity, bruteVel, 1e-7))
+  {
+    std::cout << "JVP doesn't match the dense Jacobians!" << std::endl;
+    std::cout << "Brute force pos tangent:" << std::endl
+              << brutePos << std::endl;
+    std::cout << "JVP pos tangent:" << std::endl
+              << tangent.dPosition << std::endl;
+    std::cout << "Brute force vel tangent:" << std::endl
+              << bruteVel << std::endl;
+    std::cout << "JVP vel tangent:" << std::endl
+              << tangent.dVelocity << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+bool verifyBackpropWithoutJacobians(
+    WorldPtr world,
+    const neural::BackpropSnapshotPtr& classicPtr,
+    const VectorXd& phaseSpace)
+{
+  int n = world->getNumDofs();
+
+  LossGradient nextTimeStep;
+  nextTimeStep.lossWrtPosition = phaseSpace.segment(0, n);
+  nextTimeStep.lossWrtVelocity = phaseSpace.segment(n, n);
+
+  LossGradient thisTimeStep;
+  classicPtr->backpropWithoutJacobians(world, thisTimeStep, nextTimeStep);
+
+  // This should match pushing the loss back through the dense Jacobians,
+  // before any clipping to the bounds
+  VectorXd brutePos
+      = classicPtr->getPosPosJacobian(world).transpose()
+            * nextTimeStep.lossWrtPosition
+        + classicPtr->getPosVelJacobian(world).transpose()
+              * nextTimeStep.lossWrtVelocity;
+  VectorXd bruteVel
+      = classicPtr->getVelPosJacobian(world).transpose()
+            * nextTimeStep.lossWrtPosition
+        + classicPtr->getVelVelJacobian(world).transpose()
+              * nextTimeStep.lossWrtVelocity;
+  VectorXd bruteTorque = classicPtr->getForceVelJacobian(world).transpose()
+                         * nextTimeStep.lossWrtVelocity;
+  VectorXd bruteMass = classicPtr->getMassVelJacobian(world).transpose()
+                       * nextTimeStep.lossWrtVelocity;
+
+  if (!equals(thisTimeStep.lossWrtPosition, brutePos, 1e-7)
+      || !equals(thisTimeStep.lossWrtVelocity, bruteVel, 1e-7)
+      || !equals(thisTimeStep.lossWrtTorque, bruteTorque, 1e-7)
+      || !equals(thisTimeStep.lossWrtMass, bruteMass, 1e-7))
+  {
+    std::cout << "Backprop without Jacobians doesn't match the dense "
+                 "Jacobians!"
+              << std::endl;
+    std::cout << "Clamping constraints: " << classicPtr->getNumClamping()
+              << std::endl;
+    std::cout << "Brute force loss wrt position:" << std::endl
+              << brutePos << std::endl;
+    std::cout << "VJP loss wrt position:" << std::endl
+              << thisTimeStep.lossWrtPosition << std::endl;
+    std::cout << "Brute force loss wrt velocity:" << std::endl
+              << bruteVel << std::endl;
+    std::cout << "VJP loss wrt velocity:" << std::endl
+              << thisTimeStep.lossWrtVelocity << std::endl;
+    std::cout << "Brute force loss wrt torque:" << std::endl
+              << bruteTorque << std::endl;
+    std::cout << "VJP loss wrt torque:" << std::endl
+              << thisTimeStep.lossWrtTorque << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+bool verifyBackpropWithoutJacobiansAgainstFD(WorldPtr world)
+{
+  neural::BackpropSnapshotPtr classicPtr = neural::forwardPass(world, true);
+
+  if (!classicPtr)
+  {
+    std::cout << "verifyBackpropWithoutJacobiansAgainstFD forwardPass returned "
+                 "a null BackpropSnapshotPtr!"
+              << std::endl;
+    return false;
+  }
+
+  int n = world->getNumDofs();
+
+  LossGradient nextTimeStep;
+  nextTimeStep.lossWrtPosition = VectorXd::Random(n);
+  nextTimeStep.lossWrtVelocity = VectorXd::Random(n);
+
+  LossGradient thisTimeStep;
+  classicPtr->backpropWithoutJacobians(world, thisTimeStep, nextTimeStep);
+
+  // When anything is clamping, this goes through the position derivatives of
+  // the contact geometry, so check it against finite differences rather than
+  // the analytical Jacobians
+  VectorXd brutePos
+      = classicPtr->finiteDifferencePosPosJacobian(world, 1).transpose()
+            * nextTimeStep.lossWrtPosition
+        + classicPtr->finiteDifferencePosVelJacobian(world).transpose()
+              * nextTimeStep.lossWrtVelocity;
+  VectorXd bruteVel
+      = classicPtr->finiteDifferenceVelPosJacobian(world, 1).transpose()
+            * nextTimeStep.lossWrtPosition
+        + classicPtr->finiteDifferenceVelVelJacobian(world).transpose()
+              * nextTimeStep.lossWrtVelocity;
+  VectorXd bruteTorque
+      = classicPtr->finiteDifferenceForceVelJacobian(world).transpose()
+        * nextTimeStep.lossWrtVelocity;
+
+  if (!equals(thisTimeStep.lossWrtPosition, brutePos, 1e-7)
+      || !equals(thisTimeStep.lossWrtVelocity, bruteVel, 1e-7)
+      || !equals(thisTimeStep.lossWrtTorque, bruteTorque, 1e-7))
+  {
+    std::cout << "Backprop without Jacobians doesn't match finite "
+                 "differences!"
+              << std::endl;
+    std::cout << "Clamping constraints: " << classicPtr->getNumClamping()
+              << ", upper bound constraints: "
+              << classicPtr->getNumUpperBound() << std::endl;
+    std::cout << "Finite difference loss wrt position:" << std::endl
+              << brutePos << std::endl;
+    std::cout << "VJP loss wrt position:" << std::endl
+              << thisTimeStep.lossWrtPosition << std::endl;
+    std::cout << "Finite difference loss wrt velocity:" << std::endl
+              << bruteVel << std::endl;
+    std::cout << "VJP loss wrt velocity:" << std::endl
+              << thisTimeStep.lossWrtVelocity << std::endl;
+    std::cout << "Finite difference loss wrt torque:" << std::endl
+              << bruteTorque << std::endl;
+    std::cout << "VJP loss wrt torque:" << std::endl
+              << thisTimeStep.lossWrtTorque << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
 bool verifyAnalyticalBackprop(WorldPtr world)
 {
   neural::BackpropSnapshotPtr classicPtr = neural::forwardPass(world, true);
@@ -2636,6 +2803,9 @@ bool verifyAnalyticalBackprop(WorldPtr world)
   if (!verifyConstraintGroupSubJacobians(world, classicPtr))
     return false;
 
+  if (!verifyJvp(world, classicPtr))
+    return false;
+
   VectorXd phaseSpace = VectorXd::Zero(world->getNumDofs() * 2);
 
   // Test a "1" in each dimension of the phase space separately
@@ -2646,6 +2816,8 @@ bool verifyAnalyticalBackprop(WorldPtr world)
       phaseSpace(i - 1) = 0;
     if (!verifyAnalyticalBackpropInstance(world, classicPtr, phaseSpace))
       return false;
+    if (!verifyBackpropWithoutJacobians(world, classicPtr, phaseSpace))
+      return false;
   }
 
   // Test all "0"s
@@ -2657,6 +2829,8 @@ bool verifyAnalyticalBackprop(WorldPtr world)
   phaseSpace = VectorXd::Ones(world->getNumDofs() * 2);
   if (!verifyAnalyticalBackpropInstance(world, classicPtr, phaseSpace))
     return false;
+  if (!verifyBackpropWithoutJacobians(world, classicPtr, phaseSpace))
+    return false;
 
   return true;
 }
@@ -5904,9 +6078,85 @@ bool verifyVelocityScrews(WorldPtr world)
   return true;
 }
 
+bool verifyAnalyticalCJacobians(WorldPtr world)
+{
+  for (int i = 0; i < world->getNumSkeletons(); i++)
+  {
+    std::shared_ptr<dynamics::Skeleton> skel = world->getSkeleton(i);
+    if (!skel->canDifferentiateCAnalytically())
+      continue;
+
+    Eigen::MatrixXd analyticalPos
+        = skel->getJacobianOfC(WithRespectTo::POSITION);
+    Eigen::MatrixXd bruteForcePos
+        = skel->finiteDifferenceJacobianOfC(WithRespectTo::POSITION, true);
+    if (!equals(analyticalPos, bruteForcePos, 1e-8))
+    {
+      std::cout << "Skeleton " << skel->getName()
+                << " analytical C Jacobian wrt position error: " << std::endl
+                << "Analytical: " << std::endl
+                << analyticalPos << std::endl
+                << "Brute force: " << std::endl
+                << bruteForcePos << std::endl
+                << "Diff: " << std::endl
+                << (analyticalPos - bruteForcePos) << std::endl;
+      return false;
+    }
+
+    Eigen::MatrixXd analyticalVel = skel->getVelCJacobian();
+    Eigen::MatrixXd bruteForceVel = skel->finiteDifferenceVelCJacobian(true);
+    if (!equals(analyticalVel, bruteForceVel, 1e-8))
+    {
+      std::cout << "Skeleton " << skel->getName()
+                << " analytical C Jacobian wrt velocity error: " << std::endl
+                << "Analytical: " << std::endl
+                << analyticalVel << std::endl
+                << "Brute force: " << std::endl
+                << bruteForceVel << std::endl
+                << "Diff: " << std::endl
+                << (analyticalVel - bruteForceVel) << std::endl;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool verifyAnalyticalMinvJacobians(WorldPtr world)
+{
+  for (int i = 0; i < world->getNumSkeletons(); i++)
+  {
+    std::shared_ptr<dynamics::Skeleton> skel = world->getSkeleton(i);
+    if (!skel->canDifferentiateCAnalytically())
+      continue;
+
+    Eigen::VectorXd f = Eigen::VectorXd::Random(skel->getNumDofs());
+    Eigen::MatrixXd analytical
+        = skel->getJacobianOfMinv(f, WithRespectTo::POSITION);
+    Eigen::MatrixXd bruteForce
+        = skel->finiteDifferenceJacobianOfMinv(f, WithRespectTo::POSITION, true);
+    if (!equals(analytical, bruteForce, 1e-8))
+    {
+      std::cout << "Skeleton " << skel->getName()
+                << " analytical Minv Jacobian wrt position error: " << std::endl
+                << "Analytical: " << std::endl
+                << analytical << std::endl
+                << "Brute force: " << std::endl
+                << bruteForce << std::endl
+                << "Diff: " << std::endl
+                << (analytical - bruteForce) << std::endl;
+      return false;
+    }
+  }
+
+  return true;
+}
+
 bool verifyAnalyticalJacobians(WorldPtr world, bool allowNoContacts = false)
 {
   return verifyPositionScrews(world) && verifyVelocityScrews(world)
+         && verifyAnalyticalCJacobians(world)
+         && verifyAnalyticalMinvJacobians(world)
          && verifyPerturbedContactEdges(world)
          && verifyPerturbedContactPositions(world, allowNoContacts)
          && verifyPerturbedContactNormals(world)
@@ -6055,6 +6305,44 @@ bool verifyJacobiansWrt(WorldPtr world, WithRespectTo* wrt)
          && verifyPosJacobianWrt(world, wrt);
 }
 
+bool verifyAnalyticalMassJacobians(WorldPtr world, WithRespectTo* wrt)
+{
+  for (int i = 0; i < world->getNumSkeletons(); i++)
+  {
+    auto skel = world->getSkeleton(i);
+    if (wrt->dim(skel.get()) == 0)
+      continue;
+
+    MatrixXd analyticalC = skel->getJacobianOfC(wrt);
+    MatrixXd bruteForceC = skel->finiteDifferenceJacobianOfC(wrt, true);
+    if (!equals(analyticalC, bruteForceC, 1e-8))
+    {
+      std::cout << "Brute force wrt-mass C Jacobian: " << std::endl
+                << bruteForceC << std::endl;
+      std::cout << "Analytical wrt-mass C Jacobian: " << std::endl
+                << analyticalC << std::endl;
+      std::cout << "Diff Jacobian: " << std::endl
+                << (bruteForceC - analyticalC) << std::endl;
+      return false;
+    }
+
+    Eigen::VectorXd f = Eigen::VectorXd::Random(skel->getNumDofs());
+    MatrixXd analyticalMinv = skel->getJacobianOfMinv(f, wrt);
+    MatrixXd bruteForceMinv = skel->finiteDifferenceJacobianOfMinv(f, wrt, true);
+    if (!equals(analyticalMinv, bruteForceMinv, 1e-8))
+    {
+      std::cout << "Brute force wrt-mass Minv Jacobian: " << std::endl
+                << bruteForceMinv << std::endl;
+      std::cout << "Analytical wrt-mass Minv Jacobian: " << std::endl
+                << analyticalMinv << std::endl;
+      std::cout << "Diff Jacobian: " << std::endl
+                << (bruteForceMinv - analyticalMinv) << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
 bool verifyWrtMass(WorldPtr world)
 {
   WithRespectToMass massMapping = WithRespectToMass();
@@ -6073,6 +6361,12 @@ bool verifyWrtMass(WorldPtr world)
     }
   }
 
+  if (!verifyAnalyticalMassJacobians(world, &massMapping))
+  {
+    std::cout << "Error with analytical Jacobians on mass" << std::endl;
+    return false;
+  }
+
   // return verifyScratch(world, &massMapping);
   // TODO: re-enable me later
   return true;
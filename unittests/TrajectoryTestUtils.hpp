@@ -273,6 +273,82 @@ bool verifyShotJacobian(
   return true;
 }
 
+bool verifyCheckpointedShot(WorldPtr world, int steps, int memoryBudget)
+{
+  LossFn lossFn = LossFn();
+  SingleShot shot(world, lossFn, steps, true);
+  int stateSize = world->getNumDofs() * 2;
+  int dim = shot.getFlatProblemDim(world);
+
+  Eigen::VectorXd fullFinalState = shot.getFinalState(world);
+  Eigen::MatrixXd fullJacobian = Eigen::MatrixXd::Zero(stateSize, dim);
+  shot.backpropJacobianOfFinalState(world, fullJacobian);
+
+  shot.setSnapshotMemoryBudget(memoryBudget);
+  if (shot.getSnapshotCheckpointInterval() >= steps)
+  {
+    std::cout << "Memory budget " << memoryBudget << " didn't checkpoint "
+              << steps << " steps!" << std::endl;
+    return false;
+  }
+
+  Eigen::VectorXd checkpointedFinalState = shot.getFinalState(world);
+  Eigen::MatrixXd checkpointedJacobian = Eigen::MatrixXd::Zero(stateSize, dim);
+  shot.backpropJacobianOfFinalState(world, checkpointedJacobian);
+
+  if (!equals(fullFinalState, checkpointedFinalState, 1e-12)
+      || !equals(fullJacobian, checkpointedJacobian, 1e-12))
+  {
+    std::cout << "Checkpointed shot doesn't match!" << std::endl;
+    std::cout << "Full final state:" << std::endl
+              << fullFinalState << std::endl;
+    std::cout << "Checkpointed final state:" << std::endl
+              << checkpointedFinalState << std::endl;
+    std::cout << "Diff Jacobian:" << std::endl
+              << (fullJacobian - checkpointedJacobian) << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool verifyIncrementalShot(WorldPtr world, int steps)
+{
+  LossFn lossFn = LossFn();
+  SingleShot shot(world, lossFn, steps, true);
+  int staticDim = shot.getFlatStaticProblemDim(world);
+  int dynamicDim = shot.getFlatDynamicProblemDim(world);
+
+  // Simulate once, then only change the forces in the second half
+  shot.getFinalState(world);
+  Eigen::VectorXd flatStatic = Eigen::VectorXd::Zero(staticDim);
+  Eigen::VectorXd flatDynamic = Eigen::VectorXd::Zero(dynamicDim);
+  shot.flatten(world, flatStatic, flatDynamic);
+  int forceDim = world->getNumDofs();
+  for (int i = steps / 2; i < steps; i++)
+  {
+    flatDynamic.segment(dynamicDim - (steps - i) * forceDim, forceDim)
+        = Eigen::VectorXd::Ones(forceDim) * 0.1 * (i - steps / 2);
+  }
+  shot.unflatten(world, flatStatic, flatDynamic);
+  Eigen::VectorXd incrementalFinalState = shot.getFinalState(world);
+
+  // A fresh shot has to simulate the whole thing
+  SingleShot freshShot(world, lossFn, steps, true);
+  freshShot.unflatten(world, flatStatic, flatDynamic);
+  Eigen::VectorXd freshFinalState = freshShot.getFinalState(world);
+
+  if (!equals(incrementalFinalState, freshFinalState, 1e-12))
+  {
+    std::cout << "Incremental shot doesn't match a fresh one!" << std::endl;
+    std::cout << "Incremental final state:" << std::endl
+              << incrementalFinalState << std::endl;
+    std::cout << "Fresh final state:" << std::endl
+              << freshFinalState << std::endl;
+    return false;
+  }
+  return true;
+}
+
 bool verifyShotGradient(
     WorldPtr world,
     int steps,
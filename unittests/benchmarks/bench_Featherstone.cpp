@@ -85,6 +85,9 @@ static void BM_Cartpole_Simple_Featherstone(benchmark::State& state)
     }
   }
 
+  state.counters["states/s"] = benchmark::Counter(
+      static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+
   free(pos);
   free(vel);
   free(force);
@@ -135,6 +138,9 @@ static void BM_20_Joint_Simple_Featherstone(benchmark::State& state)
     }
   }
 
+  state.counters["states/s"] = benchmark::Counter(
+      static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+
   free(pos);
   free(vel);
   free(force);
@@ -142,4 +148,32 @@ static void BM_20_Joint_Simple_Featherstone(benchmark::State& state)
 }
 BENCHMARK(BM_20_Joint_Simple_Featherstone);
 
+static void BM_20_Joint_Simple_Featherstone_Batch(benchmark::State& state)
+{
+  SkeletonPtr arm = createMultiarmRobot(20, 0.2);
+  SimpleFeatherstone simple;
+  simple.populateFromSkeleton(arm);
+
+  const int numStates = state.range(0);
+  // DOF-major, so DOF i of state k is at (k, i)
+  Eigen::MatrixXd pos = Eigen::MatrixXd::Random(numStates, simple.len());
+  Eigen::MatrixXd vel = Eigen::MatrixXd::Random(numStates, simple.len());
+  Eigen::MatrixXd force = Eigen::MatrixXd::Random(numStates, simple.len());
+  Eigen::MatrixXd accel = Eigen::MatrixXd::Zero(numStates, simple.len());
+
+  double dt = 0.001;
+  for (auto _ : state)
+  {
+    simple.forwardDynamicsBatch(
+        numStates, pos.data(), vel.data(), force.data(), accel.data());
+    pos += vel * dt;
+    vel += accel * dt;
+  }
+
+  state.counters["states/s"] = benchmark::Counter(
+      static_cast<double>(state.iterations()) * numStates,
+      benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_20_Joint_Simple_Featherstone_Batch)->Arg(8)->Arg(64)->Arg(1024);
+
 BENCHMARK_MAIN();
\ No newline at end of file
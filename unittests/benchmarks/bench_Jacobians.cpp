@@ -20,6 +20,7 @@
 #include "dart/neural/NeuralConstants.hpp"
 #include "dart/neural/NeuralUtils.hpp"
 #include "dart/neural/RestorableSnapshot.hpp"
+#include "dart/neural/WithRespectToMass.hpp"
 #include "dart/performance/PerformanceLog.hpp"
 #include "dart/simulation/World.hpp"
 #include "dart/trajectory/IPOptOptimizer.hpp"
@@ -289,6 +290,56 @@ static void BM_Jumpworm_Finite_Difference(benchmark::State& state)
 // Register the function as a benchmark
 BENCHMARK(BM_Jumpworm_Finite_Difference);
 
+std::shared_ptr<WithRespectToMass> createJumpwormInertiaMapping(
+    WorldPtr world)
+{
+  std::shared_ptr<WithRespectToMass> mapping
+      = std::make_shared<WithRespectToMass>();
+  SkeletonPtr jumpworm = world->getSkeleton("jumpworm");
+  for (int i = 0; i < jumpworm->getNumBodyNodes(); i++)
+  {
+    mapping->registerNode(
+        jumpworm->getBodyNode(i),
+        INERTIA_FULL,
+        Eigen::VectorXd::Ones(10) * 1000,
+        Eigen::VectorXd::Ones(10) * -1000);
+  }
+  return mapping;
+}
+
+static void BM_Jumpworm_Mass_Jacobian(benchmark::State& state)
+{
+  WorldPtr world = createJumpwormWorld();
+  std::shared_ptr<WithRespectToMass> mapping
+      = createJumpwormInertiaMapping(world);
+
+  std::shared_ptr<BackpropSnapshot> snapshot
+      = neural::forwardPass(world, true);
+  for (auto _ : state)
+  {
+    snapshot->getVelJacobianWrt(world, mapping.get());
+  }
+};
+// Register the function as a benchmark
+BENCHMARK(BM_Jumpworm_Mass_Jacobian);
+
+static void BM_Jumpworm_Mass_Jacobian_Finite_Difference(
+    benchmark::State& state)
+{
+  WorldPtr world = createJumpwormWorld();
+  std::shared_ptr<WithRespectToMass> mapping
+      = createJumpwormInertiaMapping(world);
+
+  std::shared_ptr<BackpropSnapshot> snapshot
+      = neural::forwardPass(world, true);
+  for (auto _ : state)
+  {
+    snapshot->finiteDifferenceVelJacobianWrt(world, mapping.get());
+  }
+};
+// Register the function as a benchmark
+BENCHMARK(BM_Jumpworm_Mass_Jacobian_Finite_Difference);
+
 static void BM_Atlas(benchmark::State& state)
 {
   // Create a world
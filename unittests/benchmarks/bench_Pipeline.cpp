@@ -0,0 +1,602 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "dart/collision/CollisionResult.hpp"
+#include "dart/constraint/ConstraintSolver.hpp"
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/BoxShape.hpp"
+#include "dart/dynamics/FreeJoint.hpp"
+#include "dart/dynamics/PrismaticJoint.hpp"
+#include "dart/dynamics/RevoluteJoint.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/dynamics/TranslationalJoint2D.hpp"
+#include "dart/dynamics/WeldJoint.hpp"
+#include "dart/math/Constants.hpp"
+#include "dart/neural/BackpropSnapshot.hpp"
+#include "dart/neural/NeuralUtils.hpp"
+#include "dart/simulation/World.hpp"
+#include "dart/trajectory/IPOptOptimizer.hpp"
+#include "dart/trajectory/LossFn.hpp"
+#include "dart/trajectory/MultiShot.hpp"
+#include "dart/trajectory/TrajectoryRollout.hpp"
+#include "dart/utils/UniversalLoader.hpp"
+
+using namespace dart;
+using namespace dynamics;
+using namespace simulation;
+using namespace neural;
+using namespace trajectory;
+
+// This times every stage of the differentiable step pipeline that our
+// optimization jobs depend on, on each of the bundled models, plus a sweep
+// over DoF counts (a revolute chain) and contact counts (a pile of boxes).
+//
+// Benchmarks are named "<model>/<stage>", so you can pick out a subset with
+// --benchmark_filter, e.g. --benchmark_filter='atlas/.*' or '.*/Backprop'.
+// Unless you pass your own --benchmark_out, results are also written as JSON
+// to bench_Pipeline.json in the working directory, for regression tracking.
+
+//==============================================================================
+// Models
+//==============================================================================
+
+WorldPtr createCartpoleWorld()
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3d(0, -9.81, 0));
+
+  SkeletonPtr cartpole = Skeleton::create("cartpole");
+
+  std::pair<PrismaticJoint*, BodyNode*> sledPair
+      = cartpole->createJointAndBodyNodePair<PrismaticJoint>(nullptr);
+  sledPair.first->setAxis(Eigen::Vector3d(1, 0, 0));
+  sledPair.second->createShapeNodeWith<VisualAspect>(
+      std::make_shared<BoxShape>(Eigen::Vector3d(0.05, 0.25, 0.05)));
+
+  std::pair<RevoluteJoint*, BodyNode*> armPair
+      = cartpole->createJointAndBodyNodePair<RevoluteJoint>(sledPair.second);
+  armPair.first->setAxis(Eigen::Vector3d(0, 0, 1));
+  armPair.second->createShapeNodeWith<VisualAspect>(
+      std::make_shared<BoxShape>(Eigen::Vector3d(0.05, 0.25, 0.05)));
+
+  Eigen::Isometry3d armOffset = Eigen::Isometry3d::Identity();
+  armOffset.translation() = Eigen::Vector3d(0, -0.5, 0);
+  armPair.first->setTransformFromChildBodyNode(armOffset);
+
+  world->addSkeleton(cartpole);
+
+  cartpole->setForceUpperLimit(0, 1000);
+  cartpole->setForceLowerLimit(0, -1000);
+  cartpole->setForceUpperLimit(1, 0);
+  cartpole->setForceLowerLimit(1, 0);
+  cartpole->setPosition(1, 15.0 / 180.0 * math::constantsd::pi());
+
+  return world;
+}
+
+//==============================================================================
+WorldPtr createKR5World()
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3d(0.0, -9.81, 0.0));
+
+  std::shared_ptr<Skeleton> arm = utils::UniversalLoader::loadSkeleton(
+      world.get(), "dart://sample/urdf/KR5/KR5 sixx R650.urdf");
+  arm->setPositions(Eigen::VectorXd::Constant(arm->getNumDofs(), 0.2));
+
+  return world;
+}
+
+//==============================================================================
+WorldPtr createAtlasWorld()
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3d(0.0, -9.81, 0.0));
+
+  std::shared_ptr<Skeleton> atlas = utils::UniversalLoader::loadSkeleton(
+      world.get(), "dart://sample/sdf/atlas/atlas_v3_no_head.sdf");
+  utils::UniversalLoader::loadSkeleton(
+      world.get(), "dart://sample/sdf/atlas/ground.urdf");
+
+  atlas->setPosition(0, -0.5 * math::constantsd::pi());
+  atlas->setPosition(4, -0.01);
+
+  return world;
+}
+
+//==============================================================================
+WorldPtr createHalfCheetahWorld()
+{
+  WorldPtr world
+      = utils::UniversalLoader::loadWorld("dart://sample/skel/half_cheetah.skel");
+
+  SkeletonPtr cheetah = world->getSkeleton(1);
+  Eigen::VectorXd forceLimits
+      = Eigen::VectorXd::Constant(cheetah->getNumDofs(), 500);
+  forceLimits(0) = 0;
+  cheetah->setForceUpperLimits(forceLimits);
+  cheetah->setForceLowerLimits(-forceLimits);
+  cheetah->setPosition(2, 0.03);
+  cheetah->setPosition(1, -0.1);
+
+  return world;
+}
+
+//==============================================================================
+/// This adds a 0.25m revolute link to `parent`, the way the catapult and
+/// chain models are built
+BodyNode* createLink(BodyNode* parent, double initialAngle)
+{
+  std::pair<RevoluteJoint*, BodyNode*> pair
+      = parent->createChildJointAndBodyNodePair<RevoluteJoint>();
+  RevoluteJoint* joint = pair.first;
+  BodyNode* link = pair.second;
+  joint->setAxis(Eigen::Vector3d::UnitZ());
+
+  link->createShapeNodeWith<VisualAspect, CollisionAspect>(
+      std::make_shared<BoxShape>(Eigen::Vector3d(0.05, 0.25, 0.05)));
+  joint->setForceUpperLimit(0, 1000.0);
+  joint->setForceLowerLimit(0, -1000.0);
+  joint->setVelocityUpperLimit(0, 10000.0);
+  joint->setVelocityLowerLimit(0, -10000.0);
+
+  Eigen::Isometry3d offset = Eigen::Isometry3d::Identity();
+  offset.translation() = Eigen::Vector3d(0, -0.125, 0);
+  joint->setTransformFromChildBodyNode(offset);
+  joint->setPosition(0, initialAngle);
+
+  if (parent->getParentBodyNode() != nullptr)
+  {
+    Eigen::Isometry3d childOffset = Eigen::Isometry3d::Identity();
+    childOffset.translation() = Eigen::Vector3d(0, 0.125, 0);
+    joint->setTransformFromParentBodyNode(childOffset);
+  }
+
+  return link;
+}
+
+//==============================================================================
+/// This adds a welded box floor, centered at `center`
+void createFloor(WorldPtr world, Eigen::Vector3d center, Eigen::Vector3d size)
+{
+  SkeletonPtr floor = Skeleton::create("floor");
+  std::pair<WeldJoint*, BodyNode*> pair
+      = floor->createJointAndBodyNodePair<WeldJoint>(nullptr);
+  Eigen::Isometry3d offset = Eigen::Isometry3d::Identity();
+  offset.translation() = center;
+  pair.first->setTransformFromParentBodyNode(offset);
+  pair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(
+      std::make_shared<BoxShape>(size));
+  world->addSkeleton(floor);
+}
+
+//==============================================================================
+WorldPtr createCatapultWorld()
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3d(0.0, -9.81, 0.0));
+
+  SkeletonPtr projectile = Skeleton::create("projectile");
+  std::pair<TranslationalJoint2D*, BodyNode*> projectilePair
+      = projectile->createJointAndBodyNodePair<TranslationalJoint2D>(nullptr);
+  projectilePair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(
+      std::make_shared<BoxShape>(Eigen::Vector3d(0.1, 0.1, 0.1)));
+  projectile->setForceUpperLimits(Eigen::Vector2d::Zero());
+  projectile->setForceLowerLimits(Eigen::Vector2d::Zero());
+  projectile->setPositions(Eigen::Vector2d(0, 0.1));
+  world->addSkeleton(projectile);
+
+  SkeletonPtr catapult = Skeleton::create("catapult");
+  std::pair<WeldJoint*, BodyNode*> rootPair
+      = catapult->createJointAndBodyNodePair<WeldJoint>(nullptr);
+  Eigen::Isometry3d rootOffset = Eigen::Isometry3d::Identity();
+  rootOffset.translation() = Eigen::Vector3d(0.5, -0.45, 0);
+  rootPair.first->setTransformFromParentBodyNode(rootOffset);
+  BodyNode* tail = rootPair.second;
+  for (int i = 0; i < 3; i++)
+  {
+    tail = createLink(tail, 90 * math::constantsd::pi() / 180);
+  }
+  catapult->setPositions(
+      Eigen::Vector3d(45, 0, 45) * math::constantsd::pi() / 180);
+  world->addSkeleton(catapult);
+
+  createFloor(
+      world, Eigen::Vector3d(1.2, -0.7, 0), Eigen::Vector3d(3.5, 0.25, 0.5));
+
+  return world;
+}
+
+//==============================================================================
+/// This is a free-hanging revolute chain with `numLinks` DoFs, and no contacts
+WorldPtr createChainWorld(int numLinks)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3d(0.0, -9.81, 0.0));
+
+  SkeletonPtr chain = Skeleton::create("chain");
+  std::pair<WeldJoint*, BodyNode*> rootPair
+      = chain->createJointAndBodyNodePair<WeldJoint>(nullptr);
+  BodyNode* tail = rootPair.second;
+  for (int i = 0; i < numLinks; i++)
+  {
+    tail = createLink(tail, 10 * math::constantsd::pi() / 180);
+  }
+  world->addSkeleton(chain);
+
+  return world;
+}
+
+//==============================================================================
+/// This is a grid of free boxes resting on a floor, which gives 4 contact
+/// points per box
+WorldPtr createBoxPileWorld(int numBoxes)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3d(0.0, -9.81, 0.0));
+
+  createFloor(
+      world, Eigen::Vector3d(0, -0.5, 0), Eigen::Vector3d(20.0, 1.0, 20.0));
+
+  const int side = std::ceil(std::sqrt(numBoxes));
+  for (int i = 0; i < numBoxes; i++)
+  {
+    SkeletonPtr box = Skeleton::create("box_" + std::to_string(i));
+    std::pair<FreeJoint*, BodyNode*> pair
+        = box->createJointAndBodyNodePair<FreeJoint>(nullptr);
+    pair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(
+        std::make_shared<BoxShape>(Eigen::Vector3d(0.5, 0.5, 0.5)));
+    pair.second->setFrictionCoeff(0.5);
+    box->setPosition(3, 0.75 * (i % side));
+    box->setPosition(4, 0.249);
+    box->setPosition(5, 0.75 * (i / side));
+    world->addSkeleton(box);
+  }
+
+  return world;
+}
+
+//==============================================================================
+/// This is the box pile, but with every box's mass registered as a
+/// differentiable parameter, so that the mass Jacobians have some real work to
+/// do
+WorldPtr createMassBoxPileWorld(int numBoxes)
+{
+  WorldPtr world = createBoxPileWorld(numBoxes);
+  for (int i = 0; i < numBoxes; i++)
+  {
+    world->getWrtMass()->registerNode(
+        world->getSkeleton("box_" + std::to_string(i))->getBodyNode(0),
+        neural::WrtMassBodyNodeEntryType::INERTIA_MASS,
+        Eigen::VectorXd::Ones(1) * 5.0,
+        Eigen::VectorXd::Ones(1) * 0.1);
+  }
+  return world;
+}
+
+//==============================================================================
+// Pipeline stages
+//==============================================================================
+
+/// This resets a World to the state it was in when it was constructed, so
+/// that every benchmark iteration does exactly the same work
+class WorldResetter
+{
+public:
+  explicit WorldResetter(WorldPtr world)
+    : mWorld(world),
+      mPositions(world->getPositions()),
+      mVelocities(world->getVelocities()),
+      mForces(world->getExternalForces()),
+      mLCPCache(world->getCachedLCPSolution())
+  {
+  }
+
+  void reset()
+  {
+    mWorld->setPositions(mPositions);
+    mWorld->setVelocities(mVelocities);
+    mWorld->setExternalForces(mForces);
+    mWorld->setCachedLCPSolution(mLCPCache);
+  }
+
+protected:
+  WorldPtr mWorld;
+  Eigen::VectorXd mPositions;
+  Eigen::VectorXd mVelocities;
+  Eigen::VectorXd mForces;
+  Eigen::VectorXd mLCPCache;
+};
+
+//==============================================================================
+/// This records the size of the problem alongside the timings, so that the
+/// JSON output can be plotted against DoFs and contacts
+void reportProblemSize(benchmark::State& state, WorldPtr world)
+{
+  state.counters["dofs"] = world->getNumDofs();
+  state.counters["contacts"]
+      = world->getLastCollisionResult().getNumContacts();
+}
+
+//==============================================================================
+void benchmarkStep(benchmark::State& state, WorldPtr world, bool gradients)
+{
+  world->getConstraintSolver()->setGradientEnabled(gradients);
+  WorldResetter resetter(world);
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    resetter.reset();
+    state.ResumeTiming();
+    world->step();
+  }
+  reportProblemSize(state, world);
+}
+
+//==============================================================================
+void benchmarkForwardPass(benchmark::State& state, WorldPtr world)
+{
+  WorldResetter resetter(world);
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    resetter.reset();
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(neural::forwardPass(world, true));
+  }
+  reportProblemSize(state, world);
+}
+
+//==============================================================================
+void benchmarkBackprop(benchmark::State& state, WorldPtr world)
+{
+  WorldResetter resetter(world);
+  LossGradient nextTimestepLoss;
+  nextTimestepLoss.lossWrtPosition = Eigen::VectorXd::Ones(world->getNumDofs());
+  nextTimestepLoss.lossWrtVelocity = Eigen::VectorXd::Ones(world->getNumDofs());
+  for (auto _ : state)
+  {
+    // BackpropSnapshot caches its intermediate matrices, so we need a fresh
+    // one each time
+    state.PauseTiming();
+    resetter.reset();
+    std::shared_ptr<BackpropSnapshot> snapshot
+        = neural::forwardPass(world, true);
+    resetter.reset();
+    state.ResumeTiming();
+
+    LossGradient thisTimestepLoss;
+    snapshot->backprop(world, thisTimestepLoss, nextTimestepLoss);
+    benchmark::DoNotOptimize(thisTimestepLoss.lossWrtPosition.data());
+  }
+  reportProblemSize(state, world);
+}
+
+//==============================================================================
+typedef std::function<const Eigen::MatrixXd&(
+    BackpropSnapshot* snapshot, WorldPtr world)>
+    JacobianFn;
+
+void benchmarkJacobian(
+    benchmark::State& state, WorldPtr world, const JacobianFn& jacobian)
+{
+  WorldResetter resetter(world);
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    resetter.reset();
+    std::shared_ptr<BackpropSnapshot> snapshot
+        = neural::forwardPass(world, true);
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(jacobian(snapshot.get(), world).data());
+  }
+  reportProblemSize(state, world);
+}
+
+//==============================================================================
+/// This is a simple loss on the final state, which works for any model
+LossFn createFinalStateLoss()
+{
+  return LossFn([](const TrajectoryRollout* rollout) {
+    const int last = rollout->getPosesConst().cols() - 1;
+    return rollout->getPosesConst().col(last).squaredNorm()
+           + rollout->getVelsConst().col(last).squaredNorm();
+  });
+}
+
+const int TRAJECTORY_STEPS = 20;
+const int SHOT_LENGTH = 5;
+
+//==============================================================================
+void benchmarkMultiShotConstraints(benchmark::State& state, WorldPtr world)
+{
+  MultiShot shot(
+      world, createFinalStateLoss(), TRAJECTORY_STEPS, SHOT_LENGTH, false);
+  Eigen::VectorXd constraints = Eigen::VectorXd::Zero(shot.getConstraintDim());
+  for (auto _ : state)
+  {
+    shot.computeConstraints(world, constraints);
+    benchmark::DoNotOptimize(constraints.data());
+  }
+  reportProblemSize(state, world);
+}
+
+//==============================================================================
+void benchmarkMultiShotJacobian(benchmark::State& state, WorldPtr world)
+{
+  MultiShot shot(
+      world, createFinalStateLoss(), TRAJECTORY_STEPS, SHOT_LENGTH, false);
+  Eigen::MatrixXd jac = Eigen::MatrixXd::Zero(
+      shot.getConstraintDim(), shot.getFlatProblemDim(world));
+  for (auto _ : state)
+  {
+    static_cast<Problem&>(shot).backpropJacobian(world, jac);
+    benchmark::DoNotOptimize(jac.data());
+  }
+  reportProblemSize(state, world);
+}
+
+const int IPOPT_ITERATIONS = 3;
+
+//==============================================================================
+/// Each benchmark iteration here is a fresh optimization of IPOPT_ITERATIONS
+/// IPOPT iterations, so divide by that for the cost of a single iteration
+void benchmarkIPOpt(benchmark::State& state, WorldPtr world)
+{
+  WorldResetter resetter(world);
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    resetter.reset();
+    MultiShot shot(
+        world, createFinalStateLoss(), TRAJECTORY_STEPS, SHOT_LENGTH, false);
+    IPOptOptimizer optimizer;
+    optimizer.setIterationLimit(IPOPT_ITERATIONS);
+    optimizer.setCheckDerivatives(false);
+    optimizer.setSuppressOutput(true);
+    optimizer.setSilenceOutput(true);
+    state.ResumeTiming();
+
+    benchmark::DoNotOptimize(optimizer.optimize(&shot));
+  }
+  state.counters["ipopt_iterations"] = benchmark::Counter(
+      IPOPT_ITERATIONS * state.iterations(), benchmark::Counter::kIsRate);
+  reportProblemSize(state, world);
+}
+
+//==============================================================================
+// Registration
+//==============================================================================
+
+struct Model
+{
+  std::string name;
+  std::function<WorldPtr()> create;
+};
+
+//==============================================================================
+std::vector<Model> getModels()
+{
+  std::vector<Model> models;
+  models.push_back({"cartpole", createCartpoleWorld});
+  models.push_back({"kr5", createKR5World});
+  models.push_back({"atlas", createAtlasWorld});
+  models.push_back({"half_cheetah", createHalfCheetahWorld});
+  models.push_back({"catapult", createCatapultWorld});
+  for (int links : {4, 16, 64})
+  {
+    models.push_back({"chain_" + std::to_string(links) + "dof",
+                      [links]() { return createChainWorld(links); }});
+  }
+  for (int boxes : {1, 4, 16})
+  {
+    models.push_back({"box_pile_" + std::to_string(boxes),
+                      [boxes]() { return createBoxPileWorld(boxes); }});
+  }
+  models.push_back(
+      {"box_pile_4_mass", []() { return createMassBoxPileWorld(4); }});
+  return models;
+}
+
+//==============================================================================
+void registerPipelineBenchmarks()
+{
+  std::vector<std::pair<std::string, JacobianFn>> jacobians;
+  jacobians.emplace_back(
+      "PosPosJacobian", [](BackpropSnapshot* snapshot,
+             WorldPtr world) -> const Eigen::MatrixXd& {
+        return snapshot->getPosPosJacobian(world);
+      });
+  jacobians.emplace_back(
+      "PosVelJacobian", [](BackpropSnapshot* snapshot,
+             WorldPtr world) -> const Eigen::MatrixXd& {
+        return snapshot->getPosVelJacobian(world);
+      });
+  jacobians.emplace_back(
+      "VelPosJacobian", [](BackpropSnapshot* snapshot,
+             WorldPtr world) -> const Eigen::MatrixXd& {
+        return snapshot->getVelPosJacobian(world);
+      });
+  jacobians.emplace_back(
+      "VelVelJacobian", [](BackpropSnapshot* snapshot,
+             WorldPtr world) -> const Eigen::MatrixXd& {
+        return snapshot->getVelVelJacobian(world);
+      });
+  jacobians.emplace_back(
+      "ForceVelJacobian", [](BackpropSnapshot* snapshot,
+             WorldPtr world) -> const Eigen::MatrixXd& {
+        return snapshot->getForceVelJacobian(world);
+      });
+  jacobians.emplace_back(
+      "MassVelJacobian", [](BackpropSnapshot* snapshot,
+             WorldPtr world) -> const Eigen::MatrixXd& {
+        return snapshot->getMassVelJacobian(world);
+      });
+
+  for (const Model& model : getModels())
+  {
+    // Each benchmark gets its own World, so that no benchmark sees state left
+    // behind by another
+    std::function<WorldPtr()> create = model.create;
+    auto registerStage
+        = [&](const std::string& stage,
+              std::function<void(benchmark::State&, WorldPtr)> fn) {
+            benchmark::RegisterBenchmark(
+                (model.name + "/" + stage).c_str(),
+                [create, fn](benchmark::State& state) { fn(state, create()); })
+                ->Unit(benchmark::kMicrosecond);
+          };
+
+    registerStage("Step", [](benchmark::State& state, WorldPtr world) {
+      benchmarkStep(state, world, false);
+    });
+    registerStage(
+        "StepWithGradients", [](benchmark::State& state, WorldPtr world) {
+          benchmarkStep(state, world, true);
+        });
+    registerStage("ForwardPass", benchmarkForwardPass);
+    registerStage("Backprop", benchmarkBackprop);
+    for (const auto& jacobian : jacobians)
+    {
+      JacobianFn fn = jacobian.second;
+      registerStage(
+          jacobian.first, [fn](benchmark::State& state, WorldPtr world) {
+            benchmarkJacobian(state, world, fn);
+          });
+    }
+    registerStage("MultiShotConstraints", benchmarkMultiShotConstraints);
+    registerStage("MultiShotJacobian", benchmarkMultiShotJacobian);
+    registerStage("IPOpt", benchmarkIPOpt);
+  }
+}
+
+//==============================================================================
+int main(int argc, char** argv)
+{
+  registerPipelineBenchmarks();
+
+  // Default to also writing JSON, unless we were told where to write results
+  std::vector<char*> args(argv, argv + argc);
+  bool hasOut = std::any_of(args.begin(), args.end(), [](const char* arg) {
+    return std::string(arg).find("--benchmark_out=") == 0;
+  });
+  std::string outArg = "--benchmark_out=bench_Pipeline.json";
+  std::string formatArg = "--benchmark_out_format=json";
+  if (!hasOut)
+  {
+    args.push_back(&outArg[0]);
+    args.push_back(&formatArg[0]);
+  }
+  int numArgs = args.size();
+
+  benchmark::Initialize(&numArgs, args.data());
+  if (benchmark::ReportUnrecognizedArguments(numArgs, args.data()))
+    return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
@@ -1532,6 +1532,150 @@ TEST_F(Collision, CollisionOfPrescribedJoints)
 }
 #endif
 
+//==============================================================================
+std::size_t countOverlappingSpheres(
+    const std::vector<std::shared_ptr<SimpleFrame>>& frames,
+    std::size_t begin1,
+    std::size_t end1,
+    std::size_t begin2,
+    std::size_t end2,
+    double radius)
+{
+  std::size_t count = 0u;
+  for (auto i = begin1; i < end1; ++i)
+  {
+    for (auto j = std::max(begin2, i + 1u); j < end2; ++j)
+    {
+      const Eigen::Vector3d diff
+          = frames[i]->getTranslation() - frames[j]->getTranslation();
+      if (diff.norm() < 2.0 * radius)
+        count++;
+    }
+  }
+  return count;
+}
+
+//==============================================================================
+#ifdef ALL_TESTS
+TEST_F(Collision, DARTBroadphase)
+{
+  const std::size_t numSpheres = 100u;
+  const double radius = 0.1;
+
+  auto cd = DARTCollisionDetector::create();
+  auto groupAll = cd->createCollisionGroup();
+  auto group1 = cd->createCollisionGroup();
+  auto group2 = cd->createCollisionGroup();
+
+  std::vector<std::shared_ptr<SimpleFrame>> frames;
+  for (auto i = 0u; i < numSpheres; ++i)
+  {
+    auto frame = SimpleFrame::createShared(Frame::World());
+    frame->setShape(std::make_shared<SphereShape>(radius));
+    frame->setTranslation(Eigen::Vector3d::Random());
+    frames.push_back(frame);
+
+    groupAll->addShapeFrame(frame.get());
+    if (i < numSpheres / 2u)
+      group1->addShapeFrame(frame.get());
+    else
+      group2->addShapeFrame(frame.get());
+  }
+
+  collision::CollisionOption option;
+  option.maxNumContacts = 10000u;
+  collision::CollisionResult result;
+
+  // Check twice, moving everything in between, so that the second pass runs
+  // on the incrementally updated sweep-and-prune ordering
+  for (auto pass = 0u; pass < 2u; ++pass)
+  {
+    const auto expectedAll = countOverlappingSpheres(
+        frames, 0u, numSpheres, 0u, numSpheres, radius);
+    result.clear();
+    groupAll->collide(option, &result);
+    EXPECT_EQ(result.getNumContacts(), expectedAll);
+
+    const auto expectedCross = countOverlappingSpheres(
+        frames, 0u, numSpheres / 2u, numSpheres / 2u, numSpheres, radius);
+    result.clear();
+    group1->collide(group2.get(), option, &result);
+    EXPECT_EQ(result.getNumContacts(), expectedCross);
+
+    for (auto& frame : frames)
+    {
+      frame->setTranslation(
+          frame->getTranslation() + 0.05 * Eigen::Vector3d::Random());
+    }
+  }
+
+  // Removing objects has to drop them from the broadphase too
+  for (auto i = 0u; i < numSpheres / 2u; ++i)
+    groupAll->removeShapeFrame(frames[i].get());
+  result.clear();
+  groupAll->collide(option, &result);
+  EXPECT_EQ(
+      result.getNumContacts(),
+      countOverlappingSpheres(
+          frames, numSpheres / 2u, numSpheres, 0u, numSpheres, radius));
+}
+#endif
+
+//==============================================================================
+#ifdef ALL_TESTS
+TEST_F(Collision, DARTBroadphaseSweepAxisHysteresis)
+{
+  const double radius = 0.5;
+
+  auto cd = DARTCollisionDetector::create();
+  auto group = cd->createCollisionGroup();
+  auto dartGroup = static_cast<DARTCollisionGroup*>(group.get());
+
+  // A 10x10 grid of spheres in the XZ plane, so the spread along each axis is
+  // proportional to the grid spacing along it
+  std::vector<std::shared_ptr<SimpleFrame>> frames;
+  for (auto i = 0u; i < 100u; ++i)
+  {
+    auto frame = SimpleFrame::createShared(Frame::World());
+    frame->setShape(std::make_shared<SphereShape>(radius));
+    frames.push_back(frame);
+    group->addShapeFrame(frame.get());
+  }
+  const auto layout = [&](double spacingX, double spacingZ) {
+    for (auto i = 0u; i < frames.size(); ++i)
+    {
+      frames[i]->setTranslation(
+          Eigen::Vector3d(spacingX * (i % 10u), 0.0, spacingZ * (i / 10u)));
+    }
+  };
+
+  collision::CollisionOption option;
+  option.maxNumContacts = 10000u;
+  collision::CollisionResult result;
+  const auto check = [&]() {
+    result.clear();
+    group->collide(option, &result);
+    EXPECT_EQ(
+        result.getNumContacts(),
+        countOverlappingSpheres(frames, 0u, 100u, 0u, 100u, radius));
+  };
+
+  layout(1.0, 0.9);
+  check();
+  EXPECT_EQ(dartGroup->getSweepAxis(), 0);
+
+  // Z is now slightly more spread out, but not by enough to be worth a re-sort
+  layout(1.0, 1.1);
+  check();
+  EXPECT_EQ(dartGroup->getSweepAxis(), 0);
+
+  // Z is now clearly more spread out, so we switch
+  layout(0.9, 1.5);
+  check();
+  EXPECT_EQ(dartGroup->getSweepAxis(), 2);
+}
+#endif
+
 //==============================================================================
 #ifdef ALL_TESTS
 TEST_F(Collision, Factory)
@@ -1538,6 +1538,22 @@ void DynamicsTest::compareEquationsOfMotion(const common::Uri& uri)
         cout << "InvAugM_AugM:" << endl << InvAugM_AugM << endl << endl;
       }
 
+      // Check if the mass matrix factorization of each tree inverts its mass
+      // matrix
+      for (std::size_t tree = 0; tree < skel->getNumTrees(); ++tree)
+      {
+        const MatrixXd& treeM = skel->getMassMatrix(tree);
+        MatrixXd treeInvM_M
+            = skel->getMassMatrixFactorization(tree).solve(treeM);
+        MatrixXd treeI = MatrixXd::Identity(treeM.rows(), treeM.cols());
+        EXPECT_TRUE(equals(treeInvM_M, treeI, 1e-6));
+        if (!equals(treeInvM_M, treeI, 1e-6))
+        {
+          cout << "treeInvM_M:" << endl << treeInvM_M << endl << endl;
+          failure = true;
+        }
+      }
+
       //------- Coriolis Force Vector and Combined Force Vector Tests --------
       // Get C1, Coriolis force vector using recursive method
       VectorXd C = skel->getCoriolisForces();
@@ -1317,6 +1317,49 @@ TEST(GRADIENTS, CARTPOLE_15_DEG)
 }
 #endif
 
+#ifdef ALL_TESTS
+TEST(GRADIENTS, CARTPOLE_ANALYTICAL_INERTIA_JACOBIANS)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3d(0, -9.81, 0));
+
+  SkeletonPtr cartpole = Skeleton::create("cartpole");
+
+  std::pair<PrismaticJoint*, BodyNode*> sledPair
+      = cartpole->createJointAndBodyNodePair<PrismaticJoint>(nullptr);
+  sledPair.first->setAxis(Eigen::Vector3d(1, 0, 0));
+
+  std::pair<RevoluteJoint*, BodyNode*> armPair
+      = cartpole->createJointAndBodyNodePair<RevoluteJoint>(sledPair.second);
+  armPair.first->setAxis(Eigen::Vector3d(0, 0, 1));
+
+  Eigen::Isometry3d armOffset = Eigen::Isometry3d::Identity();
+  armOffset.translation() = Eigen::Vector3d(0, -0.5, 0);
+  armPair.first->setTransformFromChildBodyNode(armOffset);
+
+  // Give the arm an off-center COM and a full inertia tensor, so every term
+  // in the spatial inertia shows up in the Jacobians
+  armPair.second->setInertia(dynamics::Inertia(
+      1.5, 0.1, -0.2, 0.05, 0.3, 0.4, 0.5, 0.01, -0.02, 0.03));
+
+  world->addSkeleton(cartpole);
+
+  cartpole->setPosition(1, 15.0 / 180.0 * 3.1415);
+  cartpole->setVelocity(0, 0.4);
+  cartpole->setVelocity(1, -0.7);
+
+  WithRespectToMass inertiaMapping = WithRespectToMass();
+  Eigen::VectorXd lowerBound = Eigen::VectorXd::Ones(10) * -1000;
+  Eigen::VectorXd upperBound = Eigen::VectorXd::Ones(10) * 1000;
+  inertiaMapping.registerNode(
+      sledPair.second, INERTIA_FULL, upperBound, lowerBound);
+  inertiaMapping.registerNode(
+      armPair.second, INERTIA_FULL, upperBound, lowerBound);
+
+  EXPECT_TRUE(verifyAnalyticalMassJacobians(world, &inertiaMapping));
+}
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////
 // Just idiot checking that the code doesn't crash on silly edge cases.
 ///////////////////////////////////////////////////////////////////////////////
@@ -1667,6 +1710,7 @@ void testFreeBlockWithFrictionCoeff(
   EXPECT_TRUE(verifyAnalyticalJacobians(world));
   EXPECT_TRUE(verifyVelGradients(world, worldVel));
   EXPECT_TRUE(verifyAnalyticalBackprop(world));
+  EXPECT_TRUE(verifyBackpropWithoutJacobiansAgainstFD(world));
   EXPECT_TRUE(verifyWrtMass(world));
   EXPECT_TRUE(verifyPosGradients(world, 1, 1e-8));
 
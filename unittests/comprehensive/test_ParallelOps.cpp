@@ -39,20 +39,25 @@
 
 #include "dart/collision/CollisionObject.hpp"
 #include "dart/collision/Contact.hpp"
+#include "dart/common/ThreadPool.hpp"
 #include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/RevoluteJoint.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/math/Geometry.hpp"
 #include "dart/neural/BackpropSnapshot.hpp"
+#include "dart/neural/BackpropSnapshotBatch.hpp"
 #include "dart/neural/ConstrainedGroupGradientMatrices.hpp"
 #include "dart/neural/DifferentiableContactConstraint.hpp"
+#include "dart/neural/FiniteDifferenceEngine.hpp"
 #include "dart/neural/IKMapping.hpp"
 #include "dart/neural/IdentityMapping.hpp"
 #include "dart/neural/Mapping.hpp"
 #include "dart/neural/NeuralConstants.hpp"
 #include "dart/neural/NeuralUtils.hpp"
 #include "dart/neural/RestorableSnapshot.hpp"
+#include "dart/neural/WithRespectToMass.hpp"
 #include "dart/simulation/World.hpp"
+#include "dart/simulation/WorldBatch.hpp"
 #include "dart/trajectory/IPOptOptimizer.hpp"
 #include "dart/trajectory/MultiShot.hpp"
 #include "dart/trajectory/Problem.hpp"
@@ -776,4 +781,373 @@ TEST(TRAJECTORY, JUMP_WORM)
       std::cout << "Off on force-vel Jac at step " << i << std::endl;
     }
   }
-}
\ No newline at end of file
+}
+
+WorldPtr createBoxOnFloorWorld()
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3d(0, -9.81, 0));
+  world->setPenetrationCorrectionEnabled(false);
+
+  SkeletonPtr box = Skeleton::create("box");
+  std::pair<TranslationalJoint2D*, BodyNode*> boxPair
+      = box->createJointAndBodyNodePair<TranslationalJoint2D>(nullptr);
+  boxPair.first->setXYPlane();
+  std::shared_ptr<BoxShape> boxShape(
+      new BoxShape(Eigen::Vector3d(0.1, 0.1, 0.1)));
+  boxPair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(boxShape);
+  boxPair.second->setFrictionCoeff(0.5);
+  world->addSkeleton(box);
+
+  SkeletonPtr floor = Skeleton::create("floor");
+  std::pair<WeldJoint*, BodyNode*> floorPair
+      = floor->createJointAndBodyNodePair<WeldJoint>(nullptr);
+  Eigen::Isometry3d floorOffset = Eigen::Isometry3d::Identity();
+  floorOffset.translation() = Eigen::Vector3d(0, -0.1, 0);
+  floorPair.first->setTransformFromParentBodyNode(floorOffset);
+  std::shared_ptr<BoxShape> floorShape(
+      new BoxShape(Eigen::Vector3d(2.5, 0.1, 0.5)));
+  floorPair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(
+      floorShape);
+  world->addSkeleton(floor);
+
+  return world;
+}
+
+TEST(WORLD_BATCH, MATCHES_SERIAL_STEPPING)
+{
+  WorldPtr world = createBoxOnFloorWorld();
+
+  const int BATCH = 16;
+  const int STEPS = 50;
+
+  WorldBatch batch(world, BATCH, 4);
+  EXPECT_EQ(batch.getBatchSize(), BATCH);
+  EXPECT_EQ(batch.getNumDofs(), (int)world->getNumDofs());
+
+  Eigen::MatrixXd forces = Eigen::MatrixXd::Random(world->getNumDofs(), BATCH);
+  Eigen::MatrixXd vels = Eigen::MatrixXd::Random(world->getNumDofs(), BATCH);
+  batch.setVelocities(vels);
+  batch.setExternalForces(forces);
+  batch.rollout(STEPS);
+
+  for (int i = 0; i < BATCH; i++)
+  {
+    WorldPtr serial = world->clone();
+    serial->setVelocities(vels.col(i));
+    for (int t = 0; t < STEPS; t++)
+    {
+      serial->setExternalForces(forces.col(i));
+      serial->step();
+    }
+    Eigen::VectorXd batchPos = batch.getPositions().col(i);
+    Eigen::VectorXd batchVel = batch.getVelocities().col(i);
+    EXPECT_TRUE(equals(serial->getPositions(), batchPos));
+    EXPECT_TRUE(equals(serial->getVelocities(), batchVel));
+  }
+}
+
+TEST(WORLD_BATCH, BATCHED_BACKPROP_MATCHES_SERIAL)
+{
+  WorldPtr world = createBoxOnFloorWorld();
+  int dofs = world->getNumDofs();
+
+  const int BATCH = 8;
+
+  Eigen::MatrixXd states = Eigen::MatrixXd::Zero(2 * dofs, BATCH);
+  states.bottomRows(dofs) = Eigen::MatrixXd::Random(dofs, BATCH);
+  Eigen::MatrixXd torques = Eigen::MatrixXd::Random(dofs, BATCH);
+
+  std::shared_ptr<BackpropSnapshotBatch> snapshots
+      = forwardPassBatch(world, states, torques, 4);
+  EXPECT_EQ(snapshots->getBatchSize(), BATCH);
+
+  LossGradientBatch next;
+  next.lossWrtPosition = Eigen::MatrixXd::Random(dofs, BATCH);
+  next.lossWrtVelocity = Eigen::MatrixXd::Random(dofs, BATCH);
+  LossGradientBatch batchLoss;
+  snapshots->backprop(batchLoss, next);
+
+  Eigen::MatrixXd postPos = snapshots->getPostStepPosition();
+  Eigen::MatrixXd postVel = snapshots->getPostStepVelocity();
+
+  for (int i = 0; i < BATCH; i++)
+  {
+    WorldPtr serial = world->clone();
+    serial->setPositions(states.col(i).head(dofs));
+    serial->setVelocities(states.col(i).tail(dofs));
+    serial->setExternalForces(torques.col(i));
+    std::shared_ptr<BackpropSnapshot> snapshot = forwardPass(serial, true);
+
+    Eigen::VectorXd batchPos = postPos.col(i);
+    Eigen::VectorXd batchVel = postVel.col(i);
+    EXPECT_TRUE(equals(snapshot->getPostStepPosition(), batchPos));
+    EXPECT_TRUE(equals(snapshot->getPostStepVelocity(), batchVel));
+
+    LossGradient nextLoss;
+    nextLoss.lossWrtPosition = next.lossWrtPosition.col(i);
+    nextLoss.lossWrtVelocity = next.lossWrtVelocity.col(i);
+    LossGradient thisLoss;
+    snapshot->backprop(serial, thisLoss, nextLoss);
+
+    Eigen::VectorXd batchLossPos = batchLoss.lossWrtPosition.col(i);
+    Eigen::VectorXd batchLossVel = batchLoss.lossWrtVelocity.col(i);
+    Eigen::VectorXd batchLossTorque = batchLoss.lossWrtTorque.col(i);
+    EXPECT_TRUE(equals(thisLoss.lossWrtPosition, batchLossPos));
+    EXPECT_TRUE(equals(thisLoss.lossWrtVelocity, batchLossVel));
+    EXPECT_TRUE(equals(thisLoss.lossWrtTorque, batchLossTorque));
+  }
+}
+
+TEST(WORLD_BATCH, REUSED_BATCH_FORWARD_PASS_MATCHES_FRESH)
+{
+  WorldPtr world = createBoxOnFloorWorld();
+  int dofs = world->getNumDofs();
+
+  const int BATCH = 8;
+  std::shared_ptr<WorldBatch> batch
+      = std::make_shared<WorldBatch>(world, BATCH, 4);
+
+  // Run a couple of steps on the same batch, loading new inputs each time, to
+  // check that the inputs fully replace the previous step's state. We reset
+  // the LCP warm starts to the World's each time, so that both versions start
+  // their solves from the same place.
+  for (int step = 0; step < 2; step++)
+  {
+    batch->setAllFromWorld(world);
+
+    Eigen::MatrixXd states = Eigen::MatrixXd::Zero(2 * dofs, BATCH);
+    states.bottomRows(dofs) = Eigen::MatrixXd::Random(dofs, BATCH);
+    Eigen::MatrixXd torques = Eigen::MatrixXd::Random(dofs, BATCH);
+
+    std::shared_ptr<BackpropSnapshotBatch> fresh
+        = forwardPassBatch(world, states, torques, 4);
+    std::shared_ptr<BackpropSnapshotBatch> reused = forwardPassBatch(
+        batch, states.topRows(dofs), states.bottomRows(dofs), torques);
+
+    EXPECT_TRUE(
+        equals(reused->getPostStepPosition(), fresh->getPostStepPosition()));
+    EXPECT_TRUE(
+        equals(reused->getPostStepVelocity(), fresh->getPostStepVelocity()));
+    EXPECT_TRUE(equals(batch->getPositions(), fresh->getPostStepPosition()));
+
+    LossGradientBatch next;
+    next.lossWrtPosition = Eigen::MatrixXd::Random(dofs, BATCH);
+    next.lossWrtVelocity = Eigen::MatrixXd::Random(dofs, BATCH);
+    LossGradientBatch freshLoss;
+    fresh->backprop(freshLoss, next);
+    LossGradientBatch reusedLoss;
+    reused->backprop(reusedLoss, next);
+
+    EXPECT_TRUE(
+        equals(reusedLoss.lossWrtPosition, freshLoss.lossWrtPosition));
+    EXPECT_TRUE(
+        equals(reusedLoss.lossWrtVelocity, freshLoss.lossWrtVelocity));
+    EXPECT_TRUE(equals(reusedLoss.lossWrtTorque, freshLoss.lossWrtTorque));
+  }
+}
+
+TEST(FINITE_DIFFERENCE_ENGINE, SCHEMES_MATCH_ANALYTICAL)
+{
+  // f(x) = [sin(x0) * x1, x0^2 + exp(x1), x2^3]
+  Eigen::Vector3d x(0.3, -0.7, 1.1);
+  Eigen::MatrixXd analytical = Eigen::MatrixXd::Zero(3, 3);
+  analytical << cos(x(0)) * x(1), sin(x(0)), 0, 2 * x(0), exp(x(1)), 0, 0, 0,
+      3 * x(2) * x(2);
+
+  FiniteDifferenceEngine::EvalFn eval
+      = [&](int /* worker */, int column, double eps, Eigen::VectorXd& out) {
+          Eigen::Vector3d perturbed = x;
+          perturbed(column) += eps;
+          out = Eigen::VectorXd(3);
+          out << sin(perturbed(0)) * perturbed(1),
+              perturbed(0) * perturbed(0) + exp(perturbed(1)),
+              perturbed(2) * perturbed(2) * perturbed(2);
+          return true;
+        };
+
+  FiniteDifferenceEngine engine(4);
+  EXPECT_TRUE(
+      equals(engine.jacobian(3, 3, eval, FD_FORWARD, 1e-7), analytical, 1e-5));
+  EXPECT_TRUE(
+      equals(engine.jacobian(3, 3, eval, FD_CENTRAL, 1e-6), analytical, 1e-8));
+  EXPECT_TRUE(
+      equals(engine.jacobian(3, 3, eval, FD_RIDDERS, 1e-2), analytical, 1e-11));
+}
+
+TEST(FINITE_DIFFERENCE_ENGINE, PARALLEL_MATCHES_SERIAL)
+{
+  WorldPtr world = createBoxOnFloorWorld();
+  world->setVelocities(Eigen::Vector2d(0.3, -0.1));
+  world->setExternalForces(Eigen::Vector2d(0.5, 0.2));
+  world->tuneMass(
+      world->getSkeleton("box")->getBodyNode(0),
+      INERTIA_MASS,
+      Eigen::VectorXd::Ones(1) * 10,
+      Eigen::VectorXd::Ones(1) * 0.1);
+
+  std::shared_ptr<BackpropSnapshot> snapshot = forwardPass(world, true);
+  Eigen::VectorXd positions = world->getPositions();
+  Eigen::VectorXd velocities = world->getVelocities();
+  Eigen::VectorXd mass = world->getWrtMass()->get(world.get());
+
+  world->setFiniteDifferenceThreads(1);
+  Eigen::MatrixXd serialVelVel
+      = snapshot->finiteDifferenceVelVelJacobian(world, true);
+  Eigen::MatrixXd serialForceVel
+      = snapshot->finiteDifferenceForceVelJacobian(world, true);
+  Eigen::MatrixXd serialMassVel
+      = snapshot->finiteDifferenceMassVelJacobian(world, true);
+
+  world->setFiniteDifferenceThreads(4);
+  EXPECT_EQ(world->getFiniteDifferenceEngine()->getNumThreads(), 4);
+  // Run twice, so the second call reuses the clones from the first
+  for (int i = 0; i < 2; i++)
+  {
+    EXPECT_TRUE(equals(
+        snapshot->finiteDifferenceVelVelJacobian(world, true),
+        serialVelVel,
+        0.0));
+    EXPECT_TRUE(equals(
+        snapshot->finiteDifferenceForceVelJacobian(world, true),
+        serialForceVel,
+        0.0));
+    EXPECT_TRUE(equals(
+        snapshot->finiteDifferenceMassVelJacobian(world, true),
+        serialMassVel,
+        0.0));
+  }
+
+  // Finite differencing should never touch the caller's World
+  EXPECT_TRUE(equals(world->getPositions(), positions, 0.0));
+  EXPECT_TRUE(equals(world->getVelocities(), velocities, 0.0));
+  Eigen::VectorXd massAfter = world->getWrtMass()->get(world.get());
+  EXPECT_TRUE(equals(massAfter, mass, 0.0));
+}
+
+TEST(FINITE_DIFFERENCE_ENGINE, CLONES_TRACK_PARAMETER_CHANGES)
+{
+  WorldPtr world = createBoxOnFloorWorld();
+  world->setVelocities(Eigen::Vector2d(0.3, -0.1));
+  world->setExternalForces(Eigen::Vector2d(0.5, 0.2));
+
+  // Clones shouldn't each spin up a pool of their own by default
+  EXPECT_EQ(world->getFiniteDifferenceThreads(), 1);
+  EXPECT_EQ(world->clone()->getFiniteDifferenceThreads(), 1);
+
+  world->setFiniteDifferenceThreads(2);
+  std::shared_ptr<BackpropSnapshot> snapshot = forwardPass(world, true);
+  // This creates the clones
+  snapshot->finiteDifferenceVelVelJacobian(world, true);
+
+  // Now change parameters that cloning copies, but that aren't state
+  world->getSkeleton("box")->getBodyNode(0)->setFrictionCoeff(0.2);
+  world->getSkeleton("box")->getBodyNode(0)->setRestitutionCoeff(0.3);
+  world->getSkeleton("box")->getDof(0)->setDampingCoefficient(0.4);
+  world->getSkeleton("box")->getDof(1)->setSpringStiffness(2.0);
+  world->getSkeleton("box")->getDof(1)->setRestPosition(0.1);
+  world->getSkeleton("box")->getDof(0)->setCoulombFriction(0.05);
+
+  snapshot = forwardPass(world, true);
+  Eigen::MatrixXd reused = snapshot->finiteDifferenceVelVelJacobian(world, true);
+  world->getFiniteDifferenceEngine()->clearWorldClones();
+  Eigen::MatrixXd fresh = snapshot->finiteDifferenceVelVelJacobian(world, true);
+  EXPECT_TRUE(equals(reused, fresh, 0.0));
+}
+
+TEST(FINITE_DIFFERENCE_ENGINE, CLONES_TRACK_STRUCTURAL_CHANGES)
+{
+  WorldPtr world = createBoxOnFloorWorld();
+  world->setVelocities(Eigen::Vector2d(0.3, -0.1));
+  world->setExternalForces(Eigen::Vector2d(0.5, 0.2));
+
+  world->setFiniteDifferenceThreads(2);
+  std::shared_ptr<BackpropSnapshot> snapshot = forwardPass(world, true);
+  // This creates the clones
+  Eigen::MatrixXd inContact
+      = snapshot->finiteDifferenceVelVelJacobian(world, true);
+
+  // Now drop the floor out from under the box, and swap the box for a smaller
+  // one. Neither of these is state that gets synced, so the engine has to
+  // notice on its own that its clones are stale.
+  Eigen::Isometry3d floorOffset = Eigen::Isometry3d::Identity();
+  floorOffset.translation() = Eigen::Vector3d(0, -1.0, 0);
+  world->getSkeleton("floor")->getJoint(0)->setTransformFromParentBodyNode(
+      floorOffset);
+  world->getSkeleton("box")->getBodyNode(0)->getShapeNode(0)->setShape(
+      std::make_shared<BoxShape>(Eigen::Vector3d(0.05, 0.05, 0.05)));
+
+  snapshot = forwardPass(world, true);
+  Eigen::MatrixXd reused = snapshot->finiteDifferenceVelVelJacobian(world, true);
+  world->getFiniteDifferenceEngine()->clearWorldClones();
+  Eigen::MatrixXd fresh = snapshot->finiteDifferenceVelVelJacobian(world, true);
+  EXPECT_TRUE(equals(reused, fresh, 0.0));
+  // Make sure the edit actually mattered, so the check above isn't vacuous
+  EXPECT_FALSE(equals(inContact, fresh, 1e-8));
+}
+
+TEST(THREAD_POOL, AFFINITY_RUNS_EVERY_INDEX_ONCE)
+{
+  common::ThreadPool pool(3);
+  std::vector<int> counts(50, 0);
+  std::vector<int> workers(50, -1);
+  for (int repeat = 0; repeat < 10; repeat++)
+  {
+    pool.parallelForWithAffinity(50, [&](int index, int worker) {
+      counts[index]++;
+      workers[index] = worker;
+    });
+  }
+  for (int i = 0; i < 50; i++)
+  {
+    EXPECT_EQ(counts[i], 10);
+    EXPECT_GE(workers[i], 0);
+    EXPECT_LT(workers[i], 3);
+  }
+}
+
+TEST(MULTI_SHOT, THREAD_POOL_MATCHES_SERIAL)
+{
+  WorldPtr world = createBoxOnFloorWorld();
+  world->setVelocities(Eigen::Vector2d(0.3, 0.1));
+
+  TrajectoryLossFn loss = [](const TrajectoryRollout* rollout) {
+    return rollout->getPosesConst("identity").squaredNorm();
+  };
+  LossFn lossFn(loss);
+
+  MultiShot serial(world, lossFn, 40, 5, false);
+  serial.setParallelOperationsEnabled(false);
+
+  // Use fewer threads than shots, so that workers have to share
+  MultiShot parallel(world, lossFn, 40, 5, false);
+  parallel.setNumThreads(3);
+  parallel.setParallelOperationsEnabled(true);
+  EXPECT_EQ(parallel.getNumThreads(), 3);
+
+  int constraintDim = serial.getConstraintDim();
+  int flatDim = serial.getFlatProblemDim(world);
+
+  // Run every operation twice, so the second pass reuses the pool's threads
+  for (int i = 0; i < 2; i++)
+  {
+    Eigen::VectorXd serialConstraints = Eigen::VectorXd::Zero(constraintDim);
+    Eigen::VectorXd parallelConstraints = Eigen::VectorXd::Zero(constraintDim);
+    serial.computeConstraints(world, serialConstraints);
+    parallel.computeConstraints(world, parallelConstraints);
+    EXPECT_TRUE(equals(serialConstraints, parallelConstraints, 1e-10));
+
+    Eigen::MatrixXd serialJac = Eigen::MatrixXd::Zero(constraintDim, flatDim);
+    Eigen::MatrixXd parallelJac = Eigen::MatrixXd::Zero(constraintDim, flatDim);
+    // MultiShot hides the flat overload, so go through Problem
+    static_cast<Problem&>(serial).backpropJacobian(world, serialJac);
+    static_cast<Problem&>(parallel).backpropJacobian(world, parallelJac);
+    EXPECT_TRUE(equals(serialJac, parallelJac, 1e-10));
+
+    Eigen::VectorXd serialGrad = Eigen::VectorXd::Zero(flatDim);
+    Eigen::VectorXd parallelGrad = Eigen::VectorXd::Zero(flatDim);
+    serial.backpropGradient(world, serialGrad);
+    parallel.backpropGradient(world, parallelGrad);
+    EXPECT_TRUE(equals(serialGrad, parallelGrad, 1e-10));
+  }
+}
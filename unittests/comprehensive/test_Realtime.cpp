@@ -30,6 +30,7 @@
  *   POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <atomic>
 #include <chrono>
 #include <fstream>
 #include <iostream>
@@ -42,6 +43,7 @@
 #include "dart/realtime/MPC.hpp"
 #include "dart/realtime/MPCLocal.hpp"
 #include "dart/realtime/MPCRemote.hpp"
+#include "dart/realtime/Nanos.hpp"
 #include "dart/realtime/SSID.hpp"
 #include "dart/realtime/Ticker.hpp"
 #include "dart/server/GUIWebsocketServer.hpp"
@@ -49,6 +51,9 @@
 #include "dart/trajectory/IPOptOptimizer.hpp"
 #include "dart/trajectory/LossFn.hpp"
 #include "dart/trajectory/MultiShot.hpp"
+#include "dart/trajectory/Optimizer.hpp"
+#include "dart/trajectory/SGDOptimizer.hpp"
+#include "dart/trajectory/Solution.hpp"
 
 #include "TestHelpers.hpp"
 #include "stdio.h"
@@ -216,8 +221,8 @@ TEST(REALTIME, CARTPOLE_MPC)
   world->setTimeStep(1.0 / 100);
 
   // 300 timesteps
-  int millisPerTimestep = world->getTimeStep() * 1000;
-  int planningHorizonMillis = 300 * millisPerTimestep;
+  long nanosPerTimestep = secondsToNanos(world->getTimeStep());
+  long planningHorizonNanos = 300 * nanosPerTimestep;
   int advanceSteps = 70;
 
   double goalX = 1.0;
@@ -271,13 +276,13 @@ TEST(REALTIME, CARTPOLE_MPC)
       };
 
   MPCLocal mpcLocal = MPCLocal(
-      world, std::make_shared<LossFn>(loss, lossGrad), planningHorizonMillis);
+      world, std::make_shared<LossFn>(loss, lossGrad), planningHorizonNanos);
   mpcLocal.setSilent(true);
 
-  int inferenceHistoryMillis = 10 * millisPerTimestep;
+  long inferenceHistoryNanos = 10 * nanosPerTimestep;
   std::shared_ptr<simulation::World> ssidWorld = world->clone();
   SSID ssid = SSID(
-      ssidWorld, getSSIDLoss(), inferenceHistoryMillis, world->getNumDofs());
+      ssidWorld, getSSIDLoss(), inferenceHistoryNanos, world->getNumDofs());
 
   mpcLocal.setMaxIterations(7);
 
@@ -366,7 +371,7 @@ TEST(REALTIME, CARTPOLE_MPC)
 
     /*
     realtimeWorld.registerTiming(
-        "buffer", mpcRemote.getRemainingPlanBufferMillis(), "ms");
+        "buffer", mpcRemote.getRemainingPlanBufferNanos(), "ns");
         */
 
     realtimeUnderlyingWorld->step();
@@ -487,16 +492,16 @@ TEST(REALTIME, CARTPOLE_SSID)
   world->setTimeStep(1.0 / 100);
 
   // 300 timesteps
-  int millisPerTimestep = world->getTimeStep() * 1000;
-  int inferenceHistoryMillis = 5 * millisPerTimestep;
+  long nanosPerTimestep = secondsToNanos(world->getTimeStep());
+  long inferenceHistoryNanos = 5 * nanosPerTimestep;
   int advanceSteps = 70;
 
-  SSID ssid = SSID(world, lossFn, inferenceHistoryMillis, world->getNumDofs());
+  SSID ssid = SSID(world, lossFn, inferenceHistoryNanos, world->getNumDofs());
 
   armPair.second->setMass(2.0);
   for (int i = 0; i < 50; i++)
   {
-    long time = i * millisPerTimestep;
+    long time = i * nanosPerTimestep;
     Eigen::VectorXd forces = Eigen::VectorXd::Ones(world->getNumDofs());
     world->setExternalForces(forces);
     world->step();
@@ -510,14 +515,332 @@ TEST(REALTIME, CARTPOLE_SSID)
     return sensors.col(0);
   });
 
-  ssid.runInference(30 * millisPerTimestep);
+  ssid.runInference(30 * nanosPerTimestep);
 
   std::cout << "Recovered mass after 1st iteration: "
             << armPair.second->getMass() << std::endl;
 
-  ssid.runInference(50 * millisPerTimestep);
+  ssid.runInference(50 * nanosPerTimestep);
 
   std::cout << "Recovered mass after 2nd iteration: "
             << armPair.second->getMass() << std::endl;
 }
 #endif
+
+/// This is a stand-in optimizer, which doesn't change the problem at all, but
+/// calls the intermediate callbacks the way IPOPT does: once for the starting
+/// point (iteration 0), then once after each step, stopping early if any
+/// callback returns false.
+class StepCountingOptimizer : public trajectory::Optimizer
+{
+public:
+  StepCountingOptimizer(int maxSteps) : mMaxSteps(maxSteps), mStepsTaken(0)
+  {
+  }
+
+  std::shared_ptr<Solution> optimize(
+      Problem* problem, std::shared_ptr<Solution> /* warmStart */) override
+  {
+    mStepsTaken = 0;
+    for (int iter = 0; iter <= mMaxSteps; iter++)
+    {
+      if (iter > 0)
+      {
+        mStepsTaken++;
+      }
+      bool keepGoing = true;
+      for (auto& callback : mIntermediateCallbacks)
+      {
+        keepGoing = callback(problem, iter, 0.0, 0.0) && keepGoing;
+      }
+      if (!keepGoing)
+      {
+        break;
+      }
+    }
+    return std::make_shared<Solution>();
+  }
+
+  int mMaxSteps;
+  int mStepsTaken;
+};
+
+WorldPtr createSledWorld()
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3d(0, -9.81, 0));
+
+  SkeletonPtr sled = Skeleton::create("sled");
+  std::pair<PrismaticJoint*, BodyNode*> sledPair
+      = sled->createJointAndBodyNodePair<PrismaticJoint>(nullptr);
+  sledPair.first->setAxis(Eigen::Vector3d(1, 0, 0));
+  world->addSkeleton(sled);
+
+  sled->setForceUpperLimit(0, 15);
+  sled->setForceLowerLimit(0, -15);
+  sled->setPosition(0, 1.0);
+
+  return world;
+}
+
+TEST(REALTIME, MPC_ANYTIME_DEADLINE)
+{
+  WorldPtr world = createSledWorld();
+
+  MPCLocal mpc = MPCLocal(world, getMPCLoss(), 100 * NANOS_PER_MILLI);
+  mpc.setSilent(true);
+  mpc.setEnableAnytimeReplanning(true);
+  std::shared_ptr<StepCountingOptimizer> optimizer
+      = std::make_shared<StepCountingOptimizer>(5);
+  mpc.setOptimizer(optimizer);
+
+  // Before we've published anything there's no buffer to measure a deadline
+  // against, so the first replan doesn't get one
+  EXPECT_EQ(0L, mpc.getReplanDeadline(monotonicNanos()));
+
+  // A deadline that's long gone still lets the optimizer take one step, so we
+  // never publish the un-optimized warm start
+  mpc.optimizePlan(monotonicNanos(), 1L);
+  EXPECT_EQ(1, optimizer->mStepsTaken);
+  EXPECT_GT(mpc.getRemainingPlanBufferNanos(), 0L);
+
+  // Now that there's a plan, the next replan gets half of what's left of it
+  long now = monotonicNanos();
+  long deadline = mpc.getReplanDeadline(now);
+  EXPECT_GT(deadline, now);
+  EXPECT_LE(deadline, now + 100 * NANOS_PER_MILLI / 2);
+
+  mpc.setEnableAnytimeReplanning(false);
+  EXPECT_EQ(0L, mpc.getReplanDeadline(now));
+}
+
+TEST(REALTIME, MPC_ANYTIME_DEADLINE_SGD)
+{
+  WorldPtr world = createSledWorld();
+
+  MPCLocal mpc = MPCLocal(world, getMPCLoss(), 100 * NANOS_PER_MILLI);
+  mpc.setSilent(true);
+  mpc.setEnableAnytimeReplanning(true);
+  std::shared_ptr<SGDOptimizer> optimizer = std::make_shared<SGDOptimizer>();
+  optimizer->setIterationLimit(5);
+  optimizer->setLearningRate(1e-3);
+  std::vector<int> iters;
+  optimizer->registerIntermediateCallback(
+      [&](Problem* /* problem */, int iter, double, double) {
+        iters.push_back(iter);
+        return true;
+      });
+  mpc.setOptimizer(optimizer);
+
+  // SGD reports after it's already taken a step, so an expired deadline should
+  // stop it after exactly one step, and that step should get published
+  mpc.optimizePlan(monotonicNanos(), 1L);
+  ASSERT_EQ(1, (int)iters.size());
+  EXPECT_EQ(1, iters[0]);
+  EXPECT_GT(mpc.getRemainingPlanBufferNanos(), 0L);
+}
+
+TEST(REALTIME, MPC_NO_DEADLINE_RUNS_EVERY_STEP)
+{
+  WorldPtr world = createSledWorld();
+
+  MPCLocal mpc = MPCLocal(world, getMPCLoss(), 100 * NANOS_PER_MILLI);
+  mpc.setSilent(true);
+  mpc.setEnableAnytimeReplanning(true);
+  std::shared_ptr<StepCountingOptimizer> optimizer
+      = std::make_shared<StepCountingOptimizer>(5);
+  mpc.setOptimizer(optimizer);
+
+  mpc.optimizePlan(monotonicNanos(), mpc.getReplanDeadline(monotonicNanos()));
+  EXPECT_EQ(5, optimizer->mStepsTaken);
+}
+
+/// This records `steps` of history into `ssid`, from a sled with a mass of 1
+/// pushed by a constant force, starting at `startTime`
+void recordSledHistory(SSID& ssid, int steps, long startTime)
+{
+  WorldPtr truth = createSledWorld();
+  truth->getSkeleton(0)->getBodyNode(0)->setMass(1.0);
+  truth->getSkeleton(0)->setPosition(0, 0.0);
+  long nanosPerStep = secondsToNanos(truth->getTimeStep());
+
+  Eigen::VectorXd force = Eigen::VectorXd::Ones(1);
+  for (int i = 0; i < steps; i++)
+  {
+    long time = startTime + i * nanosPerStep;
+    ssid.registerControls(time, force);
+    ssid.registerSensors(time, truth->getPositions());
+    truth->setExternalForces(force);
+    truth->step();
+  }
+}
+
+/// This wraps `optimizer` so that every iteration it runs counts towards
+/// `active` for a few millis, and `maxActive` records the most we ever saw at
+/// once
+std::shared_ptr<trajectory::Optimizer> countConcurrentIterations(
+    std::shared_ptr<trajectory::Optimizer> optimizer,
+    std::atomic<int>& active,
+    std::atomic<int>& maxActive)
+{
+  optimizer->registerIntermediateCallback(
+      [&active, &maxActive](Problem*, int, double, double) {
+        int nowActive = ++active;
+        int seen = maxActive.load();
+        while (nowActive > seen
+               && !maxActive.compare_exchange_weak(seen, nowActive))
+        {
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        active--;
+        return true;
+      });
+  return optimizer;
+}
+
+TEST(REALTIME, SSID_HYPOTHESES_REPORT_BEST)
+{
+  const int steps = 10;
+
+  WorldPtr world = createSledWorld();
+  world->getSkeleton(0)->setPosition(0, 0.0);
+  long nanosPerStep = secondsToNanos(world->getTimeStep());
+  SSID ssid = SSID(world, getSSIDLoss(), steps * nanosPerStep, 1);
+
+  long startTime = monotonicNanos();
+  recordSledHistory(ssid, steps, startTime);
+
+  // Each hypothesis guesses a different mass. The stand-in optimizer doesn't
+  // change anything, so each one's loss is just how well its guess fits.
+  int optimizersCreated = 0;
+  ssid.setHypothesisOptimizerFactory([&]() {
+    optimizersCreated++;
+    return std::make_shared<StepCountingOptimizer>(0);
+  });
+  for (double mass : {4.0, 1.0, 0.25})
+  {
+    ssid.addHypothesis([mass](std::shared_ptr<World> hypothesisWorld) {
+      hypothesisWorld->getSkeleton(0)->getBodyNode(0)->setMass(mass);
+    });
+  }
+  ssid.setNumThreads(3);
+
+  int timesReported = 0;
+  Eigen::VectorXd lastVel;
+  ssid.registerInferListener([&](long /* time */,
+                                 Eigen::VectorXd /* pos */,
+                                 Eigen::VectorXd vel,
+                                 Eigen::VectorXd /* mass */,
+                                 long /* computeNanos */) {
+    timesReported++;
+    lastVel = vel;
+  });
+
+  ssid.runInference(startTime + steps * nanosPerStep);
+
+  // Every hypothesis gets its own optimizer
+  EXPECT_EQ(3, optimizersCreated);
+  EXPECT_GE(timesReported, 1);
+  EXPECT_LE(timesReported, 3);
+
+  // The last report is the best fit, which is the hypothesis with the right
+  // mass. Its sled ends up going about steps * dt * force / mass, where the
+  // others would be off by a factor of 4.
+  double expectedVel = steps * world->getTimeStep();
+  ASSERT_EQ(1, lastVel.size());
+  EXPECT_NEAR(expectedVel, lastVel(0), 0.15 * expectedVel);
+}
+
+TEST(REALTIME, SSID_DEFAULT_HYPOTHESES_RUN_CONCURRENTLY)
+{
+  const int steps = 10;
+
+  WorldPtr world = createSledWorld();
+  world->getSkeleton(0)->setPosition(0, 0.0);
+  long nanosPerStep = secondsToNanos(world->getTimeStep());
+  SSID ssid = SSID(world, getSSIDLoss(), steps * nanosPerStep, 1);
+
+  long startTime = monotonicNanos();
+  recordSledHistory(ssid, steps, startTime);
+
+  EXPECT_TRUE(
+      SSID::createDefaultHypothesisOptimizer()->canOptimizeConcurrently());
+
+  std::atomic<int> active(0);
+  std::atomic<int> maxActive(0);
+  ssid.setHypothesisOptimizerFactory([&]() {
+    return countConcurrentIterations(
+        SSID::createDefaultHypothesisOptimizer(), active, maxActive);
+  });
+  for (double mass : {4.0, 1.0, 0.25})
+  {
+    ssid.addHypothesis([mass](std::shared_ptr<World> hypothesisWorld) {
+      hypothesisWorld->getSkeleton(0)->getBodyNode(0)->setMass(mass);
+    });
+  }
+  ssid.setNumThreads(3);
+
+  Eigen::VectorXd lastVel;
+  ssid.registerInferListener([&](long /* time */,
+                                 Eigen::VectorXd /* pos */,
+                                 Eigen::VectorXd vel,
+                                 Eigen::VectorXd /* mass */,
+                                 long /* computeNanos */) { lastVel = vel; });
+
+  ssid.runInference(startTime + steps * nanosPerStep);
+
+  // The default hypotheses don't have to take turns
+  EXPECT_GT(maxActive.load(), 1);
+  double expectedVel = steps * world->getTimeStep();
+  ASSERT_EQ(1, lastVel.size());
+  EXPECT_NEAR(expectedVel, lastVel(0), 0.15 * expectedVel);
+}
+
+TEST(REALTIME, SSID_IPOPT_HYPOTHESES)
+{
+  const int steps = 10;
+
+  WorldPtr world = createSledWorld();
+  world->getSkeleton(0)->setPosition(0, 0.0);
+  long nanosPerStep = secondsToNanos(world->getTimeStep());
+  SSID ssid = SSID(world, getSSIDLoss(), steps * nanosPerStep, 1);
+
+  long startTime = monotonicNanos();
+  recordSledHistory(ssid, steps, startTime);
+
+  // Real IPOPT hypotheses, on its default linear solver (MUMPS)
+  std::atomic<int> active(0);
+  std::atomic<int> maxActive(0);
+  ssid.setHypothesisOptimizerFactory([&]() {
+    std::shared_ptr<IPOptOptimizer> ipopt = std::make_shared<IPOptOptimizer>();
+    ipopt->setCheckDerivatives(false);
+    ipopt->setIterationLimit(5);
+    ipopt->setRecordIterations(false);
+    ipopt->setSuppressOutput(true);
+    ipopt->setSilenceOutput(true);
+    EXPECT_FALSE(ipopt->canOptimizeConcurrently());
+    return countConcurrentIterations(ipopt, active, maxActive);
+  });
+  for (double mass : {4.0, 1.0, 0.25})
+  {
+    ssid.addHypothesis([mass](std::shared_ptr<World> hypothesisWorld) {
+      hypothesisWorld->getSkeleton(0)->getBodyNode(0)->setMass(mass);
+    });
+  }
+  ssid.setNumThreads(3);
+
+  Eigen::VectorXd lastVel;
+  ssid.registerInferListener([&](long /* time */,
+                                 Eigen::VectorXd /* pos */,
+                                 Eigen::VectorXd vel,
+                                 Eigen::VectorXd /* mass */,
+                                 long /* computeNanos */) { lastVel = vel; });
+
+  ssid.runInference(startTime + steps * nanosPerStep);
+
+  // MUMPS hypotheses take turns with each other, and still report the best fit
+  EXPECT_EQ(1, maxActive.load());
+  double expectedVel = steps * world->getTimeStep();
+  ASSERT_EQ(1, lastVel.size());
+  EXPECT_NEAR(expectedVel, lastVel(0), 0.15 * expectedVel);
+}
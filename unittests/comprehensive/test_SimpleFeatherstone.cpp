@@ -1,3 +1,4 @@
+#include <cstdint>
 #include <iostream>
 
 #include <gtest/gtest.h>
@@ -135,6 +136,75 @@ void verifySkeleton(SkeletonPtr skel)
   free(accel);
 }
 
+void verifyBatch(SkeletonPtr skel, int numStates, bool misalignInputs = false)
+{
+  dynamics::SimpleFeatherstone simple;
+  simple.populateFromSkeleton(skel);
+
+  // The scratch space grows one joint at a time, so by now it has been
+  // reallocated several times. Every lane array has to have kept its
+  // alignment, or the vectorized loads fault.
+  for (int i = 0; i < simple.len(); i++)
+  {
+    const dynamics::FeatherstoneBatchScratchSpace& scratch
+        = simple.mBatchScratchSpace[i];
+    EXPECT_EQ(
+        0u,
+        reinterpret_cast<std::uintptr_t>(scratch.pos)
+            % dynamics::FeatherstoneBatchScratchSpace::ALIGNMENT);
+    EXPECT_EQ(
+        0u,
+        reinterpret_cast<std::uintptr_t>(scratch.articulatedInertia)
+            % dynamics::FeatherstoneBatchScratchSpace::ALIGNMENT);
+    EXPECT_EQ(
+        0u,
+        reinterpret_cast<std::uintptr_t>(scratch.totalForce)
+            % dynamics::FeatherstoneBatchScratchSpace::ALIGNMENT);
+  }
+
+  // DOF-major, so DOF i of state k is at (k, i). With misalignInputs, every
+  // input and output starts one double into its buffer, so none of them are
+  // vector aligned.
+  const int skip = misalignInputs ? 1 : 0;
+  const int size = numStates * simple.len();
+  Eigen::VectorXd posBuffer = Eigen::VectorXd::Random(size + skip);
+  Eigen::VectorXd velBuffer = Eigen::VectorXd::Random(size + skip);
+  Eigen::VectorXd forceBuffer = Eigen::VectorXd::Random(size + skip);
+  Eigen::VectorXd accelBuffer = Eigen::VectorXd::Zero(size + skip);
+  Eigen::Map<Eigen::MatrixXd> pos(
+      posBuffer.data() + skip, numStates, simple.len());
+  Eigen::Map<Eigen::MatrixXd> vel(
+      velBuffer.data() + skip, numStates, simple.len());
+  Eigen::Map<Eigen::MatrixXd> force(
+      forceBuffer.data() + skip, numStates, simple.len());
+  Eigen::Map<Eigen::MatrixXd> accel(
+      accelBuffer.data() + skip, numStates, simple.len());
+
+  simple.forwardDynamicsBatch(
+      numStates, pos.data(), vel.data(), force.data(), accel.data());
+
+  for (int k = 0; k < numStates; k++)
+  {
+    Eigen::VectorXd statePos = pos.row(k);
+    Eigen::VectorXd stateVel = vel.row(k);
+    Eigen::VectorXd stateForce = force.row(k);
+    Eigen::VectorXd stateAccel = Eigen::VectorXd::Zero(simple.len());
+    simple.forwardDynamics(
+        statePos.data(), stateVel.data(), stateForce.data(), stateAccel.data());
+
+    Eigen::VectorXd batchAccel = accel.row(k);
+    if (!equals(batchAccel, stateAccel, 1e-10))
+    {
+      std::cout << "State " << k << " expected acceleration: " << std::endl
+                << stateAccel << std::endl;
+      std::cout << "Got batched acceleration: " << std::endl
+                << batchAccel << std::endl;
+      EXPECT_TRUE(equals(batchAccel, stateAccel, 1e-10));
+      return;
+    }
+  }
+}
+
 #ifdef ALL_TESTS
 TEST(FEATHERSTONE, LINK_5)
 {
@@ -142,6 +212,23 @@ TEST(FEATHERSTONE, LINK_5)
 }
 #endif
 
+#ifdef ALL_TESTS
+TEST(FEATHERSTONE, BATCH_MATCHES_SINGLE)
+{
+  // 19 isn't a multiple of the lane width, so this covers a partial block
+  verifyBatch(createMultiarmRobot(5, 0.2), 19);
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(FEATHERSTONE, BATCH_MISALIGNED_INPUTS)
+{
+  // A long chain reallocates the scratch space many times, and the inputs
+  // start off a vector boundary
+  verifyBatch(createMultiarmRobot(20, 0.2), 19, true);
+}
+#endif
+
 /*
 template <class ConfigSpaceT>
 void GenericJoint<ConfigSpaceT>::addChildArtInertiaImplicitToDynamic(
@@ -152,6 +152,8 @@ TEST(TRAJECTORY, REVOLUTE_JOINT)
   EXPECT_TRUE(verifySingleShot(world, 40, 1e-7, false, nullptr));
   EXPECT_TRUE(verifyShotJacobian(world, 40, nullptr));
   EXPECT_TRUE(verifyMultiShotJacobian(world, 8, 2, nullptr));
+  EXPECT_TRUE(verifyCheckpointedShot(world, 40, 15));
+  EXPECT_TRUE(verifyIncrementalShot(world, 40));
 
   // Verify using the IK mapping as the representation
   std::shared_ptr<IKMapping> ikMap = std::make_shared<IKMapping>(world);
@@ -163,6 +165,49 @@ TEST(TRAJECTORY, REVOLUTE_JOINT)
 }
 #endif
 
+#ifdef ALL_TESTS
+TEST(TRAJECTORY, MULTI_SHOT_ADVANCE_STEPS)
+{
+  // World
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3d(0, -9.81, 0));
+
+  SkeletonPtr spinner = Skeleton::create("spinner");
+
+  std::pair<RevoluteJoint*, BodyNode*> armPair
+      = spinner->createJointAndBodyNodePair<RevoluteJoint>(nullptr);
+  armPair.first->setAxis(Eigen::Vector3d(0, 0, 1));
+
+  world->addSkeleton(spinner);
+
+  int steps = 12;
+  MultiShot shot(world, LossFn(), steps, 4, false);
+
+  Eigen::MatrixXd forces = Eigen::MatrixXd::Zero(1, steps);
+  for (int i = 0; i < steps; i++)
+  {
+    forces(0, i) = i + 1;
+  }
+  shot.setForcesRaw(forces);
+
+  int advance = 3;
+  shot.advanceSteps(
+      world, world->getPositions(), world->getVelocities(), advance);
+
+  // The forces should all move over by `advance`, including across the
+  // boundaries between shots, with 0s at the end
+  Eigen::MatrixXd expected = Eigen::MatrixXd::Zero(1, steps);
+  expected.leftCols(steps - advance) = forces.rightCols(steps - advance);
+  Eigen::MatrixXd actual = shot.getRolloutCache(world)->getForcesConst();
+  if (!equals(expected, actual, 1e-12))
+  {
+    std::cout << "Expected: " << std::endl << expected << std::endl;
+    std::cout << "Actual: " << std::endl << actual << std::endl;
+  }
+  EXPECT_TRUE(equals(expected, actual, 1e-12));
+}
+#endif
+
 #ifdef ALL_TESTS
 TEST(TRAJECTORY, TWO_LINK)
 {
@@ -30,11 +30,17 @@
  *   POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <limits>
+
 #include <gtest/gtest.h>
 
 #include "dart/common/common.hpp"
+#include "dart/constraint/LCPUtils.hpp"
 #include "dart/constraint/constraint.hpp"
 #include "dart/dynamics/dynamics.hpp"
+#include "dart/external/odelcpsolver/matrix.h"
+#include "dart/neural/BackpropSnapshot.hpp"
+#include "dart/neural/NeuralUtils.hpp"
 #include "dart/simulation/World.hpp"
 
 #include "TestHelpers.hpp"
@@ -106,3 +112,260 @@ TEST(ContactConstraint, ContactWithKinematicJoint)
       std::make_shared<constraint::PgsBoxedLcpSolver>(), 1e-4);
 #endif
 }
+
+//==============================================================================
+simulation::WorldPtr createBoxStackWorld(
+    bool batchedImpulseTests,
+    int numBoxes = 2,
+    std::size_t sparseLcpThreshold = std::numeric_limits<std::size_t>::max(),
+    constraint::BoxedLcpSolverPtr lcpSolver
+    = std::make_shared<constraint::DantzigBoxedLcpSolver>())
+{
+  auto world = std::make_shared<simulation::World>();
+  auto solver
+      = std::make_unique<constraint::BoxedLcpConstraintSolver>(lcpSolver);
+  solver->setBatchedImpulseTestsEnabled(batchedImpulseTests);
+  solver->setSparseLcpThreshold(sparseLcpThreshold);
+  world->setConstraintSolver(std::move(solver));
+
+  auto ground = dynamics::Skeleton::create("ground");
+  auto groundPair = ground->createJointAndBodyNodePair<dynamics::WeldJoint>();
+  groundPair.second
+      ->createShapeNodeWith<VisualAspect, CollisionAspect, DynamicsAspect>(
+          std::make_shared<dynamics::BoxShape>(
+              Eigen::Vector3d(10.0, 10.0, 1.0)));
+  world->addSkeleton(ground);
+
+  for (int i = 0; i < numBoxes; i++)
+  {
+    auto box = dynamics::Skeleton::create("box" + std::to_string(i));
+    auto pair = box->createJointAndBodyNodePair<dynamics::FreeJoint>();
+    pair.second
+        ->createShapeNodeWith<VisualAspect, CollisionAspect, DynamicsAspect>(
+            std::make_shared<dynamics::BoxShape>(
+                Eigen::Vector3d(1.0, 1.0, 1.0)));
+    pair.second->setFrictionCoeff(0.5);
+    box->setPosition(3, 0.1 * i);
+    box->setPosition(5, 0.99 + 0.99 * i);
+    box->setVelocity(3, 0.3 - 0.5 * i);
+    world->addSkeleton(box);
+  }
+
+  return world;
+}
+
+//==============================================================================
+TEST(ContactConstraint, BatchedImpulseTestsMatchPerDimension)
+{
+  auto batched = createBoxStackWorld(true);
+  auto perDimension = createBoxStackWorld(false);
+
+  for (auto i = 0u; i < 50; ++i)
+  {
+    batched->step();
+    perDimension->step();
+
+    EXPECT_TRUE(
+        equals(batched->getVelocities(), perDimension->getVelocities(), 1e-8));
+    EXPECT_TRUE(
+        equals(batched->getPositions(), perDimension->getPositions(), 1e-8));
+  }
+
+  // The batched path also has to report the same impulse responses to the
+  // gradient machinery
+  std::shared_ptr<neural::BackpropSnapshot> batchedSnapshot
+      = neural::forwardPass(batched, true);
+  std::shared_ptr<neural::BackpropSnapshot> perDimensionSnapshot
+      = neural::forwardPass(perDimension, true);
+  EXPECT_TRUE(equals(
+      batchedSnapshot->getVelVelJacobian(batched),
+      perDimensionSnapshot->getVelVelJacobian(perDimension),
+      1e-8));
+  EXPECT_TRUE(equals(
+      batchedSnapshot->getPosVelJacobian(batched),
+      perDimensionSnapshot->getPosVelJacobian(perDimension),
+      1e-8));
+}
+
+//==============================================================================
+TEST(ContactConstraint, SparseLcpMatchesDense)
+{
+  auto sparse = createBoxStackWorld(true, 4, 0);
+  auto dense = createBoxStackWorld(true, 4);
+
+  for (auto i = 0u; i < 50; ++i)
+  {
+    sparse->step();
+    dense->step();
+
+    EXPECT_TRUE(equals(sparse->getVelocities(), dense->getVelocities(), 1e-8));
+    EXPECT_TRUE(equals(sparse->getPositions(), dense->getPositions(), 1e-8));
+  }
+}
+
+//==============================================================================
+TEST(ContactConstraint, SparseLcpMatchesDenseGradients)
+{
+  auto sparse = createBoxStackWorld(true, 4, 0);
+  auto dense = createBoxStackWorld(true, 4);
+
+  for (auto i = 0u; i < 20; ++i)
+  {
+    sparse->step();
+    dense->step();
+  }
+
+  // Gradient worlds take the sparse path too, and hand the block-sparse A to
+  // the gradient machinery instead of a dense one
+  std::shared_ptr<neural::BackpropSnapshot> sparseSnapshot
+      = neural::forwardPass(sparse, true);
+  std::shared_ptr<neural::BackpropSnapshot> denseSnapshot
+      = neural::forwardPass(dense, true);
+  EXPECT_TRUE(equals(sparse->getVelocities(), dense->getVelocities(), 1e-8));
+  EXPECT_TRUE(equals(
+      sparseSnapshot->getVelVelJacobian(sparse),
+      denseSnapshot->getVelVelJacobian(dense),
+      1e-6));
+  EXPECT_TRUE(equals(
+      sparseSnapshot->getPosVelJacobian(sparse),
+      denseSnapshot->getPosVelJacobian(dense),
+      1e-6));
+}
+
+//==============================================================================
+TEST(ContactConstraint, PgsSparseLcpMatchesDense)
+{
+  auto pgs = []() {
+    auto solver = std::make_shared<constraint::PgsBoxedLcpSolver>();
+    solver->setOption(constraint::PgsBoxedLcpSolver::Option(500, 1e-9, 1e-12));
+    return solver;
+  };
+  auto sparse = createBoxStackWorld(true, 4, 0, pgs());
+  auto dense = createBoxStackWorld(true, 4, std::size_t(-1), pgs());
+
+  for (auto i = 0u; i < 50; ++i)
+  {
+    // The two paths warm start PGS differently, so we compare them one step
+    // at a time from the same state, rather than letting them drift apart
+    sparse->setPositions(dense->getPositions());
+    sparse->setVelocities(dense->getVelocities());
+
+    sparse->step();
+    dense->step();
+
+    EXPECT_TRUE(equals(sparse->getVelocities(), dense->getVelocities(), 1e-4));
+  }
+}
+
+//==============================================================================
+TEST(ContactConstraint, PgsSolveSparseMatchesDense)
+{
+  const int n = 12;
+  Eigen::MatrixXd J = Eigen::MatrixXd::Random(n, 2 * n);
+  Eigen::MatrixXd A = J * J.transpose();
+  // Knock out most of the couplings, the way a pile of contacts would
+  for (int i = 0; i < n; i++)
+    for (int j = 0; j < n; j++)
+      if (std::abs(i - j) > 3)
+        A(i, j) = 0.0;
+  A.diagonal().array() += 2.0 * n;
+
+  Eigen::VectorXd b = 20.0 * Eigen::VectorXd::Random(n);
+  Eigen::VectorXd lo = Eigen::VectorXd::Constant(n, -0.5);
+  Eigen::VectorXd hi = Eigen::VectorXd::Constant(n, 0.5);
+  Eigen::VectorXi findex = Eigen::VectorXi::Constant(n, -1);
+
+  constraint::PgsBoxedLcpSolver solver;
+  solver.setOption(constraint::PgsBoxedLcpSolver::Option(100, 1e-6, 1e-9));
+
+  Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+      denseA = Eigen::MatrixXd::Zero(n, dPAD(n));
+  denseA.block(0, 0, n, n) = A;
+  Eigen::VectorXd denseX = Eigen::VectorXd::Zero(n);
+  Eigen::VectorXd denseB = b;
+  Eigen::VectorXd denseLo = lo;
+  Eigen::VectorXd denseHi = hi;
+  Eigen::VectorXi denseFIndex = findex;
+  solver.solve(
+      n,
+      denseA.data(),
+      denseX.data(),
+      denseB.data(),
+      0,
+      denseLo.data(),
+      denseHi.data(),
+      denseFIndex.data(),
+      false);
+
+  Eigen::SparseMatrix<double, Eigen::RowMajor> sparseA = A.sparseView();
+  Eigen::VectorXd sparseX = Eigen::VectorXd::Zero(n);
+  Eigen::VectorXd sparseB = b;
+  Eigen::VectorXd sparseLo = lo;
+  Eigen::VectorXd sparseHi = hi;
+  Eigen::VectorXi sparseFIndex = findex;
+  solver.solveSparse(
+      sparseA, sparseX, sparseB, 0, sparseLo, sparseHi, sparseFIndex, false);
+
+  EXPECT_TRUE(equals(denseX, sparseX, 1e-10));
+  EXPECT_TRUE(constraint::LCPUtils::isLCPSolutionValid(
+      sparseA, sparseX, b, hi, lo, findex, false));
+}
+
+//==============================================================================
+TEST(ContactConstraint, DantzigSolveSparseMatchesDense)
+{
+  const int n = 12;
+  Eigen::MatrixXd J = Eigen::MatrixXd::Random(n, 2 * n);
+  Eigen::MatrixXd A = J * J.transpose();
+  for (int i = 0; i < n; i++)
+    for (int j = 0; j < n; j++)
+      if (std::abs(i - j) > 3)
+        A(i, j) = 0.0;
+  A.diagonal().array() += 2.0 * n;
+
+  Eigen::VectorXd b = 20.0 * Eigen::VectorXd::Random(n);
+  Eigen::VectorXd lo = Eigen::VectorXd::Constant(n, -0.5);
+  Eigen::VectorXd hi = Eigen::VectorXd::Constant(n, 0.5);
+  Eigen::VectorXi findex = Eigen::VectorXi::Constant(n, -1);
+
+  constraint::DantzigBoxedLcpSolver solver;
+
+  Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+      denseA = Eigen::MatrixXd::Zero(n, dPAD(n));
+  denseA.block(0, 0, n, n) = A;
+  Eigen::VectorXd denseX = Eigen::VectorXd::Zero(n);
+  Eigen::VectorXd denseB = b;
+  Eigen::VectorXd denseLo = lo;
+  Eigen::VectorXd denseHi = hi;
+  Eigen::VectorXi denseFIndex = findex;
+  EXPECT_TRUE(solver.solve(
+      n,
+      denseA.data(),
+      denseX.data(),
+      denseB.data(),
+      0,
+      denseLo.data(),
+      denseHi.data(),
+      denseFIndex.data(),
+      false));
+
+  Eigen::SparseMatrix<double, Eigen::RowMajor> sparseA = A.sparseView();
+
+  // A cold start has the wrong active set, so this has to hand off to the
+  // pivoting. A warm start from the answer only needs the sparse linear solve.
+  Eigen::VectorXd coldX = Eigen::VectorXd::Zero(n);
+  Eigen::VectorXd warmX = denseX;
+  for (Eigen::VectorXd* x : {&coldX, &warmX})
+  {
+    Eigen::VectorXd sparseB = b;
+    Eigen::VectorXd sparseLo = lo;
+    Eigen::VectorXd sparseHi = hi;
+    Eigen::VectorXi sparseFIndex = findex;
+    EXPECT_TRUE(solver.solveSparse(
+        sparseA, *x, sparseB, 0, sparseLo, sparseHi, sparseFIndex, false));
+
+    EXPECT_TRUE(equals(denseX, *x, 1e-8));
+    EXPECT_TRUE(constraint::LCPUtils::isLCPSolutionValid(
+        sparseA, *x, b, hi, lo, findex, false));
+  }
+}
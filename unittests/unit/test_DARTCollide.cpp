@@ -7,8 +7,13 @@
 #include <gtest/gtest.h>
 #include <math.h>
 
+#include "dart/collision/CollisionGroup.hpp"
 #include "dart/collision/CollisionResult.hpp"
 #include "dart/collision/dart/DARTCollide.hpp"
+#include "dart/collision/dart/DARTCollisionDetector.hpp"
+#include "dart/dynamics/BoxShape.hpp"
+#include "dart/dynamics/CapsuleShape.hpp"
+#include "dart/dynamics/SimpleFrame.hpp"
 #include "dart/neural/RestorableSnapshot.hpp"
 #include "dart/realtime/Ticker.hpp"
 #include "dart/server/GUIWebsocketServer.hpp"
@@ -3890,6 +3895,49 @@ TEST(DARTCollide, CAPSULE_CCD_SUPPORT_FN)
 }
 #endif
 
+//==============================================================================
+#ifdef ALL_TESTS
+TEST(DARTCollide, CCD_CACHE_EVICTED_WITH_OBJECTS)
+{
+  auto cd = DARTCollisionDetector::create();
+
+  auto boxFrame = dynamics::SimpleFrame::createShared(dynamics::Frame::World());
+  boxFrame->setShape(
+      std::make_shared<dynamics::BoxShape>(Eigen::Vector3d::Ones()));
+  auto capsuleFrame
+      = dynamics::SimpleFrame::createShared(dynamics::Frame::World());
+  capsuleFrame->setShape(std::make_shared<dynamics::CapsuleShape>(0.5, 1.0));
+  capsuleFrame->setTranslation(Eigen::Vector3d(0.0, 0.0, 0.9));
+
+  auto group = cd->createCollisionGroup(boxFrame.get(), capsuleFrame.get());
+  EXPECT_EQ(cd->getCcdCacheSize(), 0u);
+
+  collision::CollisionOption option;
+  collision::CollisionResult result;
+  EXPECT_TRUE(group->collide(option, &result));
+  EXPECT_EQ(cd->getCcdCacheSize(), 1u);
+
+  // Colliding again should reuse the same warm start, not add a new one
+  result.clear();
+  EXPECT_TRUE(group->collide(option, &result));
+  EXPECT_EQ(cd->getCcdCacheSize(), 1u);
+
+  // Once the capsule leaves the group, its CollisionObject is destroyed, and
+  // the warm start goes with it
+  group->removeShapeFrame(capsuleFrame.get());
+  EXPECT_EQ(cd->getCcdCacheSize(), 0u);
+
+  // Clones of the detector start with their own, empty cache
+  group->addShapeFrame(capsuleFrame.get());
+  result.clear();
+  group->collide(option, &result);
+  auto clone = std::static_pointer_cast<DARTCollisionDetector>(
+      cd->cloneWithoutCollisionObjects());
+  EXPECT_EQ(cd->getCcdCacheSize(), 1u);
+  EXPECT_EQ(clone->getCcdCacheSize(), 0u);
+}
+#endif
+
 // The number of contacts shouldn't change under tiny perturbations to position,
 // and the contacts should move in predictable ways.
 
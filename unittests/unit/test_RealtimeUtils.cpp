@@ -30,6 +30,7 @@
  *   POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <atomic>
 #include <chrono>
 #include <iostream>
 #include <memory>
@@ -38,8 +39,10 @@
 #include <gtest/gtest.h>
 
 #include "dart/realtime/ControlLog.hpp"
+#include "dart/realtime/Nanos.hpp"
 #include "dart/realtime/ObservationLog.hpp"
 #include "dart/realtime/RealTimeControlBuffer.hpp"
+#include "dart/realtime/Ticker.hpp"
 #include "dart/realtime/VectorLog.hpp"
 #include "dart/simulation/World.hpp"
 
@@ -124,6 +127,59 @@ TEST(REALTIME, VECTOR_LOG_AFTER)
 }
 #endif
 
+#ifdef ALL_TESTS
+TEST(REALTIME, VECTOR_LOG_WRAPAROUND)
+{
+  int dim = 2;
+  VectorLog log = VectorLog(dim, 4);
+  for (long t = 0; t < 10; t++)
+  {
+    log.record(t, Eigen::VectorXd::Ones(dim) * t);
+  }
+
+  // Only the last 4 records fit
+  EXPECT_EQ(3L, log.availableHistoryBefore(9L));
+
+  Eigen::MatrixXd actual = log.getValues(6L, 4, 1L);
+  for (int i = 0; i < 4; i++)
+  {
+    EXPECT_DOUBLE_EQ(6.0 + i, actual(0, i));
+  }
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(REALTIME, VECTOR_LOG_CONCURRENT)
+{
+  int dim = 20;
+  VectorLog log = VectorLog(dim, 50);
+  std::atomic<bool> done(false);
+
+  std::thread writer([&]() {
+    for (long t = 0; t < 200000; t++)
+    {
+      log.record(t, Eigen::VectorXd::Ones(dim) * t);
+    }
+    done.store(true);
+  });
+
+  // Every column we read must come from a single record, so it should be
+  // constant
+  bool torn = false;
+  while (!done.load())
+  {
+    Eigen::MatrixXd values = log.getValues(0L, 200, 1000L);
+    for (int i = 0; i < values.cols(); i++)
+    {
+      if (values.col(i).maxCoeff() != values.col(i).minCoeff())
+        torn = true;
+    }
+  }
+  writer.join();
+  EXPECT_FALSE(torn);
+}
+#endif
+
 #ifdef ALL_TESTS
 TEST(REALTIME, CONTROL_LOG)
 {
@@ -239,7 +295,7 @@ TEST(REALTIME, CONTROL_BUFFER_SCALE_DOWN)
     plan.col(i) *= i;
   }
   buffer.setForcePlan(0L, 0L, plan);
-  buffer.setMillisPerStep(10);
+  buffer.setNanosPerStep(10);
   buffer.setNumSteps(5);
 
   // Read off the lower resolution, should now jump by whole numbers
@@ -266,7 +322,7 @@ TEST(REALTIME, CONTROL_BUFFER_SCALE_UP)
     plan.col(i) *= i;
   }
   buffer.setForcePlan(0L, 0L, plan);
-  buffer.setMillisPerStep(1);
+  buffer.setNanosPerStep(1);
 
   // Read off the lower resolution, should now jump by whole numbers
   EXPECT_DOUBLE_EQ(buffer.getPlannedForce(0)(0), 0);
@@ -439,6 +495,45 @@ TEST(REALTIME, CONTROL_BUFFER_PLAN)
 }
 #endif
 
+#ifdef ALL_TESTS
+TEST(REALTIME, CONTROL_BUFFER_CONCURRENT)
+{
+  int forceDim = 20;
+  int steps = 100;
+  int dt = 1;
+  RealTimeControlBuffer buffer = RealTimeControlBuffer(forceDim, steps, dt);
+
+  // Every plan the writer publishes is a single constant value, so if the
+  // reader ever sees two different values in one force, it read a plan while
+  // it was being written.
+  std::atomic<bool> done(false);
+  std::thread writer([&]() {
+    for (int i = 1; i <= 2000; i++)
+    {
+      buffer.setForcePlan(
+          0L, 0L, Eigen::MatrixXd::Constant(forceDim, steps, (double)i));
+    }
+    done = true;
+  });
+
+  Eigen::VectorXd force = Eigen::VectorXd::Zero(forceDim);
+  double lastSeen = 0.0;
+  while (!done)
+  {
+    buffer.getPlannedForce(7L, force, true);
+    EXPECT_EQ(force.minCoeff(), force.maxCoeff());
+    // Plans should only ever move forward
+    EXPECT_GE(force(0), lastSeen);
+    lastSeen = force(0);
+  }
+  writer.join();
+
+  buffer.getPlannedForce(7L, force, true);
+  EXPECT_DOUBLE_EQ(force(0), 2000.0);
+  EXPECT_EQ(buffer.getPlanBufferNanosAfter(0L), steps * dt);
+}
+#endif
+
 #ifdef ALL_TESTS
 TEST(REALTIME, CONTROL_BUFFER_ESTIMATE)
 {
@@ -484,7 +579,7 @@ TEST(REALTIME, CONTROL_BUFFER_ESTIMATE)
 
   int forceDim = world->getNumDofs();
   int steps = 100;
-  int dt = world->getTimeStep() * 1000;
+  long dt = secondsToNanos(world->getTimeStep());
   RealTimeControlBuffer buffer = RealTimeControlBuffer(forceDim, steps, dt);
   ObservationLog log = ObservationLog(
       0L, world->getPositions(), world->getVelocities(), world->getMasses());
@@ -522,4 +617,47 @@ TEST(REALTIME, CONTROL_BUFFER_ESTIMATE)
   EXPECT_TRUE(equals(truePos, world->getPositions()));
   EXPECT_TRUE(equals(trueVel, world->getVelocities()));
 }
-#endif
\ No newline at end of file
+#endif
+
+#ifdef ALL_TESTS
+TEST(REALTIME, TICKER)
+{
+  Ticker ticker = Ticker(0.001);
+
+  std::vector<long> ticks;
+  ticker.registerTickListener([&](long now) { ticks.push_back(now); });
+  long startedAt = monotonicNanos();
+  ticker.start();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  ticker.stop();
+  long stoppedAt = monotonicNanos();
+
+  TickerStats stats = ticker.getStats();
+  EXPECT_EQ(stats.numTicks, (long)ticks.size());
+  EXPECT_GT(stats.numTicks, 0L);
+  // Deadlines are absolute, so however late individual ticks are, we can't
+  // fit in more ticks than there were periods
+  EXPECT_LE(stats.numTicks, (stoppedAt - startedAt) / NANOS_PER_MILLI + 1);
+  for (int i = 1; i < ticks.size(); i++)
+  {
+    EXPECT_GT(ticks[i], ticks[i - 1]);
+  }
+  EXPECT_LE(stats.numOverruns, stats.numTicks);
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(REALTIME, WALL_CLOCK_CONVERSION)
+{
+  long now = monotonicNanos();
+  long wall = monotonicToWallNanos(now);
+  long systemNow = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::system_clock::now().time_since_epoch())
+                       .count();
+
+  // The two clocks are sampled a few instructions apart, so allow a little
+  // slack, but not anywhere near the gap between the two epochs
+  EXPECT_LE(std::abs(wall - systemNow), 10 * NANOS_PER_MILLI);
+  EXPECT_LE(std::abs(wallToMonotonicNanos(wall) - now), NANOS_PER_MILLI);
+}
+#endif